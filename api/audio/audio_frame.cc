@@ -12,14 +12,88 @@
 
 #include <string.h>
 
+#include <algorithm>
+#include <vector>
+
 #include "rtc_base/checks.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/thread_annotations.h"
 #include "rtc_base/time_utils.h"
 
 namespace webrtc {
+namespace {
+
+// Buffer sizes in samples, covering 10 ms of mono and stereo audio at the
+// common sample rates, e.g. 480 for 44.1 kHz mono and 960 for 48 kHz stereo.
+constexpr size_t kBufferSizes[] = {160, 320, 480, 640, 960, 1920, 3840,
+                                   AudioFrame::kMaxDataSizeSamples};
+constexpr size_t kNumBufferSizes = sizeof(kBufferSizes) / sizeof(size_t);
+// Released buffers beyond this are freed, so that the pool doesn't hold on to
+// the memory of many frames which are gone.
+constexpr size_t kMaxFreeBuffersPerSize = 32;
+
+size_t BufferSizeIndex(size_t num_samples) {
+  RTC_DCHECK_LE(num_samples, AudioFrame::kMaxDataSizeSamples);
+  size_t index = 0;
+  while (kBufferSizes[index] < num_samples)
+    ++index;
+  return index;
+}
+
+// Free lists of sample buffers of each size, shared by all frames.
+class SampleBufferPool {
+ public:
+  // Returns a buffer with room for at least |num_samples| samples, and its
+  // size in |buffer_size|.
+  int16_t* Acquire(size_t num_samples, size_t* buffer_size) {
+    const size_t index = BufferSizeIndex(num_samples);
+    *buffer_size = kBufferSizes[index];
+    {
+      rtc::CritScope lock(&crit_);
+      std::vector<int16_t*>& free_buffers = free_buffers_[index];
+      if (!free_buffers.empty()) {
+        int16_t* buffer = free_buffers.back();
+        free_buffers.pop_back();
+        return buffer;
+      }
+    }
+    return new int16_t[*buffer_size];
+  }
+
+  void Release(int16_t* buffer, size_t buffer_size) {
+    const size_t index = BufferSizeIndex(buffer_size);
+    RTC_DCHECK_EQ(kBufferSizes[index], buffer_size);
+    {
+      rtc::CritScope lock(&crit_);
+      std::vector<int16_t*>& free_buffers = free_buffers_[index];
+      if (free_buffers.size() < kMaxFreeBuffersPerSize) {
+        free_buffers.push_back(buffer);
+        return;
+      }
+    }
+    delete[] buffer;
+  }
 
-AudioFrame::AudioFrame() {
-  // Visual Studio doesn't like this in the class definition.
-  static_assert(sizeof(data_) == kMaxDataSizeBytes, "kMaxDataSizeBytes");
+ private:
+  rtc::CriticalSection crit_;
+  std::vector<int16_t*> free_buffers_[kNumBufferSizes] RTC_GUARDED_BY(crit_);
+};
+
+SampleBufferPool* GetSampleBufferPool() {
+  static SampleBufferPool* const pool = new SampleBufferPool();
+  return pool;
+}
+
+}  // namespace
+
+AudioFrame::AudioFrame() : AudioFrame(StorageMode::kMaxSize) {}
+
+AudioFrame::AudioFrame(StorageMode storage_mode)
+    : storage_mode_(storage_mode) {}
+
+AudioFrame::~AudioFrame() {
+  if (data_)
+    GetSampleBufferPool()->Release(data_, allocated_samples_);
 }
 
 void AudioFrame::Reset() {
@@ -64,6 +138,7 @@ void AudioFrame::UpdateFrame(uint32_t timestamp,
   const size_t length = samples_per_channel * num_channels;
   RTC_CHECK_LE(length, kMaxDataSizeSamples);
   if (data != nullptr) {
+    EnsureAllocated(length);
     memcpy(data_, data, sizeof(int16_t) * length);
     muted_ = false;
   } else {
@@ -90,6 +165,7 @@ void AudioFrame::CopyFrom(const AudioFrame& src) {
   const size_t length = samples_per_channel_ * num_channels_;
   RTC_CHECK_LE(length, kMaxDataSizeSamples);
   if (!src.muted()) {
+    EnsureAllocated(length);
     memcpy(data_, src.data(), sizeof(int16_t) * length);
     muted_ = false;
   }
@@ -114,13 +190,23 @@ const int16_t* AudioFrame::data() const {
 // TODO(henrik.lundin) Can we skip zeroing the buffer?
 // See https://bugs.chromium.org/p/webrtc/issues/detail?id=5647.
 int16_t* AudioFrame::mutable_data() {
+  EnsureAllocated(samples_per_channel_ * num_channels_);
+  RTC_DCHECK_LE(samples_per_channel_ * num_channels_, max_16bit_samples());
   if (muted_) {
-    memset(data_, 0, kMaxDataSizeBytes);
+    memset(data_, 0, sizeof(int16_t) * allocated_samples_);
     muted_ = false;
   }
   return data_;
 }
 
+int16_t* AudioFrame::mutable_data(size_t samples_per_channel,
+                                  size_t num_channels) {
+  RTC_CHECK_LE(samples_per_channel * num_channels, kMaxDataSizeSamples);
+  samples_per_channel_ = samples_per_channel;
+  num_channels_ = num_channels;
+  return mutable_data();
+}
+
 void AudioFrame::Mute() {
   muted_ = true;
 }
@@ -129,6 +215,25 @@ bool AudioFrame::muted() const {
   return muted_;
 }
 
+void AudioFrame::EnsureAllocated(size_t num_samples) {
+  if (storage_mode_ == StorageMode::kMaxSize)
+    num_samples = kMaxDataSizeSamples;
+  if (data_ && num_samples <= allocated_samples_)
+    return;
+
+  size_t buffer_size = 0;
+  int16_t* buffer = GetSampleBufferPool()->Acquire(
+      std::max<size_t>(num_samples, 1), &buffer_size);
+  if (data_) {
+    // Muted frames are zeroed when unmuted, their samples needn't be kept.
+    if (!muted_)
+      memcpy(buffer, data_, sizeof(int16_t) * allocated_samples_);
+    GetSampleBufferPool()->Release(data_, allocated_samples_);
+  }
+  data_ = buffer;
+  allocated_samples_ = buffer_size;
+}
+
 // static
 const int16_t* AudioFrame::empty_data() {
   static int16_t* null_data = new int16_t[kMaxDataSizeSamples]();
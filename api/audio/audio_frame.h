@@ -24,6 +24,15 @@ namespace webrtc {
  * allows for adding and subtracting frames while keeping track of the resulting
  * states.
  *
+ * The samples are stored in a buffer taken from a pool shared by all frames,
+ * which is allocated on the first write to the frame. By default the buffer
+ * has room for kMaxDataSizeSamples. A compact frame only allocates room for
+ * samples_per_channel_ * num_channels_ samples and reallocates when the frame
+ * grows, which saves memory when many frames are kept around, e.g. one per
+ * receive stream in a mixer. Writers to a compact frame must set the frame
+ * format before writing to mutable_data(), or use the mutable_data() overload
+ * which sets it.
+ *
  * Notes
  * - This is a de-facto api, not designed for external use. The AudioFrame class
  *   is in need of overhaul or even replacement, and anyone depending on it
@@ -56,7 +65,11 @@ class AudioFrame {
     kUndefined = 4
   };
 
+  enum class StorageMode { kMaxSize, kCompact };
+
   AudioFrame();
+  explicit AudioFrame(StorageMode storage_mode);
+  ~AudioFrame();
 
   // Resets all members to their default state.
   void Reset();
@@ -92,13 +105,27 @@ class AudioFrame {
   // mutable_frame() zeros the non-static buffer and marks the frame unmuted.
   const int16_t* data() const;
   int16_t* mutable_data();
+  // Same as mutable_data(), and sets the frame format first, so that a compact
+  // frame has room for |samples_per_channel| * |num_channels| samples. The
+  // samples already in the frame are kept.
+  int16_t* mutable_data(size_t samples_per_channel, size_t num_channels);
 
   // Prefer to mute frames using AudioFrameOperations::Mute.
   void Mute();
   // Frame is muted by default.
   bool muted() const;
 
-  size_t max_16bit_samples() const { return kMaxDataSizeSamples; }
+  // Number of samples that can be written to the buffer returned by
+  // mutable_data(). For compact frames this is the room allocated so far,
+  // which mutable_data() grows to fit the frame format.
+  size_t max_16bit_samples() const {
+    return storage_mode_ == StorageMode::kCompact ? allocated_samples_
+                                                  : kMaxDataSizeSamples;
+  }
+  // Number of samples the frame has allocated room for, 0 until the first
+  // write.
+  size_t allocated_samples() const { return allocated_samples_; }
+  StorageMode storage_mode() const { return storage_mode_; }
   size_t samples_per_channel() const { return samples_per_channel_; }
   size_t num_channels() const { return num_channels_; }
   ChannelLayout channel_layout() const { return channel_layout_; }
@@ -147,7 +174,12 @@ class AudioFrame {
   // buffer per translation unit is to wrap a static in an inline function.
   static const int16_t* empty_data();
 
-  int16_t data_[kMaxDataSizeSamples];
+  // Makes room for |num_samples| samples, keeping the samples in the frame.
+  void EnsureAllocated(size_t num_samples);
+
+  const StorageMode storage_mode_;
+  int16_t* data_ = nullptr;
+  size_t allocated_samples_ = 0;
   bool muted_ = true;
 
   RTC_DISALLOW_COPY_AND_ASSIGN(AudioFrame);
@@ -63,6 +63,75 @@ TEST(AudioFrameTest, MutedFrameBufferIsZeroed) {
   EXPECT_TRUE(AllSamplesAre(0, frame));
 }
 
+TEST(AudioFrameTest, FrameAllocatesOnFirstWrite) {
+  AudioFrame frame;
+  EXPECT_EQ(0u, frame.allocated_samples());
+  frame.mutable_data();
+  EXPECT_EQ(AudioFrame::kMaxDataSizeSamples, frame.allocated_samples());
+}
+
+TEST(AudioFrameTest, CompactFrameAllocatesForItsFormat) {
+  AudioFrame frame(AudioFrame::StorageMode::kCompact);
+  int16_t samples[kNumChannelsMono * kSamplesPerChannel] = {17};
+  frame.UpdateFrame(kTimestamp, samples, kSamplesPerChannel, kSampleRateHz,
+                    AudioFrame::kPLC, AudioFrame::kVadActive, kNumChannelsMono);
+  EXPECT_EQ(kSamplesPerChannel, frame.allocated_samples());
+  EXPECT_EQ(0, memcmp(samples, frame.data(), sizeof(samples)));
+
+  // Muting keeps the buffer, and unmuting zeroes it.
+  frame.Mute();
+  EXPECT_EQ(0, frame.mutable_data()[0]);
+  EXPECT_EQ(kSamplesPerChannel, frame.allocated_samples());
+}
+
+TEST(AudioFrameTest, MaxSamplesOfCompactFrameIsAllocatedRoom) {
+  AudioFrame frame(AudioFrame::StorageMode::kCompact);
+  EXPECT_EQ(0u, frame.max_16bit_samples());
+  frame.mutable_data(kSamplesPerChannel, kNumChannelsMono);
+  EXPECT_EQ(kSamplesPerChannel, frame.max_16bit_samples());
+  frame.mutable_data(kSamplesPerChannel, kNumChannelsStereo);
+  EXPECT_EQ(frame.allocated_samples(), frame.max_16bit_samples());
+  EXPECT_GE(frame.max_16bit_samples(), kSamplesPerChannel * kNumChannelsStereo);
+
+  AudioFrame max_size_frame;
+  EXPECT_EQ(AudioFrame::kMaxDataSizeSamples,
+            max_size_frame.max_16bit_samples());
+}
+
+TEST(AudioFrameTest, CompactFrameKeepsSamplesWhenGrowing) {
+  AudioFrame frame(AudioFrame::StorageMode::kCompact);
+  int16_t* frame_data = frame.mutable_data(kSamplesPerChannel, 1);
+  for (size_t i = 0; i < kSamplesPerChannel; ++i)
+    frame_data[i] = static_cast<int16_t>(i);
+
+  frame_data = frame.mutable_data(kSamplesPerChannel, kNumChannels5_1);
+  EXPECT_EQ(kSamplesPerChannel, frame.samples_per_channel());
+  EXPECT_EQ(kNumChannels5_1, frame.num_channels());
+  EXPECT_GE(frame.allocated_samples(), kSamplesPerChannel * kNumChannels5_1);
+  for (size_t i = 0; i < kSamplesPerChannel; ++i)
+    EXPECT_EQ(static_cast<int16_t>(i), frame_data[i]);
+  // The new samples can be written.
+  frame_data[kSamplesPerChannel * kNumChannels5_1 - 1] = 17;
+  EXPECT_EQ(17, frame.data()[kSamplesPerChannel * kNumChannels5_1 - 1]);
+}
+
+TEST(AudioFrameTest, CompactFrameGrowsWhenCopiedTo) {
+  AudioFrame frame(AudioFrame::StorageMode::kCompact);
+  frame.mutable_data(kSamplesPerChannel, kNumChannelsMono);
+
+  AudioFrame stereo_frame;
+  int16_t* stereo_data =
+      stereo_frame.mutable_data(kSamplesPerChannel, kNumChannelsStereo);
+  for (size_t i = 0; i < kSamplesPerChannel * kNumChannelsStereo; ++i)
+    stereo_data[i] = static_cast<int16_t>(i);
+  frame.CopyFrom(stereo_frame);
+  EXPECT_GE(frame.allocated_samples(), kSamplesPerChannel * kNumChannelsStereo);
+  EXPECT_LT(frame.allocated_samples(), AudioFrame::kMaxDataSizeSamples);
+  EXPECT_EQ(0, memcmp(stereo_frame.data(), frame.data(),
+                      sizeof(int16_t) * kSamplesPerChannel *
+                          kNumChannelsStereo));
+}
+
 TEST(AudioFrameTest, UpdateFrameMono) {
   AudioFrame frame;
   int16_t samples[kNumChannelsMono * kSamplesPerChannel] = {17};
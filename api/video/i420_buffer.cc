@@ -46,9 +46,30 @@ I420Buffer::I420Buffer(int width,
       stride_y_(stride_y),
       stride_u_(stride_u),
       stride_v_(stride_v),
-      data_(static_cast<uint8_t*>(
+      owned_data_(static_cast<uint8_t*>(
           AlignedMalloc(I420DataSize(height, stride_y, stride_u, stride_v),
-                        kBufferAlignment))) {
+                        kBufferAlignment))),
+      data_(owned_data_.get()) {
+  RTC_DCHECK_GT(width, 0);
+  RTC_DCHECK_GT(height, 0);
+  RTC_DCHECK_GE(stride_y, width);
+  RTC_DCHECK_GE(stride_u, (width + 1) / 2);
+  RTC_DCHECK_GE(stride_v, (width + 1) / 2);
+}
+
+I420Buffer::I420Buffer(int width,
+                       int height,
+                       int stride_y,
+                       int stride_u,
+                       int stride_v,
+                       uint8_t* data)
+    : width_(width),
+      height_(height),
+      stride_y_(stride_y),
+      stride_u_(stride_u),
+      stride_v_(stride_v),
+      data_(data) {
+  RTC_DCHECK(data);
   RTC_DCHECK_GT(width, 0);
   RTC_DCHECK_GT(height, 0);
   RTC_DCHECK_GE(stride_y, width);
@@ -130,7 +151,7 @@ rtc::scoped_refptr<I420Buffer> I420Buffer::Rotate(
 }
 
 void I420Buffer::InitializeData() {
-  memset(data_.get(), 0,
+  memset(data_, 0,
          I420DataSize(height_, stride_y_, stride_u_, stride_v_));
 }
 
@@ -143,13 +164,13 @@ int I420Buffer::height() const {
 }
 
 const uint8_t* I420Buffer::DataY() const {
-  return data_.get();
+  return data_;
 }
 const uint8_t* I420Buffer::DataU() const {
-  return data_.get() + stride_y_ * height_;
+  return data_ + stride_y_ * height_;
 }
 const uint8_t* I420Buffer::DataV() const {
-  return data_.get() + stride_y_ * height_ + stride_u_ * ((height_ + 1) / 2);
+  return data_ + stride_y_ * height_ + stride_u_ * ((height_ + 1) / 2);
 }
 
 int I420Buffer::StrideY() const {
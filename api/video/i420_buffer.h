@@ -107,6 +107,15 @@ class RTC_EXPORT I420Buffer : public I420BufferInterface {
  protected:
   I420Buffer(int width, int height);
   I420Buffer(int width, int height, int stride_y, int stride_u, int stride_v);
+  // Wraps |data| instead of allocating memory. |data| is not owned, must hold
+  // at least the three planes, and must stay valid until the buffer is
+  // destroyed. Used by buffer pools that recycle the memory.
+  I420Buffer(int width,
+             int height,
+             int stride_y,
+             int stride_u,
+             int stride_v,
+             uint8_t* data);
 
   ~I420Buffer() override;
 
@@ -116,7 +125,9 @@ class RTC_EXPORT I420Buffer : public I420BufferInterface {
   const int stride_y_;
   const int stride_u_;
   const int stride_v_;
-  const std::unique_ptr<uint8_t, AlignedFreeDeleter> data_;
+  // Null if the memory is owned by someone else.
+  const std::unique_ptr<uint8_t, AlignedFreeDeleter> owned_data_;
+  uint8_t* const data_;
 };
 
 }  // namespace webrtc
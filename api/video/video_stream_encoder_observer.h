@@ -76,6 +76,18 @@ class VideoStreamEncoderObserver : public CpuOveruseMetricsObserver {
 
   virtual void OnFrameDropped(DropReason reason) = 0;
 
+  // Time spent by an encoded frame in the stages of the encoder pipeline, see
+  // VideoStreamEncoderSettings::enable_pipelined_encoding. Only reported when
+  // pipelining is enabled.
+  virtual void OnFramePipelineTimeMeasured(int preprocess_time_us,
+                                           int queue_time_us,
+                                           int encode_time_us) {}
+
+  // CPU budget share and complexity assigned to the encoder by the encoder CPU
+  // budget scheduler, reported whenever the allocation changes.
+  virtual void OnCpuBudgetAllocationUpdated(int max_encode_usage_percent,
+                                            VideoCodecComplexity complexity) {}
+
   // Used to indicate change in content type, which may require a change in
   // how stats are collected and set the configured preferred media bitrate.
   virtual void OnEncoderReconfigured(
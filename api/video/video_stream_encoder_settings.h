@@ -32,6 +32,16 @@ struct VideoStreamEncoderSettings {
   // cpu adaptation.
   bool experiment_cpu_load_estimator = false;
 
+  // Estimates the cpu load from the CPU time spent by the encoder thread
+  // rather than from wall clock encode times, used for cpu adaptation.
+  bool experiment_cpu_time_load_estimator = false;
+
+  // Crops and converts frames to a buffer type supported by the encoder on a
+  // separate task queue, so that preprocessing of a frame overlaps with
+  // encoding of the previous one. At most one frame is in each stage, frames
+  // arriving while both are busy are dropped like when encoding is slow.
+  bool enable_pipelined_encoding = false;
+
   // Ownership stays with WebrtcVideoEngine (delegated from PeerConnection).
   VideoEncoderFactory* encoder_factory = nullptr;
 
@@ -32,4 +32,8 @@ const char* VideoDecoder::ImplementationName() const {
   return "unknown";
 }
 
+size_t VideoDecoder::FrameBufferBytes() const {
+  return 0;
+}
+
 }  // namespace webrtc
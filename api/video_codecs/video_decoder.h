@@ -62,6 +62,10 @@ class RTC_EXPORT VideoDecoder {
   virtual bool PrefersLateDecoding() const;
 
   virtual const char* ImplementationName() const;
+
+  // Returns the size of the memory currently held for the decoder's output
+  // frame buffers, or 0 if the decoder doesn't track it.
+  virtual size_t FrameBufferBytes() const;
 };
 
 }  // namespace webrtc
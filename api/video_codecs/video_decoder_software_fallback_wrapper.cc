@@ -51,6 +51,8 @@ class VideoDecoderSoftwareFallbackWrapper final : public VideoDecoder {
 
   const char* ImplementationName() const override;
 
+  size_t FrameBufferBytes() const override;
+
  private:
   bool InitFallbackDecoder();
   int32_t InitHwDecoder();
@@ -215,6 +217,10 @@ const char* VideoDecoderSoftwareFallbackWrapper::ImplementationName() const {
              : hw_decoder_->ImplementationName();
 }
 
+size_t VideoDecoderSoftwareFallbackWrapper::FrameBufferBytes() const {
+  return active_decoder().FrameBufferBytes();
+}
+
 VideoDecoder& VideoDecoderSoftwareFallbackWrapper::active_decoder() const {
   return decoder_type_ == DecoderType::kFallback ? *fallback_decoder_
                                                  : *hw_decoder_;
@@ -66,21 +66,25 @@ void RemixAndResample(const int16_t* src_data,
   // how much to zero here; or 2) make resampler accept a hint that the input is
   // zeroed.
   const size_t src_length = samples_per_channel * audio_ptr_num_channels;
-  int out_length =
-      resampler->Resample(audio_ptr, src_length, dst_frame->mutable_data(),
-                          AudioFrame::kMaxDataSizeSamples);
+  // Set the format of the resampled audio before getting the buffer, so that
+  // a compact frame has room for it.
+  const size_t dst_num_channels = dst_frame->num_channels_;
+  int16_t* const dst_data = dst_frame->mutable_data(
+      samples_per_channel * dst_frame->sample_rate_hz_ / sample_rate_hz,
+      audio_ptr_num_channels);
+  int out_length = resampler->Resample(audio_ptr, src_length, dst_data,
+                                       dst_frame->max_16bit_samples());
   if (out_length == -1) {
     FATAL() << "Resample failed: audio_ptr = " << audio_ptr
             << ", src_length = " << src_length
-            << ", dst_frame->mutable_data() = " << dst_frame->mutable_data();
+            << ", dst_frame->mutable_data() = " << dst_data;
   }
   dst_frame->samples_per_channel_ = out_length / audio_ptr_num_channels;
 
   // Upmix after resampling.
-  if (num_channels == 1 && dst_frame->num_channels_ == 2) {
-    // The audio in dst_frame really is mono at this point; MonoToStereo will
+  if (num_channels == 1 && dst_num_channels == 2) {
+    // The audio in dst_frame really is mono at this point; UpmixChannels will
     // set this back to stereo.
-    dst_frame->num_channels_ = 1;
     AudioFrameOperations::UpmixChannels(2, dst_frame);
   }
 }
@@ -251,6 +251,18 @@ TEST_F(UtilityTest, RemixAndResampleMixingOnlySucceeds) {
   VerifyFramesAreEqual(golden_frame_, dst_frame_);
 }
 
+// Verifies that a compact destination frame grows to fit the resampled audio,
+// when it was last written with a smaller format.
+TEST_F(UtilityTest, RemixAndResampleGrowsCompactFrame) {
+  AudioFrame dst_frame(AudioFrame::StorageMode::kCompact);
+  SetMonoFrame(0, 8000, &dst_frame);
+  dst_frame.num_channels_ = 2;
+  dst_frame.sample_rate_hz_ = 48000;
+  SetStereoFrame(10, 20, 48000, &src_frame_);
+  RemixAndResample(src_frame_, &resampler_, &dst_frame);
+  VerifyFramesAreEqual(src_frame_, dst_frame);
+}
+
 TEST_F(UtilityTest, RemixAndResampleSucceeds) {
   const int kSampleRates[] = {8000, 16000, 32000, 44100, 48000, 96000};
   const int kSampleRatesSize = arraysize(kSampleRates);
@@ -169,10 +169,11 @@ void AudioFrameOperations::UpmixChannels(size_t target_number_of_channels,
   if (!frame->muted()) {
     // Up-mixing done in place. Going backwards through the frame ensure nothing
     // is irrevocably overwritten.
+    int16_t* frame_data = frame->mutable_data(frame->samples_per_channel_,
+                                              target_number_of_channels);
     for (int i = frame->samples_per_channel_ - 1; i >= 0; i--) {
       for (size_t j = 0; j < target_number_of_channels; ++j) {
-        frame->mutable_data()[target_number_of_channels * i + j] =
-            frame->data()[i];
+        frame_data[target_number_of_channels * i + j] = frame_data[i];
       }
     }
   }
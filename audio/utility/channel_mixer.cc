@@ -42,9 +42,10 @@ void ChannelMixer::Transform(AudioFrame* frame) {
     return;
   }
 
+  // The frame grows to the upmixed format when written to below.
   if (IsUpMixing()) {
     RTC_CHECK_LE(frame->samples_per_channel() * output_channels_,
-                 frame->max_16bit_samples());
+                 AudioFrame::kMaxDataSizeSamples);
   }
 
   // Only change the number of output channels if the audio frame is muted.
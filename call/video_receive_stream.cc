@@ -50,6 +50,9 @@ std::string VideoReceiveStream::Stats::ToString(int64_t time_ms) const {
   ss << "render_fps: " << render_frame_rate << ", ";
   ss << "decode_ms: " << decode_ms << ", ";
   ss << "max_decode_ms: " << max_decode_ms << ", ";
+  ss << "decoder_frame_buffer_bytes: " << decoder_frame_buffer_bytes << ", ";
+  ss << "decode_queue_depth: " << decode_queue_depth << ", ";
+  ss << "decode_deadline_misses: " << decode_deadline_misses << ", ";
   ss << "first_frame_received_to_decoded_ms: "
      << first_frame_received_to_decoded_ms << ", ";
   ss << "cur_delay_ms: " << current_delay_ms << ", ";
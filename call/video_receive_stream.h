@@ -72,6 +72,9 @@ class VideoReceiveStream {
 
     // Decoder stats.
     std::string decoder_implementation_name = "unknown";
+    // Memory held for the decoder's output frame buffers, 0 if the decoder
+    // doesn't report it.
+    size_t decoder_frame_buffer_bytes = 0;
     FrameCounts frame_counts;
     int decode_ms = 0;
     int max_decode_ms = 0;
@@ -93,6 +96,11 @@ class VideoReceiveStream {
     uint64_t total_decode_time_ms = 0;
     int64_t first_frame_received_to_decoded_ms = -1;
     absl::optional<uint64_t> qp_sum;
+    // Only set when decoding on the shared decode thread pool: decode tasks
+    // waiting for a thread, and decodes that finished after the render time
+    // of the frame.
+    int decode_queue_depth = 0;
+    uint64_t decode_deadline_misses = 0;
 
     int current_payload_type = -1;
 
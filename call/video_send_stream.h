@@ -74,6 +74,10 @@ class VideoSendStream {
     int encode_frame_rate = 0;
     int avg_encode_time_ms = 0;
     int encode_usage_percent = 0;
+    // Share of the CPU budget and the complexity assigned to this encoder by
+    // the encoder CPU budget scheduler. Unset when the scheduler is disabled.
+    absl::optional<int> cpu_budget_max_encode_usage_percent;
+    absl::optional<VideoCodecComplexity> cpu_budget_complexity;
     uint32_t frames_encoded = 0;
     // https://w3c.github.io/webrtc-stats/#dom-rtcoutboundrtpstreamstats-totalencodetime
     uint64_t total_encode_time_ms = 0;
@@ -0,0 +1,75 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <immintrin.h>
+
+#include "common_audio/signal_processing/include/signal_processing_library.h"
+#include "rtc_base/checks.h"
+
+// Returns the sum of the products of |vector1| and |vector2|, each shifted
+// right by |scaling| before being added, like the C version does.
+static int32_t DotProductWithScaleAVX2(const int16_t* vector1,
+                                       const int16_t* vector2,
+                                       size_t length,
+                                       int scaling) {
+  __m256i sum = _mm256_setzero_si256();
+  size_t i = 0;
+  if (scaling == 0) {
+    for (; i + 16 <= length; i += 16) {
+      const __m256i x = _mm256_loadu_si256((const __m256i*)&vector1[i]);
+      const __m256i y = _mm256_loadu_si256((const __m256i*)&vector2[i]);
+      sum = _mm256_add_epi32(sum, _mm256_madd_epi16(x, y));
+    }
+  } else {
+    const __m128i shift = _mm_cvtsi32_si128(scaling);
+    for (; i + 16 <= length; i += 16) {
+      const __m256i x = _mm256_loadu_si256((const __m256i*)&vector1[i]);
+      const __m256i y = _mm256_loadu_si256((const __m256i*)&vector2[i]);
+      const __m256i low = _mm256_mullo_epi16(x, y);
+      const __m256i high = _mm256_mulhi_epi16(x, y);
+      sum = _mm256_add_epi32(
+          sum, _mm256_sra_epi32(_mm256_unpacklo_epi16(low, high), shift));
+      sum = _mm256_add_epi32(
+          sum, _mm256_sra_epi32(_mm256_unpackhi_epi16(low, high), shift));
+    }
+  }
+  // The sum wraps around like the C version, the order of the additions
+  // doesn't change the result.
+  __m128i sum128 = _mm_add_epi32(_mm256_castsi256_si128(sum),
+                                 _mm256_extracti128_si256(sum, 1));
+  sum128 = _mm_add_epi32(sum128,
+                         _mm_shuffle_epi32(sum128, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum128 = _mm_add_epi32(sum128,
+                         _mm_shuffle_epi32(sum128, _MM_SHUFFLE(2, 3, 0, 1)));
+  uint32_t result = (uint32_t)_mm_cvtsi128_si32(sum128);
+  for (; i < length; i++) {
+    result += (uint32_t)((vector1[i] * vector2[i]) >> scaling);
+  }
+  return (int32_t)result;
+}
+
+/* AVX2 version of WebRtcSpl_CrossCorrelation() for x86 platforms. */
+void WebRtcSpl_CrossCorrelationAVX2(int32_t* cross_correlation,
+                                    const int16_t* seq1,
+                                    const int16_t* seq2,
+                                    size_t dim_seq,
+                                    size_t dim_cross_correlation,
+                                    int right_shifts,
+                                    int step_seq2) {
+  size_t i = 0;
+
+  RTC_DCHECK_GE(right_shifts, 0);
+
+  for (i = 0; i < dim_cross_correlation; i++) {
+    *cross_correlation++ =
+        DotProductWithScaleAVX2(seq1, seq2, dim_seq, right_shifts);
+    seq2 += step_seq2;
+  }
+}
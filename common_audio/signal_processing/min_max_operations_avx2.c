@@ -0,0 +1,60 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <immintrin.h>
+#include <stdlib.h>
+
+#include "common_audio/signal_processing/include/signal_processing_library.h"
+#include "rtc_base/checks.h"
+
+// Maximum absolute value of word16 vector. AVX2 version for x86 platforms.
+int16_t WebRtcSpl_MaxAbsValueW16AVX2(const int16_t* vector, size_t length) {
+  size_t i = 0;
+  int absolute = 0, maximum = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  // Track the largest and the smallest value, since abs(-32768) doesn't fit
+  // in 16 bits.
+  __m256i max_value = _mm256_setzero_si256();
+  __m256i min_value = _mm256_setzero_si256();
+  for (; i + 16 <= length; i += 16) {
+    const __m256i v = _mm256_loadu_si256((const __m256i*)&vector[i]);
+    max_value = _mm256_max_epi16(max_value, v);
+    min_value = _mm256_min_epi16(min_value, v);
+  }
+  int16_t max_values[16];
+  int16_t min_values[16];
+  _mm256_storeu_si256((__m256i*)max_values, max_value);
+  _mm256_storeu_si256((__m256i*)min_values, min_value);
+  for (size_t k = 0; k < 16; k++) {
+    if (max_values[k] > maximum) {
+      maximum = max_values[k];
+    }
+    if (-min_values[k] > maximum) {
+      maximum = -min_values[k];
+    }
+  }
+
+  for (; i < length; i++) {
+    absolute = abs((int)vector[i]);
+
+    if (absolute > maximum) {
+      maximum = absolute;
+    }
+  }
+
+  // Guard the case for abs(-32768).
+  if (maximum > WEBRTC_SPL_WORD16_MAX) {
+    maximum = WEBRTC_SPL_WORD16_MAX;
+  }
+
+  return (int16_t)maximum;
+}
@@ -0,0 +1,60 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include <emmintrin.h>
+#include <stdlib.h>
+
+#include "common_audio/signal_processing/include/signal_processing_library.h"
+#include "rtc_base/checks.h"
+
+// Maximum absolute value of word16 vector. SSE2 version for x86 platforms.
+int16_t WebRtcSpl_MaxAbsValueW16SSE2(const int16_t* vector, size_t length) {
+  size_t i = 0;
+  int absolute = 0, maximum = 0;
+
+  RTC_DCHECK_GT(length, 0);
+
+  // Track the largest and the smallest value, since abs(-32768) doesn't fit
+  // in 16 bits.
+  __m128i max_value = _mm_setzero_si128();
+  __m128i min_value = _mm_setzero_si128();
+  for (; i + 8 <= length; i += 8) {
+    const __m128i v = _mm_loadu_si128((const __m128i*)&vector[i]);
+    max_value = _mm_max_epi16(max_value, v);
+    min_value = _mm_min_epi16(min_value, v);
+  }
+  int16_t max_values[8];
+  int16_t min_values[8];
+  _mm_storeu_si128((__m128i*)max_values, max_value);
+  _mm_storeu_si128((__m128i*)min_values, min_value);
+  for (size_t k = 0; k < 8; k++) {
+    if (max_values[k] > maximum) {
+      maximum = max_values[k];
+    }
+    if (-min_values[k] > maximum) {
+      maximum = -min_values[k];
+    }
+  }
+
+  for (; i < length; i++) {
+    absolute = abs((int)vector[i]);
+
+    if (absolute > maximum) {
+      maximum = absolute;
+    }
+  }
+
+  // Guard the case for abs(-32768).
+  if (maximum > WEBRTC_SPL_WORD16_MAX) {
+    maximum = WEBRTC_SPL_WORD16_MAX;
+  }
+
+  return (int16_t)maximum;
+}
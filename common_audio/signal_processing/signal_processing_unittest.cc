@@ -9,9 +9,12 @@
  */
 
 #include <algorithm>
+#include <vector>
 
 #include "common_audio/signal_processing/include/signal_processing_library.h"
+#include "rtc_base/random.h"
 #include "rtc_base/strings/string_builder.h"
+#include "system_wrappers/include/cpu_features_wrapper.h"
 #include "test/gtest.h"
 
 static const size_t kVector16Size = 9;
@@ -491,18 +494,81 @@ TEST(SplTest, CrossCorrelationTest) {
   const int32_t kExpected[kCrossCorrelationDimension] = {-266947903, -15579555,
                                                          -171282001};
   const int32_t* expected = kExpected;
-#if !defined(MIPS32_LE)
+#if defined(WEBRTC_HAS_NEON)
   const int32_t kExpectedNeon[kCrossCorrelationDimension] = {
       -266947901, -15579553, -171281999};
-  if (WebRtcSpl_CrossCorrelation != WebRtcSpl_CrossCorrelationC) {
-    expected = kExpectedNeon;
-  }
+  expected = kExpectedNeon;
 #endif
   for (size_t i = 0; i < kCrossCorrelationDimension; ++i) {
     EXPECT_EQ(expected[i], vector32[i]);
   }
 }
 
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+// The SSE2 and AVX2 versions must give the same result as the C version, since
+// NetEq output is expected to be identical on all x86 CPUs.
+TEST(SplTest, X86OptimizationsAreBitExact) {
+  webrtc::Random random_generator(42);
+  std::vector<int16_t> seq1(1000);
+  std::vector<int16_t> seq2(1000);
+  for (size_t i = 0; i < seq1.size(); ++i) {
+    seq1[i] = random_generator.Rand<int16_t>();
+    seq2[i] = random_generator.Rand<int16_t>();
+  }
+  // Full scale values, including the one without a positive counterpart.
+  seq1[3] = WEBRTC_SPL_WORD16_MIN;
+  seq1[4] = WEBRTC_SPL_WORD16_MIN;
+  seq2[40] = WEBRTC_SPL_WORD16_MIN;
+  seq2[41] = WEBRTC_SPL_WORD16_MAX;
+
+  const bool has_sse2 = WebRtc_GetCPUInfo(kSSE2) != 0;
+  const bool has_avx2 = WebRtc_GetCPUInfo(kAVX2) != 0;
+  const size_t kDimCrossCorrelation = 40;
+  for (size_t dim_seq : {1, 7, 8, 15, 16, 17, 31, 33, 60, 479}) {
+    for (int right_shifts : {0, 1, 6, 15}) {
+      for (int step_seq2 : {1, -1}) {
+        const int16_t* seq2_start =
+            step_seq2 > 0 ? &seq2[0] : &seq2[kDimCrossCorrelation];
+        int32_t expected[kDimCrossCorrelation];
+        int32_t actual[kDimCrossCorrelation];
+        WebRtcSpl_CrossCorrelationC(expected, &seq1[0], seq2_start, dim_seq,
+                                    kDimCrossCorrelation, right_shifts,
+                                    step_seq2);
+        if (has_sse2) {
+          WebRtcSpl_CrossCorrelationSSE2(actual, &seq1[0], seq2_start,
+                                         dim_seq, kDimCrossCorrelation,
+                                         right_shifts, step_seq2);
+          EXPECT_TRUE(std::equal(expected, expected + kDimCrossCorrelation,
+                                 actual));
+        }
+        if (has_avx2) {
+          WebRtcSpl_CrossCorrelationAVX2(actual, &seq1[0], seq2_start,
+                                         dim_seq, kDimCrossCorrelation,
+                                         right_shifts, step_seq2);
+          EXPECT_TRUE(std::equal(expected, expected + kDimCrossCorrelation,
+                                 actual));
+        }
+      }
+    }
+  }
+
+  for (size_t length = 1; length < 100; ++length) {
+    for (size_t offset : {0, 3, 500}) {
+      const int16_t expected =
+          WebRtcSpl_MaxAbsValueW16C(&seq1[offset], length);
+      if (has_sse2) {
+        EXPECT_EQ(expected,
+                  WebRtcSpl_MaxAbsValueW16SSE2(&seq1[offset], length));
+      }
+      if (has_avx2) {
+        EXPECT_EQ(expected,
+                  WebRtcSpl_MaxAbsValueW16AVX2(&seq1[offset], length));
+      }
+    }
+  }
+}
+#endif
+
 TEST(SplTest, AutoCorrelationTest) {
   int scale = 0;
   int32_t vector32[kVector16Size];
@@ -0,0 +1,40 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "common_audio/signal_processing/include/signal_processing_library.h"
+#include "system_wrappers/include/cpu_features_wrapper.h"
+
+// The implementation is picked on the first call, since the CPU features are
+// not known when the function pointers in spl_init.c are initialized.
+
+int16_t WebRtcSpl_MaxAbsValueW16X86(const int16_t* vector, size_t length) {
+  static const MaxAbsValueW16 max_abs_value =
+      WebRtc_GetCPUInfo(kAVX2)
+          ? WebRtcSpl_MaxAbsValueW16AVX2
+          : WebRtc_GetCPUInfo(kSSE2) ? WebRtcSpl_MaxAbsValueW16SSE2
+                                     : WebRtcSpl_MaxAbsValueW16C;
+  return max_abs_value(vector, length);
+}
+
+void WebRtcSpl_CrossCorrelationX86(int32_t* cross_correlation,
+                                   const int16_t* seq1,
+                                   const int16_t* seq2,
+                                   size_t dim_seq,
+                                   size_t dim_cross_correlation,
+                                   int right_shifts,
+                                   int step_seq2) {
+  static const CrossCorrelation cross_correlation_function =
+      WebRtc_GetCPUInfo(kAVX2)
+          ? WebRtcSpl_CrossCorrelationAVX2
+          : WebRtc_GetCPUInfo(kSSE2) ? WebRtcSpl_CrossCorrelationSSE2
+                                     : WebRtcSpl_CrossCorrelationC;
+  cross_correlation_function(cross_correlation, seq1, seq2, dim_seq,
+                             dim_cross_correlation, right_shifts, step_seq2);
+}
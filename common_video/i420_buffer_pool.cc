@@ -10,23 +10,100 @@
 
 #include "common_video/include/i420_buffer_pool.h"
 
+#include <algorithm>
 #include <limits>
+#include <utility>
 
-#include "rtc_base/checks.h"
+#include "rtc_base/ref_counted_object.h"
+#include "rtc_base/time_utils.h"
 
 namespace webrtc {
+namespace {
+
+constexpr int64_t kTrimIntervalMs = 1000;
+
+}  // namespace
+
+// I420Buffer using a block of the pool's memory, returning it on destruction.
+class I420BufferPool::PooledI420Buffer : public I420Buffer {
+ public:
+  PooledI420Buffer(int width,
+                   int height,
+                   int stride_y,
+                   int stride_u,
+                   int stride_v,
+                   rtc::scoped_refptr<Storage> storage,
+                   uint32_t index)
+      : I420Buffer(width,
+                   height,
+                   stride_y,
+                   stride_u,
+                   stride_v,
+                   storage->data(index)),
+        storage_(std::move(storage)),
+        index_(index) {}
+
+ protected:
+  ~PooledI420Buffer() override {
+    storage_->Return(index_);
+    storage_->ReleaseBuffer();
+  }
+
+ private:
+  const rtc::scoped_refptr<Storage> storage_;
+  const uint32_t index_;
+};
+
+// I420Buffer allocated outside of the pool's blocks, which still counts
+// against the pool's max number of buffers until it is destroyed.
+class I420BufferPool::UnpooledI420Buffer : public I420Buffer {
+ public:
+  UnpooledI420Buffer(int width,
+                     int height,
+                     int stride_y,
+                     int stride_u,
+                     int stride_v,
+                     rtc::scoped_refptr<Storage> storage)
+      : I420Buffer(width, height, stride_y, stride_u, stride_v),
+        storage_(std::move(storage)) {}
+
+ protected:
+  ~UnpooledI420Buffer() override { storage_->ReleaseBuffer(); }
+
+ private:
+  const rtc::scoped_refptr<Storage> storage_;
+};
+
+constexpr size_t I420BufferPool::kMaxPooledBuffers;
+constexpr int64_t I420BufferPool::kMaxIdleTimeMs;
 
 I420BufferPool::I420BufferPool() : I420BufferPool(false) {}
 I420BufferPool::I420BufferPool(bool zero_initialize)
     : I420BufferPool(zero_initialize, std::numeric_limits<size_t>::max()) {}
 I420BufferPool::I420BufferPool(bool zero_initialize,
                                size_t max_number_of_buffers)
+    : I420BufferPool(zero_initialize,
+                     max_number_of_buffers,
+                     std::numeric_limits<size_t>::max()) {}
+I420BufferPool::I420BufferPool(bool zero_initialize,
+                               size_t max_number_of_buffers,
+                               size_t max_allocated_bytes)
     : zero_initialize_(zero_initialize),
-      max_number_of_buffers_(max_number_of_buffers) {}
+      max_number_of_buffers_(max_number_of_buffers),
+      storage_(new rtc::RefCountedObject<Storage>(
+          std::min(max_number_of_buffers, kMaxPooledBuffers),
+          max_allocated_bytes,
+          zero_initialize,
+          kMaxIdleTimeMs,
+          kTrimIntervalMs)) {}
 I420BufferPool::~I420BufferPool() = default;
 
 void I420BufferPool::Release() {
-  buffers_.clear();
+  storage_->FreeIdleBlocks(rtc::TimeMillis(), 0);
+}
+
+I420BufferPool::Stats I420BufferPool::GetStats() const {
+  return storage_->GetStats();
 }
 
 rtc::scoped_refptr<I420Buffer> I420BufferPool::CreateBuffer(int width,
@@ -40,36 +117,38 @@ rtc::scoped_refptr<I420Buffer> I420BufferPool::CreateBuffer(int width,
                                                             int stride_y,
                                                             int stride_u,
                                                             int stride_v) {
-  RTC_DCHECK_RUNS_SERIALIZED(&race_checker_);
-  // Release buffers with wrong resolution.
-  for (auto it = buffers_.begin(); it != buffers_.end();) {
-    const auto& buffer = *it;
-    if (buffer->width() != width || buffer->height() != height ||
-        buffer->StrideY() != stride_y || buffer->StrideU() != stride_u ||
-        buffer->StrideV() != stride_v) {
-      it = buffers_.erase(it);
-    } else {
-      ++it;
-    }
-  }
-  // Look for a free buffer.
-  for (const rtc::scoped_refptr<PooledI420Buffer>& buffer : buffers_) {
-    // If the buffer is in use, the ref count will be >= 2, one from the list we
-    // are looping over and one from the application. If the ref count is 1,
-    // then the list we are looping over holds the only reference and it's safe
-    // to reuse.
-    if (buffer->HasOneRef())
-      return buffer;
+  if (!storage_->ReserveBuffer(max_number_of_buffers_)) {
+    storage_->CountFailure();
+    return nullptr;
   }
 
-  if (buffers_.size() >= max_number_of_buffers_)
-    return nullptr;
-  // Allocate new buffer.
-  rtc::scoped_refptr<PooledI420Buffer> buffer =
-      new PooledI420Buffer(width, height, stride_y, stride_u, stride_v);
+  const int size_class = Storage::SizeClassForBytes(
+      static_cast<size_t>(stride_y) * height +
+      static_cast<size_t>(stride_u + stride_v) * ((height + 1) / 2));
+  if (size_class < Storage::kNumSizeClasses) {
+    uint32_t index;
+    switch (storage_->Acquire(size_class, &index)) {
+      case Storage::Result::kAcquired:
+        return new rtc::RefCountedObject<PooledI420Buffer>(
+            width, height, stride_y, stride_u, stride_v, storage_, index);
+      case Storage::Result::kOutOfBlocks:
+        // All pooled buffers are in use, but the reservation above allows
+        // more.
+        break;
+      case Storage::Result::kOutOfMemory:
+        storage_->ReleaseBuffer();
+        storage_->CountFailure();
+        return nullptr;
+    }
+  } else {
+    storage_->CountMiss();
+  }
+  // Allocate a buffer outside of the pool.
+  rtc::scoped_refptr<I420Buffer> buffer(
+      new rtc::RefCountedObject<UnpooledI420Buffer>(
+          width, height, stride_y, stride_u, stride_v, storage_));
   if (zero_initialize_)
     buffer->InitializeData();
-  buffers_.push_back(buffer);
   return buffer;
 }
 
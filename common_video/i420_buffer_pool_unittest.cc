@@ -13,10 +13,21 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
 #include "api/scoped_refptr.h"
+#include "api/task_queue/default_task_queue_factory.h"
+#include "api/units/time_delta.h"
 #include "api/video/i420_buffer.h"
 #include "api/video/video_frame_buffer.h"
+#include "rtc_base/event.h"
+#include "rtc_base/fake_clock.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "rtc_base/time_utils.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 
@@ -88,6 +99,8 @@ TEST(TestI420BufferPool, FailToReuseWrongStride) {
   // Make sure the stride was read correctly, for the rest of the test.
   ASSERT_EQ(16, buffer->StrideU());
   ASSERT_EQ(16, buffer->StrideV());
+  // Release buffer so that it is returned to the pool.
+  buffer = nullptr;
   buffer = pool.CreateBuffer(32, 32, 32, 20, 20);
   ASSERT_TRUE(buffer);
   EXPECT_EQ(32, buffer->StrideY());
@@ -114,4 +127,174 @@ TEST(TestI420BufferPool, MaxNumberOfBuffers) {
   EXPECT_EQ(nullptr, pool.CreateBuffer(16, 16).get());
 }
 
+TEST(TestI420BufferPool, ReusesMemoryForSmallerResolution) {
+  I420BufferPool pool;
+  auto buffer = pool.CreateBuffer(64, 64);
+  const uint8_t* y_ptr = buffer->DataY();
+  buffer = nullptr;
+  buffer = pool.CreateBuffer(60, 62);
+  EXPECT_EQ(60, buffer->width());
+  EXPECT_EQ(62, buffer->height());
+  EXPECT_EQ(y_ptr, buffer->DataY());
+
+  I420BufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(1u, stats.num_hits);
+  EXPECT_EQ(1u, stats.num_misses);
+  EXPECT_DOUBLE_EQ(0.5, stats.hit_rate());
+  EXPECT_EQ(1u, stats.num_buffers);
+  EXPECT_EQ(1u, stats.num_buffers_in_use);
+}
+
+TEST(TestI420BufferPool, DoesNotReuseMuchLargerMemory) {
+  I420BufferPool pool;
+  auto buffer = pool.CreateBuffer(640, 480);
+  const uint8_t* y_ptr = buffer->DataY();
+  buffer = nullptr;
+  buffer = pool.CreateBuffer(320, 240);
+  EXPECT_NE(y_ptr, buffer->DataY());
+  EXPECT_EQ(0u, pool.GetStats().num_hits);
+  EXPECT_EQ(2u, pool.GetStats().num_buffers);
+}
+
+TEST(TestI420BufferPool, FreesFreeBuffersToStayWithinMaxAllocatedBytes) {
+  // Room for two 16x16 buffers and a 64x64 buffer, but not for all three.
+  I420BufferPool pool(/*zero_initialize=*/false, 10, 3 * 4096);
+  auto small_buffer1 = pool.CreateBuffer(16, 16);
+  auto small_buffer2 = pool.CreateBuffer(16, 16);
+  small_buffer2 = nullptr;
+
+  auto large_buffer1 = pool.CreateBuffer(64, 64);
+  ASSERT_TRUE(large_buffer1);
+  I420BufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(2u, stats.num_buffers);
+  EXPECT_EQ(stats.in_use_bytes, stats.allocated_bytes);
+  EXPECT_LE(stats.allocated_bytes, 3u * 4096);
+
+  // Nothing left to free.
+  EXPECT_EQ(nullptr, pool.CreateBuffer(64, 64).get());
+  EXPECT_EQ(stats.allocated_bytes, pool.GetStats().allocated_bytes);
+}
+
+TEST(TestI420BufferPool, FreesIdleBuffers) {
+  rtc::ScopedFakeClock clock;
+  clock.AdvanceTime(TimeDelta::seconds(1));
+  I420BufferPool pool;
+  auto small_buffer = pool.CreateBuffer(16, 16);
+  auto large_buffer = pool.CreateBuffer(640, 480);
+  small_buffer = nullptr;
+
+  clock.AdvanceTime(TimeDelta::ms(I420BufferPool::kMaxIdleTimeMs - 1));
+  large_buffer = nullptr;
+  large_buffer = pool.CreateBuffer(640, 480);
+  EXPECT_EQ(2u, pool.GetStats().num_buffers);
+
+  // Now the small buffer has been idle for longer than kMaxIdleTimeMs.
+  clock.AdvanceTime(TimeDelta::seconds(1));
+  large_buffer = nullptr;
+  large_buffer = pool.CreateBuffer(640, 480);
+  I420BufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(1u, stats.num_buffers);
+  EXPECT_EQ(stats.in_use_bytes, stats.allocated_bytes);
+}
+
+TEST(TestI420BufferPool, ReleaseFreesBuffersNotInUse) {
+  I420BufferPool pool;
+  auto buffer1 = pool.CreateBuffer(16, 16);
+  auto buffer2 = pool.CreateBuffer(16, 16);
+  buffer2 = nullptr;
+  pool.Release();
+  EXPECT_EQ(1u, pool.GetStats().num_buffers);
+
+  // Buffers in use are still returned to the pool.
+  buffer1 = nullptr;
+  buffer1 = pool.CreateBuffer(16, 16);
+  EXPECT_EQ(1u, pool.GetStats().num_hits);
+}
+
+TEST(TestI420BufferPool, AllocatesOutsidePoolBeyondMaxPooledBuffers) {
+  I420BufferPool pool;
+  std::vector<rtc::scoped_refptr<I420Buffer>> buffers;
+  for (size_t i = 0; i < I420BufferPool::kMaxPooledBuffers + 1; ++i) {
+    buffers.push_back(pool.CreateBuffer(16, 16));
+    ASSERT_TRUE(buffers.back());
+  }
+  EXPECT_EQ(I420BufferPool::kMaxPooledBuffers, pool.GetStats().num_buffers);
+}
+
+TEST(TestI420BufferPool, MaxNumberOfBuffersBeyondMaxPooledBuffers) {
+  const size_t kMaxNumberOfBuffers = I420BufferPool::kMaxPooledBuffers + 44;
+  I420BufferPool pool(false, kMaxNumberOfBuffers);
+  std::vector<rtc::scoped_refptr<I420Buffer>> buffers;
+  for (size_t i = 0; i < kMaxNumberOfBuffers; ++i) {
+    buffers.push_back(pool.CreateBuffer(16, 16));
+    ASSERT_TRUE(buffers.back());
+  }
+  EXPECT_EQ(nullptr, pool.CreateBuffer(16, 16).get());
+
+  // Releasing a buffer allocated outside of the pool allows a new one.
+  buffers.pop_back();
+  EXPECT_NE(nullptr, pool.CreateBuffer(16, 16).get());
+}
+
+TEST(TestI420BufferPool, CanBeSharedBetweenThreads) {
+  constexpr int kNumThreads = 4;
+  constexpr int kNumBuffersPerThread = 1000;
+  std::unique_ptr<TaskQueueFactory> task_queue_factory =
+      CreateDefaultTaskQueueFactory();
+  I420BufferPool pool(/*zero_initialize=*/false, 8);
+  std::vector<std::unique_ptr<TaskQueueBase, TaskQueueDeleter>> task_queues;
+  std::vector<std::unique_ptr<rtc::Event>> done;
+  for (int i = 0; i < kNumThreads; ++i) {
+    task_queues.push_back(task_queue_factory->CreateTaskQueue(
+        "BufferUser", TaskQueueFactory::Priority::NORMAL));
+    done.push_back(absl::make_unique<rtc::Event>());
+    task_queues.back()->PostTask(ToQueuedTask([&pool, &done, i] {
+      for (int j = 0; j < kNumBuffersPerThread; ++j) {
+        // At most two buffers per thread are in use at the same time.
+        auto buffer1 = pool.CreateBuffer(32 + 2 * (j % 3), 32);
+        auto buffer2 = pool.CreateBuffer(64, 32 + 2 * (j % 5));
+        ASSERT_TRUE(buffer1);
+        ASSERT_TRUE(buffer2);
+        memset(buffer1->MutableDataY(), i, buffer1->StrideY());
+        memset(buffer2->MutableDataY(), i, buffer2->StrideY());
+        EXPECT_EQ(i, buffer1->DataY()[0]);
+        EXPECT_EQ(i, buffer2->DataY()[0]);
+      }
+      done[i]->Set();
+    }));
+  }
+  for (const auto& event : done)
+    EXPECT_TRUE(event->Wait(30000));
+
+  I420BufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(2u * kNumThreads * kNumBuffersPerThread,
+            stats.num_hits + stats.num_misses);
+  EXPECT_EQ(0u, stats.num_buffers_in_use);
+  EXPECT_EQ(0u, stats.in_use_bytes);
+  EXPECT_LE(stats.num_buffers, 8u);
+}
+
+TEST(TestI420BufferPool, DISABLED_ChangingResolutionPerf) {
+  constexpr int kNumFrames = 10000;
+  // Resolutions stepped through by e.g. quality scaling of a 720p stream.
+  const int kResolutions[][2] = {{1280, 720}, {960, 540}, {640, 360}};
+  I420BufferPool pool;
+  const int64_t start_time_us = rtc::TimeMicros();
+  for (int i = 0; i < kNumFrames; ++i) {
+    const int* resolution = kResolutions[(i / 100) % 3];
+    rtc::scoped_refptr<I420Buffer> buffer =
+        pool.CreateBuffer(resolution[0], resolution[1]);
+    buffer->MutableDataY()[0] = 0;
+  }
+  const int64_t total_time_us = rtc::TimeMicros() - start_time_us;
+  I420BufferPool::Stats stats = pool.GetStats();
+  webrtc::test::PrintResult(
+      "i420_buffer_pool", "", "create_buffer_time",
+      static_cast<double>(total_time_us) / kNumFrames, "us", false);
+  webrtc::test::PrintResult("i420_buffer_pool", "", "hit_rate",
+                            stats.hit_rate(), "unitless", false);
+  webrtc::test::PrintResult("i420_buffer_pool", "", "allocated_bytes",
+                            stats.allocated_bytes, "bytes", false);
+}
+
 }  // namespace webrtc
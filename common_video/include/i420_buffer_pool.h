@@ -12,33 +12,51 @@
 #define COMMON_VIDEO_INCLUDE_I420_BUFFER_POOL_H_
 
 #include <stddef.h>
-
-#include <list>
+#include <stdint.h>
 
 #include "api/scoped_refptr.h"
 #include "api/video/i420_buffer.h"
-#include "rtc_base/race_checker.h"
-#include "rtc_base/ref_counted_object.h"
+#include "common_video/include/size_class_block_pool.h"
 
 namespace webrtc {
 
-// Simple buffer pool to avoid unnecessary allocations of I420Buffer objects.
+// Buffer pool to avoid unnecessary allocations of I420Buffer memory.
 // The pool manages the memory of the I420Buffer returned from CreateBuffer.
 // When the I420Buffer is destructed, the memory is returned to the pool for use
-// by subsequent calls to CreateBuffer. If the resolution passed to CreateBuffer
-// changes, old buffers will be purged from the pool.
-// Note that CreateBuffer will crash if more than kMaxNumberOfFramesBeforeCrash
-// are created. This is to prevent memory leaks where frames are not returned.
+// by subsequent calls to CreateBuffer.
+//
+// Memory blocks are allocated in size classes, roughly four per doubling of
+// the size, and a block is reused for any resolution and stride that fits in
+// it, so that resolution changes, e.g. by quality scaling, don't require new
+// allocations. Blocks that have been idle for a while are freed, and so are
+// idle blocks when needed to stay within |max_allocated_bytes|.
+//
+// Acquiring and returning memory is lock-free, so one pool can be shared by
+// e.g. a decoder and a scaler running on different threads. All methods are
+// thread safe.
 class I420BufferPool {
  public:
+  // Pools never keep more buffers than this. Pools that allow more buffers
+  // allocate the excess ones outside of the pool, but still count them against
+  // |max_number_of_buffers|.
+  static constexpr size_t kMaxPooledBuffers = 256;
+  // Free buffers not used for this long are released.
+  static constexpr int64_t kMaxIdleTimeMs = 5000;
+
+  using Stats = SizeClassBlockPool::Stats;
+
   I420BufferPool();
   explicit I420BufferPool(bool zero_initialize);
   I420BufferPool(bool zero_initialze, size_t max_number_of_buffers);
+  I420BufferPool(bool zero_initialze,
+                 size_t max_number_of_buffers,
+                 size_t max_allocated_bytes);
   ~I420BufferPool();
 
   // Returns a buffer from the pool. If no suitable buffer exist in the pool
   // and there are less than |max_number_of_buffers| pending, a buffer is
-  // created. Returns null otherwise.
+  // created. Returns null otherwise, or if creating the buffer would make the
+  // pool exceed |max_allocated_bytes|.
   rtc::scoped_refptr<I420Buffer> CreateBuffer(int width, int height);
 
   // Returns a buffer from the pool with the explicitly specified stride.
@@ -48,17 +66,17 @@ class I420BufferPool {
                                               int stride_u,
                                               int stride_v);
 
-  // Clears buffers_ and detaches the thread checker so that it can be reused
-  // later from another thread.
+  // Frees the memory of all buffers not in use. Buffers in use are returned to
+  // the pool when they are destroyed.
   void Release();
 
+  Stats GetStats() const;
+
  private:
-  // Explicitly use a RefCountedObject to get access to HasOneRef,
-  // needed by the pool to check exclusive access.
-  using PooledI420Buffer = rtc::RefCountedObject<I420Buffer>;
+  using Storage = SizeClassBlockPool;
+  class PooledI420Buffer;
+  class UnpooledI420Buffer;
 
-  rtc::RaceChecker race_checker_;
-  std::list<rtc::scoped_refptr<PooledI420Buffer>> buffers_;
   // If true, newly allocated buffers are zero-initialized. Note that recycled
   // buffers are not zero'd before reuse. This is required of buffers used by
   // FFmpeg according to http://crbug.com/390941, which only requires it for the
@@ -67,6 +85,7 @@ class I420BufferPool {
   const bool zero_initialize_;
   // Max number of buffers this pool can have pending.
   const size_t max_number_of_buffers_;
+  const rtc::scoped_refptr<Storage> storage_;
 };
 
 }  // namespace webrtc
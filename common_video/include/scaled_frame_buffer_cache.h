@@ -0,0 +1,88 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef COMMON_VIDEO_INCLUDE_SCALED_FRAME_BUFFER_CACHE_H_
+#define COMMON_VIDEO_INCLUDE_SCALED_FRAME_BUFFER_CACHE_H_
+
+#include <vector>
+
+#include "api/scoped_refptr.h"
+#include "api/task_queue/task_queue_base.h"
+#include "api/video/video_frame_buffer.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/ref_count.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+// Scales a single frame buffer to several resolutions, computing each of them
+// at most once. Consumers that need the same frame in different resolutions,
+// e.g. the layers of a simulcast encoder, should share one cache per frame.
+//
+// Exact halvings of the source are kept as a pyramid: a resolution is scaled
+// from the smallest pyramid level or cached buffer that is at least as large,
+// so that e.g. a quarter resolution layer is made from the half resolution
+// one instead of from the full frame. Halvings of large frames are split into
+// horizontal bands that are scaled in parallel on |scaling_queues| and the
+// calling thread. Since each band is an exact 2:1 downscale of its own rows,
+// the result is identical to scaling on one thread.
+//
+// All methods are thread safe.
+class ScaledFrameBufferCache : public rtc::RefCountInterface {
+ public:
+  // Frames with fewer pixels than this are always scaled on the calling
+  // thread.
+  static constexpr int kMinPixelsForParallelScaling = 1920 * 1080;
+
+  // |scaling_queues| must outlive the cache and must not include the task
+  // queue calling GetScaledI420().
+  static rtc::scoped_refptr<ScaledFrameBufferCache> Create(
+      rtc::scoped_refptr<VideoFrameBuffer> source,
+      std::vector<TaskQueueBase*> scaling_queues);
+  static rtc::scoped_refptr<ScaledFrameBufferCache> Create(
+      rtc::scoped_refptr<VideoFrameBuffer> source);
+
+  // Returns the source converted to I420 and scaled to |width|x|height|.
+  // Returns null if the source can't be converted to I420.
+  rtc::scoped_refptr<I420BufferInterface> GetScaledI420(int width, int height);
+
+  // Number of buffers scaled so far, including pyramid levels.
+  int num_scaled_buffers() const;
+
+ protected:
+  ScaledFrameBufferCache(rtc::scoped_refptr<VideoFrameBuffer> source,
+                         std::vector<TaskQueueBase*> scaling_queues);
+  ~ScaledFrameBufferCache() override;
+
+ private:
+  // Returns the cached buffer of |width|x|height|, or null.
+  rtc::scoped_refptr<I420BufferInterface> FindBuffer(int width, int height)
+      const RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  // Returns the smallest buffer that is at least |width|x|height|.
+  rtc::scoped_refptr<I420BufferInterface> FindSmallestBufferAtLeast(
+      int width,
+      int height) const RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  rtc::scoped_refptr<I420BufferInterface> Halve(
+      const I420BufferInterface& buffer) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  const rtc::scoped_refptr<VideoFrameBuffer> source_;
+  const std::vector<TaskQueueBase*> scaling_queues_;
+
+  rtc::CriticalSection crit_;
+  bool source_converted_ RTC_GUARDED_BY(crit_) = false;
+  // The I420 source followed by the buffers scaled from it.
+  std::vector<rtc::scoped_refptr<I420BufferInterface>> buffers_
+      RTC_GUARDED_BY(crit_);
+  int num_scaled_buffers_ RTC_GUARDED_BY(crit_) = 0;
+};
+
+}  // namespace webrtc
+
+#endif  // COMMON_VIDEO_INCLUDE_SCALED_FRAME_BUFFER_CACHE_H_
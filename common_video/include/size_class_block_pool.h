@@ -0,0 +1,165 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef COMMON_VIDEO_INCLUDE_SIZE_CLASS_BLOCK_POOL_H_
+#define COMMON_VIDEO_INCLUDE_SIZE_CLASS_BLOCK_POOL_H_
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include <atomic>
+#include <memory>
+
+#include "rtc_base/memory/aligned_malloc.h"
+#include "rtc_base/ref_count.h"
+
+namespace webrtc {
+
+// Memory blocks for buffer pools, e.g. I420BufferPool and Vp9FrameBufferPool.
+//
+// Blocks are allocated in size classes, roughly four per doubling of the size,
+// and a free block is reused for any request that fits in it and is at least
+// half its size, so that resolution changes don't require new allocations.
+// Free blocks that have been idle for |max_idle_time_ms| are freed, and so are
+// free blocks when needed to stay within the max number of blocks and
+// |max_allocated_bytes|.
+//
+// The pool is reference counted so that buffers can return their blocks after
+// the owning buffer pool is destroyed. Acquiring and returning blocks is
+// lock-free. All methods are thread safe.
+class SizeClassBlockPool : public rtc::RefCountInterface {
+ public:
+  static constexpr int kNumSizeClasses = 64;
+
+  struct Stats {
+    double hit_rate() const {
+      return num_hits + num_misses > 0
+                 ? static_cast<double>(num_hits) / (num_hits + num_misses)
+                 : 0.0;
+    }
+
+    // Number of buffers created with recycled and with new memory, and the
+    // number of requests that failed because the pool was full.
+    uint64_t num_hits = 0;
+    uint64_t num_misses = 0;
+    uint64_t num_failures = 0;
+    // Number of memory blocks held by the pool, and how many of them are in
+    // use by buffers.
+    size_t num_buffers = 0;
+    size_t num_buffers_in_use = 0;
+    // Total size of the memory blocks held by the pool, of those in use, and
+    // the largest total size the pool has held.
+    size_t allocated_bytes = 0;
+    size_t in_use_bytes = 0;
+    size_t peak_allocated_bytes = 0;
+  };
+
+  enum class Result { kAcquired, kOutOfBlocks, kOutOfMemory };
+
+  // Returns the size of the blocks in |size_class|.
+  static size_t SizeClassBytes(int size_class);
+  // Returns the smallest size class with room for |bytes|, or kNumSizeClasses
+  // if |bytes| is larger than the largest size class.
+  static int SizeClassForBytes(size_t bytes);
+
+  SizeClassBlockPool(size_t max_number_of_blocks,
+                     size_t max_allocated_bytes,
+                     bool zero_initialize,
+                     int64_t max_idle_time_ms,
+                     int64_t trim_interval_ms);
+
+  // Finds a free block in |size_class| or a few classes above, or allocates
+  // one, and returns its index in |index|. Fails with kOutOfBlocks if all
+  // blocks are in use, or with kOutOfMemory if the block would make the pool
+  // exceed |max_allocated_bytes|.
+  Result Acquire(int size_class, uint32_t* index);
+  // Gives back a block obtained from Acquire().
+  void Return(uint32_t index);
+
+  uint8_t* data(uint32_t index) const { return blocks_[index].data.get(); }
+  size_t block_bytes(uint32_t index) const { return blocks_[index].bytes; }
+
+  // Reserves one of |max_number_of_buffers| buffers the owner may have
+  // pending, whether they use a block or are allocated outside of the pool.
+  // Fails if all of them are pending.
+  bool ReserveBuffer(size_t max_number_of_buffers);
+  void ReleaseBuffer();
+
+  // Frees the free blocks that have been idle for at least |max_idle_time_ms|.
+  void FreeIdleBlocks(int64_t now_ms, int64_t max_idle_time_ms);
+
+  // Counts requests that the owner served outside of the pool, or failed.
+  void CountMiss() { ++num_misses_; }
+  void CountFailure() { ++num_failures_; }
+
+  Stats GetStats() const;
+
+ protected:
+  ~SizeClassBlockPool() override;
+
+ private:
+  struct Block {
+    std::unique_ptr<uint8_t, AlignedFreeDeleter> data;
+    size_t bytes = 0;
+    int size_class = 0;
+    int64_t release_time_ms = 0;
+  };
+
+  // Lock-free LIFO of indices into |links_|. The head packs the top index,
+  // offset by one so that zero means empty, with a counter that is
+  // incremented on every update to avoid the ABA problem.
+  class IndexStack {
+   public:
+    void Push(std::atomic<uint32_t>* links, uint32_t index);
+    bool Pop(std::atomic<uint32_t>* links, uint32_t* index);
+    // Empties the stack and returns its old top, offset by one. The caller
+    // owns the popped indices and may walk them through |links|.
+    uint32_t PopAll();
+
+   private:
+    static uint64_t NextHead(uint64_t head, uint32_t top);
+
+    std::atomic<uint64_t> head_{0};
+  };
+
+  void OnAcquired(uint32_t index);
+  void MaybeTrim(int64_t now_ms);
+  // Frees a free block, starting with the largest size class, and returns its
+  // now unused index.
+  bool FreeIdleBlock(uint32_t* index);
+  void FreeBlock(uint32_t index);
+
+  const size_t num_blocks_;
+  const size_t max_allocated_bytes_;
+  const bool zero_initialize_;
+  const int64_t max_idle_time_ms_;
+  const int64_t trim_interval_ms_;
+  const std::unique_ptr<Block[]> blocks_;
+  const std::unique_ptr<std::atomic<uint32_t>[]> links_;
+  // Indices of blocks without memory.
+  IndexStack unused_blocks_;
+  // Indices of blocks with memory not used by any buffer, per size class.
+  IndexStack free_blocks_[kNumSizeClasses];
+  std::atomic<int64_t> next_trim_time_ms_{0};
+
+  std::atomic<uint64_t> num_hits_{0};
+  std::atomic<uint64_t> num_misses_{0};
+  std::atomic<uint64_t> num_failures_{0};
+  std::atomic<size_t> num_allocated_blocks_{0};
+  std::atomic<size_t> num_blocks_in_use_{0};
+  std::atomic<size_t> allocated_bytes_{0};
+  std::atomic<size_t> in_use_bytes_{0};
+  std::atomic<size_t> peak_allocated_bytes_{0};
+  std::atomic<size_t> num_pending_buffers_{0};
+};
+
+}  // namespace webrtc
+
+#endif  // COMMON_VIDEO_INCLUDE_SIZE_CLASS_BLOCK_POOL_H_
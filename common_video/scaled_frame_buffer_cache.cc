@@ -0,0 +1,202 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "common_video/include/scaled_frame_buffer_cache.h"
+
+#include <algorithm>
+#include <utility>
+
+#include "api/video/i420_buffer.h"
+#include "rtc_base/atomic_ops.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/event.h"
+#include "rtc_base/ref_counted_object.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "third_party/libyuv/include/libyuv/scale.h"
+
+namespace webrtc {
+namespace {
+
+// Downscales rows [first_row, last_row) of |dst| 2:1 from the corresponding
+// rows of |src|. The width and height of |src| must be multiples of 4, and
+// |first_row| and |last_row| even, so that the rows of all planes are exact
+// 2:1 downscales of their own.
+void HalveRows(const I420BufferInterface& src,
+               I420Buffer* dst,
+               int first_row,
+               int last_row) {
+  const int num_rows = last_row - first_row;
+  libyuv::ScalePlane(src.DataY() + 2 * first_row * src.StrideY(),
+                     src.StrideY(), src.width(), 2 * num_rows,
+                     dst->MutableDataY() + first_row * dst->StrideY(),
+                     dst->StrideY(), dst->width(), num_rows,
+                     libyuv::kFilterBox);
+  const int first_chroma_row = first_row / 2;
+  const int num_chroma_rows = num_rows / 2;
+  libyuv::ScalePlane(src.DataU() + 2 * first_chroma_row * src.StrideU(),
+                     src.StrideU(), src.ChromaWidth(), 2 * num_chroma_rows,
+                     dst->MutableDataU() + first_chroma_row * dst->StrideU(),
+                     dst->StrideU(), dst->ChromaWidth(), num_chroma_rows,
+                     libyuv::kFilterBox);
+  libyuv::ScalePlane(src.DataV() + 2 * first_chroma_row * src.StrideV(),
+                     src.StrideV(), src.ChromaWidth(), 2 * num_chroma_rows,
+                     dst->MutableDataV() + first_chroma_row * dst->StrideV(),
+                     dst->StrideV(), dst->ChromaWidth(), num_chroma_rows,
+                     libyuv::kFilterBox);
+}
+
+}  // namespace
+
+constexpr int ScaledFrameBufferCache::kMinPixelsForParallelScaling;
+
+// static
+rtc::scoped_refptr<ScaledFrameBufferCache> ScaledFrameBufferCache::Create(
+    rtc::scoped_refptr<VideoFrameBuffer> source,
+    std::vector<TaskQueueBase*> scaling_queues) {
+  return new rtc::RefCountedObject<ScaledFrameBufferCache>(
+      std::move(source), std::move(scaling_queues));
+}
+
+// static
+rtc::scoped_refptr<ScaledFrameBufferCache> ScaledFrameBufferCache::Create(
+    rtc::scoped_refptr<VideoFrameBuffer> source) {
+  return Create(std::move(source), std::vector<TaskQueueBase*>());
+}
+
+ScaledFrameBufferCache::ScaledFrameBufferCache(
+    rtc::scoped_refptr<VideoFrameBuffer> source,
+    std::vector<TaskQueueBase*> scaling_queues)
+    : source_(std::move(source)), scaling_queues_(std::move(scaling_queues)) {
+  RTC_DCHECK(source_);
+}
+
+ScaledFrameBufferCache::~ScaledFrameBufferCache() = default;
+
+rtc::scoped_refptr<I420BufferInterface> ScaledFrameBufferCache::GetScaledI420(
+    int width,
+    int height) {
+  RTC_DCHECK_GT(width, 0);
+  RTC_DCHECK_GT(height, 0);
+  rtc::CritScope lock(&crit_);
+  if (!source_converted_) {
+    source_converted_ = true;
+    rtc::scoped_refptr<I420BufferInterface> source_i420 = source_->ToI420();
+    if (source_i420)
+      buffers_.push_back(source_i420);
+  }
+  if (buffers_.empty())
+    return nullptr;
+
+  rtc::scoped_refptr<I420BufferInterface> buffer = FindBuffer(width, height);
+  if (buffer)
+    return buffer;
+
+  // Upscaling is done from the source.
+  buffer = FindSmallestBufferAtLeast(width, height);
+  if (!buffer)
+    buffer = buffers_.front();
+
+  // Walk down the pyramid as far as possible.
+  while (buffer->width() % 2 == 0 && buffer->height() % 2 == 0 &&
+         buffer->width() / 2 >= width && buffer->height() / 2 >= height) {
+    rtc::scoped_refptr<I420BufferInterface> half =
+        FindBuffer(buffer->width() / 2, buffer->height() / 2);
+    buffer = half ? half : Halve(*buffer);
+  }
+  if (buffer->width() == width && buffer->height() == height)
+    return buffer;
+
+  rtc::scoped_refptr<I420Buffer> scaled = I420Buffer::Create(width, height);
+  libyuv::I420Scale(buffer->DataY(), buffer->StrideY(), buffer->DataU(),
+                    buffer->StrideU(), buffer->DataV(), buffer->StrideV(),
+                    buffer->width(), buffer->height(), scaled->MutableDataY(),
+                    scaled->StrideY(), scaled->MutableDataU(),
+                    scaled->StrideU(), scaled->MutableDataV(),
+                    scaled->StrideV(), width, height,
+                    libyuv::kFilterBilinear);
+  ++num_scaled_buffers_;
+  buffers_.push_back(scaled);
+  return scaled;
+}
+
+int ScaledFrameBufferCache::num_scaled_buffers() const {
+  rtc::CritScope lock(&crit_);
+  return num_scaled_buffers_;
+}
+
+rtc::scoped_refptr<I420BufferInterface> ScaledFrameBufferCache::FindBuffer(
+    int width,
+    int height) const {
+  for (const auto& buffer : buffers_) {
+    if (buffer->width() == width && buffer->height() == height)
+      return buffer;
+  }
+  return nullptr;
+}
+
+rtc::scoped_refptr<I420BufferInterface>
+ScaledFrameBufferCache::FindSmallestBufferAtLeast(int width,
+                                                  int height) const {
+  rtc::scoped_refptr<I420BufferInterface> smallest;
+  for (const auto& buffer : buffers_) {
+    if (buffer->width() >= width && buffer->height() >= height &&
+        (!smallest || buffer->width() * buffer->height() <
+                          smallest->width() * smallest->height())) {
+      smallest = buffer;
+    }
+  }
+  return smallest;
+}
+
+rtc::scoped_refptr<I420BufferInterface> ScaledFrameBufferCache::Halve(
+    const I420BufferInterface& buffer) {
+  rtc::scoped_refptr<I420Buffer> half =
+      I420Buffer::Create(buffer.width() / 2, buffer.height() / 2);
+  const bool split_into_bands =
+      !scaling_queues_.empty() &&
+      buffer.width() * buffer.height() >= kMinPixelsForParallelScaling &&
+      buffer.width() % 4 == 0 && buffer.height() % 4 == 0;
+  if (!split_into_bands) {
+    libyuv::I420Scale(buffer.DataY(), buffer.StrideY(), buffer.DataU(),
+                      buffer.StrideU(), buffer.DataV(), buffer.StrideV(),
+                      buffer.width(), buffer.height(), half->MutableDataY(),
+                      half->StrideY(), half->MutableDataU(), half->StrideU(),
+                      half->MutableDataV(), half->StrideV(), half->width(),
+                      half->height(), libyuv::kFilterBox);
+  } else {
+    // One band per scaling queue, and the first one on this thread.
+    const int num_bands = static_cast<int>(scaling_queues_.size()) + 1;
+    const int rows_per_band =
+        ((half->height() + num_bands - 1) / num_bands + 1) & ~1;
+    std::vector<std::pair<int, int>> bands;
+    for (int row = 0; row < half->height(); row += rows_per_band)
+      bands.emplace_back(row, std::min(row + rows_per_band, half->height()));
+
+    rtc::Event done;
+    volatile int pending_bands = static_cast<int>(bands.size()) - 1;
+    for (size_t i = 1; i < bands.size(); ++i) {
+      const std::pair<int, int> band = bands[i];
+      scaling_queues_[i - 1]->PostTask(
+          ToQueuedTask([&buffer, &half, &done, &pending_bands, band] {
+            HalveRows(buffer, half.get(), band.first, band.second);
+            if (rtc::AtomicOps::Decrement(&pending_bands) == 0)
+              done.Set();
+          }));
+    }
+    HalveRows(buffer, half.get(), bands[0].first, bands[0].second);
+    if (bands.size() > 1)
+      done.Wait(rtc::Event::kForever);
+  }
+  ++num_scaled_buffers_;
+  buffers_.push_back(half);
+  return half;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,175 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "common_video/include/scaled_frame_buffer_cache.h"
+
+#include <string.h>
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "api/task_queue/default_task_queue_factory.h"
+#include "api/video/i420_buffer.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+using TaskQueuePtr = std::unique_ptr<TaskQueueBase, TaskQueueDeleter>;
+
+rtc::scoped_refptr<I420Buffer> CreateGradient(int width, int height) {
+  rtc::scoped_refptr<I420Buffer> buffer = I420Buffer::Create(width, height);
+  for (int y = 0; y < height; ++y) {
+    for (int x = 0; x < width; ++x)
+      buffer->MutableDataY()[y * buffer->StrideY() + x] = (x * 7 + y * 3) & 255;
+  }
+  for (int y = 0; y < buffer->ChromaHeight(); ++y) {
+    for (int x = 0; x < buffer->ChromaWidth(); ++x) {
+      buffer->MutableDataU()[y * buffer->StrideU() + x] = (x + y * 5) & 255;
+      buffer->MutableDataV()[y * buffer->StrideV() + x] = (x * 3 + y) & 255;
+    }
+  }
+  return buffer;
+}
+
+bool PlanesEqual(const uint8_t* a,
+                 int stride_a,
+                 const uint8_t* b,
+                 int stride_b,
+                 int width,
+                 int height) {
+  for (int y = 0; y < height; ++y) {
+    if (memcmp(a + y * stride_a, b + y * stride_b, width) != 0)
+      return false;
+  }
+  return true;
+}
+
+bool BuffersEqual(const I420BufferInterface& a, const I420BufferInterface& b) {
+  return a.width() == b.width() && a.height() == b.height() &&
+         PlanesEqual(a.DataY(), a.StrideY(), b.DataY(), b.StrideY(), a.width(),
+                     a.height()) &&
+         PlanesEqual(a.DataU(), a.StrideU(), b.DataU(), b.StrideU(),
+                     a.ChromaWidth(), a.ChromaHeight()) &&
+         PlanesEqual(a.DataV(), a.StrideV(), b.DataV(), b.StrideV(),
+                     a.ChromaWidth(), a.ChromaHeight());
+}
+
+std::vector<TaskQueuePtr> CreateScalingQueues(TaskQueueFactory* factory,
+                                              int num_queues) {
+  std::vector<TaskQueuePtr> task_queues;
+  for (int i = 0; i < num_queues; ++i) {
+    task_queues.push_back(factory->CreateTaskQueue(
+        "ScalingQueue", TaskQueueFactory::Priority::NORMAL));
+  }
+  return task_queues;
+}
+
+std::vector<TaskQueueBase*> GetPointers(
+    const std::vector<TaskQueuePtr>& task_queues) {
+  std::vector<TaskQueueBase*> pointers;
+  for (const TaskQueuePtr& task_queue : task_queues)
+    pointers.push_back(task_queue.get());
+  return pointers;
+}
+
+}  // namespace
+
+TEST(ScaledFrameBufferCacheTest, ReturnsSourceForSourceResolution) {
+  rtc::scoped_refptr<I420Buffer> source = CreateGradient(64, 48);
+  auto cache = ScaledFrameBufferCache::Create(source);
+  EXPECT_EQ(source.get(), cache->GetScaledI420(64, 48).get());
+  EXPECT_EQ(0, cache->num_scaled_buffers());
+}
+
+TEST(ScaledFrameBufferCacheTest, ScalesEachResolutionOnce) {
+  auto cache = ScaledFrameBufferCache::Create(CreateGradient(64, 48));
+  rtc::scoped_refptr<I420BufferInterface> scaled =
+      cache->GetScaledI420(40, 30);
+  EXPECT_EQ(40, scaled->width());
+  EXPECT_EQ(30, scaled->height());
+  EXPECT_EQ(scaled.get(), cache->GetScaledI420(40, 30).get());
+  EXPECT_EQ(1, cache->num_scaled_buffers());
+}
+
+TEST(ScaledFrameBufferCacheTest, BuildsPyramidLevelsFromEachOther) {
+  auto cache = ScaledFrameBufferCache::Create(CreateGradient(128, 72));
+  rtc::scoped_refptr<I420BufferInterface> quarter =
+      cache->GetScaledI420(32, 18);
+  EXPECT_EQ(32, quarter->width());
+  EXPECT_EQ(18, quarter->height());
+  // The half resolution level was made on the way.
+  EXPECT_EQ(2, cache->num_scaled_buffers());
+  rtc::scoped_refptr<I420BufferInterface> half = cache->GetScaledI420(64, 36);
+  EXPECT_EQ(2, cache->num_scaled_buffers());
+
+  // The quarter resolution level is a halving of the half resolution one.
+  auto half_cache = ScaledFrameBufferCache::Create(half);
+  EXPECT_TRUE(BuffersEqual(*quarter, *half_cache->GetScaledI420(32, 18)));
+}
+
+TEST(ScaledFrameBufferCacheTest, ScalesFromNearestLargerLevel) {
+  auto cache = ScaledFrameBufferCache::Create(CreateGradient(128, 72));
+  rtc::scoped_refptr<I420BufferInterface> half = cache->GetScaledI420(64, 36);
+  rtc::scoped_refptr<I420BufferInterface> scaled =
+      cache->GetScaledI420(48, 27);
+  EXPECT_EQ(2, cache->num_scaled_buffers());
+
+  auto half_cache = ScaledFrameBufferCache::Create(half);
+  EXPECT_TRUE(BuffersEqual(*scaled, *half_cache->GetScaledI420(48, 27)));
+}
+
+TEST(ScaledFrameBufferCacheTest, ParallelScalingIsBitExact) {
+  std::unique_ptr<TaskQueueFactory> task_queue_factory =
+      CreateDefaultTaskQueueFactory();
+  std::vector<TaskQueuePtr> scaling_queues =
+      CreateScalingQueues(task_queue_factory.get(), 3);
+  rtc::scoped_refptr<I420Buffer> source = CreateGradient(1920, 1080);
+  auto parallel_cache =
+      ScaledFrameBufferCache::Create(source, GetPointers(scaling_queues));
+  auto cache = ScaledFrameBufferCache::Create(source);
+
+  EXPECT_TRUE(BuffersEqual(*cache->GetScaledI420(960, 540),
+                           *parallel_cache->GetScaledI420(960, 540)));
+  EXPECT_TRUE(BuffersEqual(*cache->GetScaledI420(320, 180),
+                           *parallel_cache->GetScaledI420(320, 180)));
+}
+
+TEST(ScaledFrameBufferCacheTest, DISABLED_Scale4kPerf) {
+  constexpr int kNumFrames = 100;
+  std::unique_ptr<TaskQueueFactory> task_queue_factory =
+      CreateDefaultTaskQueueFactory();
+  std::vector<TaskQueuePtr> scaling_queues =
+      CreateScalingQueues(task_queue_factory.get(), 3);
+  rtc::scoped_refptr<I420Buffer> source = CreateGradient(3840, 2160);
+
+  for (size_t num_queues : {0, 1, 3}) {
+    std::vector<TaskQueueBase*> queues = GetPointers(scaling_queues);
+    queues.resize(num_queues);
+    int64_t total_time_us = 0;
+    for (int i = 0; i < kNumFrames; ++i) {
+      auto cache = ScaledFrameBufferCache::Create(source, queues);
+      const int64_t start_time_us = rtc::TimeMicros();
+      // Typical simulcast layers of a 4K stream.
+      cache->GetScaledI420(1920, 1080);
+      cache->GetScaledI420(960, 540);
+      total_time_us += rtc::TimeMicros() - start_time_us;
+    }
+    webrtc::test::PrintResult(
+        "scaled_frame_buffer_cache", "_" + std::to_string(num_queues + 1),
+        "4k_to_1080p_540p", static_cast<double>(total_time_us) / kNumFrames,
+        "us", false);
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,246 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "common_video/include/size_class_block_pool.h"
+
+#include <string.h>
+
+#include <algorithm>
+#include <vector>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/time_utils.h"
+
+namespace webrtc {
+namespace {
+
+// Same alignment as I420Buffer uses for its own memory.
+constexpr size_t kBufferAlignment = 64;
+// Size classes start at kMinBlockBytes and come in four steps per doubling,
+// so at most 25% of a new block is unused.
+constexpr size_t kMinBlockBytes = 4096;
+// Free blocks are reused for buffers up to this many size classes smaller,
+// i.e. down to half their size.
+constexpr int kMaxSizeClassesAbove = 4;
+
+}  // namespace
+
+constexpr int SizeClassBlockPool::kNumSizeClasses;
+
+size_t SizeClassBlockPool::SizeClassBytes(int size_class) {
+  return (kMinBlockBytes << (size_class / 4)) / 4 * (4 + size_class % 4);
+}
+
+int SizeClassBlockPool::SizeClassForBytes(size_t bytes) {
+  int size_class = 0;
+  while (size_class < kNumSizeClasses && SizeClassBytes(size_class) < bytes)
+    ++size_class;
+  return size_class;
+}
+
+void SizeClassBlockPool::IndexStack::Push(std::atomic<uint32_t>* links,
+                                          uint32_t index) {
+  uint64_t head = head_.load(std::memory_order_relaxed);
+  do {
+    links[index].store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+  } while (!head_.compare_exchange_weak(head, NextHead(head, index + 1),
+                                        std::memory_order_release,
+                                        std::memory_order_relaxed));
+}
+
+bool SizeClassBlockPool::IndexStack::Pop(std::atomic<uint32_t>* links,
+                                         uint32_t* index) {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  do {
+    const uint32_t top = static_cast<uint32_t>(head);
+    if (top == 0)
+      return false;
+    // |links| may be modified if another thread pops |top| first, but then
+    // the counter has changed and the exchange fails.
+    const uint32_t next = links[top - 1].load(std::memory_order_relaxed);
+    if (head_.compare_exchange_weak(head, NextHead(head, next),
+                                    std::memory_order_acquire,
+                                    std::memory_order_acquire)) {
+      *index = top - 1;
+      return true;
+    }
+  } while (true);
+}
+
+uint32_t SizeClassBlockPool::IndexStack::PopAll() {
+  uint64_t head = head_.load(std::memory_order_acquire);
+  while (!head_.compare_exchange_weak(head, NextHead(head, 0),
+                                      std::memory_order_acquire,
+                                      std::memory_order_acquire)) {
+  }
+  return static_cast<uint32_t>(head);
+}
+
+uint64_t SizeClassBlockPool::IndexStack::NextHead(uint64_t head,
+                                                  uint32_t top) {
+  return (((head >> 32) + 1) << 32) | top;
+}
+
+SizeClassBlockPool::SizeClassBlockPool(size_t max_number_of_blocks,
+                                       size_t max_allocated_bytes,
+                                       bool zero_initialize,
+                                       int64_t max_idle_time_ms,
+                                       int64_t trim_interval_ms)
+    : num_blocks_(max_number_of_blocks),
+      max_allocated_bytes_(max_allocated_bytes),
+      zero_initialize_(zero_initialize),
+      max_idle_time_ms_(max_idle_time_ms),
+      trim_interval_ms_(trim_interval_ms),
+      blocks_(new Block[max_number_of_blocks]),
+      links_(new std::atomic<uint32_t>[max_number_of_blocks]()) {
+  for (size_t i = 0; i < num_blocks_; ++i)
+    unused_blocks_.Push(links_.get(), static_cast<uint32_t>(i));
+}
+
+SizeClassBlockPool::~SizeClassBlockPool() = default;
+
+SizeClassBlockPool::Result SizeClassBlockPool::Acquire(int size_class,
+                                                       uint32_t* index) {
+  RTC_DCHECK_LT(size_class, kNumSizeClasses);
+  MaybeTrim(rtc::TimeMillis());
+
+  const int max_size_class =
+      std::min(size_class + kMaxSizeClassesAbove, kNumSizeClasses - 1);
+  for (int i = size_class; i <= max_size_class; ++i) {
+    if (free_blocks_[i].Pop(links_.get(), index)) {
+      ++num_hits_;
+      OnAcquired(*index);
+      return Result::kAcquired;
+    }
+  }
+
+  ++num_misses_;
+  if (!unused_blocks_.Pop(links_.get(), index) && !FreeIdleBlock(index))
+    return Result::kOutOfBlocks;
+  const size_t block_bytes = SizeClassBytes(size_class);
+  size_t allocated_bytes;
+  while ((allocated_bytes = allocated_bytes_.fetch_add(block_bytes) +
+                            block_bytes) > max_allocated_bytes_) {
+    allocated_bytes_ -= block_bytes;
+    uint32_t idle_index;
+    if (!FreeIdleBlock(&idle_index)) {
+      unused_blocks_.Push(links_.get(), *index);
+      return Result::kOutOfMemory;
+    }
+    unused_blocks_.Push(links_.get(), idle_index);
+  }
+  ++num_allocated_blocks_;
+  size_t peak_allocated_bytes = peak_allocated_bytes_.load();
+  while (allocated_bytes > peak_allocated_bytes &&
+         !peak_allocated_bytes_.compare_exchange_weak(peak_allocated_bytes,
+                                                      allocated_bytes)) {
+  }
+
+  Block& block = blocks_[*index];
+  block.data.reset(
+      static_cast<uint8_t*>(AlignedMalloc(block_bytes, kBufferAlignment)));
+  block.bytes = block_bytes;
+  block.size_class = size_class;
+  if (zero_initialize_)
+    memset(block.data.get(), 0, block_bytes);
+  OnAcquired(*index);
+  return Result::kAcquired;
+}
+
+void SizeClassBlockPool::Return(uint32_t index) {
+  Block& block = blocks_[index];
+  block.release_time_ms = rtc::TimeMillis();
+  --num_blocks_in_use_;
+  in_use_bytes_ -= block.bytes;
+  free_blocks_[block.size_class].Push(links_.get(), index);
+}
+
+bool SizeClassBlockPool::ReserveBuffer(size_t max_number_of_buffers) {
+  if (num_pending_buffers_.fetch_add(1) >= max_number_of_buffers) {
+    --num_pending_buffers_;
+    return false;
+  }
+  return true;
+}
+
+void SizeClassBlockPool::ReleaseBuffer() {
+  --num_pending_buffers_;
+}
+
+void SizeClassBlockPool::FreeIdleBlocks(int64_t now_ms,
+                                        int64_t max_idle_time_ms) {
+  for (IndexStack& stack : free_blocks_) {
+    std::vector<uint32_t> kept_indices;
+    uint32_t top = stack.PopAll();
+    while (top != 0) {
+      const uint32_t index = top - 1;
+      // Read the link before the block is pushed onto another stack.
+      top = links_[index].load(std::memory_order_relaxed);
+      if (now_ms - blocks_[index].release_time_ms >= max_idle_time_ms) {
+        FreeBlock(index);
+        unused_blocks_.Push(links_.get(), index);
+      } else {
+        kept_indices.push_back(index);
+      }
+    }
+    // Keep the most recently returned block on top.
+    for (auto it = kept_indices.rbegin(); it != kept_indices.rend(); ++it)
+      stack.Push(links_.get(), *it);
+  }
+}
+
+SizeClassBlockPool::Stats SizeClassBlockPool::GetStats() const {
+  Stats stats;
+  stats.num_hits = num_hits_;
+  stats.num_misses = num_misses_;
+  stats.num_failures = num_failures_;
+  stats.num_buffers = num_allocated_blocks_;
+  stats.num_buffers_in_use = num_blocks_in_use_;
+  stats.allocated_bytes = allocated_bytes_;
+  stats.in_use_bytes = in_use_bytes_;
+  stats.peak_allocated_bytes = peak_allocated_bytes_;
+  return stats;
+}
+
+void SizeClassBlockPool::OnAcquired(uint32_t index) {
+  ++num_blocks_in_use_;
+  in_use_bytes_ += blocks_[index].bytes;
+}
+
+void SizeClassBlockPool::MaybeTrim(int64_t now_ms) {
+  int64_t next_trim_time_ms =
+      next_trim_time_ms_.load(std::memory_order_relaxed);
+  if (now_ms < next_trim_time_ms ||
+      !next_trim_time_ms_.compare_exchange_strong(
+          next_trim_time_ms, now_ms + trim_interval_ms_)) {
+    return;
+  }
+  FreeIdleBlocks(now_ms, max_idle_time_ms_);
+}
+
+bool SizeClassBlockPool::FreeIdleBlock(uint32_t* index) {
+  for (int i = kNumSizeClasses - 1; i >= 0; --i) {
+    if (free_blocks_[i].Pop(links_.get(), index)) {
+      FreeBlock(*index);
+      return true;
+    }
+  }
+  return false;
+}
+
+void SizeClassBlockPool::FreeBlock(uint32_t index) {
+  Block& block = blocks_[index];
+  allocated_bytes_ -= block.bytes;
+  --num_allocated_blocks_;
+  block.data.reset();
+  block.bytes = 0;
+}
+
+}  // namespace webrtc
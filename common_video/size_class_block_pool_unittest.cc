@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "common_video/include/size_class_block_pool.h"
+
+#include <stdint.h>
+
+#include <limits>
+
+#include "api/scoped_refptr.h"
+#include "api/units/time_delta.h"
+#include "api/units/timestamp.h"
+#include "rtc_base/fake_clock.h"
+#include "rtc_base/ref_counted_object.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+constexpr size_t kUnlimited = std::numeric_limits<size_t>::max();
+constexpr int64_t kMaxIdleTimeMs = 1000;
+constexpr int64_t kTrimIntervalMs = 100;
+
+rtc::scoped_refptr<SizeClassBlockPool> CreatePool(size_t max_blocks,
+                                                  size_t max_bytes) {
+  return new rtc::RefCountedObject<SizeClassBlockPool>(
+      max_blocks, max_bytes, /*zero_initialize=*/false, kMaxIdleTimeMs,
+      kTrimIntervalMs);
+}
+
+}  // namespace
+
+TEST(SizeClassBlockPoolTest, SizeClassesFitTheirBytes) {
+  EXPECT_EQ(0, SizeClassBlockPool::SizeClassForBytes(1));
+  for (int i = 0; i < SizeClassBlockPool::kNumSizeClasses; ++i) {
+    const size_t bytes = SizeClassBlockPool::SizeClassBytes(i);
+    EXPECT_EQ(i, SizeClassBlockPool::SizeClassForBytes(bytes));
+    EXPECT_EQ(i + 1, SizeClassBlockPool::SizeClassForBytes(bytes + 1));
+  }
+}
+
+TEST(SizeClassBlockPoolTest, ReusesBlocksUpToTwiceTheSize) {
+  auto pool = CreatePool(4, kUnlimited);
+  uint32_t index;
+  ASSERT_EQ(SizeClassBlockPool::Result::kAcquired, pool->Acquire(8, &index));
+  uint8_t* const data = pool->data(index);
+  EXPECT_EQ(SizeClassBlockPool::SizeClassBytes(8), pool->block_bytes(index));
+  pool->Return(index);
+
+  ASSERT_EQ(SizeClassBlockPool::Result::kAcquired, pool->Acquire(4, &index));
+  EXPECT_EQ(data, pool->data(index));
+  pool->Return(index);
+
+  ASSERT_EQ(SizeClassBlockPool::Result::kAcquired, pool->Acquire(3, &index));
+  EXPECT_NE(data, pool->data(index));
+  pool->Return(index);
+
+  const SizeClassBlockPool::Stats stats = pool->GetStats();
+  EXPECT_EQ(1u, stats.num_hits);
+  EXPECT_EQ(2u, stats.num_misses);
+  EXPECT_EQ(2u, stats.num_buffers);
+  EXPECT_EQ(0u, stats.num_buffers_in_use);
+}
+
+TEST(SizeClassBlockPoolTest, FailsWhenOutOfBlocksOrMemory) {
+  const size_t block_bytes = SizeClassBlockPool::SizeClassBytes(0);
+  auto pool = CreatePool(2, 3 * block_bytes);
+  uint32_t first;
+  uint32_t second;
+  uint32_t index;
+  ASSERT_EQ(SizeClassBlockPool::Result::kAcquired, pool->Acquire(0, &first));
+  ASSERT_EQ(SizeClassBlockPool::Result::kAcquired, pool->Acquire(0, &second));
+  EXPECT_EQ(SizeClassBlockPool::Result::kOutOfBlocks, pool->Acquire(0, &index));
+
+  // The free block is freed to make room for a larger one, which would still
+  // exceed the max allocated bytes.
+  pool->Return(second);
+  const int large_size_class =
+      SizeClassBlockPool::SizeClassForBytes(3 * block_bytes);
+  EXPECT_EQ(SizeClassBlockPool::Result::kOutOfMemory,
+            pool->Acquire(large_size_class, &index));
+  ASSERT_EQ(SizeClassBlockPool::Result::kAcquired, pool->Acquire(4, &index));
+
+  const SizeClassBlockPool::Stats stats = pool->GetStats();
+  EXPECT_EQ(2u, stats.num_buffers);
+  EXPECT_EQ(block_bytes + SizeClassBlockPool::SizeClassBytes(4),
+            stats.allocated_bytes);
+  EXPECT_EQ(stats.allocated_bytes, stats.peak_allocated_bytes);
+  pool->Return(first);
+  pool->Return(index);
+}
+
+TEST(SizeClassBlockPoolTest, FreesIdleBlocks) {
+  rtc::ScopedFakeClock clock;
+  clock.SetTime(Timestamp::ms(1));
+  auto pool = CreatePool(4, kUnlimited);
+  uint32_t first;
+  uint32_t second;
+  ASSERT_EQ(SizeClassBlockPool::Result::kAcquired, pool->Acquire(0, &first));
+  ASSERT_EQ(SizeClassBlockPool::Result::kAcquired, pool->Acquire(8, &second));
+  pool->Return(first);
+  clock.AdvanceTime(TimeDelta::ms(kMaxIdleTimeMs));
+  pool->Return(second);
+
+  // Acquiring triggers trimming of the block idle for too long.
+  uint32_t index;
+  ASSERT_EQ(SizeClassBlockPool::Result::kAcquired, pool->Acquire(8, &index));
+  EXPECT_EQ(1u, pool->GetStats().num_buffers);
+  EXPECT_EQ(SizeClassBlockPool::SizeClassBytes(0) +
+                SizeClassBlockPool::SizeClassBytes(8),
+            pool->GetStats().peak_allocated_bytes);
+  pool->Return(index);
+
+  pool->FreeIdleBlocks(rtc::TimeMillis(), 0);
+  EXPECT_EQ(0u, pool->GetStats().num_buffers);
+  EXPECT_EQ(0u, pool->GetStats().allocated_bytes);
+}
+
+}  // namespace webrtc
@@ -18,21 +18,25 @@
 #include <string>
 #include <utility>
 
+#include "absl/memory/memory.h"
 #include "api/scoped_refptr.h"
+#include "api/task_queue/default_task_queue_factory.h"
 #include "api/video/i420_buffer.h"
 #include "api/video/video_codec_constants.h"
 #include "api/video/video_frame_buffer.h"
 #include "api/video/video_rotation.h"
 #include "api/video_codecs/video_encoder.h"
 #include "api/video_codecs/video_encoder_factory.h"
+#include "common_video/include/scaled_frame_buffer_cache.h"
 #include "modules/video_coding/include/video_error_codes.h"
 #include "modules/video_coding/utility/simulcast_rate_allocator.h"
 #include "rtc_base/atomic_ops.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/event.h"
 #include "rtc_base/experiments/rate_control_settings.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/field_trial.h"
-#include "third_party/libyuv/include/libyuv/scale.h"
 
 namespace {
 
@@ -40,6 +44,8 @@ const unsigned int kDefaultMinQp = 2;
 const unsigned int kDefaultMaxQp = 56;
 // Max qp for lowest spatial resolution when doing simulcast.
 const unsigned int kLowestResMaxQp = 45;
+// Number of extra threads scaling large input frames with parallel encoding.
+const size_t kNumScalingQueues = 2;
 
 absl::optional<unsigned int> GetScreenshareBoostedQpValue() {
   std::string experiment_group =
@@ -52,6 +58,11 @@ absl::optional<unsigned int> GetScreenshareBoostedQpValue() {
   return qp;
 }
 
+bool IsParallelEncodingEnabled() {
+  return webrtc::field_trial::IsEnabled(
+      "WebRTC-SimulcastEncoderAdapter-ParallelEncoding");
+}
+
 uint32_t SumStreamMaxBitrate(int streams, const webrtc::VideoCodec& codec) {
   uint32_t bitrate_sum = 0;
   for (int i = 0; i < streams; ++i) {
@@ -125,12 +136,14 @@ namespace webrtc {
 SimulcastEncoderAdapter::SimulcastEncoderAdapter(VideoEncoderFactory* factory,
                                                  const SdpVideoFormat& format)
     : inited_(0),
+      defer_encoded_images_(0),
       factory_(factory),
       video_format_(format),
       encoded_complete_callback_(nullptr),
       experimental_boosted_screenshare_qp_(GetScreenshareBoostedQpValue()),
       boost_base_layer_quality_(RateControlSettings::ParseFromFieldTrials()
-                                    .Vp8BoostBaseLayerQuality()) {
+                                    .Vp8BoostBaseLayerQuality()),
+      parallel_encoding_enabled_(IsParallelEncodingEnabled()) {
   RTC_DCHECK(factory_);
   encoder_info_.implementation_name = "SimulcastEncoderAdapter";
 
@@ -341,6 +354,17 @@ int SimulcastEncoderAdapter::InitEncode(
   // To save memory, don't store encoders that we don't use.
   DestroyStoredEncoders();
 
+  if (parallel_encoding_enabled_) {
+    if (!task_queue_factory_)
+      task_queue_factory_ = CreateDefaultTaskQueueFactory();
+    while (encode_queues_.size() + 1 < streaminfos_.size()) {
+      encode_queues_.push_back(absl::make_unique<rtc::TaskQueue>(
+          task_queue_factory_->CreateTaskQueue(
+              "SimulcastEncodeQueue",
+              TaskQueueFactory::Priority::NORMAL)));
+    }
+  }
+
   rtc::AtomicOps::ReleaseStore(&inited_, 1);
 
   return WEBRTC_VIDEO_CODEC_OK;
@@ -377,74 +401,145 @@ int SimulcastEncoderAdapter::Encode(
     }
   }
 
-  int src_width = input_image.width();
-  int src_height = input_image.height();
+  std::vector<size_t> stream_indices;
+  std::vector<VideoFrameType> frame_types_per_stream(streaminfos_.size());
   for (size_t stream_idx = 0; stream_idx < streaminfos_.size(); ++stream_idx) {
     // Don't encode frames in resolutions that we don't intend to send.
     if (!streaminfos_[stream_idx].send_stream) {
       continue;
     }
 
-    std::vector<VideoFrameType> stream_frame_types;
     if (send_key_frame) {
-      stream_frame_types.push_back(VideoFrameType::kVideoFrameKey);
+      frame_types_per_stream[stream_idx] = VideoFrameType::kVideoFrameKey;
       streaminfos_[stream_idx].key_frame_request = false;
     } else {
-      stream_frame_types.push_back(VideoFrameType::kVideoFrameDelta);
+      frame_types_per_stream[stream_idx] = VideoFrameType::kVideoFrameDelta;
     }
+    stream_indices.push_back(stream_idx);
+  }
 
-    int dst_width = streaminfos_[stream_idx].width;
-    int dst_height = streaminfos_[stream_idx].height;
-    // If scaling isn't required, because the input resolution
-    // matches the destination or the input image is empty (e.g.
-    // a keyframe request for encoders with internal camera
-    // sources) or the source image has a native handle, pass the image on
-    // directly. Otherwise, we'll scale it to match what the encoder expects
-    // (below).
-    // For texture frames, the underlying encoder is expected to be able to
-    // correctly sample/scale the source texture.
-    // TODO(perkj): ensure that works going forward, and figure out how this
-    // affects webrtc:5683.
-    if ((dst_width == src_width && dst_height == src_height) ||
-        input_image.video_frame_buffer()->type() ==
-            VideoFrameBuffer::Type::kNative) {
-      int ret = streaminfos_[stream_idx].encoder->Encode(input_image,
-                                                         &stream_frame_types);
-      if (ret != WEBRTC_VIDEO_CODEC_OK) {
-        return ret;
-      }
-    } else {
-      rtc::scoped_refptr<I420Buffer> dst_buffer =
-          I420Buffer::Create(dst_width, dst_height);
-      rtc::scoped_refptr<I420BufferInterface> src_buffer =
-          input_image.video_frame_buffer()->ToI420();
-      libyuv::I420Scale(src_buffer->DataY(), src_buffer->StrideY(),
-                        src_buffer->DataU(), src_buffer->StrideU(),
-                        src_buffer->DataV(), src_buffer->StrideV(), src_width,
-                        src_height, dst_buffer->MutableDataY(),
-                        dst_buffer->StrideY(), dst_buffer->MutableDataU(),
-                        dst_buffer->StrideU(), dst_buffer->MutableDataV(),
-                        dst_buffer->StrideV(), dst_width, dst_height,
-                        libyuv::kFilterBilinear);
-
-      // UpdateRect is not propagated to lower simulcast layers currently.
-      // TODO(ilnik): Consider scaling UpdateRect together with the buffer.
-      VideoFrame frame(input_image);
-      frame.set_video_frame_buffer(dst_buffer);
-      frame.set_rotation(webrtc::kVideoRotation_0);
-      frame.set_update_rect(
-          VideoFrame::UpdateRect{0, 0, frame.width(), frame.height()});
-      int ret =
-          streaminfos_[stream_idx].encoder->Encode(frame, &stream_frame_types);
-      if (ret != WEBRTC_VIDEO_CODEC_OK) {
-        return ret;
-      }
+  // Streams share the scaled versions of the frame, so that each resolution
+  // is computed once.
+  rtc::scoped_refptr<ScaledFrameBufferCache> scaled_buffers =
+      ScaledFrameBufferCache::Create(input_image.video_frame_buffer(),
+                                     GetScalingQueues(input_image));
+
+  if (parallel_encoding_enabled_ && stream_indices.size() > 1) {
+    return EncodeStreamsInParallel(input_image, scaled_buffers.get(),
+                                   stream_indices, frame_types_per_stream);
+  }
+
+  for (size_t stream_idx : stream_indices) {
+    int ret = EncodeStream(stream_idx, input_image, scaled_buffers.get(),
+                           frame_types_per_stream[stream_idx]);
+    if (ret != WEBRTC_VIDEO_CODEC_OK) {
+      return ret;
     }
   }
 
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
+int SimulcastEncoderAdapter::EncodeStream(
+    size_t stream_idx,
+    const VideoFrame& input_image,
+    ScaledFrameBufferCache* scaled_buffers,
+    VideoFrameType frame_type) {
+  const int64_t start_time_us = rtc::TimeMicros();
+  std::vector<VideoFrameType> stream_frame_types(1, frame_type);
+  int src_width = input_image.width();
+  int src_height = input_image.height();
+  int dst_width = streaminfos_[stream_idx].width;
+  int dst_height = streaminfos_[stream_idx].height;
+  int ret;
+  // If scaling isn't required, because the input resolution
+  // matches the destination or the input image is empty (e.g.
+  // a keyframe request for encoders with internal camera
+  // sources) or the source image has a native handle, pass the image on
+  // directly. Otherwise, we'll scale it to match what the encoder expects
+  // (below).
+  // For texture frames, the underlying encoder is expected to be able to
+  // correctly sample/scale the source texture.
+  // TODO(perkj): ensure that works going forward, and figure out how this
+  // affects webrtc:5683.
+  if ((dst_width == src_width && dst_height == src_height) ||
+      input_image.video_frame_buffer()->type() ==
+          VideoFrameBuffer::Type::kNative) {
+    ret = streaminfos_[stream_idx].encoder->Encode(input_image,
+                                                   &stream_frame_types);
+  } else {
+    rtc::scoped_refptr<I420BufferInterface> dst_buffer =
+        scaled_buffers->GetScaledI420(dst_width, dst_height);
+    if (!dst_buffer) {
+      RTC_LOG(LS_ERROR) << "Failed to convert frame to I420.";
+      return WEBRTC_VIDEO_CODEC_ERROR;
+    }
+
+    // UpdateRect is not propagated to lower simulcast layers currently.
+    // TODO(ilnik): Consider scaling UpdateRect together with the buffer.
+    VideoFrame frame(input_image);
+    frame.set_video_frame_buffer(dst_buffer);
+    frame.set_rotation(webrtc::kVideoRotation_0);
+    frame.set_update_rect(
+        VideoFrame::UpdateRect{0, 0, frame.width(), frame.height()});
+    ret = streaminfos_[stream_idx].encoder->Encode(frame, &stream_frame_types);
+  }
+
+  LayerEncodeStats& stats = streaminfos_[stream_idx].encode_stats;
+  ++stats.frames_encoded;
+  stats.last_encode_time_us = rtc::TimeMicros() - start_time_us;
+  stats.total_encode_time_us += stats.last_encode_time_us;
+  return ret;
+}
+
+int SimulcastEncoderAdapter::EncodeStreamsInParallel(
+    const VideoFrame& input_image,
+    ScaledFrameBufferCache* scaled_buffers,
+    const std::vector<size_t>& stream_indices,
+    const std::vector<VideoFrameType>& frame_types) {
+  RTC_DCHECK_RUN_ON(&encoder_queue_);
+  rtc::AtomicOps::ReleaseStore(&defer_encoded_images_, 1);
+
+  std::vector<int> results(streaminfos_.size(), WEBRTC_VIDEO_CODEC_OK);
+  rtc::Event done;
+  const bool encode_first_stream = stream_indices.front() == 0;
+  volatile int pending_streams =
+      static_cast<int>(stream_indices.size()) - (encode_first_stream ? 1 : 0);
+  RTC_DCHECK_GT(pending_streams, 0);
+  for (size_t stream_idx : stream_indices) {
+    if (stream_idx == 0)
+      continue;
+    encode_queues_[stream_idx - 1]->PostTask([&, stream_idx] {
+      results[stream_idx] = EncodeStream(stream_idx, input_image,
+                                         scaled_buffers,
+                                         frame_types[stream_idx]);
+      if (rtc::AtomicOps::Decrement(&pending_streams) == 0)
+        done.Set();
+    });
+  }
+  // The first stream is encoded on the calling thread.
+  if (encode_first_stream)
+    results[0] = EncodeStream(0, input_image, scaled_buffers, frame_types[0]);
+  done.Wait(rtc::Event::kForever);
+
+  rtc::AtomicOps::ReleaseStore(&defer_encoded_images_, 0);
+
+  for (StreamInfo& info : streaminfos_) {
+    for (DeferredEncodedImage& deferred : info.deferred_images) {
+      encoded_complete_callback_->OnEncodedImage(
+          deferred.encoded_image, &deferred.codec_specific_info,
+          deferred.fragmentation.get());
+    }
+    info.deferred_images.clear();
+  }
+
+  for (size_t stream_idx : stream_indices) {
+    if (results[stream_idx] != WEBRTC_VIDEO_CODEC_OK)
+      return results[stream_idx];
+  }
+  return WEBRTC_VIDEO_CODEC_OK;
+}
+
 int SimulcastEncoderAdapter::RegisterEncodeCompleteCallback(
     EncodedImageCallback* callback) {
   RTC_DCHECK_RUN_ON(&encoder_queue_);
@@ -538,6 +633,21 @@ EncodedImageCallback::Result SimulcastEncoderAdapter::OnEncodedImage(
 
   stream_image.SetSpatialIndex(stream_idx);
 
+  if (rtc::AtomicOps::AcquireLoad(&defer_encoded_images_)) {
+    // The encoder may reuse its buffer once Encode() returns.
+    stream_image.Retain();
+    DeferredEncodedImage deferred;
+    deferred.encoded_image = stream_image;
+    deferred.codec_specific_info = stream_codec_specific;
+    if (fragmentation) {
+      deferred.fragmentation = absl::make_unique<RTPFragmentationHeader>();
+      deferred.fragmentation->CopyFrom(*fragmentation);
+    }
+    streaminfos_[stream_idx].deferred_images.push_back(std::move(deferred));
+    return EncodedImageCallback::Result(EncodedImageCallback::Result::OK,
+                                        stream_image.Timestamp());
+  }
+
   return encoded_complete_callback_->OnEncodedImage(
       stream_image, &stream_codec_specific, fragmentation);
 }
@@ -605,4 +715,31 @@ VideoEncoder::EncoderInfo SimulcastEncoderAdapter::GetEncoderInfo() const {
   return encoder_info_;
 }
 
+std::vector<TaskQueueBase*> SimulcastEncoderAdapter::GetScalingQueues(
+    const VideoFrame& input_image) {
+  std::vector<TaskQueueBase*> scaling_queues;
+  if (!parallel_encoding_enabled_ ||
+      input_image.width() * input_image.height() <
+          ScaledFrameBufferCache::kMinPixelsForParallelScaling) {
+    return scaling_queues;
+  }
+  while (scaling_queues_.size() < kNumScalingQueues) {
+    scaling_queues_.push_back(absl::make_unique<rtc::TaskQueue>(
+        task_queue_factory_->CreateTaskQueue(
+            "SimulcastScalingQueue", TaskQueueFactory::Priority::NORMAL)));
+  }
+  for (const auto& scaling_queue : scaling_queues_)
+    scaling_queues.push_back(scaling_queue->Get());
+  return scaling_queues;
+}
+
+std::vector<SimulcastEncoderAdapter::LayerEncodeStats>
+SimulcastEncoderAdapter::GetLayerEncodeStats() const {
+  RTC_DCHECK_RUN_ON(&encoder_queue_);
+  std::vector<LayerEncodeStats> stats;
+  for (const StreamInfo& info : streaminfos_)
+    stats.push_back(info.encode_stats);
+  return stats;
+}
+
 }  // namespace webrtc
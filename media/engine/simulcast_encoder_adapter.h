@@ -12,6 +12,8 @@
 #ifndef MEDIA_ENGINE_SIMULCAST_ENCODER_ADAPTER_H_
 #define MEDIA_ENGINE_SIMULCAST_ENCODER_ADAPTER_H_
 
+#include <stdint.h>
+
 #include <memory>
 #include <stack>
 #include <string>
@@ -20,12 +22,16 @@
 
 #include "absl/types/optional.h"
 #include "api/fec_controller_override.h"
+#include "api/task_queue/task_queue_factory.h"
 #include "api/video_codecs/sdp_video_format.h"
 #include "api/video_codecs/video_encoder.h"
+#include "common_video/include/scaled_frame_buffer_cache.h"
+#include "modules/include/module_common_types.h"
 #include "modules/video_coding/include/video_codec_interface.h"
 #include "rtc_base/atomic_ops.h"
 #include "rtc_base/synchronization/sequence_checker.h"
 #include "rtc_base/system/rtc_export.h"
+#include "rtc_base/task_queue.h"
 
 namespace webrtc {
 
@@ -36,8 +42,22 @@ class VideoEncoderFactory;
 // webrtc::VideoEncoder instances with the given VideoEncoderFactory.
 // The object is created and destroyed on the worker thread, but all public
 // interfaces should be called from the encoder task queue.
+// With the "WebRTC-SimulcastEncoderAdapter-ParallelEncoding" field trial, the
+// streams of a frame are scaled and encoded concurrently, each stream but the
+// first on a thread of its own. Encoded images produced during Encode() are
+// then held back and delivered from the calling thread in stream order once
+// all streams are done, so the callback sees the same sequence as when
+// encoding the streams one after the other.
 class RTC_EXPORT SimulcastEncoderAdapter : public VideoEncoder {
  public:
+  struct LayerEncodeStats {
+    int frames_encoded = 0;
+    // Time spent scaling the input frame and in the Encode() call of the
+    // stream's encoder.
+    int64_t last_encode_time_us = 0;
+    int64_t total_encode_time_us = 0;
+  };
+
   explicit SimulcastEncoderAdapter(VideoEncoderFactory* factory,
                                    const SdpVideoFormat& format);
   virtual ~SimulcastEncoderAdapter();
@@ -67,7 +87,16 @@ class RTC_EXPORT SimulcastEncoderAdapter : public VideoEncoder {
 
   EncoderInfo GetEncoderInfo() const override;
 
+  // Returns the encode statistics of each simulcast stream since InitEncode().
+  std::vector<LayerEncodeStats> GetLayerEncodeStats() const;
+
  private:
+  struct DeferredEncodedImage {
+    EncodedImage encoded_image;
+    CodecSpecificInfo codec_specific_info;
+    std::unique_ptr<RTPFragmentationHeader> fragmentation;
+  };
+
   struct StreamInfo {
     StreamInfo(std::unique_ptr<VideoEncoder> encoder,
                std::unique_ptr<EncodedImageCallback> callback,
@@ -86,6 +115,9 @@ class RTC_EXPORT SimulcastEncoderAdapter : public VideoEncoder {
     uint16_t height;
     bool key_frame_request;
     bool send_stream;
+    LayerEncodeStats encode_stats;
+    // Encoded images produced during a parallel Encode(), not yet delivered.
+    std::vector<DeferredEncodedImage> deferred_images;
   };
 
   enum class StreamResolution {
@@ -103,9 +135,24 @@ class RTC_EXPORT SimulcastEncoderAdapter : public VideoEncoder {
 
   bool Initialized() const;
 
+  // Scales |input_image| to the resolution of stream |stream_idx| if needed,
+  // and encodes it.
+  int EncodeStream(size_t stream_idx,
+                   const VideoFrame& input_image,
+                   ScaledFrameBufferCache* scaled_buffers,
+                   VideoFrameType frame_type);
+  int EncodeStreamsInParallel(const VideoFrame& input_image,
+                              ScaledFrameBufferCache* scaled_buffers,
+                              const std::vector<size_t>& stream_indices,
+                              const std::vector<VideoFrameType>& frame_types);
+  // Returns the task queues that help scaling |input_image|, if any.
+  std::vector<TaskQueueBase*> GetScalingQueues(const VideoFrame& input_image);
+
   void DestroyStoredEncoders();
 
   volatile int inited_;  // Accessed atomically.
+  // Set while streams are encoded in parallel.
+  volatile int defer_encoded_images_;  // Accessed atomically.
   VideoEncoderFactory* const factory_;
   const SdpVideoFormat video_format_;
   VideoCodec codec_;
@@ -122,6 +169,14 @@ class RTC_EXPORT SimulcastEncoderAdapter : public VideoEncoder {
 
   const absl::optional<unsigned int> experimental_boosted_screenshare_qp_;
   const bool boost_base_layer_quality_;
+
+  const bool parallel_encoding_enabled_;
+  std::unique_ptr<TaskQueueFactory> task_queue_factory_;
+  // Task queues encoding all simulcast streams but the first, created on
+  // demand and kept across reinitializations.
+  std::vector<std::unique_ptr<rtc::TaskQueue>> encode_queues_;
+  // Task queues helping to downscale large frames when encoding in parallel.
+  std::vector<std::unique_ptr<rtc::TaskQueue>> scaling_queues_;
 };
 
 }  // namespace webrtc
@@ -28,10 +28,17 @@
 #include "modules/video_coding/codecs/vp8/include/vp8.h"
 #include "modules/video_coding/include/video_codec_interface.h"
 #include "modules/video_coding/utility/simulcast_test_fixture_impl.h"
+#include "rtc_base/platform_thread_types.h"
+#include "rtc_base/time_utils.h"
+#include "system_wrappers/include/sleep.h"
+#include "test/field_trial.h"
+#include "test/frame_generator.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 using ::testing::_;
+using ::testing::Invoke;
 using ::testing::Return;
 using EncoderInfo = webrtc::VideoEncoder::EncoderInfo;
 using FramerateFractions =
@@ -44,6 +51,8 @@ namespace {
 
 constexpr int kDefaultWidth = 1280;
 constexpr int kDefaultHeight = 720;
+constexpr char kParallelEncodingFieldTrial[] =
+    "WebRTC-SimulcastEncoderAdapter-ParallelEncoding/Enabled/";
 
 const VideoEncoder::Capabilities kCapabilities(false);
 const VideoEncoder::Settings kSettings(kCapabilities, 1, 1200);
@@ -158,6 +167,38 @@ TEST(SimulcastEncoderAdapterSimulcastTest, TestDecodeWidthHeightSet) {
   fixture->TestDecodeWidthHeightSet();
 }
 
+TEST(SimulcastEncoderAdapterSimulcastTest,
+     TestKeyFrameRequestsOnAllStreamsWithParallelEncoding) {
+  ScopedFieldTrials field_trials(kParallelEncodingFieldTrial);
+  InternalEncoderFactory internal_encoder_factory;
+  auto fixture = CreateSpecificSimulcastTestFixture(&internal_encoder_factory);
+  fixture->TestKeyFrameRequestsOnAllStreams();
+}
+
+TEST(SimulcastEncoderAdapterSimulcastTest,
+     TestSendAllStreamsWithParallelEncoding) {
+  ScopedFieldTrials field_trials(kParallelEncodingFieldTrial);
+  InternalEncoderFactory internal_encoder_factory;
+  auto fixture = CreateSpecificSimulcastTestFixture(&internal_encoder_factory);
+  fixture->TestSendAllStreams();
+}
+
+TEST(SimulcastEncoderAdapterSimulcastTest,
+     TestSpatioTemporalLayers333PatternEncoderWithParallelEncoding) {
+  ScopedFieldTrials field_trials(kParallelEncodingFieldTrial);
+  InternalEncoderFactory internal_encoder_factory;
+  auto fixture = CreateSpecificSimulcastTestFixture(&internal_encoder_factory);
+  fixture->TestSpatioTemporalLayers333PatternEncoder();
+}
+
+TEST(SimulcastEncoderAdapterSimulcastTest,
+     TestStrideEncodeDecodeWithParallelEncoding) {
+  ScopedFieldTrials field_trials(kParallelEncodingFieldTrial);
+  InternalEncoderFactory internal_encoder_factory;
+  auto fixture = CreateSpecificSimulcastTestFixture(&internal_encoder_factory);
+  fixture->TestStrideEncodeDecode();
+}
+
 class MockVideoEncoder;
 
 class MockVideoEncoderFactory : public VideoEncoderFactory {
@@ -380,6 +421,9 @@ class TestSimulcastEncoderAdapterFake : public ::testing::Test,
     last_encoded_image_height_ = encoded_image._encodedHeight;
     last_encoded_image_simulcast_index_ =
         encoded_image.SpatialIndex().value_or(-1);
+    encoded_image_simulcast_indices_.push_back(
+        last_encoded_image_simulcast_index_);
+    encoded_image_threads_.push_back(rtc::CurrentThreadRef());
 
     return Result(Result::OK, encoded_image.Timestamp());
   }
@@ -482,6 +526,8 @@ class TestSimulcastEncoderAdapterFake : public ::testing::Test,
   int last_encoded_image_width_;
   int last_encoded_image_height_;
   int last_encoded_image_simulcast_index_;
+  std::vector<int> encoded_image_simulcast_indices_;
+  std::vector<rtc::PlatformThreadRef> encoded_image_threads_;
   std::unique_ptr<SimulcastRateAllocator> rate_allocator_;
 };
 
@@ -1219,5 +1265,182 @@ TEST_F(TestSimulcastEncoderAdapterFake, SetRateDistributesBandwithAllocation) {
   }
 }
 
+TEST_F(TestSimulcastEncoderAdapterFake,
+       ParallelEncodingDeliversImagesInStreamOrder) {
+  ScopedFieldTrials field_trials(kParallelEncodingFieldTrial);
+  adapter_.reset();
+  helper_ = absl::make_unique<TestSimulcastEncoderAdapterFakeHelper>();
+  adapter_.reset(helper_->CreateMockEncoderAdapter());
+  SetupCodec();
+  const uint32_t target_bitrate =
+      1000 * (codec_.simulcastStream[0].targetBitrate +
+              codec_.simulcastStream[1].targetBitrate +
+              codec_.simulcastStream[2].minBitrate);
+  adapter_->SetRates(VideoEncoder::RateControlParameters(
+      rate_allocator_->Allocate(
+          VideoBitrateAllocationParameters(target_bitrate, 30)),
+      30.0));
+
+  // Lower streams take longer to encode, so that their encoders finish last.
+  std::vector<MockVideoEncoder*> encoders = helper_->factory()->encoders();
+  ASSERT_EQ(3u, encoders.size());
+  std::vector<rtc::PlatformThreadRef> encode_threads(3);
+  for (int i = 0; i < 3; ++i) {
+    MockVideoEncoder* encoder = encoders[i];
+    EXPECT_CALL(*encoder, Encode(_, _))
+        .WillOnce(Invoke([&encode_threads, encoder, i](
+                             const VideoFrame& frame,
+                             const std::vector<VideoFrameType>* frame_types) {
+          encode_threads[i] = rtc::CurrentThreadRef();
+          SleepMs((2 - i) * 20);
+          encoder->SendEncodedImage(frame.width(), frame.height());
+          return WEBRTC_VIDEO_CODEC_OK;
+        }));
+  }
+
+  rtc::scoped_refptr<I420Buffer> input_buffer =
+      I420Buffer::Create(kDefaultWidth, kDefaultHeight);
+  input_buffer->InitializeData();
+  VideoFrame input_frame = VideoFrame::Builder()
+                               .set_video_frame_buffer(input_buffer)
+                               .set_timestamp_rtp(0)
+                               .set_timestamp_us(0)
+                               .set_rotation(kVideoRotation_0)
+                               .build();
+  std::vector<VideoFrameType> frame_types(3, VideoFrameType::kVideoFrameKey);
+  EXPECT_EQ(0, adapter_->Encode(input_frame, &frame_types));
+
+  EXPECT_THAT(encoded_image_simulcast_indices_,
+              ::testing::ElementsAre(0, 1, 2));
+  // All images are delivered on the thread calling Encode(), but the streams
+  // other than the first are encoded elsewhere.
+  const rtc::PlatformThreadRef current_thread = rtc::CurrentThreadRef();
+  for (const rtc::PlatformThreadRef& thread : encoded_image_threads_)
+    EXPECT_TRUE(rtc::IsThreadRefEqual(thread, current_thread));
+  EXPECT_TRUE(rtc::IsThreadRefEqual(encode_threads[0], current_thread));
+  EXPECT_FALSE(rtc::IsThreadRefEqual(encode_threads[1], current_thread));
+  EXPECT_FALSE(rtc::IsThreadRefEqual(encode_threads[2], current_thread));
+  EXPECT_FALSE(rtc::IsThreadRefEqual(encode_threads[1], encode_threads[2]));
+
+  std::vector<SimulcastEncoderAdapter::LayerEncodeStats> stats =
+      static_cast<SimulcastEncoderAdapter*>(adapter_.get())
+          ->GetLayerEncodeStats();
+  ASSERT_EQ(3u, stats.size());
+  for (const SimulcastEncoderAdapter::LayerEncodeStats& layer_stats : stats)
+    EXPECT_EQ(1, layer_stats.frames_encoded);
+  EXPECT_GE(stats[0].last_encode_time_us, 40000);
+  EXPECT_GE(stats[1].last_encode_time_us, 20000);
+}
+
+TEST_F(TestSimulcastEncoderAdapterFake,
+       ParallelEncodingReturnsErrorOfLowestStream) {
+  ScopedFieldTrials field_trials(kParallelEncodingFieldTrial);
+  adapter_.reset();
+  helper_ = absl::make_unique<TestSimulcastEncoderAdapterFakeHelper>();
+  adapter_.reset(helper_->CreateMockEncoderAdapter());
+  SetupCodec();
+  const uint32_t target_bitrate =
+      1000 * (codec_.simulcastStream[0].targetBitrate +
+              codec_.simulcastStream[1].targetBitrate +
+              codec_.simulcastStream[2].minBitrate);
+  adapter_->SetRates(VideoEncoder::RateControlParameters(
+      rate_allocator_->Allocate(
+          VideoBitrateAllocationParameters(target_bitrate, 30)),
+      30.0));
+  std::vector<MockVideoEncoder*> encoders = helper_->factory()->encoders();
+  ASSERT_EQ(3u, encoders.size());
+  EXPECT_CALL(*encoders[0], Encode(_, _))
+      .WillOnce(Return(WEBRTC_VIDEO_CODEC_OK));
+  EXPECT_CALL(*encoders[1], Encode(_, _))
+      .WillOnce(Return(WEBRTC_VIDEO_CODEC_FALLBACK_SOFTWARE));
+  EXPECT_CALL(*encoders[2], Encode(_, _))
+      .WillOnce(Return(WEBRTC_VIDEO_CODEC_ERROR));
+
+  rtc::scoped_refptr<I420Buffer> input_buffer =
+      I420Buffer::Create(kDefaultWidth, kDefaultHeight);
+  input_buffer->InitializeData();
+  VideoFrame input_frame = VideoFrame::Builder()
+                               .set_video_frame_buffer(input_buffer)
+                               .set_timestamp_rtp(0)
+                               .set_timestamp_us(0)
+                               .set_rotation(kVideoRotation_0)
+                               .build();
+  std::vector<VideoFrameType> frame_types(3, VideoFrameType::kVideoFrameKey);
+  EXPECT_EQ(WEBRTC_VIDEO_CODEC_FALLBACK_SOFTWARE,
+            adapter_->Encode(input_frame, &frame_types));
+}
+
+namespace {
+
+class NullEncodedImageCallback : public EncodedImageCallback {
+ public:
+  Result OnEncodedImage(const EncodedImage& encoded_image,
+                        const CodecSpecificInfo* codec_specific_info,
+                        const RTPFragmentationHeader* fragmentation) override {
+    return Result(Result::OK, encoded_image.Timestamp());
+  }
+};
+
+// Encodes 720p three stream simulcast with libvpx and reports the latency of
+// Encode(), which is when all encoded images have been delivered, as well as
+// the time spent on each stream.
+void RunSimulcastEncodePerf(const std::string& trace) {
+  constexpr int kNumFrames = 300;
+  VideoCodec codec;
+  SimulcastTestFixtureImpl::DefaultSettings(
+      &codec, static_cast<const int*>(kTestTemporalLayerProfile),
+      kVideoCodecVP8);
+  InternalEncoderFactory internal_encoder_factory;
+  SimulcastEncoderAdapter adapter(&internal_encoder_factory,
+                                  SdpVideoFormat(cricket::kVp8CodecName));
+  NullEncodedImageCallback callback;
+  const VideoEncoder::Settings settings(kCapabilities, 4, 1200);
+  ASSERT_EQ(0, adapter.InitEncode(&codec, settings));
+  adapter.RegisterEncodeCompleteCallback(&callback);
+  SimulcastRateAllocator rate_allocator(codec);
+  adapter.SetRates(VideoEncoder::RateControlParameters(
+      rate_allocator.Allocate(VideoBitrateAllocationParameters(
+          codec.simulcastStream[2].maxBitrate * 3000, 30)),
+      30.0));
+
+  std::unique_ptr<FrameGenerator> frame_generator =
+      FrameGenerator::CreateSquareGenerator(codec.width, codec.height,
+                                            absl::nullopt, absl::nullopt);
+  std::vector<VideoFrameType> frame_types(3, VideoFrameType::kVideoFrameDelta);
+  int64_t total_time_us = 0;
+  for (int i = 0; i < kNumFrames; ++i) {
+    VideoFrame frame = *frame_generator->NextFrame();
+    frame.set_timestamp(90000 / 30 * i);
+    const int64_t start_time_us = rtc::TimeMicros();
+    ASSERT_EQ(0, adapter.Encode(frame, &frame_types));
+    total_time_us += rtc::TimeMicros() - start_time_us;
+  }
+
+  webrtc::test::PrintResult("simulcast_encode", "", trace + "_latency",
+                            static_cast<double>(total_time_us) / kNumFrames,
+                            "us", false);
+  std::vector<SimulcastEncoderAdapter::LayerEncodeStats> stats =
+      adapter.GetLayerEncodeStats();
+  for (size_t i = 0; i < stats.size(); ++i) {
+    webrtc::test::PrintResult(
+        "simulcast_encode", "_stream" + std::to_string(i), trace,
+        static_cast<double>(stats[i].total_encode_time_us) /
+            std::max(stats[i].frames_encoded, 1),
+        "us", false);
+  }
+  adapter.Release();
+}
+
+}  // namespace
+
+TEST(SimulcastEncoderAdapterSimulcastTest, DISABLED_SequentialEncodingPerf) {
+  RunSimulcastEncodePerf("sequential");
+}
+
+TEST(SimulcastEncoderAdapterSimulcastTest, DISABLED_ParallelEncodingPerf) {
+  ScopedFieldTrials field_trials(kParallelEncodingFieldTrial);
+  RunSimulcastEncodePerf("parallel");
+}
+
 }  // namespace test
 }  // namespace webrtc
@@ -162,10 +162,14 @@ int AcmReceiver::GetAudio(int desired_freq_hz,
   // from NetEq changes. See WebRTC issue 3923.
   if (need_resampling) {
     // TODO(yujo): handle this more efficiently for muted frames.
+    // Make room for the resampled audio first, a compact frame may move its
+    // samples when it grows.
+    int16_t* audio_data = audio_frame->mutable_data(
+        rtc::CheckedDivExact(desired_freq_hz, 100), audio_frame->num_channels_);
     int samples_per_channel_int = resampler_.Resample10Msec(
-        audio_frame->data(), current_sample_rate_hz, desired_freq_hz,
-        audio_frame->num_channels_, AudioFrame::kMaxDataSizeSamples,
-        audio_frame->mutable_data());
+        audio_data, current_sample_rate_hz, desired_freq_hz,
+        audio_frame->num_channels_, audio_frame->max_16bit_samples(),
+        audio_data);
     if (samples_per_channel_int < 0) {
       RTC_LOG(LERROR)
           << "AcmReceiver::GetAudio - Resampling audio_buffer_ failed.";
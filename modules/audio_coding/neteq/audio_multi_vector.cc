@@ -206,6 +206,13 @@ bool AudioMultiVector::Empty() const {
   return channels_[0]->Empty();
 }
 
+size_t AudioMultiVector::AllocatedBytes() const {
+  size_t bytes = 0;
+  for (const AudioVector* channel : channels_)
+    bytes += channel->AllocatedBytes();
+  return bytes;
+}
+
 void AudioMultiVector::CopyChannel(size_t from_channel, size_t to_channel) {
   assert(from_channel < num_channels_);
   assert(to_channel < num_channels_);
@@ -117,6 +117,9 @@ class AudioMultiVector {
 
   virtual bool Empty() const;
 
+  // Returns the number of bytes allocated for the samples of all channels.
+  size_t AllocatedBytes() const;
+
   // Copies the data between two channels in the AudioMultiVector. The method
   // does not add any new channel. Thus, |from_channel| and |to_channel| must
   // both be valid channel numbers.
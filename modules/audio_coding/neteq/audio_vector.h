@@ -112,6 +112,9 @@ class AudioVector {
   // Returns true if this AudioVector is empty.
   virtual bool Empty() const;
 
+  // Returns the number of bytes allocated for the samples.
+  size_t AllocatedBytes() const { return capacity_ * sizeof(int16_t); }
+
   // Accesses and modifies an element of AudioVector.
   inline const int16_t& operator[](size_t index) const {
     return array_[WrapIndex(index, begin_index_, capacity_)];
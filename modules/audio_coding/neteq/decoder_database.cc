@@ -230,6 +230,11 @@ AudioDecoder* DecoderDatabase::GetActiveDecoder() const {
   return GetDecoder(active_decoder_type_);
 }
 
+void DecoderDatabase::DropDecoders() {
+  for (const auto& kv : decoders_)
+    kv.second.DropDecoder();
+}
+
 int DecoderDatabase::SetActiveCngDecoder(uint8_t rtp_payload_type) {
   // Check that |rtp_payload_type| exists in the database.
   const DecoderInfo* info = GetDecoderInfo(rtp_payload_type);
@@ -162,6 +162,10 @@ class DecoderDatabase {
   // Returns the current active decoder, or NULL if no active decoder exists.
   virtual AudioDecoder* GetActiveDecoder() const;
 
+  // Deletes the AudioDecoder objects of all payload types. They are recreated
+  // when needed, without the state of the deleted objects.
+  virtual void DropDecoders();
+
   // Sets the active comfort noise decoder to be |rtp_payload_type|. If this
   // call results in a change of active comfort noise decoder, the previous
   // active decoder's AudioDecoder object is deleted.
@@ -16,9 +16,62 @@
 #include <algorithm>  // Access to min, max.
 
 #include "common_audio/signal_processing/include/signal_processing_library.h"
+#include "rtc_base/system/arch.h"
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include <emmintrin.h>
+#endif
+#if defined(WEBRTC_HAS_NEON)
+#include <arm_neon.h>
+#endif
 
 namespace webrtc {
 
+namespace {
+
+// Returns the sum of |data1[j] - data2[j]| over |length| samples.
+int32_t SumOfAbsoluteDifferences(const int16_t* data1,
+                                 const int16_t* data2,
+                                 size_t length) {
+  size_t j = 0;
+  int32_t sum_diff = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  const __m128i zero = _mm_setzero_si128();
+  __m128i sum = _mm_setzero_si128();
+  for (; j + 8 <= length; j += 8) {
+    const __m128i x =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&data1[j]));
+    const __m128i y =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&data2[j]));
+    // The difference between the larger and the smaller value fits in 16 bits
+    // when seen as unsigned.
+    const __m128i diff =
+        _mm_sub_epi16(_mm_max_epi16(x, y), _mm_min_epi16(x, y));
+    sum = _mm_add_epi32(sum, _mm_unpacklo_epi16(diff, zero));
+    sum = _mm_add_epi32(sum, _mm_unpackhi_epi16(diff, zero));
+  }
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1, 0, 3, 2)));
+  sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2, 3, 0, 1)));
+  sum_diff = _mm_cvtsi128_si32(sum);
+#elif defined(WEBRTC_HAS_NEON)
+  int32x4_t sum = vdupq_n_s32(0);
+  for (; j + 8 <= length; j += 8) {
+    const int16x8_t x = vld1q_s16(&data1[j]);
+    const int16x8_t y = vld1q_s16(&data2[j]);
+    sum = vabal_s16(sum, vget_low_s16(x), vget_low_s16(y));
+    sum = vabal_s16(sum, vget_high_s16(x), vget_high_s16(y));
+  }
+  int32x2_t sum2 = vadd_s32(vget_low_s32(sum), vget_high_s32(sum));
+  sum_diff = vget_lane_s32(vpadd_s32(sum2, sum2), 0);
+#endif
+  for (; j < length; j++) {
+    sum_diff += WEBRTC_SPL_ABS_W32(data1[j] - data2[j]);
+  }
+  return sum_diff;
+}
+
+}  // namespace
+
 // Table of constants used in method DspHelper::ParabolicFit().
 const int16_t DspHelper::kParabolaCoefficients[17][3] = {
     {120, 32, 64},   {140, 44, 75},   {150, 50, 80},   {160, 57, 85},
@@ -255,12 +308,7 @@ size_t DspHelper::MinDistortion(const int16_t* signal,
   size_t best_index = 0;
   int32_t min_distortion = WEBRTC_SPL_WORD32_MAX;
   for (size_t i = min_lag; i <= max_lag; i++) {
-    int32_t sum_diff = 0;
-    const int16_t* data1 = signal;
-    const int16_t* data2 = signal - i;
-    for (size_t j = 0; j < length; j++) {
-      sum_diff += WEBRTC_SPL_ABS_W32(data1[j] - data2[j]);
-    }
+    int32_t sum_diff = SumOfAbsoluteDifferences(signal, signal - i, length);
     // Compare with previous minimum.
     if (sum_diff < min_distortion) {
       min_distortion = sum_diff;
@@ -279,7 +327,66 @@ void DspHelper::CrossFade(const int16_t* input1,
                           int16_t* output) {
   int16_t factor = *mix_factor;
   int16_t complement_factor = 16384 - factor;
-  for (size_t i = 0; i < length; i++) {
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  // The factors of eight consecutive samples. Like in the loop below, they
+  // wrap around in 16 bits, and the output is truncated to 16 bits.
+  __m128i factors = _mm_sub_epi16(
+      _mm_set1_epi16(factor),
+      _mm_mullo_epi16(_mm_set1_epi16(factor_decrement),
+                      _mm_setr_epi16(0, 1, 2, 3, 4, 5, 6, 7)));
+  __m128i complement_factors = _mm_sub_epi16(_mm_set1_epi16(16384), factors);
+  const __m128i factors_decrement = _mm_set1_epi16(factor_decrement * 8);
+  const __m128i rounding = _mm_set1_epi32(8192);
+  for (; i + 8 <= length; i += 8) {
+    const __m128i x =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&input1[i]));
+    const __m128i y =
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&input2[i]));
+    __m128i low = _mm_madd_epi16(
+        _mm_unpacklo_epi16(x, y),
+        _mm_unpacklo_epi16(factors, complement_factors));
+    __m128i high = _mm_madd_epi16(
+        _mm_unpackhi_epi16(x, y),
+        _mm_unpackhi_epi16(factors, complement_factors));
+    low = _mm_srai_epi32(_mm_add_epi32(low, rounding), 14);
+    high = _mm_srai_epi32(_mm_add_epi32(high, rounding), 14);
+    // Sign extend the lower 16 bits, so that packing doesn't saturate.
+    low = _mm_srai_epi32(_mm_slli_epi32(low, 16), 16);
+    high = _mm_srai_epi32(_mm_slli_epi32(high, 16), 16);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(&output[i]),
+                     _mm_packs_epi32(low, high));
+    factors = _mm_sub_epi16(factors, factors_decrement);
+    complement_factors = _mm_add_epi16(complement_factors, factors_decrement);
+  }
+  factor -= static_cast<int16_t>(factor_decrement * i);
+  complement_factor += static_cast<int16_t>(factor_decrement * i);
+#elif defined(WEBRTC_HAS_NEON)
+  // The factors of eight consecutive samples. Like in the loop below, they
+  // wrap around in 16 bits, and the output is truncated to 16 bits.
+  const int16_t kIndices[8] = {0, 1, 2, 3, 4, 5, 6, 7};
+  int16x8_t factors = vmlsq_n_s16(vdupq_n_s16(factor), vld1q_s16(kIndices),
+                                  factor_decrement);
+  int16x8_t complement_factors = vsubq_s16(vdupq_n_s16(16384), factors);
+  const int16x8_t factors_decrement = vdupq_n_s16(factor_decrement * 8);
+  for (; i + 8 <= length; i += 8) {
+    const int16x8_t x = vld1q_s16(&input1[i]);
+    const int16x8_t y = vld1q_s16(&input2[i]);
+    int32x4_t low = vmull_s16(vget_low_s16(factors), vget_low_s16(x));
+    low = vmlal_s16(low, vget_low_s16(complement_factors), vget_low_s16(y));
+    int32x4_t high = vmull_s16(vget_high_s16(factors), vget_high_s16(x));
+    high =
+        vmlal_s16(high, vget_high_s16(complement_factors), vget_high_s16(y));
+    low = vshrq_n_s32(vaddq_s32(low, vdupq_n_s32(8192)), 14);
+    high = vshrq_n_s32(vaddq_s32(high, vdupq_n_s32(8192)), 14);
+    vst1q_s16(&output[i], vcombine_s16(vmovn_s32(low), vmovn_s32(high)));
+    factors = vsubq_s16(factors, factors_decrement);
+    complement_factors = vaddq_s16(complement_factors, factors_decrement);
+  }
+  factor -= static_cast<int16_t>(factor_decrement * i);
+  complement_factor += static_cast<int16_t>(factor_decrement * i);
+#endif
+  for (; i < length; i++) {
     output[i] =
         (factor * input1[i] + complement_factor * input2[i] + 8192) >> 14;
     factor -= factor_decrement;
@@ -10,7 +10,14 @@
 
 #include "modules/audio_coding/neteq/dsp_helper.h"
 
+#include <stdlib.h>
+
+#include <algorithm>
+#include <limits>
+#include <vector>
+
 #include "modules/audio_coding/neteq/audio_multi_vector.h"
+#include "rtc_base/random.h"
 #include "test/gtest.h"
 
 namespace webrtc {
@@ -85,4 +92,70 @@ TEST(DspHelper, RampSignalAudioMultiVector) {
     }
   }
 }
+
+// The vectorized versions must match the sample by sample computation, with
+// the same 16 bit wrap-around of the factors and truncation of the output.
+TEST(DspHelper, CrossFadeIsBitExact) {
+  Random random(17);
+  const size_t kLength = 203;
+  std::vector<int16_t> input1(kLength);
+  std::vector<int16_t> input2(kLength);
+  for (size_t i = 0; i < kLength; ++i) {
+    input1[i] = random.Rand<int16_t>();
+    input2[i] = random.Rand<int16_t>();
+  }
+  input1[9] = -32768;
+  input2[9] = -32768;
+  for (int16_t factor_decrement : {0, 1, 80, 163, 16384, -100}) {
+    for (size_t length : {1, 7, 8, 9, 64, 203}) {
+      int16_t expected[kLength];
+      int16_t factor = 16384;
+      int16_t complement_factor = 0;
+      for (size_t i = 0; i < length; ++i) {
+        expected[i] = (factor * input1[i] + complement_factor * input2[i] +
+                       8192) >> 14;
+        factor -= factor_decrement;
+        complement_factor += factor_decrement;
+      }
+      int16_t output[kLength];
+      int16_t mix_factor = 16384;
+      DspHelper::CrossFade(input1.data(), input2.data(), length, &mix_factor,
+                           factor_decrement, output);
+      EXPECT_EQ(factor, mix_factor);
+      EXPECT_TRUE(std::equal(expected, expected + length, output));
+    }
+  }
+}
+
+TEST(DspHelper, MinDistortionIsBitExact) {
+  Random random(17);
+  const size_t kMaxLag = 60;
+  const size_t kLength = 125;
+  std::vector<int16_t> signal(kMaxLag + kLength);
+  for (int16_t& sample : signal) {
+    sample = random.Rand<int16_t>();
+  }
+  signal[kMaxLag + 3] = -32768;
+  signal[kMaxLag + 4] = 32767;
+  const int16_t* data = &signal[kMaxLag];
+  for (size_t length : {1, 8, 15, 125}) {
+    size_t expected_lag = 0;
+    int32_t expected_distortion = std::numeric_limits<int32_t>::max();
+    for (size_t lag = 10; lag <= kMaxLag; ++lag) {
+      int32_t sum = 0;
+      for (size_t j = 0; j < length; ++j) {
+        sum += abs(data[j] - data[j - lag]);
+      }
+      if (sum < expected_distortion) {
+        expected_distortion = sum;
+        expected_lag = lag;
+      }
+    }
+    int32_t distortion;
+    EXPECT_EQ(expected_lag,
+              DspHelper::MinDistortion(data, 10, kMaxLag, length, &distortion));
+    EXPECT_EQ(expected_distortion, distortion);
+  }
+}
+
 }  // namespace webrtc
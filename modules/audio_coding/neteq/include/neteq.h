@@ -58,6 +58,9 @@ struct NetEqNetworkStatistics {
   int median_waiting_time_ms;
   int min_waiting_time_ms;
   int max_waiting_time_ms;
+  // Memory held by the NetEq instance for its audio buffers, decoder scratch
+  // space and buffered packets, in bytes. Decoder state is not included.
+  size_t allocated_bytes;
 };
 
 // NetEq statistics that persist over the lifetime of the class.
@@ -137,6 +140,10 @@ class NetEq {
     bool enable_fast_accelerate = false;
     bool enable_muted_state = false;
     bool enable_rtx_handling = false;
+    // Sizes the audio buffers from the sample rate of the current decoder
+    // instead of for 48 kHz, and releases the decoders and the decoding scratch
+    // space while in muted state. Meant for servers receiving many streams.
+    bool enable_compact_memory = false;
     absl::optional<AudioCodecPairId> codec_pair_id;
     bool for_test_no_time_stretching = false;  // Use only for testing.
   };
@@ -264,6 +271,10 @@ class NetEq {
   virtual absl::optional<SdpAudioFormat> GetDecoderFormat(
       int payload_type) const = 0;
 
+  // Returns the format of the decoder for the payload type of the most recently
+  // inserted speech packet. Returns empty if no such packet was inserted yet.
+  virtual absl::optional<SdpAudioFormat> GetCurrentDecoderFormat() const = 0;
+
   // Flushes both the packet buffer and the sync buffer.
   virtual void FlushBuffers() = 0;
 
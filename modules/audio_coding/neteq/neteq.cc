@@ -31,7 +31,9 @@ std::string NetEq::Config::ToString() const {
      << ", min_delay_ms=" << min_delay_ms << ", enable_fast_accelerate="
      << (enable_fast_accelerate ? "true" : "false")
      << ", enable_muted_state=" << (enable_muted_state ? "true" : "false")
-     << ", enable_rtx_handling=" << (enable_rtx_handling ? "true" : "false");
+     << ", enable_rtx_handling=" << (enable_rtx_handling ? "true" : "false")
+     << ", enable_compact_memory="
+     << (enable_compact_memory ? "true" : "false");
   return ss.str();
 }
 
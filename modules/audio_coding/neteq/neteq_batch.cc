@@ -0,0 +1,269 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_coding/neteq/neteq_batch.h"
+
+#include <algorithm>
+#include <string>
+#include <tuple>
+#include <utility>
+
+#include "absl/memory/memory.h"
+#include "absl/strings/ascii.h"
+#include "api/function_view.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+namespace {
+
+// The streams are ordered by codec again every second.
+constexpr int kRegroupIntervalTicks = 100;
+// Streams are taken from the ranges of the threads in chunks of this size.
+constexpr size_t kChunkSize = 8;
+// Fewer streams than this per thread are pulled faster on the calling thread
+// than the worker threads wake up.
+constexpr size_t kMinStreamsPerThread = 32;
+
+using CodecKey = std::tuple<std::string, int, size_t>;
+
+CodecKey GetCodecKey(const NetEq& neteq) {
+  const absl::optional<SdpAudioFormat> format =
+      neteq.GetCurrentDecoderFormat();
+  if (!format) {
+    return CodecKey();
+  }
+  return CodecKey(absl::AsciiStrToLower(format->name), format->clockrate_hz,
+                  format->num_channels);
+}
+
+}  // namespace
+
+class NetEqBatch::ThreadPool {
+ public:
+  explicit ThreadPool(int num_threads) : ranges_(num_threads) {
+    RTC_DCHECK_GT(num_threads, 1);
+    for (int i = 1; i < num_threads; ++i) {
+      workers_.push_back(absl::make_unique<Worker>());
+      Worker* worker = workers_.back().get();
+      worker->pool = this;
+      worker->index = i;
+      worker->thread = absl::make_unique<rtc::PlatformThread>(
+          &ThreadPool::ThreadMain, worker, "NetEqBatch" + std::to_string(i),
+          rtc::kRealtimePriority);
+      worker->thread->Start();
+    }
+  }
+
+  ~ThreadPool() {
+    {
+      rtc::CritScope lock(&crit_);
+      quit_ = true;
+    }
+    for (auto& worker : workers_) {
+      worker->start.Set();
+      worker->thread->Stop();
+    }
+  }
+
+  int num_threads() const { return static_cast<int>(ranges_.size()); }
+
+  // Calls |process| for each index in [0, |num_items|), on the worker threads
+  // and the calling thread. Returns when all items are processed.
+  void Run(size_t num_items, rtc::FunctionView<void(size_t)> process) {
+    const size_t num_ranges = ranges_.size();
+    for (size_t i = 0; i < num_ranges; ++i) {
+      rtc::CritScope lock(&ranges_[i].crit);
+      ranges_[i].begin = num_items * i / num_ranges;
+      ranges_[i].end = num_items * (i + 1) / num_ranges;
+    }
+    {
+      rtc::CritScope lock(&crit_);
+      process_ = &process;
+      num_busy_workers_ = static_cast<int>(workers_.size());
+    }
+    for (auto& worker : workers_)
+      worker->start.Set();
+    ProcessRanges(0);
+    // Wait for all workers, not only all items, so that no worker looks at
+    // |process_| after it goes out of scope.
+    done_.Wait(rtc::Event::kForever);
+  }
+
+ private:
+  // The items left to process by one thread, [begin, end).
+  struct Range {
+    rtc::CriticalSection crit;
+    size_t begin RTC_GUARDED_BY(crit) = 0;
+    size_t end RTC_GUARDED_BY(crit) = 0;
+  };
+
+  struct Worker {
+    ThreadPool* pool = nullptr;
+    int index = 0;
+    rtc::Event start;
+    std::unique_ptr<rtc::PlatformThread> thread;
+  };
+
+  static void ThreadMain(void* context) {
+    Worker* worker = static_cast<Worker*>(context);
+    while (true) {
+      worker->start.Wait(rtc::Event::kForever);
+      if (!worker->pool->RunWorker(worker->index))
+        return;
+    }
+  }
+
+  // Returns false if the pool is shutting down.
+  bool RunWorker(int index) {
+    {
+      rtc::CritScope lock(&crit_);
+      if (quit_)
+        return false;
+    }
+    ProcessRanges(index);
+    rtc::CritScope lock(&crit_);
+    if (--num_busy_workers_ == 0)
+      done_.Set();
+    return true;
+  }
+
+  // Processes the range of thread |index| from the front, then steals from
+  // the other ranges until all are empty.
+  void ProcessRanges(int index) {
+    rtc::FunctionView<void(size_t)>* process;
+    {
+      rtc::CritScope lock(&crit_);
+      process = process_;
+    }
+    size_t begin;
+    size_t end;
+    while (TakeFromFront(index, &begin, &end) || Steal(&begin, &end)) {
+      for (size_t i = begin; i < end; ++i)
+        (*process)(i);
+    }
+  }
+
+  bool TakeFromFront(int index, size_t* begin, size_t* end) {
+    Range& range = ranges_[index];
+    rtc::CritScope lock(&range.crit);
+    if (range.begin == range.end)
+      return false;
+    *begin = range.begin;
+    *end = std::min(range.begin + kChunkSize, range.end);
+    range.begin = *end;
+    return true;
+  }
+
+  // Takes a chunk from the end of the range with the most items left.
+  // Returns false when all ranges are empty.
+  bool Steal(size_t* begin, size_t* end) {
+    while (true) {
+      Range* victim = nullptr;
+      size_t max_items_left = 0;
+      for (Range& range : ranges_) {
+        rtc::CritScope lock(&range.crit);
+        if (range.end - range.begin > max_items_left) {
+          max_items_left = range.end - range.begin;
+          victim = &range;
+        }
+      }
+      if (!victim)
+        return false;
+      rtc::CritScope lock(&victim->crit);
+      // The owner may have emptied the range since it was looked at.
+      if (victim->begin == victim->end)
+        continue;
+      *end = victim->end;
+      *begin =
+          victim->end - std::min(kChunkSize, victim->end - victim->begin);
+      victim->end = *begin;
+      return true;
+    }
+  }
+
+  std::vector<Range> ranges_;
+  std::vector<std::unique_ptr<Worker>> workers_;
+  rtc::Event done_;
+  rtc::CriticalSection crit_;
+  bool quit_ RTC_GUARDED_BY(crit_) = false;
+  rtc::FunctionView<void(size_t)>* process_ RTC_GUARDED_BY(crit_) = nullptr;
+  int num_busy_workers_ RTC_GUARDED_BY(crit_) = 0;
+};
+
+NetEqBatch::NetEqBatch(int num_threads)
+    : thread_pool_(num_threads > 1 ? absl::make_unique<ThreadPool>(num_threads)
+                                   : nullptr) {}
+
+NetEqBatch::~NetEqBatch() = default;
+
+NetEqBatch::Stream* NetEqBatch::AddStream(NetEq* neteq) {
+  RTC_DCHECK(neteq);
+  streams_.push_back(absl::make_unique<Stream>(neteq));
+  Regroup();
+  return streams_.back().get();
+}
+
+void NetEqBatch::RemoveStream(Stream* stream) {
+  auto it = std::find_if(
+      streams_.begin(), streams_.end(),
+      [stream](const std::unique_ptr<Stream>& s) { return s.get() == stream; });
+  RTC_DCHECK(it != streams_.end());
+  // Removing a stream keeps the others grouped.
+  streams_.erase(it);
+}
+
+void NetEqBatch::GetAudio() {
+  if (ticks_until_regroup_ <= 0) {
+    GroupStreamsByCodec();
+    ticks_until_regroup_ = kRegroupIntervalTicks;
+  }
+  --ticks_until_regroup_;
+
+  auto get_audio = [this](size_t index) {
+    Stream* stream = streams_[index].get();
+    stream->result =
+        stream->neteq->GetAudio(&stream->audio_frame, &stream->muted);
+  };
+  if (thread_pool_ && streams_.size() >= 2 * kMinStreamsPerThread) {
+    thread_pool_->Run(streams_.size(), get_audio);
+  } else {
+    for (size_t i = 0; i < streams_.size(); ++i)
+      get_audio(i);
+  }
+}
+
+int NetEqBatch::num_threads() const {
+  return thread_pool_ ? thread_pool_->num_threads() : 1;
+}
+
+void NetEqBatch::GroupStreamsByCodec() {
+  std::vector<std::pair<CodecKey, std::unique_ptr<Stream>>> keyed_streams;
+  keyed_streams.reserve(streams_.size());
+  for (auto& stream : streams_) {
+    CodecKey key = GetCodecKey(*stream->neteq);
+    keyed_streams.emplace_back(std::move(key), std::move(stream));
+  }
+  // A stable sort keeps the order of the streams within a group, so that
+  // their memory is visited in the same order from one pass to the next.
+  std::stable_sort(keyed_streams.begin(), keyed_streams.end(),
+                   [](const std::pair<CodecKey, std::unique_ptr<Stream>>& a,
+                      const std::pair<CodecKey, std::unique_ptr<Stream>>& b) {
+                     return a.first < b.first;
+                   });
+  for (size_t i = 0; i < keyed_streams.size(); ++i)
+    streams_[i] = std::move(keyed_streams[i].second);
+}
+
+}  // namespace webrtc
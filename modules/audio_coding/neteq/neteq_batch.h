@@ -0,0 +1,90 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_CODING_NETEQ_NETEQ_BATCH_H_
+#define MODULES_AUDIO_CODING_NETEQ_NETEQ_BATCH_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <vector>
+
+#include "api/audio/audio_frame.h"
+#include "modules/audio_coding/neteq/include/neteq.h"
+#include "rtc_base/constructor_magic.h"
+
+namespace webrtc {
+
+// Pulls 10 ms of audio from many NetEq instances in one pass, e.g. for all the
+// receive streams of an audio bridge, instead of one GetAudio() call at a time
+// from objects scattered in memory.
+//
+// The instances are ordered by the codec they currently decode, so that
+// instances using the same decoder run back to back and find its code and
+// tables in the cache. The order is refreshed every second, when a stream is
+// added, and on request.
+//
+// With more than one thread, the streams are split into one contiguous range
+// per thread. A thread that finishes its range early steals chunks from the
+// end of the range with the most work left, so a few expensive streams, e.g.
+// ones concealing losses, don't hold up the whole pass.
+//
+// The methods of this class must be called on one thread at a time. The NetEq
+// instances may receive packets from other threads while GetAudio() runs.
+class NetEqBatch {
+ public:
+  // A NetEq instance in the batch, and its output from the last GetAudio().
+  struct Stream {
+    explicit Stream(NetEq* neteq) : neteq(neteq) {}
+
+    NetEq* const neteq;
+    AudioFrame audio_frame;
+    bool muted = false;
+    // Return value of NetEq::GetAudio().
+    int result = NetEq::kOK;
+  };
+
+  // Runs GetAudio() on the calling thread and |num_threads| - 1 worker
+  // threads.
+  explicit NetEqBatch(int num_threads);
+  ~NetEqBatch();
+
+  // Adds |neteq|, which must outlive its stream. The returned stream is owned
+  // by the batch and valid until RemoveStream() is called.
+  Stream* AddStream(NetEq* neteq);
+  void RemoveStream(Stream* stream);
+
+  // Calls NetEq::GetAudio() once for every stream. Returns when all streams
+  // have their new audio frame.
+  void GetAudio();
+
+  // Orders the streams by codec again on the next GetAudio(), e.g. after the
+  // payload types of many streams changed.
+  void Regroup() { ticks_until_regroup_ = 0; }
+
+  size_t num_streams() const { return streams_.size(); }
+  int num_threads() const;
+
+ private:
+  class ThreadPool;
+
+  // Orders |streams_| by the current codec of their NetEq instances.
+  void GroupStreamsByCodec();
+
+  std::vector<std::unique_ptr<Stream>> streams_;
+  int ticks_until_regroup_ = 0;
+  const std::unique_ptr<ThreadPool> thread_pool_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(NetEqBatch);
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_CODING_NETEQ_NETEQ_BATCH_H_
@@ -0,0 +1,163 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_coding/neteq/neteq_batch.h"
+
+#include <algorithm>
+#include <memory>
+#include <vector>
+
+#include "absl/memory/memory.h"
+#include "api/audio/audio_frame.h"
+#include "api/audio_codecs/builtin_audio_decoder_factory.h"
+#include "modules/audio_coding/codecs/pcm16b/pcm16b.h"
+#include "modules/audio_coding/neteq/include/neteq.h"
+#include "modules/audio_coding/neteq/tools/rtp_generator.h"
+#include "system_wrappers/include/clock.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+constexpr int kPayloadType = 95;
+constexpr int kFrameSizeMs = 20;
+
+// One sender, whose packets are inserted into a NetEq pulled by the batch and
+// a reference NetEq pulled directly.
+class Sender {
+ public:
+  Sender(int sample_rate_hz, int loss_period)
+      : sample_rate_hz_(sample_rate_hz),
+        loss_period_(loss_period),
+        rtp_generator_(sample_rate_hz / 1000) {}
+
+  // Inserts the packets sent up to |time_ms|.
+  void InsertPackets(int time_ms, NetEq* neteq, NetEq* reference_neteq) {
+    const size_t samples_per_packet = kFrameSizeMs * sample_rate_hz_ / 1000;
+    while (next_packet_time_ms_ <= time_ms) {
+      RTPHeader header;
+      next_packet_time_ms_ = static_cast<int>(
+          rtp_generator_.GetRtpHeader(kPayloadType, samples_per_packet,
+                                      &header));
+      std::vector<int16_t> samples(samples_per_packet);
+      for (size_t i = 0; i < samples.size(); ++i) {
+        samples[i] = static_cast<int16_t>((num_samples_sent_ + i) * 1009);
+      }
+      num_samples_sent_ += samples_per_packet;
+      std::vector<uint8_t> payload(2 * samples_per_packet);
+      WebRtcPcm16b_Encode(samples.data(), samples.size(), payload.data());
+      if (loss_period_ > 0 && header.sequenceNumber % loss_period_ == 0)
+        continue;
+      const uint32_t receive_timestamp = time_ms * (sample_rate_hz_ / 1000);
+      ASSERT_EQ(NetEq::kOK,
+                neteq->InsertPacket(header, payload, receive_timestamp));
+      ASSERT_EQ(NetEq::kOK, reference_neteq->InsertPacket(
+                                header, payload, receive_timestamp));
+    }
+  }
+
+ private:
+  const int sample_rate_hz_;
+  const int loss_period_;
+  test::RtpGenerator rtp_generator_;
+  int next_packet_time_ms_ = 0;
+  size_t num_samples_sent_ = 0;
+};
+
+std::unique_ptr<NetEq> CreateNetEq(int sample_rate_hz, Clock* clock) {
+  NetEq::Config config;
+  config.sample_rate_hz = sample_rate_hz;
+  std::unique_ptr<NetEq> neteq(
+      NetEq::Create(config, clock, CreateBuiltinAudioDecoderFactory()));
+  EXPECT_TRUE(neteq->RegisterPayloadType(
+      kPayloadType, SdpAudioFormat("l16", sample_rate_hz, 1)));
+  return neteq;
+}
+
+}  // namespace
+
+class NetEqBatchTest : public ::testing::TestWithParam<int> {
+ protected:
+  NetEqBatchTest() : clock_(0) {}
+
+  SimulatedClock clock_;
+};
+
+TEST_P(NetEqBatchTest, GivesSameOutputAsSeparateGetAudioCalls) {
+  // Enough streams to use all threads, in interleaved codecs.
+  const int kNumStreams = 150;
+  const int kSampleRatesHz[] = {8000, 16000, 32000};
+  NetEqBatch batch(GetParam());
+  std::vector<std::unique_ptr<Sender>> senders;
+  std::vector<std::unique_ptr<NetEq>> neteqs;
+  std::vector<std::unique_ptr<NetEq>> reference_neteqs;
+  std::vector<NetEqBatch::Stream*> streams;
+  for (int i = 0; i < kNumStreams; ++i) {
+    const int sample_rate_hz = kSampleRatesHz[i % 3];
+    senders.push_back(absl::make_unique<Sender>(sample_rate_hz, 5 + i % 7));
+    neteqs.push_back(CreateNetEq(sample_rate_hz, &clock_));
+    reference_neteqs.push_back(CreateNetEq(sample_rate_hz, &clock_));
+    streams.push_back(batch.AddStream(neteqs.back().get()));
+  }
+  EXPECT_EQ(static_cast<size_t>(kNumStreams), batch.num_streams());
+  EXPECT_FALSE(neteqs[1]->GetCurrentDecoderFormat());
+
+  AudioFrame reference_frame;
+  for (int time_ms = 0; time_ms < 3000; time_ms += 10) {
+    for (int i = 0; i < kNumStreams; ++i) {
+      senders[i]->InsertPackets(time_ms, neteqs[i].get(),
+                                reference_neteqs[i].get());
+    }
+    batch.GetAudio();
+    for (int i = 0; i < kNumStreams; ++i) {
+      bool muted;
+      ASSERT_EQ(NetEq::kOK,
+                reference_neteqs[i]->GetAudio(&reference_frame, &muted));
+      ASSERT_EQ(NetEq::kOK, streams[i]->result);
+      EXPECT_EQ(muted, streams[i]->muted);
+      ASSERT_EQ(reference_frame.samples_per_channel_,
+                streams[i]->audio_frame.samples_per_channel_);
+      ASSERT_TRUE(std::equal(
+          reference_frame.data(),
+          reference_frame.data() + reference_frame.samples_per_channel_,
+          streams[i]->audio_frame.data()))
+          << "Stream " << i << " at " << time_ms << " ms";
+    }
+    clock_.AdvanceTimeMilliseconds(10);
+  }
+  absl::optional<SdpAudioFormat> format = neteqs[1]->GetCurrentDecoderFormat();
+  ASSERT_TRUE(format);
+  EXPECT_EQ("l16", format->name);
+  EXPECT_EQ(16000, format->clockrate_hz);
+}
+
+TEST_P(NetEqBatchTest, RemovesStreams) {
+  NetEqBatch batch(GetParam());
+  std::vector<std::unique_ptr<NetEq>> neteqs;
+  std::vector<NetEqBatch::Stream*> streams;
+  for (int i = 0; i < 100; ++i) {
+    neteqs.push_back(CreateNetEq(16000, &clock_));
+    streams.push_back(batch.AddStream(neteqs.back().get()));
+  }
+  batch.RemoveStream(streams[10]);
+  neteqs[10].reset();
+  batch.GetAudio();
+  EXPECT_EQ(99u, batch.num_streams());
+  for (int i = 0; i < 100; ++i) {
+    if (i == 10)
+      continue;
+    EXPECT_EQ(NetEq::kOK, streams[i]->result);
+    EXPECT_EQ(160u, streams[i]->audio_frame.samples_per_channel_);
+  }
+}
+
+INSTANTIATE_TEST_SUITE_P(NumThreads, NetEqBatchTest, ::testing::Values(1, 3));
+
+}  // namespace webrtc
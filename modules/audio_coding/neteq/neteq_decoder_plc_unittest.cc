@@ -22,6 +22,7 @@
 #include "modules/audio_coding/neteq/tools/encode_neteq_input.h"
 #include "modules/audio_coding/neteq/tools/fake_decode_from_file.h"
 #include "modules/audio_coding/neteq/tools/input_audio_file.h"
+#include "modules/audio_coding/neteq/tools/neteq_input.h"
 #include "modules/audio_coding/neteq/tools/neteq_test.h"
 #include "rtc_base/numerics/safe_conversions.h"
 #include "rtc_base/ref_counted_object.h"
@@ -102,43 +103,6 @@ class ZeroSampleGenerator : public EncodeNetEqInput::Generator {
   std::vector<int16_t> vec;
 };
 
-// A NetEqInput which connects to another NetEqInput, but drops a number of
-// packets on the way.
-class LossyInput : public NetEqInput {
- public:
-  LossyInput(int loss_cadence, std::unique_ptr<NetEqInput> input)
-      : loss_cadence_(loss_cadence), input_(std::move(input)) {}
-
-  absl::optional<int64_t> NextPacketTime() const override {
-    return input_->NextPacketTime();
-  }
-
-  absl::optional<int64_t> NextOutputEventTime() const override {
-    return input_->NextOutputEventTime();
-  }
-
-  std::unique_ptr<PacketData> PopPacket() override {
-    if (loss_cadence_ != 0 && (++count_ % loss_cadence_) == 0) {
-      // Pop one extra packet to create the loss.
-      input_->PopPacket();
-    }
-    return input_->PopPacket();
-  }
-
-  void AdvanceOutputEvent() override { return input_->AdvanceOutputEvent(); }
-
-  bool ended() const override { return input_->ended(); }
-
-  absl::optional<RTPHeader> NextHeader() const override {
-    return input_->NextHeader();
-  }
-
- private:
-  const int loss_cadence_;
-  int count_ = 0;
-  const std::unique_ptr<NetEqInput> input_;
-};
-
 class AudioChecksumWithOutput : public AudioChecksum {
  public:
   explicit AudioChecksumWithOutput(std::string* output_str)
@@ -168,7 +132,7 @@ NetEqNetworkStatistics RunTest(int loss_cadence, std::string* checksum) {
       std::move(generator), std::move(encoder), kRunTimeMs);
   // Wrap the input in a loss function.
   auto lossy_input =
-      absl::make_unique<LossyInput>(loss_cadence, std::move(input));
+      absl::make_unique<LossyNetEqInput>(std::move(input), loss_cadence);
 
   // Settinng up decoders.
   NetEqTest::DecoderMap decoders;
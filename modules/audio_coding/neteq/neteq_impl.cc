@@ -108,8 +108,10 @@ NetEqImpl::NetEqImpl(const NetEq::Config& config,
       preemptive_expand_factory_(std::move(deps.preemptive_expand_factory)),
       stats_(std::move(deps.stats)),
       last_mode_(kModeNormal),
-      decoded_buffer_length_(kMaxFrameSize),
-      decoded_buffer_(new int16_t[decoded_buffer_length_]),
+      decoded_buffer_length_(config.enable_compact_memory ? 0 : kMaxFrameSize),
+      decoded_buffer_(config.enable_compact_memory
+                          ? nullptr
+                          : new int16_t[decoded_buffer_length_]),
       playout_timestamp_(0),
       new_codec_(false),
       timestamp_(0),
@@ -118,6 +120,7 @@ NetEqImpl::NetEqImpl(const NetEq::Config& config,
       enable_fast_accelerate_(config.enable_fast_accelerate),
       nack_enabled_(false),
       enable_muted_state_(config.enable_muted_state),
+      enable_compact_memory_(config.enable_compact_memory),
       expand_uma_logger_("WebRTC.Audio.ExpandRatePercent",
                          10,  // Report once every 10 s.
                          tick_timer_.get()),
@@ -342,6 +345,7 @@ int NetEqImpl::NetworkStatistics(NetEqNetworkStatistics* stats) {
                                     stats);
   stats_->GetNetworkStatistics(fs_hz_, total_samples_in_buffers,
                                decoder_frame_length_, stats);
+  stats->allocated_bytes = AllocatedBytes();
   return 0;
 }
 
@@ -410,6 +414,18 @@ absl::optional<SdpAudioFormat> NetEqImpl::GetDecoderFormat(
   return format;
 }
 
+absl::optional<SdpAudioFormat> NetEqImpl::GetCurrentDecoderFormat() const {
+  absl::optional<uint8_t> payload_type;
+  {
+    rtc::CritScope lock(&crit_sect_);
+    payload_type = current_rtp_payload_type_;
+  }
+  if (!payload_type) {
+    return absl::nullopt;
+  }
+  return GetDecoderFormat(*payload_type);
+}
+
 void NetEqImpl::FlushBuffers() {
   rtc::CritScope lock(&crit_sect_);
   RTC_LOG(LS_VERBOSE) << "FlushBuffers";
@@ -796,9 +812,13 @@ int NetEqImpl::GetAudioInternal(AudioFrame* audio_frame,
                   static_cast<uint32_t>(audio_frame->samples_per_channel_);
     audio_frame->num_channels_ = sync_buffer_->Channels();
     stats_->ExpandedNoiseSamples(output_size_samples_, false);
+    if (enable_compact_memory_ && decoded_buffer_)
+      ReleaseIdleMemory();
     *muted = true;
     return 0;
   }
+  if (!decoded_buffer_)
+    decoded_buffer_.reset(new int16_t[decoded_buffer_length_]);
   int return_value = GetDecision(&operation, &packet_list, &dtmf_event,
                                  &play_dtmf, action_override);
   if (return_value != 0) {
@@ -1433,7 +1453,8 @@ int NetEqImpl::DecodeLoop(PacketList* packet_list,
     // The number of channels in the |sync_buffer_| should be the same as the
     // number decoder channels.
     assert(sync_buffer_->Channels() == decoder->Channels());
-    assert(decoded_buffer_length_ >= kMaxFrameSize * decoder->Channels());
+    assert(enable_compact_memory_ ||
+           decoded_buffer_length_ >= kMaxFrameSize * decoder->Channels());
     assert(operation == kNormal || operation == kAccelerate ||
            operation == kFastAccelerate || operation == kMerge ||
            operation == kPreemptiveExpand);
@@ -2040,7 +2061,11 @@ void NetEqImpl::SetSampleRateAndChannels(int fs_hz, size_t channels) {
   algorithm_buffer_.reset(new AudioMultiVector(channels));
 
   // Delete sync buffer and create a new one.
-  sync_buffer_.reset(new SyncBuffer(channels, kSyncBufferSize * fs_mult_));
+  const size_t sync_buffer_size =
+      enable_compact_memory_
+          ? static_cast<size_t>(kSyncBufferSizeMs * fs_hz / 1000)
+          : kSyncBufferSize * fs_mult_;
+  sync_buffer_.reset(new SyncBuffer(channels, sync_buffer_size));
 
   // Delete BackgroundNoise object and create a new one.
   background_noise_.reset(new BackgroundNoise(channels));
@@ -2065,9 +2090,16 @@ void NetEqImpl::SetSampleRateAndChannels(int fs_hz, size_t channels) {
   comfort_noise_.reset(
       new ComfortNoise(fs_hz, decoder_database_.get(), sync_buffer_.get()));
 
-  // Verify that |decoded_buffer_| is long enough.
-  if (decoded_buffer_length_ < kMaxFrameSize * channels) {
-    // Reallocate to larger size.
+  if (enable_compact_memory_) {
+    // Size |decoded_buffer_| for the new sample rate and channels.
+    const size_t decoded_buffer_length =
+        static_cast<size_t>(kMaxFrameSizeMs * fs_hz / 1000) * channels;
+    if (decoded_buffer_length_ != decoded_buffer_length) {
+      decoded_buffer_length_ = decoded_buffer_length;
+      decoded_buffer_.reset(new int16_t[decoded_buffer_length_]);
+    }
+  } else if (decoded_buffer_length_ < kMaxFrameSize * channels) {
+    // Verify that |decoded_buffer_| is long enough. Reallocate to larger size.
     decoded_buffer_length_ = kMaxFrameSize * channels;
     decoded_buffer_.reset(new int16_t[decoded_buffer_length_]);
   }
@@ -2099,6 +2131,24 @@ NetEqImpl::OutputType NetEqImpl::LastOutputType() {
   }
 }
 
+void NetEqImpl::ReleaseIdleMemory() {
+  RTC_DCHECK(packet_buffer_->Empty());
+  decoder_database_->DropDecoders();
+  decoded_buffer_.reset();
+  // The algorithm buffer only holds samples during a GetAudio() call.
+  const size_t channels = algorithm_buffer_->Channels();
+  algorithm_buffer_.reset(new AudioMultiVector(channels));
+}
+
+size_t NetEqImpl::AllocatedBytes() const {
+  size_t bytes = sizeof(*this) + sync_buffer_->AllocatedBytes() +
+                 algorithm_buffer_->AllocatedBytes() +
+                 packet_buffer_->NumPacketsInBuffer() * sizeof(Packet);
+  if (decoded_buffer_)
+    bytes += decoded_buffer_length_ * sizeof(int16_t);
+  return bytes;
+}
+
 void NetEqImpl::CreateDecisionLogic() {
   decision_logic_.reset(DecisionLogic::Create(
       fs_hz_, output_size_samples_, no_time_stretching_,
@@ -189,6 +189,8 @@ class NetEqImpl : public webrtc::NetEq {
   absl::optional<SdpAudioFormat> GetDecoderFormat(
       int payload_type) const override;
 
+  absl::optional<SdpAudioFormat> GetCurrentDecoderFormat() const override;
+
   // Flushes both the packet buffer and the sync buffer.
   void FlushBuffers() override;
 
@@ -213,6 +215,10 @@ class NetEqImpl : public webrtc::NetEq {
   // Current value is kMaxFrameSize + 60 ms * 48 kHz, which is enough for
   // calculating correlations of current frame against history.
   static const size_t kSyncBufferSize = kMaxFrameSize + 60 * 48;
+  // With Config::enable_compact_memory, the buffers above hold the same
+  // durations at the sample rate of the current decoder instead.
+  static const int kMaxFrameSizeMs = 120;
+  static const int kSyncBufferSizeMs = kMaxFrameSizeMs + 60;
 
   // Inserts a new packet into NetEq. This is used by the InsertPacket method
   // above. Returns 0 on success, otherwise an error code.
@@ -339,6 +345,14 @@ class NetEqImpl : public webrtc::NetEq {
   // GetAudio().
   OutputType LastOutputType() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_sect_);
 
+  // Frees the decoders and the decoding scratch space while there is nothing
+  // to decode. They are recreated when the next packet is decoded.
+  void ReleaseIdleMemory() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_sect_);
+
+  // Returns the number of bytes held by this instance, as reported in
+  // NetEqNetworkStatistics::allocated_bytes.
+  size_t AllocatedBytes() const RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_sect_);
+
   // Updates Expand and Merge.
   virtual void UpdatePlcComponents(int fs_hz, size_t channels)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_sect_);
@@ -408,6 +422,7 @@ class NetEqImpl : public webrtc::NetEq {
   std::unique_ptr<NackTracker> nack_ RTC_GUARDED_BY(crit_sect_);
   bool nack_enabled_ RTC_GUARDED_BY(crit_sect_);
   const bool enable_muted_state_ RTC_GUARDED_BY(crit_sect_);
+  const bool enable_compact_memory_ RTC_GUARDED_BY(crit_sect_);
   AudioFrame::VADActivity last_vad_activity_ RTC_GUARDED_BY(crit_sect_) =
       AudioFrame::kVadPassive;
   std::unique_ptr<TickTimer::Stopwatch> generated_noise_stopwatch_
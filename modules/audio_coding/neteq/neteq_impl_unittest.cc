@@ -1689,4 +1689,102 @@ TEST_F(NetEqImplTest120ms, Accelerate) {
   EXPECT_EQ(kAccelerate, neteq_->last_operation_for_test());
 }
 
+class NetEqImplCompactMemoryTest : public ::testing::Test {
+ protected:
+  static constexpr int kSampleRateHz = 48000;
+  static constexpr int kPacketSamples = kSampleRateHz / 1000 * 120;
+  static constexpr uint8_t kPayloadType = 17;
+
+  NetEqImplCompactMemoryTest() : clock_(0) {
+    decoder_factory_ =
+        new rtc::RefCountedObject<test::FunctionAudioDecoderFactory>([this]() {
+          ++num_decoders_created_;
+          return absl::make_unique<Decoder120ms>(kSampleRateHz,
+                                                 AudioDecoder::kSpeech);
+        });
+  }
+
+  std::unique_ptr<NetEq> CreateNetEq(bool enable_compact_memory) {
+    NetEq::Config config;
+    config.sample_rate_hz = kSampleRateHz;
+    config.enable_muted_state = true;
+    config.enable_compact_memory = enable_compact_memory;
+    std::unique_ptr<NetEq> neteq(
+        NetEq::Create(config, &clock_, decoder_factory_));
+    EXPECT_TRUE(neteq->RegisterPayloadType(
+        kPayloadType, SdpAudioFormat("opus", 48000, 2, {{"stereo", "1"}})));
+    return neteq;
+  }
+
+  void InsertPacket(NetEq* neteq, int packet_index) {
+    RTPHeader rtp_header;
+    rtp_header.payloadType = kPayloadType;
+    rtp_header.sequenceNumber = packet_index;
+    rtp_header.timestamp = packet_index * kPacketSamples;
+    rtp_header.ssrc = 15;
+    const uint8_t payload[1] = {0};
+    EXPECT_EQ(NetEq::kOK, neteq->InsertPacket(rtp_header, payload, 10));
+  }
+
+  size_t AllocatedBytes(NetEq* neteq) {
+    NetEqNetworkStatistics stats;
+    EXPECT_EQ(NetEq::kOK, neteq->NetworkStatistics(&stats));
+    return stats.allocated_bytes;
+  }
+
+  SimulatedClock clock_;
+  rtc::scoped_refptr<AudioDecoderFactory> decoder_factory_;
+  int num_decoders_created_ = 0;
+};
+
+TEST_F(NetEqImplCompactMemoryTest, GivesSameOutputWithLessMemory) {
+  std::unique_ptr<NetEq> neteq = CreateNetEq(false);
+  std::unique_ptr<NetEq> compact_neteq = CreateNetEq(true);
+  AudioFrame output;
+  AudioFrame compact_output;
+  bool muted;
+  for (int i = 0; i < 50 * 12; ++i) {
+    // Insert a 120 ms packet every 12 output frames, losing every fifth.
+    if (i % 12 == 0 && i % 60 != 48) {
+      InsertPacket(neteq.get(), i / 12);
+      InsertPacket(compact_neteq.get(), i / 12);
+    }
+    ASSERT_EQ(NetEq::kOK, neteq->GetAudio(&output, &muted));
+    ASSERT_FALSE(muted);
+    ASSERT_EQ(NetEq::kOK, compact_neteq->GetAudio(&compact_output, &muted));
+    ASSERT_FALSE(muted);
+    ASSERT_EQ(output.samples_per_channel_, compact_output.samples_per_channel_);
+    ASSERT_EQ(output.num_channels_, compact_output.num_channels_);
+    ASSERT_EQ(0, memcmp(output.data(), compact_output.data(),
+                        output.samples_per_channel_ * output.num_channels_ *
+                            sizeof(int16_t)));
+  }
+  EXPECT_LT(AllocatedBytes(compact_neteq.get()),
+            AllocatedBytes(neteq.get()) / 2);
+}
+
+TEST_F(NetEqImplCompactMemoryTest, ReleasesDecodersWhenMuted) {
+  std::unique_ptr<NetEq> neteq = CreateNetEq(true);
+  AudioFrame output;
+  bool muted = false;
+  InsertPacket(neteq.get(), 0);
+  EXPECT_EQ(NetEq::kOK, neteq->GetAudio(&output, &muted));
+  EXPECT_EQ(1, num_decoders_created_);
+  const size_t decoding_bytes = AllocatedBytes(neteq.get());
+
+  // Let the stream time out.
+  for (int i = 0; i < 1000 && !muted; ++i)
+    EXPECT_EQ(NetEq::kOK, neteq->GetAudio(&output, &muted));
+  ASSERT_TRUE(muted);
+  EXPECT_LT(AllocatedBytes(neteq.get()), decoding_bytes);
+
+  // The decoder is recreated when the stream comes back.
+  const int kNextPacket = 100;
+  InsertPacket(neteq.get(), kNextPacket);
+  for (int i = 0; i < 12 && muted; ++i)
+    EXPECT_EQ(NetEq::kOK, neteq->GetAudio(&output, &muted));
+  EXPECT_FALSE(muted);
+  EXPECT_EQ(2, num_decoders_created_);
+}
+
 }  // namespace webrtc
@@ -22,8 +22,15 @@ size_t SyncBuffer::FutureLength() const {
 
 void SyncBuffer::PushBack(const AudioMultiVector& append_this) {
   size_t samples_added = append_this.Size();
-  AudioMultiVector::PushBack(append_this);
-  AudioMultiVector::PopFront(samples_added);
+  // Make room before appending, so that the buffer never grows beyond its
+  // initial size.
+  if (samples_added <= Size()) {
+    AudioMultiVector::PopFront(samples_added);
+    AudioMultiVector::PushBack(append_this);
+  } else {
+    AudioMultiVector::PushBack(append_this);
+    AudioMultiVector::PopFront(samples_added);
+  }
   if (samples_added <= next_index_) {
     next_index_ -= samples_added;
   } else {
@@ -38,11 +45,15 @@ void SyncBuffer::PushBack(const AudioMultiVector& append_this) {
 }
 
 void SyncBuffer::PushBackInterleaved(const rtc::BufferT<int16_t>& append_this) {
-  const size_t size_before_adding = Size();
-  AudioMultiVector::PushBackInterleaved(append_this);
-  const size_t samples_added_per_channel = Size() - size_before_adding;
+  const size_t samples_added_per_channel = append_this.size() / Channels();
   RTC_DCHECK_EQ(samples_added_per_channel * Channels(), append_this.size());
-  AudioMultiVector::PopFront(samples_added_per_channel);
+  if (samples_added_per_channel <= Size()) {
+    AudioMultiVector::PopFront(samples_added_per_channel);
+    AudioMultiVector::PushBackInterleaved(append_this);
+  } else {
+    AudioMultiVector::PushBackInterleaved(append_this);
+    AudioMultiVector::PopFront(samples_added_per_channel);
+  }
   next_index_ -= std::min(next_index_, samples_added_per_channel);
   dtmf_index_ -= std::min(dtmf_index_, samples_added_per_channel);
 }
@@ -86,8 +97,9 @@ void SyncBuffer::GetNextAudioInterleaved(size_t requested_len,
   RTC_DCHECK(output);
   const size_t samples_to_read = std::min(FutureLength(), requested_len);
   output->ResetWithoutMuting();
-  const size_t tot_samples_read = ReadInterleavedFromIndex(
-      next_index_, samples_to_read, output->mutable_data());
+  int16_t* output_data = output->mutable_data(samples_to_read, Channels());
+  const size_t tot_samples_read =
+      ReadInterleavedFromIndex(next_index_, samples_to_read, output_data);
   const size_t samples_read_per_channel = tot_samples_read / Channels();
   next_index_ += samples_read_per_channel;
   output->num_channels_ = Channels();
@@ -8,9 +8,20 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "api/audio_codecs/builtin_audio_decoder_factory.h"
+#include "modules/audio_coding/neteq/tools/audio_sink.h"
+#include "modules/audio_coding/neteq/tools/neteq_input.h"
+#include "modules/audio_coding/neteq/tools/neteq_packet_source_input.h"
 #include "modules/audio_coding/neteq/tools/neteq_performance_test.h"
+#include "modules/audio_coding/neteq/tools/neteq_test.h"
+#include "modules/audio_coding/neteq/tools/rtp_file_source.h"
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/field_trial.h"
 #include "test/gtest.h"
+#include "test/testsupport/file_utils.h"
 #include "test/testsupport/perf_test.h"
 
 // Runs a test with 10% packet losses and 10% clock drift, to exercise
@@ -47,3 +58,55 @@ TEST(NetEqPerformanceTest, RunClean) {
   webrtc::test::PrintResult("neteq_performance", "", "0_pl_0_drift", runtime,
                             "ms", true);
 }
+
+// Pulls 10 ms from many NetEq instances at once, as an audio bridge does, with
+// 10% packet losses. Reports the average time of one pull of all streams.
+TEST(NetEqPerformanceTest, RunBatch) {
+  const int kSimulationTimeMs = 10000;
+  const int kQuickSimulationTimeMs = 1000;
+  const int kLossPeriod = 10;  // Drop every 10th packet.
+  const int simulation_time_ms =
+      webrtc::field_trial::IsEnabled("WebRTC-QuickPerfTest")
+          ? kQuickSimulationTimeMs
+          : kSimulationTimeMs;
+  for (int num_streams : {500, 1000, 2000}) {
+    for (int num_threads : {1, 4}) {
+      int64_t tick_time_us = webrtc::test::NetEqPerformanceTest::RunBatch(
+          num_streams, num_threads, simulation_time_ms, kLossPeriod);
+      ASSERT_GT(tick_time_us, 0);
+      webrtc::test::PrintResult(
+          "neteq_performance",
+          "_" + std::to_string(num_streams) + "_streams_" +
+              std::to_string(num_threads) + "_threads",
+          "batch_tick_time", tick_time_us, "us", true);
+    }
+  }
+}
+
+// Replays a recorded Opus RTP dump with every 10th packet dropped, to measure
+// the loss concealment and merge code on real speech rather than on the
+// synthetic signal of the tests above. Decoding is included in the runtime.
+TEST(NetEqPerformanceTest, RunLossyRtpDump) {
+  const int kLossPeriod = 10;  // Drop every 10th packet.
+  const int kNumRepetitions =
+      webrtc::field_trial::IsEnabled("WebRTC-QuickPerfTest") ? 1 : 20;
+  int64_t runtime_ms = 0;
+  for (int i = 0; i < kNumRepetitions; ++i) {
+    auto input = absl::make_unique<webrtc::test::NetEqRtpDumpInput>(
+        webrtc::test::ResourcePath("audio_coding/neteq_opus", "rtp"),
+        webrtc::test::NetEqPacketSourceInput::RtpHeaderExtensionMap(),
+        absl::nullopt /*No SSRC filter*/);
+    webrtc::test::NetEqTest neteq_test(
+        webrtc::NetEq::Config(), webrtc::CreateBuiltinAudioDecoderFactory(),
+        webrtc::test::NetEqTest::StandardDecoderMap(), nullptr,
+        absl::make_unique<webrtc::test::LossyNetEqInput>(std::move(input),
+                                                         kLossPeriod),
+        absl::make_unique<webrtc::test::VoidAudioSink>(),
+        webrtc::test::NetEqTest::Callbacks());
+    const int64_t start_ms = rtc::TimeMillis();
+    ASSERT_GT(neteq_test.Run(), 0);
+    runtime_ms += rtc::TimeMillis() - start_ms;
+  }
+  webrtc::test::PrintResult("neteq_performance", "", "opus_rtp_dump_10_pl",
+                            runtime_ms, "ms", true);
+}
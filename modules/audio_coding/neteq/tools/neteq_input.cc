@@ -78,5 +78,39 @@ void TimeLimitedNetEqInput::MaybeSetEnded() {
   }
 }
 
+LossyNetEqInput::LossyNetEqInput(std::unique_ptr<NetEqInput> input,
+                                 int loss_cadence)
+    : input_(std::move(input)), loss_cadence_(loss_cadence) {}
+
+LossyNetEqInput::~LossyNetEqInput() = default;
+
+absl::optional<int64_t> LossyNetEqInput::NextPacketTime() const {
+  return input_->NextPacketTime();
+}
+
+absl::optional<int64_t> LossyNetEqInput::NextOutputEventTime() const {
+  return input_->NextOutputEventTime();
+}
+
+std::unique_ptr<NetEqInput::PacketData> LossyNetEqInput::PopPacket() {
+  if (loss_cadence_ != 0 && (++count_ % loss_cadence_) == 0) {
+    // Pop one extra packet to create the loss.
+    input_->PopPacket();
+  }
+  return input_->PopPacket();
+}
+
+void LossyNetEqInput::AdvanceOutputEvent() {
+  input_->AdvanceOutputEvent();
+}
+
+bool LossyNetEqInput::ended() const {
+  return input_->ended();
+}
+
+absl::optional<RTPHeader> LossyNetEqInput::NextHeader() const {
+  return input_->NextHeader();
+}
+
 }  // namespace test
 }  // namespace webrtc
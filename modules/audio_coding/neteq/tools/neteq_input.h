@@ -102,6 +102,25 @@ class TimeLimitedNetEqInput : public NetEqInput {
   bool ended_ = false;
 };
 
+// Wrapper class which drops every |loss_cadence|th packet of a NetEqInput
+// object. A |loss_cadence| of 0 means that no packets are dropped.
+class LossyNetEqInput : public NetEqInput {
+ public:
+  LossyNetEqInput(std::unique_ptr<NetEqInput> input, int loss_cadence);
+  ~LossyNetEqInput() override;
+  absl::optional<int64_t> NextPacketTime() const override;
+  absl::optional<int64_t> NextOutputEventTime() const override;
+  std::unique_ptr<PacketData> PopPacket() override;
+  void AdvanceOutputEvent() override;
+  bool ended() const override;
+  absl::optional<RTPHeader> NextHeader() const override;
+
+ private:
+  std::unique_ptr<NetEqInput> input_;
+  const int loss_cadence_;
+  int count_ = 0;
+};
+
 }  // namespace test
 }  // namespace webrtc
 #endif  // MODULES_AUDIO_CODING_NETEQ_TOOLS_NETEQ_INPUT_H_
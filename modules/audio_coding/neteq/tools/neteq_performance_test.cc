@@ -10,10 +10,15 @@
 
 #include "modules/audio_coding/neteq/tools/neteq_performance_test.h"
 
+#include <memory>
+#include <vector>
+
 #include "api/audio/audio_frame.h"
 #include "api/audio_codecs/builtin_audio_decoder_factory.h"
+#include "modules/audio_coding/codecs/g711/g711_interface.h"
 #include "modules/audio_coding/codecs/pcm16b/pcm16b.h"
 #include "modules/audio_coding/neteq/include/neteq.h"
+#include "modules/audio_coding/neteq/neteq_batch.h"
 #include "modules/audio_coding/neteq/tools/audio_loop.h"
 #include "modules/audio_coding/neteq/tools/rtp_generator.h"
 #include "rtc_base/checks.h"
@@ -125,5 +130,121 @@ int64_t NetEqPerformanceTest::Run(int runtime_ms,
   return end_time_ms - start_time_ms;
 }
 
+int64_t NetEqPerformanceTest::RunBatch(int num_streams,
+                                       int num_threads,
+                                       int runtime_ms,
+                                       int lossrate) {
+  const std::string kInputFileName =
+      webrtc::test::ResourcePath("audio_coding/testfile32kHz", "pcm");
+  const int kPacketSizeMs = 20;
+  const int kOutputBlockSizeMs = 10;
+  struct Codec {
+    SdpAudioFormat format;
+    int payload_type;
+    // One second of encoded packets, sent in a loop.
+    std::vector<std::vector<uint8_t>> payloads;
+  };
+  Codec codecs[] = {{SdpAudioFormat("pcmu", 8000, 1), 0, {}},
+                    {SdpAudioFormat("l16", 16000, 1), 95, {}}};
+  for (Codec& codec : codecs) {
+    const size_t samples_per_packet =
+        kPacketSizeMs * codec.format.clockrate_hz / 1000;
+    AudioLoop audio_loop;
+    if (!audio_loop.Init(kInputFileName, codec.format.clockrate_hz,
+                         samples_per_packet))
+      return -1;
+    for (int i = 0; i < 1000 / kPacketSizeMs; ++i) {
+      auto samples = audio_loop.GetNextBlock();
+      std::vector<uint8_t> payload(2 * samples_per_packet);
+      size_t payload_len;
+      if (codec.payload_type == 0) {
+        payload_len = WebRtcG711_EncodeU(samples.data(), samples.size(),
+                                         payload.data());
+      } else {
+        payload_len = WebRtcPcm16b_Encode(samples.data(), samples.size(),
+                                          payload.data());
+      }
+      payload.resize(payload_len);
+      codec.payloads.push_back(std::move(payload));
+    }
+  }
+
+  struct Stream {
+    std::unique_ptr<NetEq> neteq;
+    NetEqBatch::Stream* batch_stream;
+    const Codec* codec;
+    std::unique_ptr<RtpGenerator> rtp_generator;
+    RTPHeader rtp_header;
+    int32_t packet_input_time_ms;
+    size_t packet_index;
+  };
+  webrtc::Clock* clock = webrtc::Clock::GetRealTimeClock();
+  auto decoder_factory = CreateBuiltinAudioDecoderFactory();
+  NetEqBatch batch(num_threads);
+  std::vector<Stream> streams(num_streams);
+  for (int i = 0; i < num_streams; ++i) {
+    Stream& stream = streams[i];
+    // Interleave the codecs, the batch groups them.
+    stream.codec = &codecs[i % 2];
+    const int sample_rate_hz = stream.codec->format.clockrate_hz;
+    NetEq::Config config;
+    config.sample_rate_hz = sample_rate_hz;
+    stream.neteq.reset(NetEq::Create(config, clock, decoder_factory));
+    if (!stream.neteq->RegisterPayloadType(stream.codec->payload_type,
+                                           stream.codec->format))
+      return -1;
+    stream.batch_stream = batch.AddStream(stream.neteq.get());
+    // Spread the packet arrivals over the packet interval.
+    stream.rtp_generator = absl::make_unique<RtpGenerator>(
+        sample_rate_hz / 1000, static_cast<uint16_t>(i), i * 1000,
+        i % kPacketSizeMs);
+    stream.packet_input_time_ms = stream.rtp_generator->GetRtpHeader(
+        stream.codec->payload_type, kPacketSizeMs * sample_rate_hz / 1000,
+        &stream.rtp_header);
+    // Don't send the same audio on all streams.
+    stream.packet_index = i % stream.codec->payloads.size();
+  }
+
+  int64_t total_tick_time_us = 0;
+  int num_ticks = 0;
+  for (int time_now_ms = 0; time_now_ms < runtime_ms;
+       time_now_ms += kOutputBlockSizeMs) {
+    for (size_t i = 0; i < streams.size(); ++i) {
+      Stream& stream = streams[i];
+      const int sample_rate_hz = stream.codec->format.clockrate_hz;
+      while (stream.packet_input_time_ms <= time_now_ms) {
+        const bool lost =
+            lossrate > 0 &&
+            (stream.rtp_header.sequenceNumber + i) % lossrate == 0;
+        if (!lost) {
+          const std::vector<uint8_t>& payload =
+              stream.codec->payloads[stream.packet_index];
+          if (stream.neteq->InsertPacket(
+                  stream.rtp_header, payload,
+                  stream.packet_input_time_ms * sample_rate_hz / 1000) !=
+              NetEq::kOK)
+            return -1;
+        }
+        stream.packet_index =
+            (stream.packet_index + 1) % stream.codec->payloads.size();
+        stream.packet_input_time_ms = stream.rtp_generator->GetRtpHeader(
+            stream.codec->payload_type, kPacketSizeMs * sample_rate_hz / 1000,
+            &stream.rtp_header);
+      }
+    }
+
+    // Only pulling the audio is timed, packets arrive on other threads.
+    const int64_t start_time_us = clock->TimeInMicroseconds();
+    batch.GetAudio();
+    total_tick_time_us += clock->TimeInMicroseconds() - start_time_us;
+    ++num_ticks;
+    for (const Stream& stream : streams) {
+      if (stream.batch_stream->result != NetEq::kOK)
+        return -1;
+    }
+  }
+  return num_ticks > 0 ? total_tick_time_us / num_ticks : -1;
+}
+
 }  // namespace test
 }  // namespace webrtc
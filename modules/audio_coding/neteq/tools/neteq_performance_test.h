@@ -24,6 +24,15 @@ class NetEqPerformanceTest {
   //   |drift_factor|: clock drift in [0, 1].
   // Returns the runtime in ms.
   static int64_t Run(int runtime_ms, int lossrate, double drift_factor);
+
+  // Runs |num_streams| NetEq instances in a NetEqBatch with |num_threads|
+  // threads, half of them decoding PCMU and half 16 kHz L16. Each stream drops
+  // one out of |lossrate| packets. Returns the average time in microseconds
+  // to pull 10 ms from all streams, or -1 on failure.
+  static int64_t RunBatch(int num_streams,
+                          int num_threads,
+                          int runtime_ms,
+                          int lossrate);
 };
 
 }  // namespace test
@@ -11,7 +11,9 @@
 #include "modules/audio_mixer/audio_frame_manipulator.h"
 
 #include <algorithm>
+#include <limits>
 
+#include "rtc_base/random.h"
 #include "test/gtest.h"
 
 namespace webrtc {
@@ -63,4 +65,32 @@ TEST(AudioFrameManipulator, CompareBackwardRampWithExpectedResultMono) {
       std::equal(frame_data, frame_data + total_samples, expected_result));
 }
 
+TEST(AudioFrameManipulator, EnergyMatchesSumOfSquares) {
+  Random random(42);
+  for (size_t samples_per_channel : {1, 7, 80, 441, 480}) {
+    for (size_t number_of_channels : {1, 2}) {
+      AudioFrame frame;
+      frame.samples_per_channel_ = samples_per_channel;
+      frame.num_channels_ = number_of_channels;
+      const size_t length = samples_per_channel * number_of_channels;
+      int16_t* frame_data = frame.mutable_data();
+      uint32_t expected_energy = 0;
+      for (size_t i = 0; i < length; ++i) {
+        // Include full scale samples, whose squares overflow when summed.
+        frame_data[i] = i % 5 == 0 ? std::numeric_limits<int16_t>::min()
+                                   : random.Rand<int16_t>();
+        expected_energy += frame_data[i] * frame_data[i];
+      }
+      EXPECT_EQ(expected_energy, AudioMixerCalculateEnergy(frame));
+    }
+  }
+}
+
+TEST(AudioFrameManipulator, MutedFrameHasNoEnergy) {
+  AudioFrame frame;
+  FillFrameWithConstants(480, 1, 1000, &frame);
+  frame.Mute();
+  EXPECT_EQ(0u, AudioMixerCalculateEnergy(frame));
+}
+
 }  // namespace webrtc
@@ -13,10 +13,12 @@
 #include <stdint.h>
 
 #include <algorithm>
+#include <array>
 #include <iterator>
 #include <type_traits>
 #include <utility>
 
+#include "api/array_view.h"
 #include "modules/audio_mixer/audio_frame_manipulator.h"
 #include "modules/audio_mixer/default_output_rate_calculator.h"
 #include "rtc_base/checks.h"
@@ -93,10 +95,27 @@ AudioMixerImpl::SourceStatusList::const_iterator FindSourceInList(
 }
 }  // namespace
 
+AudioMixerImpl::MinusOneMixes::MinusOneMixes() = default;
+
+AudioMixerImpl::MinusOneMixes::~MinusOneMixes() = default;
+
+const AudioFrame* AudioMixerImpl::MinusOneMixes::Find(
+    const Source* audio_source) const {
+  for (size_t i = 0; i < num_mixes_; ++i) {
+    if (sources_[i] == audio_source)
+      return &frames_[i];
+  }
+  return nullptr;
+}
+
 AudioMixerImpl::AudioMixerImpl(
     std::unique_ptr<OutputRateCalculator> output_rate_calculator,
-    bool use_limiter)
+    bool use_limiter,
+    bool compact_source_frames)
     : output_rate_calculator_(std::move(output_rate_calculator)),
+      source_frame_storage_mode_(compact_source_frames
+                                     ? AudioFrame::StorageMode::kCompact
+                                     : AudioFrame::StorageMode::kMaxSize),
       output_frequency_(0),
       sample_size_(0),
       audio_source_list_(),
@@ -113,9 +132,17 @@ rtc::scoped_refptr<AudioMixerImpl> AudioMixerImpl::Create() {
 rtc::scoped_refptr<AudioMixerImpl> AudioMixerImpl::Create(
     std::unique_ptr<OutputRateCalculator> output_rate_calculator,
     bool use_limiter) {
+  return Create(std::move(output_rate_calculator), use_limiter, false);
+}
+
+rtc::scoped_refptr<AudioMixerImpl> AudioMixerImpl::Create(
+    std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+    bool use_limiter,
+    bool compact_source_frames) {
   return rtc::scoped_refptr<AudioMixerImpl>(
       new rtc::RefCountedObject<AudioMixerImpl>(
-          std::move(output_rate_calculator), use_limiter));
+          std::move(output_rate_calculator), use_limiter,
+          compact_source_frames));
 }
 
 void AudioMixerImpl::Mix(size_t number_of_channels,
@@ -128,7 +155,7 @@ void AudioMixerImpl::Mix(size_t number_of_channels,
   {
     rtc::CritScope lock(&crit_);
     const size_t number_of_streams = audio_source_list_.size();
-    frame_combiner_.Combine(GetAudioFromSources(), number_of_channels,
+    frame_combiner_.Combine(GetAudioFromSources(nullptr), number_of_channels,
                             OutputFrequency(), number_of_streams,
                             audio_frame_for_mixing);
   }
@@ -136,6 +163,35 @@ void AudioMixerImpl::Mix(size_t number_of_channels,
   return;
 }
 
+void AudioMixerImpl::MixMinusOne(size_t number_of_channels,
+                                 AudioFrame* audio_frame_for_mixing,
+                                 MinusOneMixes* minus_one_mixes) {
+  RTC_DCHECK(number_of_channels >= 1);
+  RTC_DCHECK(minus_one_mixes);
+  RTC_DCHECK_RUNS_SERIALIZED(&race_checker_);
+
+  CalculateOutputFrequency();
+
+  {
+    rtc::CritScope lock(&crit_);
+    const size_t number_of_streams = audio_source_list_.size();
+    std::vector<Source*> mixed_sources;
+    const AudioFrameList mix_list = GetAudioFromSources(&mixed_sources);
+    RTC_DCHECK_LE(mix_list.size(), kMaximumAmountOfMixedAudioSources);
+
+    std::array<AudioFrame*, kMaximumAmountOfMixedAudioSources> frames;
+    for (size_t i = 0; i < mix_list.size(); ++i) {
+      minus_one_mixes->sources_[i] = mixed_sources[i];
+      frames[i] = &minus_one_mixes->frames_[i];
+    }
+    minus_one_mixes->num_mixes_ = mix_list.size();
+    frame_combiner_.CombineMinusOne(
+        mix_list, mixed_sources, number_of_channels, OutputFrequency(),
+        number_of_streams, audio_frame_for_mixing,
+        rtc::ArrayView<AudioFrame* const>(frames.data(), mix_list.size()));
+  }
+}
+
 void AudioMixerImpl::CalculateOutputFrequency() {
   RTC_DCHECK_RUNS_SERIALIZED(&race_checker_);
   rtc::CritScope lock(&crit_);
@@ -163,7 +219,8 @@ bool AudioMixerImpl::AddSource(Source* audio_source) {
   RTC_DCHECK(FindSourceInList(audio_source, &audio_source_list_) ==
              audio_source_list_.end())
       << "Source already added to mixer";
-  audio_source_list_.emplace_back(new SourceStatus(audio_source, false, 0));
+  audio_source_list_.emplace_back(
+      new SourceStatus(audio_source, false, 0, source_frame_storage_mode_));
   return true;
 }
 
@@ -175,11 +232,13 @@ void AudioMixerImpl::RemoveSource(Source* audio_source) {
   audio_source_list_.erase(iter);
 }
 
-AudioFrameList AudioMixerImpl::GetAudioFromSources() {
+AudioFrameList AudioMixerImpl::GetAudioFromSources(
+    std::vector<Source*>* mixed_sources) {
   RTC_DCHECK_RUNS_SERIALIZED(&race_checker_);
   AudioFrameList result;
   std::vector<SourceFrame> audio_source_mixing_data_list;
   std::vector<SourceFrame> ramp_list;
+  audio_source_mixing_data_list.reserve(audio_source_list_.size());
 
   // Get audio from the audio sources and put it in the SourceFrame vector.
   for (auto& source_and_status : audio_source_list_) {
@@ -196,29 +255,40 @@ AudioFrameList AudioMixerImpl::GetAudioFromSources() {
         audio_frame_info == Source::AudioFrameInfo::kMuted);
   }
 
-  // Sort frames by sorting function.
-  std::sort(audio_source_mixing_data_list.begin(),
-            audio_source_mixing_data_list.end(), ShouldMixBefore);
-
-  int max_audio_frame_counter = kMaximumAmountOfMixedAudioSources;
-
-  // Go through list in order and put unmuted frames in result list.
+  // Move the frames to mix to the front. Only their set matters, so there's
+  // no need to sort all the frames of a large conference.
+  const auto mixed_end =
+      audio_source_mixing_data_list.begin() +
+      std::min<size_t>(kMaximumAmountOfMixedAudioSources,
+                       audio_source_mixing_data_list.size());
+  std::nth_element(audio_source_mixing_data_list.begin(), mixed_end,
+                   audio_source_mixing_data_list.end(), ShouldMixBefore);
+
+  // Muted frames are never mixed.
+  std::vector<SourceStatus*> mixed_statuses;
+  for (auto it = audio_source_mixing_data_list.begin(); it != mixed_end;
+       ++it) {
+    if (!it->muted)
+      mixed_statuses.push_back(it->source_status);
+  }
   for (const auto& p : audio_source_mixing_data_list) {
-    // Filter muted.
-    if (p.muted) {
-      p.source_status->is_mixed = false;
-      continue;
-    }
+    p.source_status->is_mixed =
+        std::find(mixed_statuses.begin(), mixed_statuses.end(),
+                  p.source_status) != mixed_statuses.end();
+  }
 
-    // Add frame to result vector for mixing.
-    bool is_mixed = false;
-    if (max_audio_frame_counter > 0) {
-      --max_audio_frame_counter;
-      result.push_back(p.audio_frame);
-      ramp_list.emplace_back(p.source_status, p.audio_frame, false, -1);
-      is_mixed = true;
+  // Output the mixed frames in the order of the sources, which is stable
+  // between calls.
+  for (auto& source_and_status : audio_source_list_) {
+    if (std::find(mixed_statuses.begin(), mixed_statuses.end(),
+                  source_and_status.get()) == mixed_statuses.end()) {
+      continue;
     }
-    p.source_status->is_mixed = is_mixed;
+    result.push_back(&source_and_status->audio_frame);
+    ramp_list.emplace_back(source_and_status.get(),
+                           &source_and_status->audio_frame, false, -1);
+    if (mixed_sources)
+      mixed_sources->push_back(source_and_status->audio_source);
   }
   RampAndUpdateGain(ramp_list);
   return result;
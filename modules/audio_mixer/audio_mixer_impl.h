@@ -13,6 +13,7 @@
 
 #include <stddef.h>
 
+#include <array>
 #include <memory>
 #include <vector>
 
@@ -33,8 +34,14 @@ typedef std::vector<AudioFrame*> AudioFrameList;
 class AudioMixerImpl : public AudioMixer {
  public:
   struct SourceStatus {
-    SourceStatus(Source* audio_source, bool is_mixed, float gain)
-        : audio_source(audio_source), is_mixed(is_mixed), gain(gain) {}
+    SourceStatus(Source* audio_source,
+                 bool is_mixed,
+                 float gain,
+                 AudioFrame::StorageMode frame_storage_mode)
+        : audio_source(audio_source),
+          is_mixed(is_mixed),
+          gain(gain),
+          audio_frame(frame_storage_mode) {}
     Source* audio_source = nullptr;
     bool is_mixed = false;
     float gain = 0.0f;
@@ -49,12 +56,45 @@ class AudioMixerImpl : public AudioMixer {
   static const int kFrameDurationInMs = 10;
   static const int kMaximumAmountOfMixedAudioSources = 3;
 
+  // The mixes without each of the mixed sources, output by MixMinusOne().
+  class MinusOneMixes {
+   public:
+    MinusOneMixes();
+    ~MinusOneMixes();
+
+    // Number of mixed sources, i.e. of minus-one mixes.
+    size_t size() const { return num_mixes_; }
+
+    // Returns the mix without |audio_source|, or null if |audio_source| wasn't
+    // mixed, in which case it hears the full mix.
+    const AudioFrame* Find(const Source* audio_source) const;
+
+   private:
+    friend class AudioMixerImpl;
+
+    std::array<Source*, kMaximumAmountOfMixedAudioSources> sources_{};
+    std::array<AudioFrame, kMaximumAmountOfMixedAudioSources> frames_;
+    size_t num_mixes_ = 0;
+
+    RTC_DISALLOW_COPY_AND_ASSIGN(MinusOneMixes);
+  };
+
   static rtc::scoped_refptr<AudioMixerImpl> Create();
 
   static rtc::scoped_refptr<AudioMixerImpl> Create(
       std::unique_ptr<OutputRateCalculator> output_rate_calculator,
       bool use_limiter);
 
+  // If |compact_source_frames| is set, the frames passed to the sources only
+  // allocate room for the audio of the source, instead of for the largest
+  // possible frame. This saves memory with many sources, but requires the
+  // sources to set the frame format before writing to the frame, see
+  // AudioFrame.
+  static rtc::scoped_refptr<AudioMixerImpl> Create(
+      std::unique_ptr<OutputRateCalculator> output_rate_calculator,
+      bool use_limiter,
+      bool compact_source_frames);
+
   ~AudioMixerImpl() override;
 
   // AudioMixer functions
@@ -65,6 +105,14 @@ class AudioMixerImpl : public AudioMixer {
            AudioFrame* audio_frame_for_mixing) override
       RTC_LOCKS_EXCLUDED(crit_);
 
+  // Same as Mix(), and also outputs the mix without each of the mixed sources
+  // to |minus_one_mixes|, so that every source of a conference can hear all
+  // the others: the sources are selected and mixed once, and each minus-one
+  // mix is derived from the mix by subtraction.
+  void MixMinusOne(size_t number_of_channels,
+                   AudioFrame* audio_frame_for_mixing,
+                   MinusOneMixes* minus_one_mixes) RTC_LOCKS_EXCLUDED(crit_);
+
   // Returns true if the source was mixed last round. Returns
   // false and logs an error if the source was never added to the
   // mixer.
@@ -72,7 +120,8 @@ class AudioMixerImpl : public AudioMixer {
 
  protected:
   AudioMixerImpl(std::unique_ptr<OutputRateCalculator> output_rate_calculator,
-                 bool use_limiter);
+                 bool use_limiter,
+                 bool compact_source_frames);
 
  private:
   // Set mixing frequency through OutputFrequencyCalculator.
@@ -82,8 +131,10 @@ class AudioMixerImpl : public AudioMixer {
 
   // Compute what audio sources to mix from audio_source_list_. Ramp
   // in and out. Update mixed status. Mixes up to
-  // kMaximumAmountOfMixedAudioSources audio sources.
-  AudioFrameList GetAudioFromSources() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  // kMaximumAmountOfMixedAudioSources audio sources. If |mixed_sources| is
+  // not null, the sources of the returned frames are output to it.
+  AudioFrameList GetAudioFromSources(std::vector<Source*>* mixed_sources)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // The critical section lock guards audio source insertion and
   // removal, which can be done from any thread. The race checker
@@ -92,6 +143,7 @@ class AudioMixerImpl : public AudioMixer {
   rtc::RaceChecker race_checker_;
 
   std::unique_ptr<OutputRateCalculator> output_rate_calculator_;
+  const AudioFrame::StorageMode source_frame_storage_mode_;
   // The current sample frequency and sample size when mixing.
   int output_frequency_ RTC_GUARDED_BY(race_checker_);
   size_t sample_size_ RTC_GUARDED_BY(race_checker_);
@@ -20,12 +20,15 @@
 #include "absl/memory/memory.h"
 #include "api/audio/audio_mixer.h"
 #include "modules/audio_mixer/default_output_rate_calculator.h"
+#include "modules/audio_mixer/sine_wave_generator.h"
 #include "rtc_base/bind.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/strings/string_builder.h"
 #include "rtc_base/task_queue_for_test.h"
+#include "rtc_base/time_utils.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 using ::testing::_;
 using ::testing::Exactly;
@@ -640,4 +643,264 @@ TEST(AudioMixer, MultipleChannelsAndHighRate) {
 #endif
 }
 
+TEST(AudioMixer, MinusOneMixesExcludeOwnAudio) {
+  constexpr int16_t kValues[] = {100, 200, 400};
+  constexpr int16_t kQuietValue = 10;
+  constexpr size_t kSamples = kDefaultSampleRateHz / 100;
+  const auto mixer = AudioMixerImpl::Create(
+      absl::make_unique<DefaultOutputRateCalculator>(), false);
+  MockMixerAudioSource sources[4];
+  for (size_t i = 0; i < 4; ++i) {
+    ResetFrame(sources[i].fake_frame());
+    std::fill(sources[i].fake_frame()->mutable_data(),
+              sources[i].fake_frame()->mutable_data() + kSamples,
+              i < 3 ? kValues[i] : kQuietValue);
+    mixer->AddSource(&sources[i]);
+  }
+
+  AudioMixerImpl::MinusOneMixes minus_one_mixes;
+  // The first mix ramps the sources in.
+  for (int i = 0; i < 2; ++i) {
+    mixer->MixMinusOne(1, &frame_for_mixing, &minus_one_mixes);
+  }
+
+  EXPECT_EQ(3u, minus_one_mixes.size());
+  EXPECT_EQ(700, frame_for_mixing.data()[kSamples - 1]);
+  for (size_t i = 0; i < 3; ++i) {
+    const AudioFrame* minus_one = minus_one_mixes.Find(&sources[i]);
+    ASSERT_TRUE(minus_one);
+    EXPECT_EQ(frame_for_mixing.samples_per_channel_,
+              minus_one->samples_per_channel_);
+    EXPECT_EQ(700 - kValues[i], minus_one->data()[kSamples - 1]);
+  }
+  // The quietest source isn't mixed and hears the full mix.
+  EXPECT_FALSE(minus_one_mixes.Find(&sources[3]));
+}
+
+TEST(AudioMixer, MinusOneMixEqualsMixOfOtherSources) {
+  // Loud enough for the limiter to kick in.
+  SineWaveGenerator generators[] = {{300.f, 15000}, {500.f, 15000},
+                                    {700.f, 15000}};
+  MockMixerAudioSource sources[3];
+  const auto mixer = AudioMixerImpl::Create();
+  // Mixes all the sources but the first.
+  const auto other_mixer = AudioMixerImpl::Create();
+  for (size_t i = 0; i < 3; ++i) {
+    ResetFrame(sources[i].fake_frame());
+    mixer->AddSource(&sources[i]);
+    if (i > 0)
+      other_mixer->AddSource(&sources[i]);
+  }
+
+  AudioMixerImpl::MinusOneMixes minus_one_mixes;
+  AudioFrame other_mix;
+  for (int i = 0; i < 10; ++i) {
+    for (size_t j = 0; j < 3; ++j)
+      generators[j].GenerateNextFrame(sources[j].fake_frame());
+    mixer->MixMinusOne(1, &frame_for_mixing, &minus_one_mixes);
+    other_mixer->Mix(1, &other_mix);
+
+    const AudioFrame* minus_one = minus_one_mixes.Find(&sources[0]);
+    ASSERT_TRUE(minus_one);
+    ASSERT_EQ(other_mix.samples_per_channel_, minus_one->samples_per_channel_);
+    EXPECT_EQ(0, memcmp(other_mix.data(), minus_one->data(),
+                        sizeof(int16_t) * other_mix.samples_per_channel_));
+  }
+}
+
+// Verifies that the minus-one mix of a source keeps its limiter when the set
+// of mixed sources changes, and with it the position of the source in the mix.
+TEST(AudioMixer, MinusOneMixKeepsLimiterWhenMixedSourcesChange) {
+  using AudioFrameInfo = AudioMixer::Source::AudioFrameInfo;
+  // Loud enough for the limiter to kick in, with a different gain for each
+  // minus-one mix.
+  SineWaveGenerator generators[] = {{300.f, 30000},
+                                    {500.f, 20000},
+                                    {700.f, 10000},
+                                    {900.f, 5000}};
+  MockMixerAudioSource sources[4];
+  const auto mixer = AudioMixerImpl::Create();
+  // Mix all the sources but the second and the third one, respectively.
+  const rtc::scoped_refptr<AudioMixerImpl> other_mixers[] = {
+      AudioMixerImpl::Create(), AudioMixerImpl::Create()};
+  for (size_t i = 0; i < 4; ++i) {
+    ResetFrame(sources[i].fake_frame());
+    mixer->AddSource(&sources[i]);
+    for (size_t j = 0; j < 2; ++j) {
+      if (i != j + 1)
+        other_mixers[j]->AddSource(&sources[i]);
+    }
+  }
+
+  AudioMixerImpl::MinusOneMixes minus_one_mixes;
+  AudioFrame other_mix;
+  for (int i = 0; i < 20; ++i) {
+    // The first source leaves the mix half way and the fourth one enters it,
+    // which moves the second and the third source one step ahead in the mix.
+    const bool first_half = i < 10;
+    sources[0].set_fake_info(first_half ? AudioFrameInfo::kNormal
+                                        : AudioFrameInfo::kMuted);
+    sources[3].set_fake_info(first_half ? AudioFrameInfo::kMuted
+                                        : AudioFrameInfo::kNormal);
+    for (size_t j = 0; j < 4; ++j)
+      generators[j].GenerateNextFrame(sources[j].fake_frame());
+    mixer->MixMinusOne(1, &frame_for_mixing, &minus_one_mixes);
+    ASSERT_EQ(3u, minus_one_mixes.size());
+
+    for (size_t j = 0; j < 2; ++j) {
+      other_mixers[j]->Mix(1, &other_mix);
+      const AudioFrame* minus_one = minus_one_mixes.Find(&sources[j + 1]);
+      ASSERT_TRUE(minus_one);
+      ASSERT_EQ(other_mix.samples_per_channel_,
+                minus_one->samples_per_channel_);
+      EXPECT_EQ(0, memcmp(other_mix.data(), minus_one->data(),
+                          sizeof(int16_t) * other_mix.samples_per_channel_));
+    }
+  }
+}
+
+TEST(AudioMixer, MinusOneMixOfSingleSourceIsMuted) {
+  MockMixerAudioSource source;
+  ResetFrame(source.fake_frame());
+  std::fill(source.fake_frame()->mutable_data(),
+            source.fake_frame()->mutable_data() + kDefaultSampleRateHz / 100,
+            1000);
+  const auto mixer = AudioMixerImpl::Create();
+  mixer->AddSource(&source);
+
+  AudioMixerImpl::MinusOneMixes minus_one_mixes;
+  mixer->MixMinusOne(1, &frame_for_mixing, &minus_one_mixes);
+  ASSERT_EQ(1u, minus_one_mixes.size());
+  EXPECT_TRUE(minus_one_mixes.Find(&source)->muted());
+  EXPECT_FALSE(frame_for_mixing.muted());
+}
+
+TEST(AudioMixer, CompactSourceFramesGiveSameMix) {
+  SineWaveGenerator generators[] = {{300.f, 5000}, {500.f, 5000}};
+  MockMixerAudioSource sources[2];
+  const auto mixer = AudioMixerImpl::Create();
+  const auto compact_mixer = AudioMixerImpl::Create(
+      absl::make_unique<DefaultOutputRateCalculator>(), true, true);
+  for (size_t i = 0; i < 2; ++i) {
+    ResetFrame(sources[i].fake_frame());
+    mixer->AddSource(&sources[i]);
+    compact_mixer->AddSource(&sources[i]);
+  }
+
+  // Mixing in stereo upmixes the mono source frames.
+  AudioFrame compact_mix;
+  for (int i = 0; i < 10; ++i) {
+    for (size_t j = 0; j < 2; ++j)
+      generators[j].GenerateNextFrame(sources[j].fake_frame());
+    mixer->Mix(2, &frame_for_mixing);
+    compact_mixer->Mix(2, &compact_mix);
+
+    ASSERT_EQ(frame_for_mixing.samples_per_channel_,
+              compact_mix.samples_per_channel_);
+    ASSERT_EQ(2u, compact_mix.num_channels_);
+    EXPECT_EQ(0,
+              memcmp(frame_for_mixing.data(), compact_mix.data(),
+                     sizeof(int16_t) * 2 * compact_mix.samples_per_channel_));
+  }
+}
+
+namespace {
+
+// Cheaper than MockMixerAudioSource, for measuring the mixer alone.
+class FakeAudioSource : public AudioMixer::Source {
+ public:
+  explicit FakeAudioSource(int16_t amplitude)
+      : frame_(AudioFrame::StorageMode::kCompact) {
+    ResetFrame(&frame_);
+    int16_t* const data = frame_.mutable_data();
+    for (size_t i = 0; i < frame_.samples_per_channel_; ++i)
+      data[i] = (i % 2 ? 1 : -1) * amplitude;
+  }
+
+  AudioFrameInfo GetAudioFrameWithInfo(int sample_rate_hz,
+                                       AudioFrame* audio_frame) override {
+    audio_frame->CopyFrom(frame_);
+    mixer_frame_bytes_ =
+        sizeof(AudioFrame) + sizeof(int16_t) * audio_frame->allocated_samples();
+    return AudioFrameInfo::kNormal;
+  }
+  int Ssrc() const override { return 0; }
+  int PreferredSampleRate() const override { return kDefaultSampleRateHz; }
+
+  // Memory used by the frame the mixer holds for this source.
+  size_t mixer_frame_bytes() const { return mixer_frame_bytes_; }
+
+ private:
+  AudioFrame frame_;
+  size_t mixer_frame_bytes_ = 0;
+};
+
+}  // namespace
+
+TEST(AudioMixer, DISABLED_MixMinusOnePerf) {
+  constexpr int kNumIterations = 1000;
+  for (size_t num_sources : {10, 100, 1000}) {
+    std::vector<std::unique_ptr<FakeAudioSource>> sources;
+    const auto mixer = AudioMixerImpl::Create();
+    for (size_t i = 0; i < num_sources; ++i) {
+      sources.push_back(
+          absl::make_unique<FakeAudioSource>(static_cast<int16_t>(i % 1000)));
+      mixer->AddSource(sources.back().get());
+    }
+    const std::string modifier =
+        "_" + std::to_string(num_sources) + "_sources";
+
+    int64_t start_ns = rtc::SystemTimeNanos();
+    for (int i = 0; i < kNumIterations; ++i)
+      mixer->Mix(1, &frame_for_mixing);
+    test::PrintResult("audio_mixer", modifier, "mix_time",
+                      static_cast<double>(rtc::SystemTimeNanos() - start_ns) /
+                          kNumIterations / rtc::kNumNanosecsPerMicrosec,
+                      "us", false);
+
+    // All the sources hear either the full mix or one of the minus-one mixes.
+    AudioMixerImpl::MinusOneMixes minus_one_mixes;
+    start_ns = rtc::SystemTimeNanos();
+    for (int i = 0; i < kNumIterations; ++i)
+      mixer->MixMinusOne(1, &frame_for_mixing, &minus_one_mixes);
+    test::PrintResult("audio_mixer", modifier, "mix_minus_one_time",
+                      static_cast<double>(rtc::SystemTimeNanos() - start_ns) /
+                          kNumIterations / rtc::kNumNanosecsPerMicrosec,
+                      "us", false);
+  }
+}
+
+TEST(AudioMixer, DISABLED_SourceFrameMemoryPerf) {
+  // A server mixing many 48 kHz mono receive streams.
+  constexpr size_t kNumSources = 2000;
+  constexpr int kNumIterations = 100;
+  for (bool compact_source_frames : {false, true}) {
+    std::vector<std::unique_ptr<FakeAudioSource>> sources;
+    const auto mixer = AudioMixerImpl::Create(
+        absl::make_unique<DefaultOutputRateCalculator>(), true,
+        compact_source_frames);
+    for (size_t i = 0; i < kNumSources; ++i) {
+      sources.push_back(
+          absl::make_unique<FakeAudioSource>(static_cast<int16_t>(i % 1000)));
+      mixer->AddSource(sources.back().get());
+    }
+    const std::string modifier =
+        compact_source_frames ? "_compact_frames" : "_max_size_frames";
+
+    const int64_t start_ns = rtc::SystemTimeNanos();
+    for (int i = 0; i < kNumIterations; ++i)
+      mixer->Mix(1, &frame_for_mixing);
+    test::PrintResult("audio_mixer", modifier, "mix_time",
+                      static_cast<double>(rtc::SystemTimeNanos() - start_ns) /
+                          kNumIterations / rtc::kNumNanosecsPerMicrosec,
+                      "us", false);
+
+    size_t source_frame_bytes = 0;
+    for (const auto& source : sources)
+      source_frame_bytes += source->mixer_frame_bytes();
+    test::PrintResult("audio_mixer", modifier, "source_frame_bytes",
+                      source_frame_bytes, "bytes", false);
+  }
+}
+
 }  // namespace webrtc
@@ -21,6 +21,7 @@
 #include "common_audio/include/audio_util.h"
 #include "modules/audio_mixer/audio_frame_manipulator.h"
 #include "modules/audio_mixer/audio_mixer_impl.h"
+#include "modules/audio_processing/agc2/cpu_features.h"
 #include "modules/audio_processing/include/audio_frame_view.h"
 #include "modules/audio_processing/include/audio_processing.h"
 #include "modules/audio_processing/logging/apm_data_dumper.h"
@@ -74,18 +75,39 @@ void MixFewFramesWithNoLimiter(const std::vector<AudioFrame*>& mix_list,
             audio_frame_for_mixing->mutable_data());
 }
 
-void MixToFloatFrame(const std::vector<AudioFrame*>& mix_list,
+void MixToFloatFrame(const VectorMath& vector_math,
+                     const std::vector<AudioFrame*>& mix_list,
                      size_t samples_per_channel,
                      size_t number_of_channels,
                      MixingBuffer* mixing_buffer) {
   RTC_DCHECK_LE(samples_per_channel, FrameCombiner::kMaximumChannelSize);
   RTC_DCHECK_LE(number_of_channels, FrameCombiner::kMaximumNumberOfChannels);
-  // Clear the mixing buffer.
-  for (auto& one_channel_buffer : *mixing_buffer) {
-    std::fill(one_channel_buffer.begin(), one_channel_buffer.end(), 0.f);
+  // Clear the channels of the mixing buffer that are used.
+  for (size_t j = 0; j < std::min(number_of_channels,
+                                  FrameCombiner::kMaximumNumberOfChannels);
+       ++j) {
+    std::fill((*mixing_buffer)[j].begin(), (*mixing_buffer)[j].end(), 0.f);
   }
 
-  // Convert to FloatS16 and mix.
+  // Convert to FloatS16 and mix. Mono and stereo frames are mixed with the
+  // vectorized functions.
+  if (number_of_channels <= 2 &&
+      samples_per_channel <= FrameCombiner::kMaximumChannelSize) {
+    for (const AudioFrame* frame : mix_list) {
+      rtc::ArrayView<const int16_t> frame_data(
+          frame->data(), number_of_channels * samples_per_channel);
+      rtc::ArrayView<float> left((*mixing_buffer)[0].data(),
+                                 samples_per_channel);
+      if (number_of_channels == 1) {
+        vector_math.AccumulateS16(frame_data, left);
+      } else {
+        rtc::ArrayView<float> right((*mixing_buffer)[1].data(),
+                                    samples_per_channel);
+        vector_math.AccumulateStereoS16(frame_data, left, right);
+      }
+    }
+    return;
+  }
   for (size_t i = 0; i < mix_list.size(); ++i) {
     const AudioFrame* const frame = mix_list[i];
     for (size_t j = 0; j < std::min(number_of_channels,
@@ -108,15 +130,52 @@ void RunLimiter(AudioFrameView<float> mixing_buffer_view, Limiter* limiter) {
   limiter->Process(mixing_buffer_view);
 }
 
+// Outputs the mix in 'mixing_buffer' without 'frame' into 'output'.
+void SubtractFromFloatFrame(const MixingBuffer& mixing_buffer,
+                            const AudioFrame& frame,
+                            size_t samples_per_channel,
+                            size_t number_of_channels,
+                            MixingBuffer* output) {
+  RTC_DCHECK_LE(samples_per_channel, FrameCombiner::kMaximumChannelSize);
+  const int16_t* const frame_data = frame.data();
+  for (size_t j = 0; j < std::min(number_of_channels,
+                                  FrameCombiner::kMaximumNumberOfChannels);
+       ++j) {
+    const float* const mix = mixing_buffer[j].data();
+    float* const output_channel = (*output)[j].data();
+    if (number_of_channels == 1) {
+      // Contiguous, so that the loop is vectorized.
+      for (size_t k = 0; k < samples_per_channel; ++k)
+        output_channel[k] = mix[k] - frame_data[k];
+    } else {
+      for (size_t k = 0; k < samples_per_channel; ++k)
+        output_channel[k] = mix[k] - frame_data[number_of_channels * k + j];
+    }
+  }
+}
+
 // Both interleaves and rounds.
-void InterleaveToAudioFrame(AudioFrameView<const float> mixing_buffer_view,
+void InterleaveToAudioFrame(const VectorMath& vector_math,
+                            AudioFrameView<const float> mixing_buffer_view,
                             AudioFrame* audio_frame_for_mixing) {
   const size_t number_of_channels = mixing_buffer_view.num_channels();
   const size_t samples_per_channel = mixing_buffer_view.samples_per_channel();
+  int16_t* const data = audio_frame_for_mixing->mutable_data();
+  if (number_of_channels == 1) {
+    vector_math.ToS16(mixing_buffer_view.channel(0),
+                      rtc::ArrayView<int16_t>(data, samples_per_channel));
+    return;
+  }
+  if (number_of_channels == 2) {
+    vector_math.ToStereoS16(
+        mixing_buffer_view.channel(0), mixing_buffer_view.channel(1),
+        rtc::ArrayView<int16_t>(data, 2 * samples_per_channel));
+    return;
+  }
   // Put data in the result frame.
   for (size_t i = 0; i < number_of_channels; ++i) {
     for (size_t j = 0; j < samples_per_channel; ++j) {
-      audio_frame_for_mixing->mutable_data()[number_of_channels * j + i] =
+      data[number_of_channels * j + i] =
           FloatS16ToS16(mixing_buffer_view.channel(i)[j]);
     }
   }
@@ -132,6 +191,7 @@ FrameCombiner::FrameCombiner(bool use_limiter)
           absl::make_unique<std::array<std::array<float, kMaximumChannelSize>,
                                        kMaximumNumberOfChannels>>()),
       limiter_(static_cast<size_t>(48000), data_dumper_.get(), "AudioMixer"),
+      vector_math_(GetAvailableCpuFeatures()),
       use_limiter_(use_limiter) {
   static_assert(kMaximumChannelSize * kMaximumNumberOfChannels <=
                     AudioFrame::kMaxDataSizeSamples,
@@ -145,12 +205,53 @@ void FrameCombiner::Combine(const std::vector<AudioFrame*>& mix_list,
                             int sample_rate,
                             size_t number_of_streams,
                             AudioFrame* audio_frame_for_mixing) {
+  CombineFrames(mix_list, {}, number_of_channels, sample_rate,
+                number_of_streams, audio_frame_for_mixing, {});
+}
+
+void FrameCombiner::CombineMinusOne(
+    const std::vector<AudioFrame*>& mix_list,
+    rtc::ArrayView<AudioMixer::Source* const> sources,
+    size_t number_of_channels,
+    int sample_rate,
+    size_t number_of_streams,
+    AudioFrame* audio_frame_for_mixing,
+    rtc::ArrayView<AudioFrame* const> minus_one_frames) {
+  RTC_DCHECK_EQ(sources.size(), mix_list.size());
+  RTC_DCHECK_EQ(minus_one_frames.size(), mix_list.size());
+  // Drop the limiters of the sources that left the mix, so that a source
+  // entering it later starts from a fresh limiter.
+  for (auto it = minus_one_limiters_.begin();
+       it != minus_one_limiters_.end();) {
+    if (std::find(sources.begin(), sources.end(), it->first) == sources.end())
+      it = minus_one_limiters_.erase(it);
+    else
+      ++it;
+  }
+  CombineFrames(mix_list, sources, number_of_channels, sample_rate,
+                number_of_streams, audio_frame_for_mixing, minus_one_frames);
+}
+
+void FrameCombiner::CombineFrames(
+    const std::vector<AudioFrame*>& mix_list,
+    rtc::ArrayView<AudioMixer::Source* const> sources,
+    size_t number_of_channels,
+    int sample_rate,
+    size_t number_of_streams,
+    AudioFrame* audio_frame_for_mixing,
+    rtc::ArrayView<AudioFrame* const> minus_one_frames) {
   RTC_DCHECK(audio_frame_for_mixing);
 
   LogMixingStats(mix_list, sample_rate, number_of_streams);
 
   SetAudioFrameFields(mix_list, number_of_channels, sample_rate,
                       number_of_streams, audio_frame_for_mixing);
+  for (size_t i = 0; i < minus_one_frames.size(); ++i) {
+    std::vector<AudioFrame*> other_frames(mix_list);
+    other_frames.erase(other_frames.begin() + i);
+    SetAudioFrameFields(other_frames, number_of_channels, sample_rate,
+                        number_of_streams, minus_one_frames[i]);
+  }
 
   const size_t samples_per_channel = static_cast<size_t>(
       (sample_rate * webrtc::AudioMixerImpl::kFrameDurationInMs) / 1000);
@@ -168,11 +269,14 @@ void FrameCombiner::Combine(const std::vector<AudioFrame*>& mix_list,
 
   if (number_of_streams <= 1) {
     MixFewFramesWithNoLimiter(mix_list, audio_frame_for_mixing);
+    // There is at most one frame, so the mixes without it are silent.
+    for (AudioFrame* frame : minus_one_frames)
+      frame->Mute();
     return;
   }
 
-  MixToFloatFrame(mix_list, samples_per_channel, number_of_channels,
-                  mixing_buffer_.get());
+  MixToFloatFrame(vector_math_, mix_list, samples_per_channel,
+                  number_of_channels, mixing_buffer_.get());
 
   const size_t output_number_of_channels =
       std::min(number_of_channels, kMaximumNumberOfChannels);
@@ -188,11 +292,41 @@ void FrameCombiner::Combine(const std::vector<AudioFrame*>& mix_list,
                                            output_number_of_channels,
                                            output_samples_per_channel);
 
+  if (!minus_one_frames.empty()) {
+    if (!minus_one_buffer_)
+      minus_one_buffer_ = absl::make_unique<MixingBuffer>();
+    std::array<float*, kMaximumNumberOfChannels> minus_one_pointers{};
+    for (size_t i = 0; i < output_number_of_channels; ++i) {
+      minus_one_pointers[i] = &(*minus_one_buffer_)[i][0];
+    }
+    AudioFrameView<float> minus_one_view(&minus_one_pointers[0],
+                                         output_number_of_channels,
+                                         output_samples_per_channel);
+
+    // The mix is limited in place, so the minus-one mixes are made first.
+    for (size_t i = 0; i < minus_one_frames.size(); ++i) {
+      SubtractFromFloatFrame(*mixing_buffer_, *mix_list[i],
+                             output_samples_per_channel, number_of_channels,
+                             minus_one_buffer_.get());
+      if (use_limiter_) {
+        std::unique_ptr<Limiter>& limiter = minus_one_limiters_[sources[i]];
+        if (!limiter) {
+          limiter = absl::make_unique<Limiter>(
+              static_cast<size_t>(48000), data_dumper_.get(), "AudioMixer");
+        }
+        RunLimiter(minus_one_view, limiter.get());
+      }
+      InterleaveToAudioFrame(vector_math_, minus_one_view,
+                             minus_one_frames[i]);
+    }
+  }
+
   if (use_limiter_) {
     RunLimiter(mixing_buffer_view, &limiter_);
   }
 
-  InterleaveToAudioFrame(mixing_buffer_view, audio_frame_for_mixing);
+  InterleaveToAudioFrame(vector_math_, mixing_buffer_view,
+                         audio_frame_for_mixing);
 }
 
 void FrameCombiner::LogMixingStats(const std::vector<AudioFrame*>& mix_list,
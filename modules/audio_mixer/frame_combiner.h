@@ -11,11 +11,15 @@
 #ifndef MODULES_AUDIO_MIXER_FRAME_COMBINER_H_
 #define MODULES_AUDIO_MIXER_FRAME_COMBINER_H_
 
+#include <map>
 #include <memory>
 #include <vector>
 
+#include "api/array_view.h"
 #include "api/audio/audio_frame.h"
+#include "api/audio/audio_mixer.h"
 #include "modules/audio_processing/agc2/limiter.h"
+#include "modules/audio_processing/agc2/vector_math.h"
 
 namespace webrtc {
 class ApmDataDumper;
@@ -38,6 +42,20 @@ class FrameCombiner {
                size_t number_of_streams,
                AudioFrame* audio_frame_for_mixing);
 
+  // Same as Combine(), and also outputs the mix without each of the frames
+  // in 'mix_list': 'minus_one_frames[i]' is the mix of all frames but
+  // 'mix_list[i]', which is the frame of 'sources[i]'. The frames are mixed
+  // once and each minus-one mix is derived by subtracting its frame from the
+  // mix, before limiting it with the limiter of its source. A source gets a
+  // new limiter when it enters the mix and loses it when it leaves.
+  void CombineMinusOne(const std::vector<AudioFrame*>& mix_list,
+                       rtc::ArrayView<AudioMixer::Source* const> sources,
+                       size_t number_of_channels,
+                       int sample_rate,
+                       size_t number_of_streams,
+                       AudioFrame* audio_frame_for_mixing,
+                       rtc::ArrayView<AudioFrame* const> minus_one_frames);
+
   // Stereo, 48 kHz, 10 ms.
   static constexpr size_t kMaximumNumberOfChannels = 8;
   static constexpr size_t kMaximumChannelSize = 48 * 10;
@@ -46,6 +64,13 @@ class FrameCombiner {
                                   kMaximumNumberOfChannels>;
 
  private:
+  void CombineFrames(const std::vector<AudioFrame*>& mix_list,
+                     rtc::ArrayView<AudioMixer::Source* const> sources,
+                     size_t number_of_channels,
+                     int sample_rate,
+                     size_t number_of_streams,
+                     AudioFrame* audio_frame_for_mixing,
+                     rtc::ArrayView<AudioFrame* const> minus_one_frames);
   void LogMixingStats(const std::vector<AudioFrame*>& mix_list,
                       int sample_rate,
                       size_t number_of_streams) const;
@@ -53,6 +78,12 @@ class FrameCombiner {
   std::unique_ptr<ApmDataDumper> data_dumper_;
   std::unique_ptr<MixingBuffer> mixing_buffer_;
   Limiter limiter_;
+  const VectorMath vector_math_;
+  // Created on the first CombineMinusOne() call. The limiters are keyed by
+  // the source whose audio is left out of the minus-one mix.
+  std::unique_ptr<MixingBuffer> minus_one_buffer_;
+  std::map<const AudioMixer::Source*, std::unique_ptr<Limiter>>
+      minus_one_limiters_;
   const bool use_limiter_;
   mutable int uma_logging_counter_ = 0;
 };
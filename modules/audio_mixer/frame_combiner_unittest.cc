@@ -10,6 +10,7 @@
 
 #include "modules/audio_mixer/frame_combiner.h"
 
+#include <algorithm>
 #include <cstdint>
 #include <initializer_list>
 #include <numeric>
@@ -22,8 +23,10 @@
 #include "modules/audio_mixer/sine_wave_generator.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/strings/string_builder.h"
+#include "rtc_base/time_utils.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 
@@ -216,6 +219,34 @@ TEST(FrameCombiner, CombiningOneFrameShouldNotChangeFrame) {
   }
 }
 
+TEST(FrameCombiner, CombiningFramesWithoutLimiterAddsThem) {
+  FrameCombiner combiner(false);
+  for (const int rate : {8000, 16000, 44100, 48000}) {
+    for (const int number_of_channels : {1, 2, 4}) {
+      SCOPED_TRACE(ProduceDebugText(rate, number_of_channels, 2));
+
+      SetUpFrames(rate, number_of_channels);
+      const size_t number_of_samples = number_of_channels * rate / 100;
+      int16_t* frame1_data = frame1.mutable_data();
+      int16_t* frame2_data = frame2.mutable_data();
+      for (size_t i = 0; i < number_of_samples; ++i) {
+        frame1_data[i] = static_cast<int16_t>(20 * i - 10000);
+        frame2_data[i] = static_cast<int16_t>(30000 - 7 * i);
+      }
+      const std::vector<AudioFrame*> frames_to_combine = {&frame1, &frame2};
+      combiner.Combine(frames_to_combine, number_of_channels, rate,
+                       frames_to_combine.size(), &audio_frame_for_mixing);
+
+      // The sums above the int16 range are saturated.
+      for (size_t i = 0; i < number_of_samples; ++i) {
+        const int sum = frame1_data[i] + frame2_data[i];
+        ASSERT_EQ(std::min(sum, 32767), audio_frame_for_mixing.data()[i])
+            << "Sample " << i;
+      }
+    }
+  }
+}
+
 // Send a sine wave through the FrameCombiner, and check that the
 // difference between input and output varies smoothly. Also check
 // that it is inside reasonable bounds. This is to catch issues like
@@ -273,4 +304,37 @@ TEST(FrameCombiner, GainCurveIsSmoothForAlternatingNumberOfStreams) {
     EXPECT_LT(change_calculator.LatestGain(), 1.01f);
   }
 }
+
+TEST(FrameCombiner, DISABLED_CombinePerf) {
+  constexpr int kNumIterations = 20000;
+  constexpr int kSampleRateHz = 48000;
+  constexpr size_t kNumberOfStreams = 3;
+  for (const int number_of_channels : {1, 2}) {
+    FrameCombiner combiner(true);
+    std::vector<AudioFrame> frames(kNumberOfStreams);
+    std::vector<AudioFrame*> frames_to_combine;
+    for (size_t i = 0; i < kNumberOfStreams; ++i) {
+      frames[i].UpdateFrame(0, nullptr, kSampleRateHz / 100, kSampleRateHz,
+                            AudioFrame::kNormalSpeech, AudioFrame::kVadActive,
+                            number_of_channels);
+      SineWaveGenerator(300.f * (i + 1), 12000).GenerateNextFrame(&frames[i]);
+      frames_to_combine.push_back(&frames[i]);
+    }
+
+    const int64_t start_ns = rtc::SystemTimeNanos();
+    for (int i = 0; i < kNumIterations; ++i) {
+      combiner.Combine(frames_to_combine, number_of_channels, kSampleRateHz,
+                       kNumberOfStreams, &audio_frame_for_mixing);
+    }
+    const int64_t elapsed_ns = rtc::SystemTimeNanos() - start_ns;
+    const std::string modifier =
+        "_" + std::to_string(number_of_channels) + "_channels";
+    test::PrintResult("frame_combiner", modifier, "mixes_per_second",
+                      kNumIterations *
+                          static_cast<double>(rtc::kNumNanosecsPerSec) /
+                          elapsed_ns,
+                      "mixes/s", false);
+  }
+}
+
 }  // namespace webrtc
@@ -0,0 +1,131 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_processing/aec3/adaptive_fir_filter.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+
+#include "rtc_base/checks.h"
+
+namespace webrtc {
+
+namespace aec3 {
+
+// Computes and stores the frequency response of the filter (AVX2 variant).
+void UpdateFrequencyResponse_AVX2(
+    rtc::ArrayView<const FftData> H,
+    std::vector<std::array<float, kFftLengthBy2Plus1>>* H2) {
+  RTC_DCHECK_EQ(H.size(), H2->size());
+  for (size_t k = 0; k < H.size(); ++k) {
+    for (size_t j = 0; j < kFftLengthBy2; j += 8) {
+      const __m256 re = _mm256_loadu_ps(&H[k].re[j]);
+      const __m256 im = _mm256_loadu_ps(&H[k].im[j]);
+      const __m256 H2_k_j = _mm256_fmadd_ps(re, re, _mm256_mul_ps(im, im));
+      _mm256_storeu_ps(&(*H2)[k][j], H2_k_j);
+    }
+    (*H2)[k][kFftLengthBy2] = H[k].re[kFftLengthBy2] * H[k].re[kFftLengthBy2] +
+                              H[k].im[kFftLengthBy2] * H[k].im[kFftLengthBy2];
+  }
+}
+
+// Adapts the filter partitions (AVX2 variant).
+void AdaptPartitions_AVX2(const RenderBuffer& render_buffer,
+                          const FftData& G,
+                          rtc::ArrayView<FftData> H) {
+  rtc::ArrayView<const std::vector<FftData>> render_buffer_data =
+      render_buffer.GetFftBuffer();
+  const int lim1 =
+      std::min(render_buffer_data.size() - render_buffer.Position(), H.size());
+  const int lim2 = H.size();
+  FftData* H_j = &H[0];
+  const std::vector<FftData>* X_channels =
+      &render_buffer_data[render_buffer.Position()];
+
+  int j = 0;
+  int limit = lim1;
+  do {
+    for (; j < limit; ++j, ++H_j, ++X_channels) {
+      const FftData& X = (*X_channels)[/*channel=*/0];
+      for (size_t k = 0; k < kFftLengthBy2; k += 8) {
+        const __m256 G_re = _mm256_loadu_ps(&G.re[k]);
+        const __m256 G_im = _mm256_loadu_ps(&G.im[k]);
+        const __m256 X_re = _mm256_loadu_ps(&X.re[k]);
+        const __m256 X_im = _mm256_loadu_ps(&X.im[k]);
+        __m256 H_re = _mm256_loadu_ps(&H_j->re[k]);
+        __m256 H_im = _mm256_loadu_ps(&H_j->im[k]);
+        // H += G * conj(X).
+        H_re = _mm256_fmadd_ps(X_re, G_re, H_re);
+        H_re = _mm256_fmadd_ps(X_im, G_im, H_re);
+        H_im = _mm256_fmadd_ps(X_re, G_im, H_im);
+        H_im = _mm256_fnmadd_ps(X_im, G_re, H_im);
+        _mm256_storeu_ps(&H_j->re[k], H_re);
+        _mm256_storeu_ps(&H_j->im[k], H_im);
+      }
+      H_j->re[kFftLengthBy2] += X.re[kFftLengthBy2] * G.re[kFftLengthBy2] +
+                                X.im[kFftLengthBy2] * G.im[kFftLengthBy2];
+      H_j->im[kFftLengthBy2] += X.re[kFftLengthBy2] * G.im[kFftLengthBy2] -
+                                X.im[kFftLengthBy2] * G.re[kFftLengthBy2];
+    }
+
+    X_channels = &render_buffer_data[0];
+    limit = lim2;
+  } while (j < lim2);
+}
+
+// Produces the filter output (AVX2 variant).
+void ApplyFilter_AVX2(const RenderBuffer& render_buffer,
+                      rtc::ArrayView<const FftData> H,
+                      FftData* S) {
+  S->re.fill(0.f);
+  S->im.fill(0.f);
+
+  rtc::ArrayView<const std::vector<FftData>> render_buffer_data =
+      render_buffer.GetFftBuffer();
+  const int lim1 =
+      std::min(render_buffer_data.size() - render_buffer.Position(), H.size());
+  const int lim2 = H.size();
+  const FftData* H_j = &H[0];
+  const std::vector<FftData>* X_channels =
+      &render_buffer_data[render_buffer.Position()];
+
+  int j = 0;
+  int limit = lim1;
+  do {
+    for (; j < limit; ++j, ++H_j, ++X_channels) {
+      const FftData& X = (*X_channels)[/*channel=*/0];
+      for (size_t k = 0; k < kFftLengthBy2; k += 8) {
+        const __m256 X_re = _mm256_loadu_ps(&X.re[k]);
+        const __m256 X_im = _mm256_loadu_ps(&X.im[k]);
+        const __m256 H_re = _mm256_loadu_ps(&H_j->re[k]);
+        const __m256 H_im = _mm256_loadu_ps(&H_j->im[k]);
+        __m256 S_re = _mm256_loadu_ps(&S->re[k]);
+        __m256 S_im = _mm256_loadu_ps(&S->im[k]);
+        // S += X * H.
+        S_re = _mm256_fmadd_ps(X_re, H_re, S_re);
+        S_re = _mm256_fnmadd_ps(X_im, H_im, S_re);
+        S_im = _mm256_fmadd_ps(X_re, H_im, S_im);
+        S_im = _mm256_fmadd_ps(X_im, H_re, S_im);
+        _mm256_storeu_ps(&S->re[k], S_re);
+        _mm256_storeu_ps(&S->im[k], S_im);
+      }
+      S->re[kFftLengthBy2] += X.re[kFftLengthBy2] * H_j->re[kFftLengthBy2] -
+                              X.im[kFftLengthBy2] * H_j->im[kFftLengthBy2];
+      S->im[kFftLengthBy2] += X.re[kFftLengthBy2] * H_j->im[kFftLengthBy2] +
+                              X.im[kFftLengthBy2] * H_j->re[kFftLengthBy2];
+    }
+    limit = lim2;
+    X_channels = &render_buffer_data[0];
+  } while (j < lim2);
+}
+
+}  // namespace aec3
+}  // namespace webrtc
@@ -75,6 +75,31 @@ TEST(AdaptiveFirFilter, UpdateErlSse2Optimization) {
   }
 }
 
+// Verifies that the AVX2 method for echo return loss computation matches the
+// SSE2 one.
+TEST(AdaptiveFirFilter, UpdateErlAvx2Optimization) {
+  if (DetectOptimization() != Aec3Optimization::kAvx2) {
+    return;
+  }
+  const size_t kNumPartitions = 12;
+  std::vector<std::array<float, kFftLengthBy2Plus1>> H2(kNumPartitions);
+  std::array<float, kFftLengthBy2Plus1> erl_SSE2;
+  std::array<float, kFftLengthBy2Plus1> erl_AVX2;
+
+  for (size_t j = 0; j < H2.size(); ++j) {
+    for (size_t k = 0; k < H2[j].size(); ++k) {
+      H2[j][k] = k + j / 3.f;
+    }
+  }
+
+  ErlComputer_SSE2(H2, erl_SSE2);
+  ErlComputer_AVX2(H2, erl_AVX2);
+
+  for (size_t j = 0; j < erl_SSE2.size(); ++j) {
+    EXPECT_FLOAT_EQ(erl_SSE2[j], erl_AVX2[j]);
+  }
+}
+
 #endif
 
 }  // namespace aec3
@@ -16,6 +16,7 @@
 #include <algorithm>
 #include <numeric>
 #include <string>
+#include <utility>
 
 #include "rtc_base/system/arch.h"
 #if defined(WEBRTC_ARCH_X86_FAMILY)
@@ -35,8 +36,10 @@
 #include "rtc_base/numerics/safe_minmax.h"
 #include "rtc_base/random.h"
 #include "rtc_base/strings/string_builder.h"
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/cpu_features_wrapper.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 namespace aec3 {
@@ -245,6 +248,115 @@ TEST(AdaptiveFirFilter, UpdateFrequencyResponseSse2Optimization) {
   }
 }
 
+// Verifies that the AVX2 methods for filtering and filter adaptation match the
+// SSE2 ones. The fused multiply-adds round differently, so the results are
+// compared relative to the largest magnitude in the output.
+TEST(AdaptiveFirFilter, FilterAdaptationAvx2Optimizations) {
+  if (DetectOptimization() != Aec3Optimization::kAvx2) {
+    return;
+  }
+  constexpr size_t kNumRenderChannels = 1;
+  constexpr int kSampleRateHz = 48000;
+  constexpr size_t kNumBands = NumBandsForRate(kSampleRateHz);
+  constexpr float kRelativeTolerance = 1e-5f;
+
+  std::unique_ptr<RenderDelayBuffer> render_delay_buffer(
+      RenderDelayBuffer::Create(EchoCanceller3Config(), kSampleRateHz,
+                                kNumRenderChannels));
+  Random random_generator(42U);
+  std::vector<std::vector<std::vector<float>>> x(
+      kNumBands,
+      std::vector<std::vector<float>>(kNumRenderChannels,
+                                      std::vector<float>(kBlockSize, 0.f)));
+  FftData S_SSE2;
+  FftData S_AVX2;
+  FftData G;
+  std::vector<FftData> H_SSE2(10);
+  std::vector<FftData> H_AVX2(10);
+  for (auto& H_j : H_SSE2) {
+    H_j.Clear();
+  }
+  for (auto& H_j : H_AVX2) {
+    H_j.Clear();
+  }
+
+  for (size_t k = 0; k < 500; ++k) {
+    for (size_t band = 0; band < x.size(); ++band) {
+      for (size_t channel = 0; channel < x[band].size(); ++channel) {
+        RandomizeSampleVector(&random_generator, x[band][channel]);
+      }
+    }
+    render_delay_buffer->Insert(x);
+    if (k == 0) {
+      render_delay_buffer->Reset();
+    }
+    render_delay_buffer->PrepareCaptureProcessing();
+    auto* const render_buffer = render_delay_buffer->GetRenderBuffer();
+
+    ApplyFilter_AVX2(*render_buffer, H_AVX2, &S_AVX2);
+    ApplyFilter_SSE2(*render_buffer, H_SSE2, &S_SSE2);
+    float max_abs_S = 1.f;
+    for (size_t j = 0; j < S_SSE2.re.size(); ++j) {
+      max_abs_S = std::max(
+          max_abs_S, std::max(fabsf(S_SSE2.re[j]), fabsf(S_SSE2.im[j])));
+    }
+    for (size_t j = 0; j < S_SSE2.re.size(); ++j) {
+      EXPECT_NEAR(S_SSE2.re[j], S_AVX2.re[j], kRelativeTolerance * max_abs_S);
+      EXPECT_NEAR(S_SSE2.im[j], S_AVX2.im[j], kRelativeTolerance * max_abs_S);
+    }
+
+    std::for_each(G.re.begin(), G.re.end(),
+                  [&](float& a) { a = random_generator.Rand<float>(); });
+    std::for_each(G.im.begin(), G.im.end(),
+                  [&](float& a) { a = random_generator.Rand<float>(); });
+
+    AdaptPartitions_AVX2(*render_buffer, G, H_AVX2);
+    AdaptPartitions_SSE2(*render_buffer, G, H_SSE2);
+
+    for (size_t p = 0; p < H_SSE2.size(); ++p) {
+      float max_abs_H = 1.f;
+      for (size_t j = 0; j < H_SSE2[p].re.size(); ++j) {
+        max_abs_H = std::max(max_abs_H, std::max(fabsf(H_SSE2[p].re[j]),
+                                                 fabsf(H_SSE2[p].im[j])));
+      }
+      for (size_t j = 0; j < H_SSE2[p].re.size(); ++j) {
+        EXPECT_NEAR(H_SSE2[p].re[j], H_AVX2[p].re[j],
+                    kRelativeTolerance * max_abs_H);
+        EXPECT_NEAR(H_SSE2[p].im[j], H_AVX2[p].im[j],
+                    kRelativeTolerance * max_abs_H);
+      }
+    }
+  }
+}
+
+// Verifies that the AVX2 method for frequency response computation matches the
+// SSE2 one.
+TEST(AdaptiveFirFilter, UpdateFrequencyResponseAvx2Optimization) {
+  if (DetectOptimization() != Aec3Optimization::kAvx2) {
+    return;
+  }
+  const size_t kNumPartitions = 12;
+  std::vector<FftData> H(kNumPartitions);
+  std::vector<std::array<float, kFftLengthBy2Plus1>> H2_SSE2(kNumPartitions);
+  std::vector<std::array<float, kFftLengthBy2Plus1>> H2_AVX2(kNumPartitions);
+
+  for (size_t j = 0; j < H.size(); ++j) {
+    for (size_t k = 0; k < H[j].re.size(); ++k) {
+      H[j].re[k] = k + j / 3.f;
+      H[j].im[k] = j + k / 7.f;
+    }
+  }
+
+  UpdateFrequencyResponse_SSE2(H, &H2_SSE2);
+  UpdateFrequencyResponse_AVX2(H, &H2_AVX2);
+
+  for (size_t j = 0; j < H2_SSE2.size(); ++j) {
+    for (size_t k = 0; k < H[j].re.size(); ++k) {
+      EXPECT_FLOAT_EQ(H2_SSE2[j][k], H2_AVX2[j][k]);
+    }
+  }
+}
+
 #endif
 
 #if RTC_DCHECK_IS_ON && GTEST_HAS_DEATH_TEST && !defined(WEBRTC_ANDROID)
@@ -405,5 +517,82 @@ TEST(AdaptiveFirFilter, FilterAndAdapt) {
               std::inner_product(y.begin(), y.end(), y.begin(), 0.f));
   }
 }
+
+// Measures the time spent per block in the filtering, the adaptation, the
+// frequency response and the echo return loss computation of a main filter of
+// the default length, for each available optimization.
+TEST(AdaptiveFirFilter, DISABLED_FilterAndAdaptPerf) {
+  constexpr size_t kNumRenderChannels = 1;
+  constexpr int kSampleRateHz = 48000;
+  constexpr size_t kNumBands = NumBandsForRate(kSampleRateHz);
+  constexpr int kNumBlocks = 20000;
+  EchoCanceller3Config config;
+  std::vector<std::pair<Aec3Optimization, std::string>> optimizations = {
+      {Aec3Optimization::kNone, "none"}};
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2) != 0) {
+    optimizations.push_back({Aec3Optimization::kSse2, "sse2"});
+  }
+  if (DetectOptimization() == Aec3Optimization::kAvx2) {
+    optimizations.push_back({Aec3Optimization::kAvx2, "avx2"});
+  }
+#endif
+#if defined(WEBRTC_HAS_NEON)
+  optimizations.push_back({Aec3Optimization::kNeon, "neon"});
+#endif
+
+  for (const auto& optimization : optimizations) {
+    ApmDataDumper data_dumper(42);
+    AdaptiveFirFilter filter(config.filter.main.length_blocks,
+                             config.filter.main.length_blocks,
+                             config.filter.config_change_duration_blocks, 1, 1,
+                             optimization.first, &data_dumper);
+    std::unique_ptr<RenderDelayBuffer> render_delay_buffer(
+        RenderDelayBuffer::Create(config, kSampleRateHz, kNumRenderChannels));
+    Random random_generator(42U);
+    std::vector<std::vector<std::vector<float>>> x(
+        kNumBands,
+        std::vector<std::vector<float>>(kNumRenderChannels,
+                                        std::vector<float>(kBlockSize, 0.f)));
+    std::vector<std::array<float, kFftLengthBy2Plus1>> H2(
+        filter.max_filter_size_partitions(),
+        std::array<float, kFftLengthBy2Plus1>());
+    std::array<float, kFftLengthBy2Plus1> erl;
+    FftData S;
+    FftData G;
+    int64_t elapsed_ns = 0;
+    for (int k = 0; k < kNumBlocks; ++k) {
+      for (auto& band : x) {
+        RandomizeSampleVector(&random_generator, band[0]);
+      }
+      render_delay_buffer->Insert(x);
+      if (k == 0) {
+        render_delay_buffer->Reset();
+      }
+      render_delay_buffer->PrepareCaptureProcessing();
+      const RenderBuffer& render_buffer =
+          *render_delay_buffer->GetRenderBuffer();
+      // A small gain keeps the filter bounded.
+      std::for_each(G.re.begin(), G.re.end(), [&](float& a) {
+        a = 1e-9f * random_generator.Rand<float>();
+      });
+      std::for_each(G.im.begin(), G.im.end(), [&](float& a) {
+        a = 1e-9f * random_generator.Rand<float>();
+      });
+
+      const int64_t start_ns = rtc::SystemTimeNanos();
+      filter.Filter(render_buffer, &S);
+      filter.Adapt(render_buffer, G);
+      filter.ComputeFrequencyResponse(&H2);
+      ComputeErl(optimization.first, H2, erl);
+      elapsed_ns += rtc::SystemTimeNanos() - start_ns;
+    }
+    test::PrintResult("aec3_adaptive_fir_filter", "_" + optimization.second,
+                      "block_time",
+                      static_cast<double>(elapsed_ns) / kNumBlocks, "ns",
+                      false);
+  }
+}
+
 }  // namespace aec3
 }  // namespace webrtc
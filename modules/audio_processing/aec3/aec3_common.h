@@ -23,7 +23,9 @@ namespace webrtc {
 #define ALIGN16_END __attribute__((aligned(16)))
 #endif
 
-enum class Aec3Optimization { kNone, kSse2, kNeon };
+// kAvx2 stands for AVX2 together with FMA3. The code paths without an AVX2
+// variant use the SSE2 one.
+enum class Aec3Optimization { kNone, kSse2, kAvx2, kNeon };
 
 constexpr int kNumBlocksPerSecond = 250;
 
@@ -18,6 +18,7 @@
 #endif
 #include <algorithm>
 #include <string>
+#include <utility>
 
 #include "modules/audio_processing/aec3/aec3_common.h"
 #include "modules/audio_processing/aec3/decimator.h"
@@ -26,8 +27,10 @@
 #include "modules/audio_processing/test/echo_canceller_test_tools.h"
 #include "rtc_base/random.h"
 #include "rtc_base/strings/string_builder.h"
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/cpu_features_wrapper.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 namespace aec3 {
@@ -133,8 +136,114 @@ TEST(MatchedFilter, TestSse2Optimizations) {
   }
 }
 
+// Verifies that the AVX2 methods are similar to the SSE2 ones. The fused
+// multiply-adds round differently, so the results are not bitexact.
+TEST(MatchedFilter, TestAvx2Optimizations) {
+  if (DetectOptimization() != Aec3Optimization::kAvx2) {
+    return;
+  }
+  Random random_generator(42U);
+  constexpr float kSmoothing = 0.7f;
+  for (auto down_sampling_factor : kDownSamplingFactors) {
+    const size_t sub_block_size = kBlockSize / down_sampling_factor;
+    std::vector<float> x(2000);
+    RandomizeSampleVector(&random_generator, x);
+    std::vector<float> y(sub_block_size);
+    std::vector<float> h_SSE2(512);
+    std::vector<float> h_AVX2(512);
+    int x_index = 0;
+    for (int k = 0; k < 1000; ++k) {
+      RandomizeSampleVector(&random_generator, y);
+
+      bool filters_updated_SSE2 = false;
+      float error_sum_SSE2 = 0.f;
+      bool filters_updated_AVX2 = false;
+      float error_sum_AVX2 = 0.f;
+
+      MatchedFilterCore_SSE2(x_index, h_SSE2.size() * 150.f * 150.f,
+                             kSmoothing, x, y, h_SSE2, &filters_updated_SSE2,
+                             &error_sum_SSE2);
+
+      MatchedFilterCore_AVX2(x_index, h_AVX2.size() * 150.f * 150.f,
+                             kSmoothing, x, y, h_AVX2, &filters_updated_AVX2,
+                             &error_sum_AVX2);
+
+      EXPECT_EQ(filters_updated_SSE2, filters_updated_AVX2);
+      EXPECT_NEAR(error_sum_SSE2, error_sum_AVX2, error_sum_SSE2 / 100000.f);
+
+      for (size_t j = 0; j < h_SSE2.size(); ++j) {
+        EXPECT_NEAR(h_SSE2[j], h_AVX2[j], 0.00001f);
+      }
+
+      x_index = (x_index + sub_block_size) % x.size();
+    }
+  }
+}
+
 #endif
 
+// Measures the time spent per block in the matched filters of the delay
+// estimator with the default configuration, for each available optimization.
+TEST(MatchedFilter, DISABLED_UpdatePerf) {
+  constexpr int kNumBlocks = 20000;
+  const EchoCanceller3Config config;
+  const size_t sub_block_size = kBlockSize / config.delay.down_sampling_factor;
+  std::vector<std::pair<Aec3Optimization, std::string>> optimizations = {
+      {Aec3Optimization::kNone, "none"}};
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (WebRtc_GetCPUInfo(kSSE2) != 0) {
+    optimizations.push_back({Aec3Optimization::kSse2, "sse2"});
+  }
+  if (DetectOptimization() == Aec3Optimization::kAvx2) {
+    optimizations.push_back({Aec3Optimization::kAvx2, "avx2"});
+  }
+#endif
+#if defined(WEBRTC_HAS_NEON)
+  optimizations.push_back({Aec3Optimization::kNeon, "neon"});
+#endif
+
+  for (const auto& optimization : optimizations) {
+    Random random_generator(42U);
+    ApmDataDumper data_dumper(0);
+    MatchedFilter filter(&data_dumper, optimization.first, sub_block_size,
+                         kMatchedFilterWindowSizeSubBlocks,
+                         config.delay.num_filters,
+                         kMatchedFilterAlignmentShiftSizeSubBlocks,
+                         config.render_levels.poor_excitation_render_limit,
+                         config.delay.delay_estimate_smoothing,
+                         config.delay.delay_candidate_detection_threshold);
+    std::unique_ptr<RenderDelayBuffer> render_delay_buffer(
+        RenderDelayBuffer::Create(config, 16000, 1));
+    Decimator capture_decimator(config.delay.down_sampling_factor);
+    std::vector<std::vector<std::vector<float>>> render(
+        1, std::vector<std::vector<float>>(1, std::vector<float>(kBlockSize)));
+    std::vector<std::vector<float>> capture(1, std::vector<float>(kBlockSize));
+    std::array<float, kBlockSize> downsampled_capture_data;
+    rtc::ArrayView<float> downsampled_capture(downsampled_capture_data.data(),
+                                              sub_block_size);
+    int64_t elapsed_ns = 0;
+    for (int k = 0; k < kNumBlocks; ++k) {
+      RandomizeSampleVector(&random_generator, render[0][0]);
+      RandomizeSampleVector(&random_generator, capture[0]);
+      render_delay_buffer->Insert(render);
+      if (k == 0) {
+        render_delay_buffer->Reset();
+      }
+      render_delay_buffer->PrepareCaptureProcessing();
+      capture_decimator.Decimate(capture, true, downsampled_capture);
+
+      const int64_t start_ns = rtc::SystemTimeNanos();
+      filter.Update(render_delay_buffer->GetDownsampledRenderBuffer(),
+                    downsampled_capture);
+      elapsed_ns += rtc::SystemTimeNanos() - start_ns;
+    }
+    test::PrintResult("aec3_matched_filter", "_" + optimization.second,
+                      "block_time",
+                      static_cast<double>(elapsed_ns) / kNumBlocks, "ns",
+                      false);
+  }
+}
+
 // Verifies that the matched filter produces proper lag estimates for
 // artificially
 // delayed signals.
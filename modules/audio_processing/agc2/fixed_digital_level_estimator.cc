@@ -11,7 +11,6 @@
 #include "modules/audio_processing/agc2/fixed_digital_level_estimator.h"
 
 #include <algorithm>
-#include <cmath>
 
 #include "api/array_view.h"
 #include "modules/audio_processing/logging/apm_data_dumper.h"
@@ -28,6 +27,7 @@ FixedDigitalLevelEstimator::FixedDigitalLevelEstimator(
     size_t sample_rate_hz,
     ApmDataDumper* apm_data_dumper)
     : apm_data_dumper_(apm_data_dumper),
+      vector_math_(GetAvailableCpuFeatures()),
       filter_state_level_(kInitialFilterStateLevel) {
   SetSampleRate(sample_rate_hz);
   CheckParameterCombination();
@@ -53,13 +53,10 @@ std::array<float, kSubFramesInFrame> FixedDigitalLevelEstimator::ComputeLevel(
        ++channel_idx) {
     const auto channel = float_frame.channel(channel_idx);
     for (size_t sub_frame = 0; sub_frame < kSubFramesInFrame; ++sub_frame) {
-      for (size_t sample_in_sub_frame = 0;
-           sample_in_sub_frame < samples_in_sub_frame_; ++sample_in_sub_frame) {
-        envelope[sub_frame] =
-            std::max(envelope[sub_frame],
-                     std::abs(channel[sub_frame * samples_in_sub_frame_ +
-                                      sample_in_sub_frame]));
-      }
+      envelope[sub_frame] = std::max(
+          envelope[sub_frame],
+          vector_math_.MaxAbs(channel.subview(
+              sub_frame * samples_in_sub_frame_, samples_in_sub_frame_)));
     }
   }
 
@@ -12,7 +12,6 @@
 
 #include "api/array_view.h"
 #include "modules/audio_processing/agc2/agc2_common.h"
-#include "rtc_base/numerics/safe_minmax.h"
 
 namespace webrtc {
 namespace {
@@ -24,16 +23,14 @@ bool GainCloseToOne(float gain_factor) {
          gain_factor <= 1.f + 1.f / kMaxFloatS16Value;
 }
 
-void ClipSignal(AudioFrameView<float> signal) {
+void ClipSignal(const VectorMath& vector_math, AudioFrameView<float> signal) {
   for (size_t k = 0; k < signal.num_channels(); ++k) {
-    rtc::ArrayView<float> channel_view = signal.channel(k);
-    for (auto& sample : channel_view) {
-      sample = rtc::SafeClamp(sample, kMinFloatS16Value, kMaxFloatS16Value);
-    }
+    vector_math.Clamp(signal.channel(k));
   }
 }
 
-void ApplyGainWithRamping(float last_gain_linear,
+void ApplyGainWithRamping(const VectorMath& vector_math,
+                          float last_gain_linear,
                           float gain_at_end_of_frame_linear,
                           float inverse_samples_per_channel,
                           AudioFrameView<float> float_frame) {
@@ -46,10 +43,7 @@ void ApplyGainWithRamping(float last_gain_linear,
   // Gain is constant and different from 1.
   if (last_gain_linear == gain_at_end_of_frame_linear) {
     for (size_t k = 0; k < float_frame.num_channels(); ++k) {
-      rtc::ArrayView<float> channel_view = float_frame.channel(k);
-      for (auto& sample : channel_view) {
-        sample *= gain_at_end_of_frame_linear;
-      }
+      vector_math.Scale(gain_at_end_of_frame_linear, float_frame.channel(k));
     }
     return;
   }
@@ -57,12 +51,9 @@ void ApplyGainWithRamping(float last_gain_linear,
   // The gain changes. We have to change slowly to avoid discontinuities.
   const float increment = (gain_at_end_of_frame_linear - last_gain_linear) *
                           inverse_samples_per_channel;
-  float gain = last_gain_linear;
-  for (size_t i = 0; i < float_frame.samples_per_channel(); ++i) {
-    for (size_t ch = 0; ch < float_frame.num_channels(); ++ch) {
-      float_frame.channel(ch)[i] *= gain;
-    }
-    gain += increment;
+  for (size_t ch = 0; ch < float_frame.num_channels(); ++ch) {
+    vector_math.ScaleWithRamp(last_gain_linear, increment,
+                              float_frame.channel(ch));
   }
 }
 
@@ -70,6 +61,7 @@ void ApplyGainWithRamping(float last_gain_linear,
 
 GainApplier::GainApplier(bool hard_clip_samples, float initial_gain_factor)
     : hard_clip_samples_(hard_clip_samples),
+      vector_math_(GetAvailableCpuFeatures()),
       last_gain_factor_(initial_gain_factor),
       current_gain_factor_(initial_gain_factor) {}
 
@@ -78,13 +70,13 @@ void GainApplier::ApplyGain(AudioFrameView<float> signal) {
     Initialize(signal.samples_per_channel());
   }
 
-  ApplyGainWithRamping(last_gain_factor_, current_gain_factor_,
+  ApplyGainWithRamping(vector_math_, last_gain_factor_, current_gain_factor_,
                        inverse_samples_per_channel_, signal);
 
   last_gain_factor_ = current_gain_factor_;
 
   if (hard_clip_samples_) {
-    ClipSignal(signal);
+    ClipSignal(vector_math_, signal);
   }
 }
 
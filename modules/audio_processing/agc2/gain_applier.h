@@ -13,6 +13,7 @@
 
 #include <stddef.h>
 
+#include "modules/audio_processing/agc2/vector_math.h"
 #include "modules/audio_processing/include/audio_frame_view.h"
 
 namespace webrtc {
@@ -30,6 +31,7 @@ class GainApplier {
   // Whether to clip samples after gain is applied. If 'true', result
   // will fit in FloatS16 range.
   const bool hard_clip_samples_;
+  const VectorMath vector_math_;
   float last_gain_factor_;
 
   // If this value is not equal to 'last_gain_factor', gain will be
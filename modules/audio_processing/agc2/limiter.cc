@@ -18,7 +18,6 @@
 #include "modules/audio_processing/agc2/agc2_common.h"
 #include "modules/audio_processing/logging/apm_data_dumper.h"
 #include "rtc_base/checks.h"
-#include "rtc_base/numerics/safe_minmax.h"
 
 namespace webrtc {
 namespace {
@@ -71,16 +70,14 @@ void ComputePerSampleSubframeFactors(
   }
 }
 
-void ScaleSamples(rtc::ArrayView<const float> per_sample_scaling_factors,
+void ScaleSamples(const VectorMath& vector_math,
+                  rtc::ArrayView<const float> per_sample_scaling_factors,
                   AudioFrameView<float> signal) {
   const size_t samples_per_channel = signal.samples_per_channel();
   RTC_DCHECK_EQ(samples_per_channel, per_sample_scaling_factors.size());
   for (size_t i = 0; i < signal.num_channels(); ++i) {
-    auto channel = signal.channel(i);
-    for (size_t j = 0; j < samples_per_channel; ++j) {
-      channel[j] = rtc::SafeClamp(channel[j] * per_sample_scaling_factors[j],
-                                  kMinFloatS16Value, kMaxFloatS16Value);
-    }
+    vector_math.MultiplyAndClamp(per_sample_scaling_factors,
+                                 signal.channel(i));
   }
 }
 
@@ -97,7 +94,8 @@ Limiter::Limiter(size_t sample_rate_hz,
                  std::string histogram_name)
     : interp_gain_curve_(apm_data_dumper, histogram_name),
       level_estimator_(sample_rate_hz, apm_data_dumper),
-      apm_data_dumper_(apm_data_dumper) {
+      apm_data_dumper_(apm_data_dumper),
+      vector_math_(GetAvailableCpuFeatures()) {
   CheckLimiterSampleRate(sample_rate_hz);
 }
 
@@ -120,7 +118,7 @@ void Limiter::Process(AudioFrameView<float> signal) {
       &per_sample_scaling_factors_[0], samples_per_channel);
   ComputePerSampleSubframeFactors(scaling_factors_, samples_per_channel,
                                   per_sample_scaling_factors);
-  ScaleSamples(per_sample_scaling_factors, signal);
+  ScaleSamples(vector_math_, per_sample_scaling_factors, signal);
 
   last_scaling_factor_ = scaling_factors_.back();
 
@@ -16,6 +16,7 @@
 
 #include "modules/audio_processing/agc2/fixed_digital_level_estimator.h"
 #include "modules/audio_processing/agc2/interpolated_gain_curve.h"
+#include "modules/audio_processing/agc2/vector_math.h"
 #include "modules/audio_processing/include/audio_frame_view.h"
 #include "rtc_base/constructor_magic.h"
 
@@ -51,6 +52,7 @@ class Limiter {
   const InterpolatedGainCurve interp_gain_curve_;
   FixedDigitalLevelEstimator level_estimator_;
   ApmDataDumper* const apm_data_dumper_ = nullptr;
+  const VectorMath vector_math_;
 
   // Work array containing the sub-frame scaling factors to be interpolated.
   std::array<float, kSubFramesInFrame + 1> scaling_factors_ = {};
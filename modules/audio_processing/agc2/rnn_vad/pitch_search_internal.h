@@ -18,6 +18,7 @@
 #include "api/array_view.h"
 #include "modules/audio_processing/agc2/rnn_vad/common.h"
 #include "modules/audio_processing/agc2/rnn_vad/pitch_info.h"
+#include "modules/audio_processing/agc2/vector_math.h"
 
 namespace webrtc {
 namespace rnn_vad {
@@ -36,6 +37,9 @@ float ComputePitchGainThreshold(int candidate_pitch_period,
                                 int prev_pitch_period,
                                 float prev_pitch_gain);
 
+// The functions below compute the correlations and the energies of the pitch
+// buffer as dot products using |vector_math|.
+
 // Computes the sum of squared samples for every sliding frame in the pitch
 // buffer. |yy_values| indexes are lags.
 //
@@ -46,6 +50,7 @@ float ComputePitchGainThreshold(int candidate_pitch_period,
 // most recent ones. The size of "a" corresponds to the maximum pitch period,
 // that of "b" to the frame size (e.g., 16 ms and 20 ms respectively).
 void ComputeSlidingFrameSquareEnergies(
+    const VectorMath& vector_math,
     rtc::ArrayView<const float, kBufSize24kHz> pitch_buf,
     rtc::ArrayView<float, kMaxPitch24kHz + 1> yy_values);
 
@@ -53,6 +58,7 @@ void ComputeSlidingFrameSquareEnergies(
 // ComputePitchAutoCorrelation() (i.e., using inverted lags), returns the best
 // and the second best pitch periods.
 std::array<size_t, 2> FindBestPitchPeriods(
+    const VectorMath& vector_math,
     rtc::ArrayView<const float> auto_corr,
     rtc::ArrayView<const float> pitch_buf,
     size_t max_pitch_period);
@@ -61,12 +67,14 @@ std::array<size_t, 2> FindBestPitchPeriods(
 // the initial pitch period estimation |inv_lags|. Returns an inverted lag at
 // 48 kHz.
 size_t RefinePitchPeriod48kHz(
+    const VectorMath& vector_math,
     rtc::ArrayView<const float, kBufSize24kHz> pitch_buf,
     rtc::ArrayView<const size_t, 2> inv_lags);
 
 // Refines the pitch period estimation and compute the pitch gain. Returns the
 // refined pitch estimation data at 48 kHz.
 PitchInfo CheckLowerPitchPeriodsAndComputePitchGain(
+    const VectorMath& vector_math,
     rtc::ArrayView<const float, kBufSize24kHz> pitch_buf,
     int initial_pitch_period_48kHz,
     PitchInfo prev_pitch_48kHz);
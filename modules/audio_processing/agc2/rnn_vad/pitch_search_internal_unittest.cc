@@ -13,7 +13,9 @@
 #include <array>
 #include <tuple>
 
+#include "modules/audio_processing/agc2/cpu_features.h"
 #include "modules/audio_processing/agc2/rnn_vad/test_utils.h"
+#include "modules/audio_processing/agc2/vector_math.h"
 // TODO(bugs.webrtc.org/8948): Add when the issue is fixed.
 // #include "test/fpe_observer.h"
 #include "test/gtest.h"
@@ -87,16 +89,21 @@ INSTANTIATE_TEST_SUITE_P(
 // within tolerance given test input data.
 TEST(RnnVadTest, ComputeSlidingFrameSquareEnergiesWithinTolerance) {
   PitchTestData test_data;
-  std::array<float, kNumPitchBufSquareEnergies> computed_output;
-  {
-    // TODO(bugs.webrtc.org/8948): Add when the issue is fixed.
-    // FloatingPointExceptionObserver fpe_observer;
-    ComputeSlidingFrameSquareEnergies(test_data.GetPitchBufView(),
-                                      computed_output);
+  for (const AvailableCpuFeatures& cpu_features : GetCpuFeaturesToTest()) {
+    SCOPED_TRACE(cpu_features.ToString());
+    std::array<float, kNumPitchBufSquareEnergies> computed_output;
+    {
+      // TODO(bugs.webrtc.org/8948): Add when the issue is fixed.
+      // FloatingPointExceptionObserver fpe_observer;
+      ComputeSlidingFrameSquareEnergies(VectorMath(cpu_features),
+                                        test_data.GetPitchBufView(),
+                                        computed_output);
+    }
+    auto square_energies_view = test_data.GetPitchBufSquareEnergiesView();
+    ExpectNearAbsolute(
+        {square_energies_view.data(), square_energies_view.size()},
+        computed_output, 3e-2f);
   }
-  auto square_energies_view = test_data.GetPitchBufSquareEnergiesView();
-  ExpectNearAbsolute({square_energies_view.data(), square_energies_view.size()},
-                     computed_output, 3e-2f);
 }
 
 // Checks that the estimated pitch period is bit-exact given test input data.
@@ -104,31 +111,39 @@ TEST(RnnVadTest, FindBestPitchPeriodsBitExactness) {
   PitchTestData test_data;
   std::array<float, kBufSize12kHz> pitch_buf_decimated;
   Decimate2x(test_data.GetPitchBufView(), pitch_buf_decimated);
-  std::array<size_t, 2> pitch_candidates_inv_lags;
-  {
-    // TODO(bugs.webrtc.org/8948): Add when the issue is fixed.
-    // FloatingPointExceptionObserver fpe_observer;
-    auto auto_corr_view = test_data.GetPitchBufAutoCorrCoeffsView();
-    pitch_candidates_inv_lags =
-        FindBestPitchPeriods({auto_corr_view.data(), auto_corr_view.size()},
-                             pitch_buf_decimated, kMaxPitch12kHz);
+  for (const AvailableCpuFeatures& cpu_features : GetCpuFeaturesToTest()) {
+    SCOPED_TRACE(cpu_features.ToString());
+    std::array<size_t, 2> pitch_candidates_inv_lags;
+    {
+      // TODO(bugs.webrtc.org/8948): Add when the issue is fixed.
+      // FloatingPointExceptionObserver fpe_observer;
+      auto auto_corr_view = test_data.GetPitchBufAutoCorrCoeffsView();
+      pitch_candidates_inv_lags = FindBestPitchPeriods(
+          VectorMath(cpu_features),
+          {auto_corr_view.data(), auto_corr_view.size()}, pitch_buf_decimated,
+          kMaxPitch12kHz);
+    }
+    EXPECT_EQ(pitch_candidates_inv_lags[0], static_cast<size_t>(140));
+    EXPECT_EQ(pitch_candidates_inv_lags[1], static_cast<size_t>(142));
   }
-  EXPECT_EQ(pitch_candidates_inv_lags[0], static_cast<size_t>(140));
-  EXPECT_EQ(pitch_candidates_inv_lags[1], static_cast<size_t>(142));
 }
 
 // Checks that the refined pitch period is bit-exact given test input data.
 TEST(RnnVadTest, RefinePitchPeriod48kHzBitExactness) {
   PitchTestData test_data;
-  size_t pitch_inv_lag;
-  {
-    // TODO(bugs.webrtc.org/8948): Add when the issue is fixed.
-    // FloatingPointExceptionObserver fpe_observer;
-    const std::array<size_t, 2> pitch_candidates_inv_lags = {280, 284};
-    pitch_inv_lag = RefinePitchPeriod48kHz(test_data.GetPitchBufView(),
-                                           pitch_candidates_inv_lags);
+  for (const AvailableCpuFeatures& cpu_features : GetCpuFeaturesToTest()) {
+    SCOPED_TRACE(cpu_features.ToString());
+    size_t pitch_inv_lag;
+    {
+      // TODO(bugs.webrtc.org/8948): Add when the issue is fixed.
+      // FloatingPointExceptionObserver fpe_observer;
+      const std::array<size_t, 2> pitch_candidates_inv_lags = {280, 284};
+      pitch_inv_lag = RefinePitchPeriod48kHz(VectorMath(cpu_features),
+                                             test_data.GetPitchBufView(),
+                                             pitch_candidates_inv_lags);
+    }
+    EXPECT_EQ(560u, pitch_inv_lag);
   }
-  EXPECT_EQ(560u, pitch_inv_lag);
 }
 
 class CheckLowerPitchPeriodsAndComputePitchGainTest
@@ -151,12 +166,13 @@ TEST_P(CheckLowerPitchPeriodsAndComputePitchGainTest,
   const int expected_pitch_period = std::get<3>(params);
   const float expected_pitch_gain = std::get<4>(params);
   PitchTestData test_data;
-  {
+  for (const AvailableCpuFeatures& cpu_features : GetCpuFeaturesToTest()) {
+    SCOPED_TRACE(cpu_features.ToString());
     // TODO(bugs.webrtc.org/8948): Add when the issue is fixed.
     // FloatingPointExceptionObserver fpe_observer;
     const auto computed_output = CheckLowerPitchPeriodsAndComputePitchGain(
-        test_data.GetPitchBufView(), initial_pitch_period,
-        {prev_pitch_period, prev_pitch_gain});
+        VectorMath(cpu_features), test_data.GetPitchBufView(),
+        initial_pitch_period, {prev_pitch_period, prev_pitch_gain});
     EXPECT_EQ(expected_pitch_period, computed_output.period);
     EXPECT_NEAR(expected_pitch_gain, computed_output.gain, 1e-6f);
   }
@@ -11,14 +11,19 @@
 #include "modules/audio_processing/agc2/rnn_vad/pitch_search.h"
 
 #include <algorithm>
+#include <array>
 #include <vector>
 
+#include "modules/audio_processing/agc2/cpu_features.h"
 #include "modules/audio_processing/agc2/rnn_vad/pitch_info.h"
 #include "modules/audio_processing/agc2/rnn_vad/pitch_search_internal.h"
 #include "modules/audio_processing/agc2/rnn_vad/test_utils.h"
+#include "rtc_base/random.h"
+#include "rtc_base/time_utils.h"
 // TODO(bugs.webrtc.org/8948): Add when the issue is fixed.
 // #include "test/fpe_observer.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 namespace rnn_vad {
@@ -49,6 +54,32 @@ TEST(RnnVadTest, PitchSearchWithinTolerance) {
   }
 }
 
+// Measures the time spent by the pitch search per 10 ms frame.
+TEST(RnnVadTest, DISABLED_PitchSearchPerf) {
+  constexpr int kNumFrames = 10000;
+  Random random(42);
+  std::vector<std::array<float, kBufSize24kHz>> pitch_bufs(10);
+  for (auto& pitch_buf : pitch_bufs) {
+    for (float& sample : pitch_buf) {
+      sample = static_cast<float>(random.Gaussian(0.0, 1000.0));
+    }
+  }
+  for (const AvailableCpuFeatures& cpu_features : GetCpuFeaturesToTest()) {
+    PitchEstimator pitch_estimator(cpu_features);
+    int period_sum = 0;
+    const int64_t start_ns = rtc::SystemTimeNanos();
+    for (int i = 0; i < kNumFrames; ++i) {
+      period_sum +=
+          pitch_estimator.Estimate(pitch_bufs[i % pitch_bufs.size()]).period;
+    }
+    const int64_t elapsed_ns = rtc::SystemTimeNanos() - start_ns;
+    EXPECT_GT(period_sum, 0);
+    webrtc::test::PrintResult(
+        "rnn_vad", "_" + cpu_features.ToString(), "pitch_search",
+        static_cast<double>(elapsed_ns) / kNumFrames, "ns", false);
+  }
+}
+
 }  // namespace test
 }  // namespace rnn_vad
 }  // namespace webrtc
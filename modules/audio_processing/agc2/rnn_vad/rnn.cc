@@ -48,23 +48,50 @@ using rnnoise::RectifiedLinearUnit;
 using rnnoise::SigmoidApproximated;
 using rnnoise::TansigApproximated;
 
+namespace {
+
+// Converts the bias terms to float.
+std::vector<float> PreprocessBias(rtc::ArrayView<const int8_t> bias) {
+  return std::vector<float>(bias.begin(), bias.end());
+}
+
+// Converts the weights, stored as a |num_rows| x |num_columns| row-major
+// matrix with one row per input, to float and transposes them, so that the
+// weights of each output are contiguous.
+std::vector<float> PreprocessWeights(rtc::ArrayView<const int8_t> weights,
+                                     size_t num_rows,
+                                     size_t num_columns) {
+  RTC_DCHECK_LE(num_rows * num_columns, weights.size());
+  std::vector<float> transposed(num_rows * num_columns);
+  for (size_t r = 0; r < num_rows; ++r) {
+    for (size_t c = 0; c < num_columns; ++c) {
+      transposed[c * num_rows + r] = weights[r * num_columns + c];
+    }
+  }
+  return transposed;
+}
+
+}  // namespace
+
 FullyConnectedLayer::FullyConnectedLayer(
     const size_t input_size,
     const size_t output_size,
     const rtc::ArrayView<const int8_t> bias,
     const rtc::ArrayView<const int8_t> weights,
-    float (*const activation_function)(float))
+    float (*const activation_function)(float),
+    const AvailableCpuFeatures& cpu_features)
     : input_size_(input_size),
       output_size_(output_size),
-      bias_(bias),
-      weights_(weights),
-      activation_function_(activation_function) {
+      bias_(PreprocessBias(bias)),
+      weights_(PreprocessWeights(weights, input_size, output_size)),
+      activation_function_(activation_function),
+      vector_math_(cpu_features) {
   RTC_DCHECK_LE(output_size_, kFullyConnectedLayersMaxUnits)
       << "Static over-allocation of fully-connected layers output vectors is "
          "not sufficient.";
-  RTC_DCHECK_EQ(output_size_, bias_.size())
+  RTC_DCHECK_EQ(output_size_, bias.size())
       << "Mismatching output size and bias terms array size.";
-  RTC_DCHECK_EQ(input_size_ * output_size_, weights_.size())
+  RTC_DCHECK_EQ(input_size_ * output_size_, weights.size())
       << "Mismatching input-output size and weight coefficients array size.";
 }
 
@@ -75,16 +102,13 @@ rtc::ArrayView<const float> FullyConnectedLayer::GetOutput() const {
 }
 
 void FullyConnectedLayer::ComputeOutput(rtc::ArrayView<const float> input) {
-  // TODO(bugs.chromium.org/9076): Optimize using SSE/AVX fused multiply-add
-  // operations.
+  RTC_DCHECK_EQ(input_size_, input.size());
   for (size_t o = 0; o < output_size_; ++o) {
-    output_[o] = bias_[o];
-    // TODO(bugs.chromium.org/9076): Benchmark how different layouts for
-    // |weights_| change the performance across different platforms.
-    for (size_t i = 0; i < input_size_; ++i) {
-      output_[o] += input[i] * weights_[i * output_size_ + o];
-    }
-    output_[o] = (*activation_function_)(kWeightsScale * output_[o]);
+    const float sum =
+        bias_[o] + vector_math_.DotProduct(
+                       input, rtc::ArrayView<const float>(
+                                  &weights_[o * input_size_], input_size_));
+    output_[o] = (*activation_function_)(kWeightsScale * sum);
   }
 }
 
@@ -94,21 +118,24 @@ GatedRecurrentLayer::GatedRecurrentLayer(
     const rtc::ArrayView<const int8_t> bias,
     const rtc::ArrayView<const int8_t> weights,
     const rtc::ArrayView<const int8_t> recurrent_weights,
-    float (*const activation_function)(float))
+    float (*const activation_function)(float),
+    const AvailableCpuFeatures& cpu_features)
     : input_size_(input_size),
       output_size_(output_size),
-      bias_(bias),
-      weights_(weights),
-      recurrent_weights_(recurrent_weights),
-      activation_function_(activation_function) {
+      bias_(PreprocessBias(bias)),
+      weights_(PreprocessWeights(weights, input_size, 3 * output_size)),
+      recurrent_weights_(
+          PreprocessWeights(recurrent_weights, output_size, 3 * output_size)),
+      activation_function_(activation_function),
+      vector_math_(cpu_features) {
   RTC_DCHECK_LE(output_size_, kRecurrentLayersMaxUnits)
       << "Static over-allocation of recurrent layers state vectors is not "
       << "sufficient.";
-  RTC_DCHECK_EQ(3 * output_size_, bias_.size())
+  RTC_DCHECK_EQ(3 * output_size_, bias.size())
       << "Mismatching output size and bias terms array size.";
-  RTC_DCHECK_EQ(3 * input_size_ * output_size_, weights_.size())
+  RTC_DCHECK_EQ(3 * input_size_ * output_size_, weights.size())
       << "Mismatching input-output size and weight coefficients array size.";
-  RTC_DCHECK_EQ(3 * input_size_ * output_size_, recurrent_weights_.size())
+  RTC_DCHECK_EQ(3 * input_size_ * output_size_, recurrent_weights.size())
       << "Mismatching input-output size and recurrent weight coefficients array"
       << " size.";
   Reset();
@@ -125,56 +152,48 @@ void GatedRecurrentLayer::Reset() {
 }
 
 void GatedRecurrentLayer::ComputeOutput(rtc::ArrayView<const float> input) {
-  // TODO(bugs.chromium.org/9076): Optimize using SSE/AVX fused multiply-add
-  // operations.
-  // Stride and offset used to read parameter arrays.
-  const size_t stride = 3 * output_size_;
-  size_t offset = 0;
+  RTC_DCHECK_EQ(input_size_, input.size());
+  const rtc::ArrayView<const float> state(state_.data(), output_size_);
+  // Returns the bias, input and recurrent contributions for the unit with index
+  // |c| among the 3 * |output_size_| units of the gates.
+  auto weighted_sum = [&](size_t c, rtc::ArrayView<const float> recurrent) {
+    return bias_[c] +
+           vector_math_.DotProduct(
+               input, rtc::ArrayView<const float>(&weights_[c * input_size_],
+                                                  input_size_)) +
+           vector_math_.DotProduct(
+               recurrent,
+               rtc::ArrayView<const float>(
+                   &recurrent_weights_[c * output_size_], output_size_));
+  };
 
   // Compute update gates.
+  size_t offset = 0;
   std::array<float, kRecurrentLayersMaxUnits> update;
   for (size_t o = 0; o < output_size_; ++o) {
-    update[o] = bias_[o];
-    // TODO(bugs.chromium.org/9076): Benchmark how different layouts for
-    // |weights_| and |recurrent_weights_| change the performance across
-    // different platforms.
-    for (size_t i = 0; i < input_size_; ++i) {  // Add input.
-      update[o] += input[i] * weights_[i * stride + o];
-    }
-    for (size_t s = 0; s < output_size_; ++s) {
-      update[o] += state_[s] * recurrent_weights_[s * stride + o];
-    }  // Add state.
-    update[o] = SigmoidApproximated(kWeightsScale * update[o]);
+    update[o] = SigmoidApproximated(kWeightsScale * weighted_sum(o, state));
   }
 
   // Compute reset gates.
   offset += output_size_;
   std::array<float, kRecurrentLayersMaxUnits> reset;
   for (size_t o = 0; o < output_size_; ++o) {
-    reset[o] = bias_[offset + o];
-    for (size_t i = 0; i < input_size_; ++i) {  // Add input.
-      reset[o] += input[i] * weights_[offset + i * stride + o];
-    }
-    for (size_t s = 0; s < output_size_; ++s) {  // Add state.
-      reset[o] += state_[s] * recurrent_weights_[offset + s * stride + o];
-    }
-    reset[o] = SigmoidApproximated(kWeightsScale * reset[o]);
+    reset[o] =
+        SigmoidApproximated(kWeightsScale * weighted_sum(offset + o, state));
   }
 
-  // Compute output.
+  // Compute output. The state is added through the reset gates.
   offset += output_size_;
+  std::array<float, kRecurrentLayersMaxUnits> reset_state;
+  for (size_t s = 0; s < output_size_; ++s) {
+    reset_state[s] = state_[s] * reset[s];
+  }
+  const rtc::ArrayView<const float> reset_state_view(reset_state.data(),
+                                                     output_size_);
   std::array<float, kRecurrentLayersMaxUnits> output;
   for (size_t o = 0; o < output_size_; ++o) {
-    output[o] = bias_[offset + o];
-    for (size_t i = 0; i < input_size_; ++i) {  // Add input.
-      output[o] += input[i] * weights_[offset + i * stride + o];
-    }
-    for (size_t s = 0; s < output_size_;
-         ++s) {  // Add state through reset gates.
-      output[o] +=
-          state_[s] * recurrent_weights_[offset + s * stride + o] * reset[s];
-    }
-    output[o] = (*activation_function_)(kWeightsScale * output[o]);
+    output[o] = (*activation_function_)(
+        kWeightsScale * weighted_sum(offset + o, reset_state_view));
     // Update output through the update gates.
     output[o] = update[o] * state_[o] + (1.f - update[o]) * output[o];
   }
@@ -184,23 +203,28 @@ void GatedRecurrentLayer::ComputeOutput(rtc::ArrayView<const float> input) {
   std::copy(output.begin(), output.end(), state_.begin());
 }
 
-RnnBasedVad::RnnBasedVad()
+RnnBasedVad::RnnBasedVad() : RnnBasedVad(GetAvailableCpuFeatures()) {}
+
+RnnBasedVad::RnnBasedVad(const AvailableCpuFeatures& cpu_features)
     : input_layer_(kInputLayerInputSize,
                    kInputLayerOutputSize,
                    kInputDenseBias,
                    kInputDenseWeights,
-                   TansigApproximated),
+                   TansigApproximated,
+                   cpu_features),
       hidden_layer_(kInputLayerOutputSize,
                     kHiddenLayerOutputSize,
                     kHiddenGruBias,
                     kHiddenGruWeights,
                     kHiddenGruRecurrentWeights,
-                    RectifiedLinearUnit),
+                    RectifiedLinearUnit,
+                    cpu_features),
       output_layer_(kHiddenLayerOutputSize,
                     kOutputLayerOutputSize,
                     kOutputDenseBias,
                     kOutputDenseWeights,
-                    SigmoidApproximated) {
+                    SigmoidApproximated,
+                    cpu_features) {
   // Input-output chaining size checks.
   RTC_DCHECK_EQ(input_layer_.output_size(), hidden_layer_.input_size())
       << "The input and the hidden layers sizes do not match.";
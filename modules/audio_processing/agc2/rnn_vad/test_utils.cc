@@ -46,6 +46,18 @@ void ExpectNearAbsolute(rtc::ArrayView<const float> expected,
   }
 }
 
+std::vector<AvailableCpuFeatures> GetCpuFeaturesToTest() {
+  const AvailableCpuFeatures available = GetAvailableCpuFeatures();
+  std::vector<AvailableCpuFeatures> cpu_features = {NoAvailableCpuFeatures()};
+  if (available.sse2)
+    cpu_features.push_back({/*sse2=*/true, /*avx2=*/false, /*neon=*/false});
+  if (available.avx2)
+    cpu_features.push_back({/*sse2=*/true, /*avx2=*/true, /*neon=*/false});
+  if (available.neon)
+    cpu_features.push_back({/*sse2=*/false, /*avx2=*/false, /*neon=*/true});
+  return cpu_features;
+}
+
 std::pair<std::unique_ptr<BinaryFileReader<int16_t, float>>, const size_t>
 CreatePcmSamplesReader(const size_t frame_length) {
   auto ptr = absl::make_unique<BinaryFileReader<int16_t, float>>(
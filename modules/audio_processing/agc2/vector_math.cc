@@ -0,0 +1,413 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_processing/agc2/vector_math.h"
+
+// Defines WEBRTC_ARCH_X86_FAMILY, used below.
+#include "rtc_base/system/arch.h"
+
+#if defined(WEBRTC_HAS_NEON)
+#include <arm_neon.h>
+#endif
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+#include <emmintrin.h>
+
+#include "modules/audio_processing/agc2/vector_math_avx2.h"
+#endif
+
+#include <algorithm>
+#include <cmath>
+
+#include "common_audio/include/audio_util.h"
+#include "modules/audio_processing/agc2/agc2_common.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/numerics/safe_minmax.h"
+
+namespace webrtc {
+namespace {
+
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+// Clamps to the int16 range and rounds away from zero like FloatS16ToS16().
+__m128i RoundToS16(__m128 x) {
+  x = _mm_min_ps(_mm_max_ps(x, _mm_set1_ps(-32768.f)), _mm_set1_ps(32767.f));
+  // Adds +/-0.5 and truncates.
+  const __m128 half =
+      _mm_or_ps(_mm_and_ps(x, _mm_set1_ps(-0.f)), _mm_set1_ps(0.5f));
+  return _mm_cvttps_epi32(_mm_add_ps(x, half));
+}
+#elif defined(WEBRTC_HAS_NEON)
+// Clamps to the int16 range and rounds away from zero like FloatS16ToS16().
+int16x4_t RoundToS16(float32x4_t x) {
+  x = vminq_f32(vmaxq_f32(x, vdupq_n_f32(-32768.f)), vdupq_n_f32(32767.f));
+  // Adds +/-0.5 and truncates.
+  const uint32x4_t half =
+      vorrq_u32(vandq_u32(vreinterpretq_u32_f32(x), vdupq_n_u32(0x80000000)),
+                vreinterpretq_u32_f32(vdupq_n_f32(0.5f)));
+  return vqmovn_s32(vcvtq_s32_f32(vaddq_f32(x, vreinterpretq_f32_u32(half))));
+}
+#endif
+
+}  // namespace
+
+void VectorMath::AccumulateS16(rtc::ArrayView<const int16_t> x,
+                               rtc::ArrayView<float> accumulator) const {
+  RTC_DCHECK_EQ(x.size(), accumulator.size());
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (cpu_features_.avx2) {
+    AccumulateS16Avx2(x, accumulator);
+    return;
+  }
+  if (cpu_features_.sse2) {
+    for (; i + 8 <= x.size(); i += 8) {
+      const __m128i samples =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i]));
+      // Sign extends by shifting the samples from the upper halves.
+      const __m128 low = _mm_cvtepi32_ps(
+          _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16));
+      const __m128 high = _mm_cvtepi32_ps(
+          _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16));
+      _mm_storeu_ps(&accumulator[i],
+                    _mm_add_ps(_mm_loadu_ps(&accumulator[i]), low));
+      _mm_storeu_ps(&accumulator[i + 4],
+                    _mm_add_ps(_mm_loadu_ps(&accumulator[i + 4]), high));
+    }
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  if (cpu_features_.neon) {
+    for (; i + 8 <= x.size(); i += 8) {
+      const int16x8_t samples = vld1q_s16(&x[i]);
+      const float32x4_t low =
+          vcvtq_f32_s32(vmovl_s16(vget_low_s16(samples)));
+      const float32x4_t high =
+          vcvtq_f32_s32(vmovl_s16(vget_high_s16(samples)));
+      vst1q_f32(&accumulator[i], vaddq_f32(vld1q_f32(&accumulator[i]), low));
+      vst1q_f32(&accumulator[i + 4],
+                vaddq_f32(vld1q_f32(&accumulator[i + 4]), high));
+    }
+  }
+#endif
+  for (; i < x.size(); ++i) {
+    accumulator[i] += x[i];
+  }
+}
+
+void VectorMath::AccumulateStereoS16(rtc::ArrayView<const int16_t> x,
+                                     rtc::ArrayView<float> left,
+                                     rtc::ArrayView<float> right) const {
+  RTC_DCHECK_EQ(x.size(), 2 * left.size());
+  RTC_DCHECK_EQ(left.size(), right.size());
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (cpu_features_.avx2) {
+    AccumulateStereoS16Avx2(x, left, right);
+    return;
+  }
+  if (cpu_features_.sse2) {
+    for (; i + 4 <= left.size(); i += 4) {
+      const __m128i samples =
+          _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[2 * i]));
+      const __m128 low = _mm_cvtepi32_ps(
+          _mm_srai_epi32(_mm_unpacklo_epi16(samples, samples), 16));
+      const __m128 high = _mm_cvtepi32_ps(
+          _mm_srai_epi32(_mm_unpackhi_epi16(samples, samples), 16));
+      // Deinterleaves L0 R0 L1 R1 and L2 R2 L3 R3.
+      const __m128 left_samples =
+          _mm_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0));
+      const __m128 right_samples =
+          _mm_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1));
+      _mm_storeu_ps(&left[i], _mm_add_ps(_mm_loadu_ps(&left[i]), left_samples));
+      _mm_storeu_ps(&right[i],
+                    _mm_add_ps(_mm_loadu_ps(&right[i]), right_samples));
+    }
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  if (cpu_features_.neon) {
+    for (; i + 4 <= left.size(); i += 4) {
+      const int16x4x2_t samples = vld2_s16(&x[2 * i]);
+      vst1q_f32(&left[i],
+                vaddq_f32(vld1q_f32(&left[i]),
+                          vcvtq_f32_s32(vmovl_s16(samples.val[0]))));
+      vst1q_f32(&right[i],
+                vaddq_f32(vld1q_f32(&right[i]),
+                          vcvtq_f32_s32(vmovl_s16(samples.val[1]))));
+    }
+  }
+#endif
+  for (; i < left.size(); ++i) {
+    left[i] += x[2 * i];
+    right[i] += x[2 * i + 1];
+  }
+}
+
+float VectorMath::MaxAbs(rtc::ArrayView<const float> x) const {
+  size_t i = 0;
+  float max_abs = 0.f;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (cpu_features_.avx2) {
+    return MaxAbsAvx2(x);
+  }
+  if (cpu_features_.sse2 && x.size() >= 4) {
+    const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7FFFFFFF));
+    __m128 max = _mm_setzero_ps();
+    for (; i + 4 <= x.size(); i += 4) {
+      max = _mm_max_ps(max, _mm_and_ps(_mm_loadu_ps(&x[i]), abs_mask));
+    }
+    max = _mm_max_ps(max, _mm_movehl_ps(max, max));
+    max = _mm_max_ss(max, _mm_shuffle_ps(max, max, _MM_SHUFFLE(1, 1, 1, 1)));
+    _mm_store_ss(&max_abs, max);
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  if (cpu_features_.neon && x.size() >= 4) {
+    float32x4_t max = vdupq_n_f32(0.f);
+    for (; i + 4 <= x.size(); i += 4) {
+      max = vmaxq_f32(max, vabsq_f32(vld1q_f32(&x[i])));
+    }
+    float32x2_t max_pair = vmax_f32(vget_low_f32(max), vget_high_f32(max));
+    max_pair = vpmax_f32(max_pair, max_pair);
+    max_abs = vget_lane_f32(max_pair, 0);
+  }
+#endif
+  for (; i < x.size(); ++i) {
+    max_abs = std::max(max_abs, std::abs(x[i]));
+  }
+  return max_abs;
+}
+
+void VectorMath::Scale(float gain, rtc::ArrayView<float> x) const {
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (cpu_features_.avx2) {
+    ScaleAvx2(gain, x);
+    return;
+  }
+  if (cpu_features_.sse2) {
+    const __m128 gains = _mm_set1_ps(gain);
+    for (; i + 4 <= x.size(); i += 4) {
+      _mm_storeu_ps(&x[i], _mm_mul_ps(_mm_loadu_ps(&x[i]), gains));
+    }
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  if (cpu_features_.neon) {
+    for (; i + 4 <= x.size(); i += 4) {
+      vst1q_f32(&x[i], vmulq_n_f32(vld1q_f32(&x[i]), gain));
+    }
+  }
+#endif
+  for (; i < x.size(); ++i) {
+    x[i] *= gain;
+  }
+}
+
+void VectorMath::ScaleWithRamp(float gain,
+                               float increment,
+                               rtc::ArrayView<float> x) const {
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (cpu_features_.avx2) {
+    ScaleWithRampAvx2(gain, increment, x);
+    return;
+  }
+  if (cpu_features_.sse2 && x.size() >= 4) {
+    __m128 gains = _mm_add_ps(
+        _mm_set1_ps(gain),
+        _mm_mul_ps(_mm_set1_ps(increment), _mm_setr_ps(0.f, 1.f, 2.f, 3.f)));
+    const __m128 increments = _mm_set1_ps(4.f * increment);
+    for (; i + 4 <= x.size(); i += 4) {
+      _mm_storeu_ps(&x[i], _mm_mul_ps(_mm_loadu_ps(&x[i]), gains));
+      gains = _mm_add_ps(gains, increments);
+    }
+    gain += i * increment;
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  if (cpu_features_.neon && x.size() >= 4) {
+    const float kSteps[] = {0.f, 1.f, 2.f, 3.f};
+    float32x4_t gains =
+        vmlaq_n_f32(vdupq_n_f32(gain), vld1q_f32(kSteps), increment);
+    const float32x4_t increments = vdupq_n_f32(4.f * increment);
+    for (; i + 4 <= x.size(); i += 4) {
+      vst1q_f32(&x[i], vmulq_f32(vld1q_f32(&x[i]), gains));
+      gains = vaddq_f32(gains, increments);
+    }
+    gain += i * increment;
+  }
+#endif
+  for (; i < x.size(); ++i) {
+    x[i] *= gain;
+    gain += increment;
+  }
+}
+
+void VectorMath::MultiplyAndClamp(rtc::ArrayView<const float> gains,
+                                  rtc::ArrayView<float> x) const {
+  RTC_DCHECK_EQ(gains.size(), x.size());
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (cpu_features_.avx2) {
+    MultiplyAndClampAvx2(gains, x);
+    return;
+  }
+  if (cpu_features_.sse2) {
+    const __m128 min = _mm_set1_ps(kMinFloatS16Value);
+    const __m128 max = _mm_set1_ps(kMaxFloatS16Value);
+    for (; i + 4 <= x.size(); i += 4) {
+      const __m128 product =
+          _mm_mul_ps(_mm_loadu_ps(&x[i]), _mm_loadu_ps(&gains[i]));
+      _mm_storeu_ps(&x[i], _mm_min_ps(_mm_max_ps(product, min), max));
+    }
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  if (cpu_features_.neon) {
+    const float32x4_t min = vdupq_n_f32(kMinFloatS16Value);
+    const float32x4_t max = vdupq_n_f32(kMaxFloatS16Value);
+    for (; i + 4 <= x.size(); i += 4) {
+      const float32x4_t product =
+          vmulq_f32(vld1q_f32(&x[i]), vld1q_f32(&gains[i]));
+      vst1q_f32(&x[i], vminq_f32(vmaxq_f32(product, min), max));
+    }
+  }
+#endif
+  for (; i < x.size(); ++i) {
+    x[i] = rtc::SafeClamp(x[i] * gains[i], kMinFloatS16Value,
+                          kMaxFloatS16Value);
+  }
+}
+
+void VectorMath::Clamp(rtc::ArrayView<float> x) const {
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (cpu_features_.avx2) {
+    ClampAvx2(x);
+    return;
+  }
+  if (cpu_features_.sse2) {
+    const __m128 min = _mm_set1_ps(kMinFloatS16Value);
+    const __m128 max = _mm_set1_ps(kMaxFloatS16Value);
+    for (; i + 4 <= x.size(); i += 4) {
+      _mm_storeu_ps(&x[i], _mm_min_ps(_mm_max_ps(_mm_loadu_ps(&x[i]), min),
+                                      max));
+    }
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  if (cpu_features_.neon) {
+    const float32x4_t min = vdupq_n_f32(kMinFloatS16Value);
+    const float32x4_t max = vdupq_n_f32(kMaxFloatS16Value);
+    for (; i + 4 <= x.size(); i += 4) {
+      vst1q_f32(&x[i], vminq_f32(vmaxq_f32(vld1q_f32(&x[i]), min), max));
+    }
+  }
+#endif
+  for (; i < x.size(); ++i) {
+    x[i] = rtc::SafeClamp(x[i], kMinFloatS16Value, kMaxFloatS16Value);
+  }
+}
+
+void VectorMath::ToS16(rtc::ArrayView<const float> x,
+                       rtc::ArrayView<int16_t> y) const {
+  RTC_DCHECK_EQ(x.size(), y.size());
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (cpu_features_.avx2) {
+    ToS16Avx2(x, y);
+    return;
+  }
+  if (cpu_features_.sse2) {
+    for (; i + 8 <= x.size(); i += 8) {
+      _mm_storeu_si128(reinterpret_cast<__m128i*>(&y[i]),
+                       _mm_packs_epi32(RoundToS16(_mm_loadu_ps(&x[i])),
+                                       RoundToS16(_mm_loadu_ps(&x[i + 4]))));
+    }
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  if (cpu_features_.neon) {
+    for (; i + 4 <= x.size(); i += 4) {
+      vst1_s16(&y[i], RoundToS16(vld1q_f32(&x[i])));
+    }
+  }
+#endif
+  for (; i < x.size(); ++i) {
+    y[i] = FloatS16ToS16(x[i]);
+  }
+}
+
+void VectorMath::ToStereoS16(rtc::ArrayView<const float> left,
+                             rtc::ArrayView<const float> right,
+                             rtc::ArrayView<int16_t> y) const {
+  RTC_DCHECK_EQ(left.size(), right.size());
+  RTC_DCHECK_EQ(2 * left.size(), y.size());
+  size_t i = 0;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (cpu_features_.avx2) {
+    ToStereoS16Avx2(left, right, y);
+    return;
+  }
+  if (cpu_features_.sse2) {
+    for (; i + 4 <= left.size(); i += 4) {
+      const __m128i left_samples = RoundToS16(_mm_loadu_ps(&left[i]));
+      const __m128i right_samples = RoundToS16(_mm_loadu_ps(&right[i]));
+      _mm_storeu_si128(
+          reinterpret_cast<__m128i*>(&y[2 * i]),
+          _mm_packs_epi32(_mm_unpacklo_epi32(left_samples, right_samples),
+                          _mm_unpackhi_epi32(left_samples, right_samples)));
+    }
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  if (cpu_features_.neon) {
+    for (; i + 4 <= left.size(); i += 4) {
+      int16x4x2_t samples;
+      samples.val[0] = RoundToS16(vld1q_f32(&left[i]));
+      samples.val[1] = RoundToS16(vld1q_f32(&right[i]));
+      vst2_s16(&y[2 * i], samples);
+    }
+  }
+#endif
+  for (; i < left.size(); ++i) {
+    y[2 * i] = FloatS16ToS16(left[i]);
+    y[2 * i + 1] = FloatS16ToS16(right[i]);
+  }
+}
+
+float VectorMath::DotProduct(rtc::ArrayView<const float> x,
+                             rtc::ArrayView<const float> y) const {
+  RTC_DCHECK_EQ(x.size(), y.size());
+  size_t i = 0;
+  float dot_product = 0.f;
+#if defined(WEBRTC_ARCH_X86_FAMILY)
+  if (cpu_features_.avx2) {
+    return DotProductAvx2(x, y);
+  }
+  if (cpu_features_.sse2) {
+    __m128 sum = _mm_setzero_ps();
+    for (; i + 4 <= x.size(); i += 4) {
+      sum = _mm_add_ps(sum,
+                       _mm_mul_ps(_mm_loadu_ps(&x[i]), _mm_loadu_ps(&y[i])));
+    }
+    sum = _mm_add_ps(sum, _mm_movehl_ps(sum, sum));
+    sum = _mm_add_ss(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 1, 1, 1)));
+    _mm_store_ss(&dot_product, sum);
+  }
+#elif defined(WEBRTC_HAS_NEON)
+  if (cpu_features_.neon) {
+    float32x4_t sum = vdupq_n_f32(0.f);
+    for (; i + 4 <= x.size(); i += 4) {
+      sum = vmlaq_f32(sum, vld1q_f32(&x[i]), vld1q_f32(&y[i]));
+    }
+    float32x2_t sum_pair = vadd_f32(vget_low_f32(sum), vget_high_f32(sum));
+    sum_pair = vpadd_f32(sum_pair, sum_pair);
+    dot_product = vget_lane_f32(sum_pair, 0);
+  }
+#endif
+  for (; i < x.size(); ++i) {
+    dot_product += x[i] * y[i];
+  }
+  return dot_product;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,79 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_PROCESSING_AGC2_VECTOR_MATH_H_
+#define MODULES_AUDIO_PROCESSING_AGC2_VECTOR_MATH_H_
+
+#include <stdint.h>
+
+#include "api/array_view.h"
+#include "modules/audio_processing/agc2/cpu_features.h"
+
+namespace webrtc {
+
+// Provides optimizations for the operations on FloatS16 signals done by the
+// limiter, the gain applier and the audio mixer, and for the dot products of
+// the RNN VAD. Except for ScaleWithRamp() and DotProduct(), the optimized
+// versions give the same results as the plain C++ versions.
+class VectorMath {
+ public:
+  explicit VectorMath(AvailableCpuFeatures cpu_features)
+      : cpu_features_(cpu_features) {}
+
+  // Adds the int16 samples in |x| to |accumulator|.
+  void AccumulateS16(rtc::ArrayView<const int16_t> x,
+                     rtc::ArrayView<float> accumulator) const;
+
+  // Adds the interleaved stereo int16 samples in |x| to |left| and |right|.
+  void AccumulateStereoS16(rtc::ArrayView<const int16_t> x,
+                           rtc::ArrayView<float> left,
+                           rtc::ArrayView<float> right) const;
+
+  // Returns the maximum absolute value in |x|, or 0 if |x| is empty.
+  float MaxAbs(rtc::ArrayView<const float> x) const;
+
+  // Multiplies |x| by |gain|.
+  void Scale(float gain, rtc::ArrayView<float> x) const;
+
+  // Multiplies |x| by a gain that starts at |gain| and changes by |increment|
+  // from one sample to the next. The optimized versions compute the gains
+  // with a different rounding than the plain C++ version.
+  void ScaleWithRamp(float gain,
+                     float increment,
+                     rtc::ArrayView<float> x) const;
+
+  // Multiplies |x| by |gains| sample by sample and clamps the result to the
+  // FloatS16 range.
+  void MultiplyAndClamp(rtc::ArrayView<const float> gains,
+                        rtc::ArrayView<float> x) const;
+
+  // Clamps |x| to the FloatS16 range.
+  void Clamp(rtc::ArrayView<float> x) const;
+
+  // Rounds |x| to int16 samples in |y| like FloatS16ToS16().
+  void ToS16(rtc::ArrayView<const float> x, rtc::ArrayView<int16_t> y) const;
+
+  // Rounds |left| and |right| like ToS16() and interleaves them in |y|.
+  void ToStereoS16(rtc::ArrayView<const float> left,
+                   rtc::ArrayView<const float> right,
+                   rtc::ArrayView<int16_t> y) const;
+
+  // Returns the dot product of |x| and |y|. The optimized versions sum the
+  // products in a different order than the plain C++ version.
+  float DotProduct(rtc::ArrayView<const float> x,
+                   rtc::ArrayView<const float> y) const;
+
+ private:
+  const AvailableCpuFeatures cpu_features_;
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_PROCESSING_AGC2_VECTOR_MATH_H_
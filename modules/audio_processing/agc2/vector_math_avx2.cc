@@ -0,0 +1,227 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_processing/agc2/vector_math_avx2.h"
+
+#include <immintrin.h>
+
+#include <algorithm>
+#include <cmath>
+
+#include "common_audio/include/audio_util.h"
+#include "modules/audio_processing/agc2/agc2_common.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/numerics/safe_minmax.h"
+
+namespace webrtc {
+namespace {
+
+// Clamps to the int16 range and rounds away from zero like FloatS16ToS16().
+__m256i RoundToS16(__m256 x) {
+  x = _mm256_min_ps(_mm256_max_ps(x, _mm256_set1_ps(-32768.f)),
+                    _mm256_set1_ps(32767.f));
+  // Adds +/-0.5 and truncates.
+  const __m256 half = _mm256_or_ps(_mm256_and_ps(x, _mm256_set1_ps(-0.f)),
+                                   _mm256_set1_ps(0.5f));
+  return _mm256_cvttps_epi32(_mm256_add_ps(x, half));
+}
+
+}  // namespace
+
+void AccumulateS16Avx2(rtc::ArrayView<const int16_t> x,
+                       rtc::ArrayView<float> accumulator) {
+  RTC_DCHECK_EQ(x.size(), accumulator.size());
+  size_t i = 0;
+  for (; i + 8 <= x.size(); i += 8) {
+    const __m256 samples = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[i]))));
+    _mm256_storeu_ps(&accumulator[i],
+                     _mm256_add_ps(_mm256_loadu_ps(&accumulator[i]), samples));
+  }
+  for (; i < x.size(); ++i) {
+    accumulator[i] += x[i];
+  }
+}
+
+void AccumulateStereoS16Avx2(rtc::ArrayView<const int16_t> x,
+                             rtc::ArrayView<float> left,
+                             rtc::ArrayView<float> right) {
+  RTC_DCHECK_EQ(x.size(), 2 * left.size());
+  RTC_DCHECK_EQ(left.size(), right.size());
+  size_t i = 0;
+  for (; i + 8 <= left.size(); i += 8) {
+    const __m256 low = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[2 * i]))));
+    const __m256 high = _mm256_cvtepi32_ps(_mm256_cvtepi16_epi32(
+        _mm_loadu_si128(reinterpret_cast<const __m128i*>(&x[2 * i + 8]))));
+    // The shuffles work within 128 bit lanes, which gives L0 L1 L4 L5 and
+    // L2 L3 L6 L7. The permutation puts the pairs of samples in order.
+    const __m256 left_samples = _mm256_castpd_ps(_mm256_permute4x64_pd(
+        _mm256_castps_pd(_mm256_shuffle_ps(low, high, _MM_SHUFFLE(2, 0, 2, 0))),
+        _MM_SHUFFLE(3, 1, 2, 0)));
+    const __m256 right_samples = _mm256_castpd_ps(_mm256_permute4x64_pd(
+        _mm256_castps_pd(_mm256_shuffle_ps(low, high, _MM_SHUFFLE(3, 1, 3, 1))),
+        _MM_SHUFFLE(3, 1, 2, 0)));
+    _mm256_storeu_ps(&left[i],
+                     _mm256_add_ps(_mm256_loadu_ps(&left[i]), left_samples));
+    _mm256_storeu_ps(&right[i],
+                     _mm256_add_ps(_mm256_loadu_ps(&right[i]), right_samples));
+  }
+  for (; i < left.size(); ++i) {
+    left[i] += x[2 * i];
+    right[i] += x[2 * i + 1];
+  }
+}
+
+float MaxAbsAvx2(rtc::ArrayView<const float> x) {
+  size_t i = 0;
+  float max_abs = 0.f;
+  if (x.size() >= 8) {
+    const __m256 abs_mask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+    __m256 max = _mm256_setzero_ps();
+    for (; i + 8 <= x.size(); i += 8) {
+      max = _mm256_max_ps(max, _mm256_and_ps(_mm256_loadu_ps(&x[i]), abs_mask));
+    }
+    __m128 max_128 =
+        _mm_max_ps(_mm256_castps256_ps128(max), _mm256_extractf128_ps(max, 1));
+    max_128 = _mm_max_ps(max_128, _mm_movehl_ps(max_128, max_128));
+    max_128 = _mm_max_ss(max_128, _mm_shuffle_ps(max_128, max_128,
+                                                 _MM_SHUFFLE(1, 1, 1, 1)));
+    _mm_store_ss(&max_abs, max_128);
+  }
+  for (; i < x.size(); ++i) {
+    max_abs = std::max(max_abs, std::abs(x[i]));
+  }
+  return max_abs;
+}
+
+void ScaleAvx2(float gain, rtc::ArrayView<float> x) {
+  size_t i = 0;
+  const __m256 gains = _mm256_set1_ps(gain);
+  for (; i + 8 <= x.size(); i += 8) {
+    _mm256_storeu_ps(&x[i], _mm256_mul_ps(_mm256_loadu_ps(&x[i]), gains));
+  }
+  for (; i < x.size(); ++i) {
+    x[i] *= gain;
+  }
+}
+
+void ScaleWithRampAvx2(float gain, float increment, rtc::ArrayView<float> x) {
+  size_t i = 0;
+  if (x.size() >= 8) {
+    __m256 gains = _mm256_add_ps(
+        _mm256_set1_ps(gain),
+        _mm256_mul_ps(_mm256_set1_ps(increment),
+                      _mm256_setr_ps(0.f, 1.f, 2.f, 3.f, 4.f, 5.f, 6.f, 7.f)));
+    const __m256 increments = _mm256_set1_ps(8.f * increment);
+    for (; i + 8 <= x.size(); i += 8) {
+      _mm256_storeu_ps(&x[i], _mm256_mul_ps(_mm256_loadu_ps(&x[i]), gains));
+      gains = _mm256_add_ps(gains, increments);
+    }
+    gain += i * increment;
+  }
+  for (; i < x.size(); ++i) {
+    x[i] *= gain;
+    gain += increment;
+  }
+}
+
+void MultiplyAndClampAvx2(rtc::ArrayView<const float> gains,
+                          rtc::ArrayView<float> x) {
+  RTC_DCHECK_EQ(gains.size(), x.size());
+  size_t i = 0;
+  const __m256 min = _mm256_set1_ps(kMinFloatS16Value);
+  const __m256 max = _mm256_set1_ps(kMaxFloatS16Value);
+  for (; i + 8 <= x.size(); i += 8) {
+    const __m256 product =
+        _mm256_mul_ps(_mm256_loadu_ps(&x[i]), _mm256_loadu_ps(&gains[i]));
+    _mm256_storeu_ps(&x[i], _mm256_min_ps(_mm256_max_ps(product, min), max));
+  }
+  for (; i < x.size(); ++i) {
+    x[i] = rtc::SafeClamp(x[i] * gains[i], kMinFloatS16Value,
+                          kMaxFloatS16Value);
+  }
+}
+
+void ClampAvx2(rtc::ArrayView<float> x) {
+  size_t i = 0;
+  const __m256 min = _mm256_set1_ps(kMinFloatS16Value);
+  const __m256 max = _mm256_set1_ps(kMaxFloatS16Value);
+  for (; i + 8 <= x.size(); i += 8) {
+    _mm256_storeu_ps(
+        &x[i], _mm256_min_ps(_mm256_max_ps(_mm256_loadu_ps(&x[i]), min), max));
+  }
+  for (; i < x.size(); ++i) {
+    x[i] = rtc::SafeClamp(x[i], kMinFloatS16Value, kMaxFloatS16Value);
+  }
+}
+
+void ToS16Avx2(rtc::ArrayView<const float> x, rtc::ArrayView<int16_t> y) {
+  RTC_DCHECK_EQ(x.size(), y.size());
+  size_t i = 0;
+  for (; i + 16 <= x.size(); i += 16) {
+    // The packing works within 128 bit lanes, the permutation puts the
+    // samples in order.
+    const __m256i packed =
+        _mm256_packs_epi32(RoundToS16(_mm256_loadu_ps(&x[i])),
+                           RoundToS16(_mm256_loadu_ps(&x[i + 8])));
+    _mm256_storeu_si256(
+        reinterpret_cast<__m256i*>(&y[i]),
+        _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+  }
+  for (; i < x.size(); ++i) {
+    y[i] = FloatS16ToS16(x[i]);
+  }
+}
+
+void ToStereoS16Avx2(rtc::ArrayView<const float> left,
+                     rtc::ArrayView<const float> right,
+                     rtc::ArrayView<int16_t> y) {
+  RTC_DCHECK_EQ(left.size(), right.size());
+  RTC_DCHECK_EQ(2 * left.size(), y.size());
+  size_t i = 0;
+  for (; i + 8 <= left.size(); i += 8) {
+    const __m256i left_samples = RoundToS16(_mm256_loadu_ps(&left[i]));
+    const __m256i right_samples = RoundToS16(_mm256_loadu_ps(&right[i]));
+    // Within each 128 bit lane, the unpacking gives L0 R0 L1 R1 and
+    // L2 R2 L3 R3, which the packing puts in order.
+    const __m256i interleaved =
+        _mm256_packs_epi32(_mm256_unpacklo_epi32(left_samples, right_samples),
+                           _mm256_unpackhi_epi32(left_samples, right_samples));
+    _mm256_storeu_si256(reinterpret_cast<__m256i*>(&y[2 * i]), interleaved);
+  }
+  for (; i < left.size(); ++i) {
+    y[2 * i] = FloatS16ToS16(left[i]);
+    y[2 * i + 1] = FloatS16ToS16(right[i]);
+  }
+}
+
+float DotProductAvx2(rtc::ArrayView<const float> x,
+                     rtc::ArrayView<const float> y) {
+  RTC_DCHECK_EQ(x.size(), y.size());
+  size_t i = 0;
+  __m256 sum = _mm256_setzero_ps();
+  for (; i + 8 <= x.size(); i += 8) {
+    sum = _mm256_add_ps(
+        sum, _mm256_mul_ps(_mm256_loadu_ps(&x[i]), _mm256_loadu_ps(&y[i])));
+  }
+  __m128 sum_128 =
+      _mm_add_ps(_mm256_castps256_ps128(sum), _mm256_extractf128_ps(sum, 1));
+  sum_128 = _mm_add_ps(sum_128, _mm_movehl_ps(sum_128, sum_128));
+  sum_128 = _mm_add_ss(
+      sum_128, _mm_shuffle_ps(sum_128, sum_128, _MM_SHUFFLE(1, 1, 1, 1)));
+  float dot_product = _mm_cvtss_f32(sum_128);
+  for (; i < x.size(); ++i) {
+    dot_product += x[i] * y[i];
+  }
+  return dot_product;
+}
+
+}  // namespace webrtc
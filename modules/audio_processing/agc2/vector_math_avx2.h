@@ -0,0 +1,42 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_PROCESSING_AGC2_VECTOR_MATH_AVX2_H_
+#define MODULES_AUDIO_PROCESSING_AGC2_VECTOR_MATH_AVX2_H_
+
+#include <stdint.h>
+
+#include "api/array_view.h"
+
+namespace webrtc {
+
+// AVX2 versions of the VectorMath operations. They must only be called if the
+// CPU supports AVX2.
+void AccumulateS16Avx2(rtc::ArrayView<const int16_t> x,
+                       rtc::ArrayView<float> accumulator);
+void AccumulateStereoS16Avx2(rtc::ArrayView<const int16_t> x,
+                             rtc::ArrayView<float> left,
+                             rtc::ArrayView<float> right);
+float MaxAbsAvx2(rtc::ArrayView<const float> x);
+void ScaleAvx2(float gain, rtc::ArrayView<float> x);
+void ScaleWithRampAvx2(float gain, float increment, rtc::ArrayView<float> x);
+void MultiplyAndClampAvx2(rtc::ArrayView<const float> gains,
+                          rtc::ArrayView<float> x);
+void ClampAvx2(rtc::ArrayView<float> x);
+void ToS16Avx2(rtc::ArrayView<const float> x, rtc::ArrayView<int16_t> y);
+void ToStereoS16Avx2(rtc::ArrayView<const float> left,
+                     rtc::ArrayView<const float> right,
+                     rtc::ArrayView<int16_t> y);
+float DotProductAvx2(rtc::ArrayView<const float> x,
+                     rtc::ArrayView<const float> y);
+
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_PROCESSING_AGC2_VECTOR_MATH_AVX2_H_
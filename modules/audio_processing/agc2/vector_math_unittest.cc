@@ -0,0 +1,273 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_processing/agc2/vector_math.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+#include "common_audio/include/audio_util.h"
+#include "modules/audio_processing/agc2/cpu_features.h"
+#include "rtc_base/gunit.h"
+#include "rtc_base/random.h"
+#include "rtc_base/time_utils.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+// Sizes covering the vectorized loops and their tails.
+constexpr size_t kSizes[] = {1, 3, 4, 7, 8, 15, 16, 17, 31, 160, 441, 480};
+
+// Returns the optimizations available on the current platform.
+std::vector<AvailableCpuFeatures> GetOptimizationsToTest() {
+  const AvailableCpuFeatures available = GetAvailableCpuFeatures();
+  std::vector<AvailableCpuFeatures> optimizations;
+  if (available.sse2)
+    optimizations.push_back({/*sse2=*/true, /*avx2=*/false, /*neon=*/false});
+  if (available.avx2)
+    optimizations.push_back({/*sse2=*/true, /*avx2=*/true, /*neon=*/false});
+  if (available.neon)
+    optimizations.push_back({/*sse2=*/false, /*avx2=*/false, /*neon=*/true});
+  return optimizations;
+}
+
+// Returns random FloatS16 samples, some of them out of the int16 range.
+std::vector<float> RandomFloats(Random* random, size_t size) {
+  std::vector<float> x(size);
+  for (float& sample : x)
+    sample = static_cast<float>(random->Gaussian(0.0, 20000.0));
+  return x;
+}
+
+std::vector<int16_t> RandomInts(Random* random, size_t size) {
+  std::vector<int16_t> x(size);
+  for (int16_t& sample : x)
+    sample = random->Rand<int16_t>();
+  return x;
+}
+
+}  // namespace
+
+TEST(VectorMath, AccumulateS16IsBitExact) {
+  const VectorMath reference(NoAvailableCpuFeatures());
+  Random random(42);
+  for (const AvailableCpuFeatures& features : GetOptimizationsToTest()) {
+    SCOPED_TRACE(features.ToString());
+    const VectorMath vector_math(features);
+    for (size_t size : kSizes) {
+      SCOPED_TRACE(size);
+      const std::vector<int16_t> x = RandomInts(&random, size);
+      std::vector<float> expected = RandomFloats(&random, size);
+      std::vector<float> accumulator = expected;
+      reference.AccumulateS16(x, expected);
+      vector_math.AccumulateS16(x, accumulator);
+      EXPECT_EQ(expected, accumulator);
+    }
+  }
+}
+
+TEST(VectorMath, AccumulateStereoS16IsBitExact) {
+  const VectorMath reference(NoAvailableCpuFeatures());
+  Random random(42);
+  for (const AvailableCpuFeatures& features : GetOptimizationsToTest()) {
+    SCOPED_TRACE(features.ToString());
+    const VectorMath vector_math(features);
+    for (size_t size : kSizes) {
+      SCOPED_TRACE(size);
+      const std::vector<int16_t> x = RandomInts(&random, 2 * size);
+      std::vector<float> expected_left(size, 0.f);
+      std::vector<float> expected_right(size, 0.f);
+      reference.AccumulateStereoS16(x, expected_left, expected_right);
+      std::vector<float> left(size, 0.f);
+      std::vector<float> right(size, 0.f);
+      vector_math.AccumulateStereoS16(x, left, right);
+      EXPECT_EQ(expected_left, left);
+      EXPECT_EQ(expected_right, right);
+      EXPECT_EQ(x[2 * size - 1], right[size - 1]);
+    }
+  }
+}
+
+TEST(VectorMath, MaxAbsIsBitExact) {
+  const VectorMath reference(NoAvailableCpuFeatures());
+  Random random(42);
+  for (const AvailableCpuFeatures& features : GetOptimizationsToTest()) {
+    SCOPED_TRACE(features.ToString());
+    const VectorMath vector_math(features);
+    for (size_t size : kSizes) {
+      SCOPED_TRACE(size);
+      std::vector<float> x = RandomFloats(&random, size);
+      EXPECT_EQ(reference.MaxAbs(x), vector_math.MaxAbs(x));
+      // The maximum is found in the tail too.
+      x.back() = -1e6f;
+      EXPECT_EQ(1e6f, vector_math.MaxAbs(x));
+    }
+    EXPECT_EQ(0.f, vector_math.MaxAbs({}));
+  }
+}
+
+TEST(VectorMath, ScaleAndClampAreBitExact) {
+  const VectorMath reference(NoAvailableCpuFeatures());
+  Random random(42);
+  for (const AvailableCpuFeatures& features : GetOptimizationsToTest()) {
+    SCOPED_TRACE(features.ToString());
+    const VectorMath vector_math(features);
+    for (size_t size : kSizes) {
+      SCOPED_TRACE(size);
+      const std::vector<float> x = RandomFloats(&random, size);
+      std::vector<float> gains(size);
+      for (float& gain : gains)
+        gain = 2.f * random.Rand<float>();
+
+      std::vector<float> expected = x;
+      std::vector<float> output = x;
+      reference.Scale(0.7f, expected);
+      vector_math.Scale(0.7f, output);
+      EXPECT_EQ(expected, output);
+
+      expected = x;
+      output = x;
+      reference.MultiplyAndClamp(gains, expected);
+      vector_math.MultiplyAndClamp(gains, output);
+      EXPECT_EQ(expected, output);
+
+      expected = x;
+      output = x;
+      reference.Clamp(expected);
+      vector_math.Clamp(output);
+      EXPECT_EQ(expected, output);
+    }
+  }
+}
+
+TEST(VectorMath, ScaleWithRampIsWithinTolerance) {
+  const VectorMath reference(NoAvailableCpuFeatures());
+  Random random(42);
+  for (const AvailableCpuFeatures& features : GetOptimizationsToTest()) {
+    SCOPED_TRACE(features.ToString());
+    const VectorMath vector_math(features);
+    for (size_t size : kSizes) {
+      SCOPED_TRACE(size);
+      const std::vector<float> x = RandomFloats(&random, size);
+      std::vector<float> expected = x;
+      std::vector<float> output = x;
+      reference.ScaleWithRamp(0.2f, 1.5f / size, expected);
+      vector_math.ScaleWithRamp(0.2f, 1.5f / size, output);
+      for (size_t i = 0; i < size; ++i) {
+        // The gains differ by a few rounding errors.
+        EXPECT_NEAR(expected[i], output[i], 1e-5f * std::fabs(x[i]));
+      }
+    }
+  }
+}
+
+TEST(VectorMath, ToS16IsBitExact) {
+  const VectorMath reference(NoAvailableCpuFeatures());
+  Random random(42);
+  for (const AvailableCpuFeatures& features : GetOptimizationsToTest()) {
+    SCOPED_TRACE(features.ToString());
+    const VectorMath vector_math(features);
+    for (size_t size : kSizes) {
+      SCOPED_TRACE(size);
+      std::vector<float> x = RandomFloats(&random, size);
+      // Halfway cases are rounded away from zero.
+      x[0] = -2.5f;
+      if (size > 4) {
+        x[1] = 2.5f;
+        x[2] = -0.f;
+        x[3] = 32767.5f;
+        x[4] = -32768.5f;
+      }
+      std::vector<int16_t> expected(size);
+      std::vector<int16_t> output(size);
+      reference.ToS16(x, expected);
+      vector_math.ToS16(x, output);
+      EXPECT_EQ(expected, output);
+    }
+  }
+}
+
+TEST(VectorMath, ToStereoS16IsBitExact) {
+  const VectorMath reference(NoAvailableCpuFeatures());
+  Random random(42);
+  for (const AvailableCpuFeatures& features : GetOptimizationsToTest()) {
+    SCOPED_TRACE(features.ToString());
+    const VectorMath vector_math(features);
+    for (size_t size : kSizes) {
+      SCOPED_TRACE(size);
+      const std::vector<float> left = RandomFloats(&random, size);
+      const std::vector<float> right = RandomFloats(&random, size);
+      std::vector<int16_t> expected(2 * size);
+      std::vector<int16_t> output(2 * size);
+      reference.ToStereoS16(left, right, expected);
+      vector_math.ToStereoS16(left, right, output);
+      EXPECT_EQ(expected, output);
+      EXPECT_EQ(FloatS16ToS16(right.back()), output.back());
+    }
+  }
+}
+
+TEST(VectorMath, DotProductIsWithinTolerance) {
+  const VectorMath reference(NoAvailableCpuFeatures());
+  Random random(42);
+  for (const AvailableCpuFeatures& features : GetOptimizationsToTest()) {
+    SCOPED_TRACE(features.ToString());
+    const VectorMath vector_math(features);
+    for (size_t size : kSizes) {
+      SCOPED_TRACE(size);
+      const std::vector<float> x = RandomFloats(&random, size);
+      const std::vector<float> y = RandomFloats(&random, size);
+      float abs_sum = 0.f;
+      for (size_t i = 0; i < size; ++i)
+        abs_sum += std::fabs(x[i] * y[i]);
+      // The products are summed in a different order.
+      EXPECT_NEAR(reference.DotProduct(x, y), vector_math.DotProduct(x, y),
+                  1e-6f * abs_sum);
+    }
+  }
+}
+
+TEST(VectorMath, DISABLED_KernelsPerf) {
+  constexpr int kNumIterations = 100000;
+  constexpr size_t kSize = 480;
+  Random random(42);
+  const std::vector<int16_t> samples = RandomInts(&random, 2 * kSize);
+  const std::vector<float> gains(kSize, 0.5f);
+  std::vector<float> left(kSize);
+  std::vector<float> right(kSize);
+  std::vector<int16_t> output(2 * kSize);
+  std::vector<AvailableCpuFeatures> optimizations = GetOptimizationsToTest();
+  optimizations.insert(optimizations.begin(), NoAvailableCpuFeatures());
+  for (const AvailableCpuFeatures& features : optimizations) {
+    const VectorMath vector_math(features);
+    // One stereo frame at 48 kHz going through the mixer and the limiter.
+    float max_abs = 0.f;
+    const int64_t start_ns = rtc::SystemTimeNanos();
+    for (int i = 0; i < kNumIterations; ++i) {
+      std::fill(left.begin(), left.end(), 0.f);
+      std::fill(right.begin(), right.end(), 0.f);
+      vector_math.AccumulateStereoS16(samples, left, right);
+      max_abs += std::max(vector_math.MaxAbs(left), vector_math.MaxAbs(right));
+      vector_math.MultiplyAndClamp(gains, left);
+      vector_math.MultiplyAndClamp(gains, right);
+      vector_math.ToStereoS16(left, right, output);
+    }
+    const int64_t elapsed_ns = rtc::SystemTimeNanos() - start_ns;
+    EXPECT_GT(max_abs, 0.f);
+    test::PrintResult("agc2_vector_math", "_" + features.ToString(),
+                      "frame_time",
+                      static_cast<double>(elapsed_ns) / kNumIterations, "ns",
+                      false);
+  }
+}
+
+}  // namespace webrtc
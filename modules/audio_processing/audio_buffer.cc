@@ -340,11 +340,11 @@ void AudioBuffer::CopyTo(AudioFrame* frame) const {
 }
 
 void AudioBuffer::SplitIntoFrequencyBands() {
-  splitting_filter_->Analysis(data_.get(), split_data_.get());
+  splitting_filter_->Analysis(data_.get(), split_data_.get(), thread_pool_);
 }
 
 void AudioBuffer::MergeFrequencyBands() {
-  splitting_filter_->Synthesis(split_data_.get(), data_.get());
+  splitting_filter_->Synthesis(split_data_.get(), data_.get(), thread_pool_);
 }
 
 void AudioBuffer::ExportSplitChannelData(size_t channel,
@@ -23,6 +23,7 @@
 
 namespace webrtc {
 
+class ChannelThreadPool;
 class PushSincResampler;
 class SplittingFilter;
 
@@ -122,6 +123,13 @@ class AudioBuffer {
   // Recombines the frequency bands into a full-band signal.
   void MergeFrequencyBands();
 
+  // Sets the pool on which the band splitting and the submodules process the
+  // channels of this buffer. With no pool they run on the calling thread.
+  void set_thread_pool(ChannelThreadPool* thread_pool) {
+    thread_pool_ = thread_pool;
+  }
+  ChannelThreadPool* thread_pool() const { return thread_pool_; }
+
   // Copies the split bands data into the integer two-dimensional array.
   void ExportSplitChannelData(size_t channel, int16_t* const* split_band_data);
 
@@ -170,6 +178,7 @@ class AudioBuffer {
   std::vector<std::unique_ptr<PushSincResampler>> output_resamplers_;
   bool downmix_by_averaging_ = true;
   size_t channel_for_downmixing_ = 0;
+  ChannelThreadPool* thread_pool_ = nullptr;
 };
 
 }  // namespace webrtc
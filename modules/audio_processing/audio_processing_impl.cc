@@ -40,6 +40,7 @@
 #include "modules/audio_processing/noise_suppression_proxy.h"
 #include "modules/audio_processing/residual_echo_detector.h"
 #include "modules/audio_processing/transient/transient_suppressor.h"
+#include "modules/audio_processing/utility/channel_thread_pool.h"
 #include "modules/audio_processing/voice_detection_impl.h"
 #include "rtc_base/atomic_ops.h"
 #include "rtc_base/checks.h"
@@ -528,6 +529,7 @@ int AudioProcessingImpl::InitializeLocked() {
       formats_.api_format.output_stream().num_channels(),
       formats_.api_format.output_stream().sample_rate_hz(),
       formats_.api_format.output_stream().num_channels()));
+  capture_.capture_audio->set_thread_pool(capture_.thread_pool.get());
 
   AllocateRenderQueue();
 
@@ -684,8 +686,16 @@ void AudioProcessingImpl::ApplyConfig(const AudioProcessing::Config& config) {
       config_.gain_controller1.analog_level_maximum !=
           config.gain_controller1.analog_level_maximum;
 
+  const bool pipeline_config_changed =
+      config_.pipeline.num_capture_threads !=
+      config.pipeline.num_capture_threads;
+
   config_ = config;
 
+  if (pipeline_config_changed) {
+    InitializeCaptureThreadPool();
+  }
+
   if (aec_config_changed) {
     InitializeEchoController();
   }
@@ -1836,6 +1846,20 @@ void AudioProcessingImpl::InitializeHighPassFilter() {
   }
 }
 
+void AudioProcessingImpl::InitializeCaptureThreadPool() {
+  if (config_.pipeline.num_capture_threads > 1) {
+    capture_.thread_pool = absl::make_unique<ChannelThreadPool>(
+        config_.pipeline.num_capture_threads);
+  } else {
+    capture_.thread_pool.reset();
+  }
+  if (capture_.capture_audio) {
+    capture_.capture_audio->set_thread_pool(capture_.thread_pool.get());
+  }
+  RTC_LOG(LS_INFO) << "Capture processing threads: "
+                   << config_.pipeline.num_capture_threads;
+}
+
 void AudioProcessingImpl::InitializeEchoController() {
   bool use_echo_controller =
       echo_control_factory_ ||
@@ -10,6 +10,7 @@
 
 #include "modules/audio_processing/audio_processing_impl.h"
 
+#include <algorithm>
 #include <memory>
 
 #include "absl/memory/memory.h"
@@ -18,6 +19,7 @@
 #include "modules/audio_processing/test/echo_control_mock.h"
 #include "modules/audio_processing/test/test_utils.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/random.h"
 #include "rtc_base/ref_counted_object.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
@@ -211,6 +213,46 @@ TEST(AudioProcessingImplTest, UpdateCapturePreGainRuntimeSetting) {
       << "Frame should be amplified.";
 }
 
+TEST(AudioProcessingImplTest, ParallelCaptureProcessingIsBitExact) {
+  constexpr size_t kNumChannels = 8;
+  for (int sample_rate_hz : {16000, 32000, 48000}) {
+    SCOPED_TRACE(sample_rate_hz);
+    AudioProcessing::Config apm_config;
+    apm_config.high_pass_filter.enabled = true;
+    apm_config.noise_suppression.enabled = true;
+    apm_config.gain_controller1.enabled = true;
+    apm_config.gain_controller1.mode =
+        AudioProcessing::Config::GainController1::kAdaptiveDigital;
+    std::unique_ptr<AudioProcessing> apm(AudioProcessingBuilder().Create());
+    apm->ApplyConfig(apm_config);
+    apm_config.pipeline.num_capture_threads = 3;
+    std::unique_ptr<AudioProcessing> parallel_apm(
+        AudioProcessingBuilder().Create());
+    parallel_apm->ApplyConfig(apm_config);
+
+    Random random_generator(42);
+    AudioFrame frame;
+    AudioFrame parallel_frame;
+    InitializeAudioFrame(sample_rate_hz, kNumChannels, &frame);
+    for (int i = 0; i < 100; ++i) {
+      const size_t num_samples = frame.samples_per_channel_ * kNumChannels;
+      int16_t* data = frame.mutable_data();
+      for (size_t k = 0; k < num_samples; ++k) {
+        // A different level in each channel.
+        const int level = 100 << (k % kNumChannels);
+        data[k] = static_cast<int16_t>(random_generator.Rand(-level, level));
+      }
+      parallel_frame.CopyFrom(frame);
+      ASSERT_EQ(AudioProcessing::kNoError, apm->ProcessStream(&frame));
+      ASSERT_EQ(AudioProcessing::kNoError,
+                parallel_apm->ProcessStream(&parallel_frame));
+      ASSERT_TRUE(std::equal(frame.data(), frame.data() + num_samples,
+                             parallel_frame.data()))
+          << "Frame " << i;
+    }
+  }
+}
+
 TEST(AudioProcessingImplTest,
      EchoControllerObservesPreAmplifierEchoPathGainChange) {
   // Tests that the echo controller observes an echo path gain change when the
@@ -11,6 +11,7 @@
 
 #include <algorithm>
 #include <memory>
+#include <string>
 #include <vector>
 
 #include "api/array_view.h"
@@ -615,6 +616,54 @@ bool TimedThreadApiProcessor::Process() {
 
 const float CallSimulator::kRenderInputFloatLevel = 0.5f;
 const float CallSimulator::kCaptureInputFloatLevel = 0.03125f;
+
+// Returns the average duration in us of a ProcessStream() call for a
+// multichannel microphone array at 48 kHz, with the per-channel processing
+// spread over |num_threads| threads.
+double MultichannelCaptureCallDuration(size_t num_channels, int num_threads) {
+  constexpr int kSampleRateHz = 48000;
+  constexpr size_t kNumFrames = kSampleRateHz / 100;
+  constexpr int kNumWarmupCalls = 100;
+  constexpr int kNumCalls = 1000;
+
+  // The echo canceller downmixes the capture signal to mono, so only the
+  // submodules that process each channel are enabled.
+  AudioProcessing::Config apm_config;
+  apm_config.high_pass_filter.enabled = true;
+  apm_config.noise_suppression.enabled = true;
+  apm_config.gain_controller1.enabled = true;
+  apm_config.gain_controller1.mode =
+      AudioProcessing::Config::GainController1::kAdaptiveDigital;
+  apm_config.pipeline.num_capture_threads = num_threads;
+  std::unique_ptr<AudioProcessing> apm(AudioProcessingBuilder().Create());
+  apm->ApplyConfig(apm_config);
+
+  Random rand_gen(42U);
+  std::vector<float> input_samples(num_channels * kNumFrames);
+  for (float& sample : input_samples)
+    sample = 0.1f * (2 * rand_gen.Rand<float>() - 1);
+  std::vector<float> output_samples(num_channels * kNumFrames);
+  std::vector<const float*> input(num_channels);
+  std::vector<float*> output(num_channels);
+  for (size_t ch = 0; ch < num_channels; ++ch) {
+    input[ch] = &input_samples[ch * kNumFrames];
+    output[ch] = &output_samples[ch * kNumFrames];
+  }
+  const StreamConfig stream_config(kSampleRateHz, num_channels, false);
+
+  Clock* clock = Clock::GetRealTimeClock();
+  int64_t start_time = 0;
+  for (int i = 0; i < kNumWarmupCalls + kNumCalls; ++i) {
+    if (i == kNumWarmupCalls)
+      start_time = clock->TimeInMicroseconds();
+    EXPECT_EQ(AudioProcessing::kNoError,
+              apm->ProcessStream(input.data(), stream_config, stream_config,
+                                 output.data()));
+  }
+  return static_cast<double>(clock->TimeInMicroseconds() - start_time) /
+         kNumCalls;
+}
+
 }  // anonymous namespace
 
 // TODO(peah): Reactivate once issue 7712 has been resolved.
@@ -623,6 +672,22 @@ TEST_P(CallSimulator, DISABLED_ApiCallDurationTest) {
   EXPECT_TRUE(Run());
 }
 
+// Measures the capture processing of a conference room microphone array with
+// the channels processed on one and on several threads.
+TEST(AudioProcessingPerformanceTest, DISABLED_MultichannelCaptureDurationTest) {
+  for (size_t num_channels : {8, 16}) {
+    for (int num_threads : {1, 2, 4}) {
+      webrtc::test::PrintResult(
+          "apm_timing",
+          "_48000Hz_" + std::to_string(num_channels) + "_channels_" +
+              std::to_string(num_threads) + "_threads",
+          "multichannel_capture_api_call_duration",
+          MultichannelCaptureCallDuration(num_channels, num_threads), "us",
+          false);
+    }
+  }
+}
+
 INSTANTIATE_TEST_SUITE_P(
     AudioProcessingPerformanceTest,
     CallSimulator,
@@ -17,6 +17,7 @@
 #include "modules/audio_processing/audio_buffer.h"
 #include "modules/audio_processing/include/audio_processing.h"
 #include "modules/audio_processing/logging/apm_data_dumper.h"
+#include "modules/audio_processing/utility/channel_thread_pool.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/constructor_magic.h"
 
@@ -78,8 +79,17 @@ class GainControlImpl::GainController {
     return *capture_level_;
   }
 
+  // Outcome of the last call processing the channel of this controller, which
+  // may have run on a worker thread.
+  int error() const { return error_; }
+  void set_error(int error) { error_ = error; }
+  bool saturation_warning() const { return saturation_warning_; }
+  void set_saturation_warning(bool warning) { saturation_warning_ = warning; }
+
  private:
   Handle* state_;
+  int error_ = 0;
+  bool saturation_warning_ = false;
   // TODO(peah): Remove the optional once the initialization is moved into the
   // ctor.
   absl::optional<int> capture_level_;
@@ -154,52 +164,43 @@ int GainControlImpl::AnalyzeCaptureAudio(AudioBuffer* audio) {
   RTC_DCHECK_EQ(audio->num_channels(), *num_proc_channels_);
   RTC_DCHECK_LE(*num_proc_channels_, gain_controllers_.size());
 
-  int16_t split_band_data[AudioBuffer::kMaxNumBands]
-                         [AudioBuffer::kMaxSplitFrameLength];
-  int16_t* split_bands[AudioBuffer::kMaxNumBands] = {
-      split_band_data[0], split_band_data[1], split_band_data[2]};
-
-  if (mode_ == kAdaptiveAnalog) {
-    int capture_channel = 0;
-    for (auto& gain_controller : gain_controllers_) {
-      gain_controller->set_capture_level(analog_capture_level_);
-
-      audio->ExportSplitChannelData(capture_channel, split_bands);
-
-      int err =
-          WebRtcAgc_AddMic(gain_controller->state(), split_bands,
-                           audio->num_bands(), audio->num_frames_per_band());
+  if (mode_ != kAdaptiveAnalog && mode_ != kAdaptiveDigital) {
+    return AudioProcessing::kNoError;
+  }
 
-      audio->ImportSplitChannelData(capture_channel, split_bands);
+  // The channels have independent states and may be processed in parallel.
+  const size_t num_channels = gain_controllers_.size();
+  ForEachChannel(audio->thread_pool(), num_channels, [&](size_t ch) {
+    GainController* gain_controller = gain_controllers_[ch].get();
+    int16_t split_band_data[AudioBuffer::kMaxNumBands]
+                           [AudioBuffer::kMaxSplitFrameLength];
+    int16_t* split_bands[AudioBuffer::kMaxNumBands] = {
+        split_band_data[0], split_band_data[1], split_band_data[2]};
+    audio->ExportSplitChannelData(ch, split_bands);
 
-      if (err != AudioProcessing::kNoError) {
-        return AudioProcessing::kUnspecifiedError;
-      }
-      ++capture_channel;
-    }
-  } else if (mode_ == kAdaptiveDigital) {
-    int capture_channel = 0;
-    for (auto& gain_controller : gain_controllers_) {
+    int err;
+    if (mode_ == kAdaptiveAnalog) {
+      gain_controller->set_capture_level(analog_capture_level_);
+      err = WebRtcAgc_AddMic(gain_controller->state(), split_bands,
+                             audio->num_bands(), audio->num_frames_per_band());
+    } else {
       int32_t capture_level_out = 0;
-
-      audio->ExportSplitChannelData(capture_channel, split_bands);
-
-      int err =
-          WebRtcAgc_VirtualMic(gain_controller->state(), split_bands,
-                               audio->num_bands(), audio->num_frames_per_band(),
-                               analog_capture_level_, &capture_level_out);
-
-      audio->ImportSplitChannelData(capture_channel, split_bands);
-
+      err = WebRtcAgc_VirtualMic(
+          gain_controller->state(), split_bands, audio->num_bands(),
+          audio->num_frames_per_band(), analog_capture_level_,
+          &capture_level_out);
       gain_controller->set_capture_level(capture_level_out);
+    }
 
-      if (err != AudioProcessing::kNoError) {
-        return AudioProcessing::kUnspecifiedError;
-      }
-      ++capture_channel;
+    audio->ImportSplitChannelData(ch, split_bands);
+    gain_controller->set_error(err);
+  });
+
+  for (auto& gain_controller : gain_controllers_) {
+    if (gain_controller->error() != AudioProcessing::kNoError) {
+      return AudioProcessing::kUnspecifiedError;
     }
   }
-
   return AudioProcessing::kNoError;
 }
 
@@ -218,9 +219,9 @@ int GainControlImpl::ProcessCaptureAudio(AudioBuffer* audio,
                 audio->num_frames_per_band());
   RTC_DCHECK_EQ(audio->num_channels(), *num_proc_channels_);
 
-  stream_is_saturated_ = false;
-  int capture_channel = 0;
-  for (auto& gain_controller : gain_controllers_) {
+  const size_t num_channels = gain_controllers_.size();
+  ForEachChannel(audio->thread_pool(), num_channels, [&](size_t ch) {
+    GainController* gain_controller = gain_controllers_[ch].get();
     int32_t capture_level_out = 0;
     uint8_t saturation_warning = 0;
 
@@ -228,7 +229,7 @@ int GainControlImpl::ProcessCaptureAudio(AudioBuffer* audio,
                            [AudioBuffer::kMaxSplitFrameLength];
     int16_t* split_bands[AudioBuffer::kMaxNumBands] = {
         split_band_data[0], split_band_data[1], split_band_data[2]};
-    audio->ExportSplitChannelData(capture_channel, split_bands);
+    audio->ExportSplitChannelData(ch, split_bands);
 
     // The call to stream_has_echo() is ok from a deadlock perspective
     // as the capture lock is allready held.
@@ -238,18 +239,23 @@ int GainControlImpl::ProcessCaptureAudio(AudioBuffer* audio,
         gain_controller->get_capture_level(), &capture_level_out,
         stream_has_echo, &saturation_warning);
 
-    audio->ImportSplitChannelData(capture_channel, split_bands);
+    audio->ImportSplitChannelData(ch, split_bands);
 
-    if (err != AudioProcessing::kNoError) {
-      return AudioProcessing::kUnspecifiedError;
+    gain_controller->set_error(err);
+    if (err == AudioProcessing::kNoError) {
+      gain_controller->set_capture_level(capture_level_out);
     }
+    gain_controller->set_saturation_warning(saturation_warning == 1);
+  });
 
-    gain_controller->set_capture_level(capture_level_out);
-    if (saturation_warning == 1) {
+  stream_is_saturated_ = false;
+  for (auto& gain_controller : gain_controllers_) {
+    if (gain_controller->error() != AudioProcessing::kNoError) {
+      return AudioProcessing::kUnspecifiedError;
+    }
+    if (gain_controller->saturation_warning()) {
       stream_is_saturated_ = true;
     }
-
-    ++capture_channel;
   }
 
   RTC_DCHECK_LT(0ul, *num_proc_channels_);
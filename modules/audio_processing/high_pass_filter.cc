@@ -12,6 +12,7 @@
 
 #include "api/array_view.h"
 #include "modules/audio_processing/audio_buffer.h"
+#include "modules/audio_processing/utility/channel_thread_pool.h"
 #include "rtc_base/checks.h"
 
 namespace webrtc {
@@ -38,11 +39,11 @@ HighPassFilter::~HighPassFilter() = default;
 void HighPassFilter::Process(AudioBuffer* audio) {
   RTC_DCHECK(audio);
   RTC_DCHECK_EQ(filters_.size(), audio->num_channels());
-  for (size_t k = 0; k < audio->num_channels(); ++k) {
+  ForEachChannel(audio->thread_pool(), audio->num_channels(), [&](size_t k) {
     rtc::ArrayView<float> channel_data = rtc::ArrayView<float>(
         audio->split_bands(k)[0], audio->num_frames_per_band());
     filters_[k]->Process(channel_data);
-  }
+  });
 }
 
 void HighPassFilter::Process(rtc::ArrayView<float> audio) {
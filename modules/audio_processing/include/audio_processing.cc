@@ -62,6 +62,8 @@ std::string AudioProcessing::Config::ToString() const {
   builder << "AudioProcessing::Config{ "
           << "pre_amplifier: { enabled: " << pre_amplifier.enabled
           << ", fixed_gain_factor: " << pre_amplifier.fixed_gain_factor
+          << " }, pipeline: { num_capture_threads: "
+          << pipeline.num_capture_threads
           << " }, high_pass_filter: { enabled: " << high_pass_filter.enabled
           << " }, echo_canceller: { enabled: " << echo_canceller.enabled
           << ", mobile_mode: " << echo_canceller.mobile_mode
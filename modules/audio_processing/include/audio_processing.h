@@ -252,6 +252,15 @@ class AudioProcessing : public rtc::RefCountInterface {
       float fixed_gain_factor = 1.f;
     } pre_amplifier;
 
+    // Sets how the capture processing is executed.
+    struct Pipeline {
+      // Number of threads, including the capture thread, over which the
+      // channels of the band splitting, the high-pass filter, the noise
+      // suppressor and the AGC are processed. Only pays off for many capture
+      // channels. The output does not depend on the number of threads.
+      int num_capture_threads = 1;
+    } pipeline;
+
     struct HighPassFilter {
       bool enabled = false;
     } high_pass_filter;
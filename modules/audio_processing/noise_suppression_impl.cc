@@ -11,6 +11,7 @@
 #include "modules/audio_processing/noise_suppression_impl.h"
 
 #include "modules/audio_processing/audio_buffer.h"
+#include "modules/audio_processing/utility/channel_thread_pool.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/constructor_magic.h"
 #if defined(WEBRTC_NS_FLOAT)
@@ -80,10 +81,13 @@ void NoiseSuppressionImpl::AnalyzeCaptureAudio(AudioBuffer* audio) {
 
   RTC_DCHECK_GE(160, audio->num_frames_per_band());
   RTC_DCHECK_EQ(suppressors_.size(), audio->num_channels());
-  for (size_t i = 0; i < suppressors_.size(); i++) {
-    WebRtcNs_Analyze(suppressors_[i]->state(),
+  // |crit_| stays held by this thread while the channels are processed, also
+  // when that happens on the worker threads of the pool.
+  const auto& suppressors = suppressors_;
+  ForEachChannel(audio->thread_pool(), suppressors.size(), [&](size_t i) {
+    WebRtcNs_Analyze(suppressors[i]->state(),
                      audio->split_bands_const(i)[kBand0To8kHz]);
-  }
+  });
 #endif
 }
 
@@ -96,9 +100,10 @@ void NoiseSuppressionImpl::ProcessCaptureAudio(AudioBuffer* audio) {
 
   RTC_DCHECK_GE(160, audio->num_frames_per_band());
   RTC_DCHECK_EQ(suppressors_.size(), audio->num_channels());
-  for (size_t i = 0; i < suppressors_.size(); i++) {
+  const auto& suppressors = suppressors_;
+  ForEachChannel(audio->thread_pool(), suppressors.size(), [&](size_t i) {
 #if defined(WEBRTC_NS_FLOAT)
-    WebRtcNs_Process(suppressors_[i]->state(), audio->split_bands_const(i),
+    WebRtcNs_Process(suppressors[i]->state(), audio->split_bands_const(i),
                      audio->num_bands(), audio->split_bands(i));
 #elif defined(WEBRTC_NS_FIXED)
     int16_t split_band_data[AudioBuffer::kMaxNumBands]
@@ -107,12 +112,12 @@ void NoiseSuppressionImpl::ProcessCaptureAudio(AudioBuffer* audio) {
         split_band_data[0], split_band_data[1], split_band_data[2]};
     audio->ExportSplitChannelData(i, split_bands);
 
-    WebRtcNsx_Process(suppressors_[i]->state(), split_bands, audio->num_bands(),
+    WebRtcNsx_Process(suppressors[i]->state(), split_bands, audio->num_bands(),
                       split_bands);
 
     audio->ImportSplitChannelData(i, split_bands);
 #endif
-  }
+  });
 }
 
 int NoiseSuppressionImpl::Enable(bool enable) {
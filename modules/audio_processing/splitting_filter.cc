@@ -14,6 +14,7 @@
 
 #include "common_audio/channel_buffer.h"
 #include "common_audio/signal_processing/include/signal_processing_library.h"
+#include "modules/audio_processing/utility/channel_thread_pool.h"
 #include "rtc_base/checks.h"
 
 namespace webrtc {
@@ -42,82 +43,90 @@ SplittingFilter::SplittingFilter(size_t num_channels,
 SplittingFilter::~SplittingFilter() = default;
 
 void SplittingFilter::Analysis(const ChannelBuffer<float>* data,
-                               ChannelBuffer<float>* bands) {
+                               ChannelBuffer<float>* bands,
+                               ChannelThreadPool* thread_pool) {
   RTC_DCHECK_EQ(num_bands_, bands->num_bands());
   RTC_DCHECK_EQ(data->num_channels(), bands->num_channels());
   RTC_DCHECK_EQ(data->num_frames(),
                 bands->num_frames_per_band() * bands->num_bands());
   if (bands->num_bands() == 2) {
-    TwoBandsAnalysis(data, bands);
+    RTC_DCHECK_EQ(two_bands_states_.size(), data->num_channels());
+    RTC_DCHECK_EQ(data->num_frames(), kTwoBandFilterSamplesPerFrame);
+    ForEachChannel(thread_pool, two_bands_states_.size(),
+                   [&](size_t ch) { TwoBandsAnalysis(data, bands, ch); });
   } else if (bands->num_bands() == 3) {
-    ThreeBandsAnalysis(data, bands);
+    RTC_DCHECK_EQ(three_band_filter_banks_.size(), data->num_channels());
+    ForEachChannel(thread_pool, three_band_filter_banks_.size(),
+                   [&](size_t ch) { ThreeBandsAnalysis(data, bands, ch); });
   }
 }
 
 void SplittingFilter::Synthesis(const ChannelBuffer<float>* bands,
-                                ChannelBuffer<float>* data) {
+                                ChannelBuffer<float>* data,
+                                ChannelThreadPool* thread_pool) {
   RTC_DCHECK_EQ(num_bands_, bands->num_bands());
   RTC_DCHECK_EQ(data->num_channels(), bands->num_channels());
   RTC_DCHECK_EQ(data->num_frames(),
                 bands->num_frames_per_band() * bands->num_bands());
   if (bands->num_bands() == 2) {
-    TwoBandsSynthesis(bands, data);
+    RTC_DCHECK_LE(data->num_channels(), two_bands_states_.size());
+    RTC_DCHECK_EQ(data->num_frames(), kTwoBandFilterSamplesPerFrame);
+    ForEachChannel(thread_pool, data->num_channels(),
+                   [&](size_t ch) { TwoBandsSynthesis(bands, data, ch); });
   } else if (bands->num_bands() == 3) {
-    ThreeBandsSynthesis(bands, data);
+    RTC_DCHECK_LE(data->num_channels(), three_band_filter_banks_.size());
+    ForEachChannel(thread_pool, data->num_channels(),
+                   [&](size_t ch) { ThreeBandsSynthesis(bands, data, ch); });
   }
 }
 
 void SplittingFilter::TwoBandsAnalysis(const ChannelBuffer<float>* data,
-                                       ChannelBuffer<float>* bands) {
-  RTC_DCHECK_EQ(two_bands_states_.size(), data->num_channels());
-  RTC_DCHECK_EQ(data->num_frames(), kTwoBandFilterSamplesPerFrame);
-
-  for (size_t i = 0; i < two_bands_states_.size(); ++i) {
-    std::array<std::array<int16_t, kSamplesPerBand>, 2> bands16;
-    std::array<int16_t, kTwoBandFilterSamplesPerFrame> full_band16;
-    FloatS16ToS16(data->channels(0)[i], full_band16.size(), full_band16.data());
-    WebRtcSpl_AnalysisQMF(full_band16.data(), data->num_frames(),
-                          bands16[0].data(), bands16[1].data(),
-                          two_bands_states_[i].analysis_state1,
-                          two_bands_states_[i].analysis_state2);
-    S16ToFloatS16(bands16[0].data(), bands16[0].size(), bands->channels(0)[i]);
-    S16ToFloatS16(bands16[1].data(), bands16[1].size(), bands->channels(1)[i]);
-  }
+                                       ChannelBuffer<float>* bands,
+                                       size_t channel) {
+  std::array<std::array<int16_t, kSamplesPerBand>, 2> bands16;
+  std::array<int16_t, kTwoBandFilterSamplesPerFrame> full_band16;
+  FloatS16ToS16(data->channels(0)[channel], full_band16.size(),
+                full_band16.data());
+  WebRtcSpl_AnalysisQMF(full_band16.data(), data->num_frames(),
+                        bands16[0].data(), bands16[1].data(),
+                        two_bands_states_[channel].analysis_state1,
+                        two_bands_states_[channel].analysis_state2);
+  S16ToFloatS16(bands16[0].data(), bands16[0].size(),
+                bands->channels(0)[channel]);
+  S16ToFloatS16(bands16[1].data(), bands16[1].size(),
+                bands->channels(1)[channel]);
 }
 
 void SplittingFilter::TwoBandsSynthesis(const ChannelBuffer<float>* bands,
-                                        ChannelBuffer<float>* data) {
-  RTC_DCHECK_LE(data->num_channels(), two_bands_states_.size());
-  RTC_DCHECK_EQ(data->num_frames(), kTwoBandFilterSamplesPerFrame);
-  for (size_t i = 0; i < data->num_channels(); ++i) {
-    std::array<std::array<int16_t, kSamplesPerBand>, 2> bands16;
-    std::array<int16_t, kTwoBandFilterSamplesPerFrame> full_band16;
-    FloatS16ToS16(bands->channels(0)[i], bands16[0].size(), bands16[0].data());
-    FloatS16ToS16(bands->channels(1)[i], bands16[1].size(), bands16[1].data());
-    WebRtcSpl_SynthesisQMF(bands16[0].data(), bands16[1].data(),
-                           bands->num_frames_per_band(), full_band16.data(),
-                           two_bands_states_[i].synthesis_state1,
-                           two_bands_states_[i].synthesis_state2);
-    S16ToFloatS16(full_band16.data(), full_band16.size(), data->channels(0)[i]);
-  }
+                                        ChannelBuffer<float>* data,
+                                        size_t channel) {
+  std::array<std::array<int16_t, kSamplesPerBand>, 2> bands16;
+  std::array<int16_t, kTwoBandFilterSamplesPerFrame> full_band16;
+  FloatS16ToS16(bands->channels(0)[channel], bands16[0].size(),
+                bands16[0].data());
+  FloatS16ToS16(bands->channels(1)[channel], bands16[1].size(),
+                bands16[1].data());
+  WebRtcSpl_SynthesisQMF(bands16[0].data(), bands16[1].data(),
+                         bands->num_frames_per_band(), full_band16.data(),
+                         two_bands_states_[channel].synthesis_state1,
+                         two_bands_states_[channel].synthesis_state2);
+  S16ToFloatS16(full_band16.data(), full_band16.size(),
+                data->channels(0)[channel]);
 }
 
 void SplittingFilter::ThreeBandsAnalysis(const ChannelBuffer<float>* data,
-                                         ChannelBuffer<float>* bands) {
-  RTC_DCHECK_EQ(three_band_filter_banks_.size(), data->num_channels());
-  for (size_t i = 0; i < three_band_filter_banks_.size(); ++i) {
-    three_band_filter_banks_[i]->Analysis(data->channels()[i],
-                                          data->num_frames(), bands->bands(i));
-  }
+                                         ChannelBuffer<float>* bands,
+                                         size_t channel) {
+  three_band_filter_banks_[channel]->Analysis(
+      data->channels()[channel], data->num_frames(), bands->bands(channel));
 }
 
 void SplittingFilter::ThreeBandsSynthesis(const ChannelBuffer<float>* bands,
-                                          ChannelBuffer<float>* data) {
-  RTC_DCHECK_LE(data->num_channels(), three_band_filter_banks_.size());
-  for (size_t i = 0; i < data->num_channels(); ++i) {
-    three_band_filter_banks_[i]->Synthesis(
-        bands->bands(i), bands->num_frames_per_band(), data->channels()[i]);
-  }
+                                          ChannelBuffer<float>* data,
+                                          size_t channel) {
+  three_band_filter_banks_[channel]->Synthesis(
+      bands->bands(channel), bands->num_frames_per_band(),
+      data->channels()[channel]);
 }
 
 }  // namespace webrtc
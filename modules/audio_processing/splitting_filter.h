@@ -20,6 +20,8 @@
 
 namespace webrtc {
 
+class ChannelThreadPool;
+
 struct TwoBandsStates {
   TwoBandsStates() {
     memset(analysis_state1, 0, sizeof(analysis_state1));
@@ -41,25 +43,40 @@ struct TwoBandsStates {
 // For each block, Analysis() is called to split into bands and then Synthesis()
 // to merge these bands again. The input and output signals are contained in
 // ChannelBuffers and for the different bands an array of ChannelBuffers is
-// used.
+// used. The channels are filtered on |thread_pool| if one is given.
 class SplittingFilter {
  public:
   SplittingFilter(size_t num_channels, size_t num_bands, size_t num_frames);
   ~SplittingFilter();
 
-  void Analysis(const ChannelBuffer<float>* data, ChannelBuffer<float>* bands);
-  void Synthesis(const ChannelBuffer<float>* bands, ChannelBuffer<float>* data);
+  void Analysis(const ChannelBuffer<float>* data, ChannelBuffer<float>* bands) {
+    Analysis(data, bands, nullptr);
+  }
+  void Synthesis(const ChannelBuffer<float>* bands,
+                 ChannelBuffer<float>* data) {
+    Synthesis(bands, data, nullptr);
+  }
+  void Analysis(const ChannelBuffer<float>* data,
+                ChannelBuffer<float>* bands,
+                ChannelThreadPool* thread_pool);
+  void Synthesis(const ChannelBuffer<float>* bands,
+                 ChannelBuffer<float>* data,
+                 ChannelThreadPool* thread_pool);
 
  private:
   // Two-band analysis and synthesis work for 640 samples or less.
   void TwoBandsAnalysis(const ChannelBuffer<float>* data,
-                        ChannelBuffer<float>* bands);
+                        ChannelBuffer<float>* bands,
+                        size_t channel);
   void TwoBandsSynthesis(const ChannelBuffer<float>* bands,
-                         ChannelBuffer<float>* data);
+                         ChannelBuffer<float>* data,
+                         size_t channel);
   void ThreeBandsAnalysis(const ChannelBuffer<float>* data,
-                          ChannelBuffer<float>* bands);
+                          ChannelBuffer<float>* bands,
+                          size_t channel);
   void ThreeBandsSynthesis(const ChannelBuffer<float>* bands,
-                           ChannelBuffer<float>* data);
+                           ChannelBuffer<float>* data,
+                           size_t channel);
   void InitBuffers();
 
   const size_t num_bands_;
@@ -0,0 +1,127 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_processing/utility/channel_thread_pool.h"
+
+#include <algorithm>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/platform_thread.h"
+
+namespace webrtc {
+
+struct ChannelThreadPool::Worker {
+  ChannelThreadPool* pool = nullptr;
+  rtc::Event start;
+  std::unique_ptr<rtc::PlatformThread> thread;
+};
+
+ChannelThreadPool::ChannelThreadPool(int num_threads) {
+  RTC_DCHECK_GT(num_threads, 0);
+  for (int i = 1; i < num_threads; ++i) {
+    workers_.push_back(absl::make_unique<Worker>());
+    Worker* worker = workers_.back().get();
+    worker->pool = this;
+    worker->thread = absl::make_unique<rtc::PlatformThread>(
+        &ChannelThreadPool::ThreadMain, worker,
+        "ApmChannelWorker" + std::to_string(i), rtc::kRealtimePriority);
+    worker->thread->Start();
+  }
+}
+
+ChannelThreadPool::~ChannelThreadPool() {
+  {
+    rtc::CritScope lock(&crit_);
+    quit_ = true;
+  }
+  for (auto& worker : workers_) {
+    worker->start.Set();
+    worker->thread->Stop();
+  }
+}
+
+void ChannelThreadPool::Run(size_t num_channels,
+                            rtc::FunctionView<void(size_t)> process) {
+  // The calling thread takes one channel, so one worker less is needed than
+  // there are channels.
+  const size_t num_workers =
+      std::min(workers_.size(), num_channels > 0 ? num_channels - 1 : 0);
+  if (num_workers == 0) {
+    for (size_t ch = 0; ch < num_channels; ++ch)
+      process(ch);
+    return;
+  }
+
+  {
+    rtc::CritScope lock(&crit_);
+    process_ = &process;
+    num_channels_ = num_channels;
+    next_channel_ = 0;
+    num_busy_workers_ = static_cast<int>(num_workers);
+  }
+  for (size_t i = 0; i < num_workers; ++i)
+    workers_[i]->start.Set();
+  ProcessChannels();
+  // Wait for all started workers, not only all channels, so that no worker
+  // looks at |process_| after it goes out of scope.
+  done_.Wait(rtc::Event::kForever);
+}
+
+void ChannelThreadPool::ThreadMain(void* context) {
+  Worker* worker = static_cast<Worker*>(context);
+  while (true) {
+    worker->start.Wait(rtc::Event::kForever);
+    if (!worker->pool->RunWorker())
+      return;
+  }
+}
+
+bool ChannelThreadPool::RunWorker() {
+  {
+    rtc::CritScope lock(&crit_);
+    if (quit_)
+      return false;
+  }
+  ProcessChannels();
+  rtc::CritScope lock(&crit_);
+  if (--num_busy_workers_ == 0)
+    done_.Set();
+  return true;
+}
+
+void ChannelThreadPool::ProcessChannels() {
+  while (true) {
+    rtc::FunctionView<void(size_t)>* process;
+    size_t channel;
+    {
+      rtc::CritScope lock(&crit_);
+      if (next_channel_ >= num_channels_)
+        return;
+      process = process_;
+      channel = next_channel_++;
+    }
+    (*process)(channel);
+  }
+}
+
+void ForEachChannel(ChannelThreadPool* thread_pool,
+                    size_t num_channels,
+                    rtc::FunctionView<void(size_t)> process) {
+  if (thread_pool) {
+    thread_pool->Run(num_channels, process);
+    return;
+  }
+  for (size_t ch = 0; ch < num_channels; ++ch)
+    process(ch);
+}
+
+}  // namespace webrtc
@@ -0,0 +1,74 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_AUDIO_PROCESSING_UTILITY_CHANNEL_THREAD_POOL_H_
+#define MODULES_AUDIO_PROCESSING_UTILITY_CHANNEL_THREAD_POOL_H_
+
+#include <stddef.h>
+
+#include <memory>
+#include <vector>
+
+#include "api/function_view.h"
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+// Spreads the per-channel work of a processing stage over a few threads. The
+// channels of a stage have independent states, so the output does not depend
+// on which thread processes which channel.
+//
+// The processing runs while the calling thread holds the APM capture lock, so
+// the per-channel functions must not take any lock held by the calling thread.
+class ChannelThreadPool {
+ public:
+  // Runs on the calling thread and |num_threads| - 1 worker threads.
+  explicit ChannelThreadPool(int num_threads);
+  ~ChannelThreadPool();
+
+  int num_threads() const { return static_cast<int>(workers_.size()) + 1; }
+
+  // Calls |process| once for each channel in [0, |num_channels|), on the
+  // worker threads and the calling thread. Returns when all channels are
+  // processed.
+  void Run(size_t num_channels, rtc::FunctionView<void(size_t)> process);
+
+ private:
+  struct Worker;
+
+  static void ThreadMain(void* context);
+  // Returns false if the pool is shutting down.
+  bool RunWorker();
+  void ProcessChannels();
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  rtc::Event done_;
+  rtc::CriticalSection crit_;
+  bool quit_ RTC_GUARDED_BY(crit_) = false;
+  rtc::FunctionView<void(size_t)>* process_ RTC_GUARDED_BY(crit_) = nullptr;
+  size_t num_channels_ RTC_GUARDED_BY(crit_) = 0;
+  size_t next_channel_ RTC_GUARDED_BY(crit_) = 0;
+  int num_busy_workers_ RTC_GUARDED_BY(crit_) = 0;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(ChannelThreadPool);
+};
+
+// Calls |process| for each channel in [0, |num_channels|). Without a
+// |thread_pool| the channels are processed in order on the calling thread.
+void ForEachChannel(ChannelThreadPool* thread_pool,
+                    size_t num_channels,
+                    rtc::FunctionView<void(size_t)> process);
+
+}  // namespace webrtc
+
+#endif  // MODULES_AUDIO_PROCESSING_UTILITY_CHANNEL_THREAD_POOL_H_
@@ -0,0 +1,41 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/audio_processing/utility/channel_thread_pool.h"
+
+#include <vector>
+
+#include "test/gtest.h"
+
+namespace webrtc {
+
+TEST(ChannelThreadPool, ProcessesEachChannelOnce) {
+  for (int num_threads : {1, 2, 4}) {
+    ChannelThreadPool thread_pool(num_threads);
+    EXPECT_EQ(num_threads, thread_pool.num_threads());
+    for (size_t num_channels : {0, 1, 3, 16}) {
+      // Every call writes its own element, so no locking is needed.
+      std::vector<int> num_calls(num_channels, 0);
+      for (int k = 0; k < 10; ++k) {
+        thread_pool.Run(num_channels, [&](size_t ch) { ++num_calls[ch]; });
+      }
+      for (int calls : num_calls)
+        EXPECT_EQ(10, calls);
+    }
+  }
+}
+
+TEST(ChannelThreadPool, ProcessesChannelsInOrderWithoutPool) {
+  std::vector<size_t> channels;
+  ForEachChannel(nullptr, 4, [&](size_t ch) { channels.push_back(ch); });
+  EXPECT_EQ(std::vector<size_t>({0, 1, 2, 3}), channels);
+}
+
+}  // namespace webrtc
@@ -13,18 +13,35 @@
 #include <stdint.h>
 #include <string.h>
 
+#include <algorithm>
+#include <string>
 #include <utility>
+#include <vector>
 
+#include "absl/memory/memory.h"
+#include "api/function_view.h"
 #include "modules/desktop_capture/desktop_geometry.h"
 #include "modules/desktop_capture/desktop_region.h"
 #include "modules/desktop_capture/differ_block.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/thread_annotations.h"
 #include "rtc_base/time_utils.h"
+#include "system_wrappers/include/cpu_info.h"
 
 namespace webrtc {
 
 namespace {
 
+// Frames are compared on at most this many threads by default, as the
+// comparison is bound by memory bandwidth rather than by the cores.
+constexpr int kDefaultMaxDiffThreads = 4;
+// Areas are only split into bands of at least this many pixels, smaller ones
+// are compared faster than a worker thread wakes up.
+constexpr int kMinBandPixels = 512 * 512;
+
 // Returns true if (0, 0) - (|width|, |height|) vector in |old_buffer| and
 // |new_buffer| are equal. |width| should be less than 32
 // (defined by kBlockSize), otherwise BlockDifference() should be used.
@@ -109,44 +126,187 @@ void CompareRow(const uint8_t* old_buffer,
   }
 }
 
-// Compares |rect| area in |old_frame| and |new_frame|, and outputs dirty
-// regions into |output|.
-void CompareFrames(const DesktopFrame& old_frame,
-                   const DesktopFrame& new_frame,
-                   DesktopRect rect,
-                   DesktopRegion* const output) {
+// Compares the block-rows in [|first_block_row|, |end_block_row|) of |rect| in
+// |old_frame| and |new_frame|, and outputs dirty regions into |output|.
+void CompareBlockRows(const DesktopFrame& old_frame,
+                      const DesktopFrame& new_frame,
+                      const DesktopRect& rect,
+                      int first_block_row,
+                      int end_block_row,
+                      DesktopRegion* const output) {
+  for (int y = first_block_row; y < end_block_row; y++) {
+    const int top = rect.top() + y * kBlockSize;
+    // The last row may have a different height.
+    const int bottom = std::min(top + kBlockSize, rect.bottom());
+    const DesktopVector top_left(rect.left(), top);
+    CompareRow(old_frame.GetFrameDataAtPos(top_left),
+               new_frame.GetFrameDataAtPos(top_left), rect.left(),
+               rect.right(), top, bottom, old_frame.stride(), output);
+  }
+}
+
+int NumBlockRows(const DesktopRect& rect) {
+  return (rect.height() + kBlockSize - 1) / kBlockSize;
+}
+
+// Returns the number of bands to split |rect| into, so that each band is
+// large enough to be worth a thread.
+int NumBands(const DesktopRect& rect, int max_bands) {
+  const int64_t num_pixels = static_cast<int64_t>(rect.width()) * rect.height();
+  return static_cast<int>(
+      std::min<int64_t>({max_bands, NumBlockRows(rect),
+                         std::max<int64_t>(1, num_pixels / kMinBandPixels)}));
+}
+
+}  // namespace
+
+class DesktopCapturerDifferWrapper::DiffThreadPool {
+ public:
+  explicit DiffThreadPool(int num_threads) {
+    RTC_DCHECK_GT(num_threads, 0);
+    for (int i = 0; i < num_threads; ++i) {
+      workers_.push_back(absl::make_unique<Worker>());
+      Worker* worker = workers_.back().get();
+      worker->pool = this;
+      worker->thread = absl::make_unique<rtc::PlatformThread>(
+          &DiffThreadPool::ThreadMain, worker,
+          "DesktopDiffer" + std::to_string(i));
+      worker->thread->Start();
+    }
+  }
+
+  ~DiffThreadPool() {
+    {
+      rtc::CritScope lock(&crit_);
+      quit_ = true;
+    }
+    for (auto& worker : workers_) {
+      worker->start.Set();
+      worker->thread->Stop();
+    }
+  }
+
+  int num_threads() const { return static_cast<int>(workers_.size()); }
+
+  // Calls |compare_band| for each band in [0, |num_bands|), on the worker
+  // threads and the calling thread. Returns when all bands are compared.
+  void Run(int num_bands, rtc::FunctionView<void(int)> compare_band) {
+    {
+      rtc::CritScope lock(&crit_);
+      compare_band_ = &compare_band;
+      num_bands_ = num_bands;
+      next_band_ = 0;
+      num_busy_workers_ = num_threads();
+    }
+    for (auto& worker : workers_)
+      worker->start.Set();
+    CompareBands();
+    // Wait for all workers, not only all bands, so that no worker looks at
+    // |compare_band_| after it goes out of scope.
+    done_.Wait(rtc::Event::kForever);
+  }
+
+ private:
+  struct Worker {
+    DiffThreadPool* pool = nullptr;
+    rtc::Event start;
+    std::unique_ptr<rtc::PlatformThread> thread;
+  };
+
+  static void ThreadMain(void* context) {
+    Worker* worker = static_cast<Worker*>(context);
+    while (true) {
+      worker->start.Wait(rtc::Event::kForever);
+      if (!worker->pool->RunWorker())
+        return;
+    }
+  }
+
+  // Returns false if the pool is shutting down.
+  bool RunWorker() {
+    {
+      rtc::CritScope lock(&crit_);
+      if (quit_)
+        return false;
+    }
+    CompareBands();
+    rtc::CritScope lock(&crit_);
+    if (--num_busy_workers_ == 0)
+      done_.Set();
+    return true;
+  }
+
+  void CompareBands() {
+    while (true) {
+      rtc::FunctionView<void(int)>* compare_band;
+      int band;
+      {
+        rtc::CritScope lock(&crit_);
+        if (next_band_ >= num_bands_)
+          return;
+        compare_band = compare_band_;
+        band = next_band_++;
+      }
+      (*compare_band)(band);
+    }
+  }
+
+  std::vector<std::unique_ptr<Worker>> workers_;
+  rtc::Event done_;
+  rtc::CriticalSection crit_;
+  bool quit_ RTC_GUARDED_BY(crit_) = false;
+  rtc::FunctionView<void(int)>* compare_band_ RTC_GUARDED_BY(crit_) = nullptr;
+  int num_bands_ RTC_GUARDED_BY(crit_) = 0;
+  int next_band_ RTC_GUARDED_BY(crit_) = 0;
+  int num_busy_workers_ RTC_GUARDED_BY(crit_) = 0;
+};
+
+void DesktopCapturerDifferWrapper::CompareFrames(
+    const DesktopFrame& old_frame,
+    const DesktopFrame& new_frame,
+    DesktopRect rect,
+    DesktopRegion* const output) {
   RTC_DCHECK(old_frame.size().equals(new_frame.size()));
   RTC_DCHECK_EQ(old_frame.stride(), new_frame.stride());
   rect.IntersectWith(DesktopRect::MakeSize(old_frame.size()));
+  if (rect.is_empty())
+    return;
 
-  const int y_block_count = (rect.height() - 1) / kBlockSize;
-  const int last_y_block_height = rect.height() - y_block_count * kBlockSize;
-  // Offset from the start of one block-row to the next.
-  const int block_y_stride = old_frame.stride() * kBlockSize;
-  const uint8_t* prev_block_row_start =
-      old_frame.GetFrameDataAtPos(rect.top_left());
-  const uint8_t* curr_block_row_start =
-      new_frame.GetFrameDataAtPos(rect.top_left());
-
-  int top = rect.top();
-  // The last row may have a different height, so we handle it separately.
-  for (int y = 0; y < y_block_count; y++) {
-    CompareRow(prev_block_row_start, curr_block_row_start, rect.left(),
-               rect.right(), top, top + kBlockSize, old_frame.stride(), output);
-    top += kBlockSize;
-    prev_block_row_start += block_y_stride;
-    curr_block_row_start += block_y_stride;
-  }
-  CompareRow(prev_block_row_start, curr_block_row_start, rect.left(),
-             rect.right(), top, top + last_y_block_height, old_frame.stride(),
-             output);
-}
+  const int num_block_rows = NumBlockRows(rect);
+  const int num_bands = NumBands(rect, max_diff_threads_);
+  if (num_bands <= 1) {
+    CompareBlockRows(old_frame, new_frame, rect, 0, num_block_rows, output);
+    return;
+  }
 
-}  // namespace
+  if (!diff_thread_pool_) {
+    diff_thread_pool_ =
+        absl::make_unique<DiffThreadPool>(max_diff_threads_ - 1);
+  }
+  // Each band outputs into its own region, the regions are merged after.
+  std::vector<DesktopRegion> band_regions(num_bands);
+  diff_thread_pool_->Run(num_bands, [&](int band) {
+    CompareBlockRows(old_frame, new_frame, rect,
+                     num_block_rows * band / num_bands,
+                     num_block_rows * (band + 1) / num_bands,
+                     &band_regions[band]);
+  });
+  for (const DesktopRegion& region : band_regions)
+    output->AddRegion(region);
+}
 
 DesktopCapturerDifferWrapper::DesktopCapturerDifferWrapper(
     std::unique_ptr<DesktopCapturer> base_capturer)
-    : base_capturer_(std::move(base_capturer)) {
+    : DesktopCapturerDifferWrapper(
+          std::move(base_capturer),
+          std::min(kDefaultMaxDiffThreads,
+                   static_cast<int>(CpuInfo::DetectNumberOfCores()))) {}
+
+DesktopCapturerDifferWrapper::DesktopCapturerDifferWrapper(
+    std::unique_ptr<DesktopCapturer> base_capturer,
+    int max_diff_threads)
+    : base_capturer_(std::move(base_capturer)),
+      max_diff_threads_(std::max(1, max_diff_threads)) {
   RTC_DCHECK(base_capturer_);
 }
 
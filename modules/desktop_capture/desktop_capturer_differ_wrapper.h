@@ -17,6 +17,7 @@
 #include "modules/desktop_capture/desktop_capturer.h"
 #include "modules/desktop_capture/desktop_frame.h"
 #include "modules/desktop_capture/desktop_geometry.h"
+#include "modules/desktop_capture/desktop_region.h"
 #include "modules/desktop_capture/shared_desktop_frame.h"
 #include "modules/desktop_capture/shared_memory.h"
 
@@ -30,6 +31,9 @@ namespace webrtc {
 //
 // This class marks entire frame as updated if the frame size or frame stride
 // has been changed.
+//
+// Large updated areas, e.g. full 4K frames, are split into bands of rows that
+// are compared on a few worker threads, next to the capture thread.
 class DesktopCapturerDifferWrapper : public DesktopCapturer,
                                      public DesktopCapturer::Callback {
  public:
@@ -38,6 +42,12 @@ class DesktopCapturerDifferWrapper : public DesktopCapturer,
   explicit DesktopCapturerDifferWrapper(
       std::unique_ptr<DesktopCapturer> base_capturer);
 
+  // As above, but compares frames on at most |max_diff_threads| threads,
+  // including the capture thread. 1 compares all frames on the capture
+  // thread.
+  DesktopCapturerDifferWrapper(std::unique_ptr<DesktopCapturer> base_capturer,
+                               int max_diff_threads);
+
   ~DesktopCapturerDifferWrapper() override;
 
   // DesktopCapturer interface.
@@ -56,9 +66,22 @@ class DesktopCapturerDifferWrapper : public DesktopCapturer,
   void OnCaptureResult(Result result,
                        std::unique_ptr<DesktopFrame> frame) override;
 
+  // Compares bands of a frame on worker threads.
+  class DiffThreadPool;
+
+  // Compares |rect| area in |old_frame| and |new_frame|, and outputs dirty
+  // regions into |output|.
+  void CompareFrames(const DesktopFrame& old_frame,
+                     const DesktopFrame& new_frame,
+                     DesktopRect rect,
+                     DesktopRegion* output);
+
   const std::unique_ptr<DesktopCapturer> base_capturer_;
+  const int max_diff_threads_;
   DesktopCapturer::Callback* callback_;
   std::unique_ptr<SharedDesktopFrame> last_frame_;
+  // Created on the first frame large enough to be split into bands.
+  std::unique_ptr<DiffThreadPool> diff_thread_pool_;
 };
 
 }  // namespace webrtc
@@ -10,8 +10,11 @@
 
 #include "modules/desktop_capture/desktop_capturer_differ_wrapper.h"
 
+#include <string.h>
+
 #include <initializer_list>
 #include <memory>
+#include <string>
 #include <utility>
 #include <vector>
 
@@ -20,10 +23,12 @@
 #include "modules/desktop_capture/differ_block.h"
 #include "modules/desktop_capture/fake_desktop_capturer.h"
 #include "modules/desktop_capture/mock_desktop_capturer_callback.h"
+#include "modules/desktop_capture/shared_desktop_frame.h"
 #include "rtc_base/random.h"
 #include "rtc_base/time_utils.h"
 #include "system_wrappers/include/cpu_features_wrapper.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 
@@ -153,7 +158,8 @@ void ExecuteCapturer(DesktopCapturerDifferWrapper* capturer,
 void ExecuteDifferWrapperTest(bool with_hints,
                               bool enlarge_updated_region,
                               bool random_updated_region,
-                              bool check_result) {
+                              bool check_result,
+                              int max_diff_threads = 1) {
   const bool updated_region_should_exactly_match =
       with_hints && !enlarge_updated_region && !random_updated_region;
   BlackWhiteDesktopFramePainter frame_painter;
@@ -161,7 +167,7 @@ void ExecuteDifferWrapperTest(bool with_hints,
   frame_generator.set_desktop_frame_painter(&frame_painter);
   std::unique_ptr<FakeDesktopCapturer> fake(new FakeDesktopCapturer());
   fake->set_frame_generator(&frame_generator);
-  DesktopCapturerDifferWrapper capturer(std::move(fake));
+  DesktopCapturerDifferWrapper capturer(std::move(fake), max_diff_threads);
   MockDesktopCapturerCallback callback;
   frame_generator.set_provide_updated_region_hints(with_hints);
   frame_generator.set_enlarge_updated_region(enlarge_updated_region);
@@ -222,6 +228,61 @@ void ExecuteDifferWrapperTest(bool with_hints,
   }
 }
 
+// Returns two frames in turn, which only differ in their last pixel, so that
+// all blocks are compared.
+class AlternatingFrameGenerator : public DesktopFrameGenerator {
+ public:
+  explicit AlternatingFrameGenerator(DesktopSize size) {
+    for (auto& frame : frames_) {
+      frame = SharedDesktopFrame::Wrap(
+          std::unique_ptr<DesktopFrame>(new BasicDesktopFrame(size)));
+      memset(frame->data(), 0, frame->stride() * size.height());
+    }
+    frames_[1]->data()[frames_[1]->stride() * size.height() - 1] = 0xff;
+  }
+
+  std::unique_ptr<DesktopFrame> GetNextFrame(
+      SharedMemoryFactory* factory) override {
+    std::unique_ptr<DesktopFrame> frame = frames_[next_frame_]->Share();
+    next_frame_ = 1 - next_frame_;
+    frame->mutable_updated_region()->SetRect(
+        DesktopRect::MakeSize(frame->size()));
+    return frame;
+  }
+
+ private:
+  std::unique_ptr<SharedDesktopFrame> frames_[2];
+  int next_frame_ = 0;
+};
+
+void RunFrameDifferencePerf(const std::string& resolution,
+                            DesktopSize size,
+                            int max_diff_threads) {
+  constexpr int kNumFrames = 100;
+  AlternatingFrameGenerator frame_generator(size);
+  std::unique_ptr<FakeDesktopCapturer> fake(new FakeDesktopCapturer());
+  fake->set_frame_generator(&frame_generator);
+  DesktopCapturerDifferWrapper capturer(std::move(fake), max_diff_threads);
+  MockDesktopCapturerCallback callback;
+  EXPECT_CALL(callback, OnCaptureResultPtr(DesktopCapturer::Result::SUCCESS,
+                                           ::testing::_))
+      .Times(kNumFrames + 1);
+  capturer.Start(&callback);
+  // The first frame is not compared.
+  capturer.CaptureFrame();
+
+  const int64_t start_time_nanos = rtc::TimeNanos();
+  for (int i = 0; i < kNumFrames; ++i)
+    capturer.CaptureFrame();
+  const int64_t elapsed_nanos = rtc::TimeNanos() - start_time_nanos;
+  webrtc::test::PrintResult(
+      "frame_difference_time", "_" + resolution,
+      std::to_string(max_diff_threads) + "_threads",
+      static_cast<double>(elapsed_nanos) / rtc::kNumNanosecsPerMicrosec /
+          kNumFrames,
+      "us", false);
+}
+
 }  // namespace
 
 TEST(DesktopCapturerDifferWrapperTest, CaptureWithoutHints) {
@@ -244,6 +305,42 @@ TEST(DesktopCapturerDifferWrapperTest, CaptureWithEnlargedAndRandomHints) {
   ExecuteDifferWrapperTest(true, true, true, true);
 }
 
+TEST(DesktopCapturerDifferWrapperTest, CaptureWithoutHintsOnManyThreads) {
+  ExecuteDifferWrapperTest(false, false, false, true, 4);
+}
+
+TEST(DesktopCapturerDifferWrapperTest,
+     CaptureWithEnlargedAndRandomHintsOnManyThreads) {
+  ExecuteDifferWrapperTest(true, true, true, true, 4);
+}
+
+TEST(DesktopCapturerDifferWrapperTest, Capture4KFrameOnManyThreads) {
+  Random random(rtc::TimeMillis());
+  const DesktopSize size(3840, 2160);
+  for (int threads : {1, 2, 4}) {
+    BlackWhiteDesktopFramePainter frame_painter;
+    PainterDesktopFrameGenerator frame_generator;
+    frame_generator.set_desktop_frame_painter(&frame_painter);
+    frame_generator.size()->set(size.width(), size.height());
+    std::unique_ptr<FakeDesktopCapturer> fake(new FakeDesktopCapturer());
+    fake->set_frame_generator(&frame_generator);
+    DesktopCapturerDifferWrapper capturer(std::move(fake), threads);
+    MockDesktopCapturerCallback callback;
+    capturer.Start(&callback);
+    ExecuteCapturer(&capturer, &callback);
+    std::vector<DesktopRect> updated_region;
+    for (int i = 0; i < 20; i++) {
+      const int left = random.Rand(0, size.width() - 2);
+      const int top = random.Rand(0, size.height() - 2);
+      updated_region.push_back(DesktopRect::MakeLTRB(
+          left, top, random.Rand(left + 1, size.width()),
+          random.Rand(top + 1, size.height())));
+    }
+    ExecuteDifferWrapperCase(&frame_painter, &capturer, &callback,
+                             updated_region, true, false);
+  }
+}
+
 // When hints are provided, DesktopCapturerDifferWrapper has a slightly better
 // performance in current configuration, but not so significant. Following is
 // one run result.
@@ -288,4 +385,12 @@ TEST(DesktopCapturerDifferWrapperTest,
   ASSERT_LE(rtc::TimeMillis() - started, 15000);
 }
 
+TEST(DesktopCapturerDifferWrapperTest, DISABLED_FrameDifferencePerf) {
+  for (int threads : {1, 2, 4}) {
+    RunFrameDifferencePerf("1080p", DesktopSize(1920, 1080), threads);
+    RunFrameDifferencePerf("4K", DesktopSize(3840, 2160), threads);
+    RunFrameDifferencePerf("5K", DesktopSize(5120, 2880), threads);
+  }
+}
+
 }  // namespace webrtc
@@ -0,0 +1,135 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/desktop_capture/desktop_frame_i420_converter.h"
+
+#include <algorithm>
+
+#include "modules/desktop_capture/desktop_geometry.h"
+#include "modules/desktop_capture/desktop_region.h"
+#include "third_party/libyuv/include/libyuv/convert.h"
+#include "third_party/libyuv/include/libyuv/planar_functions.h"
+
+namespace webrtc {
+
+namespace {
+
+// Extends |rect| to even coordinates, so that it covers whole 2x2 blocks of
+// chroma samples, within a frame of |size|.
+DesktopRect AlignToChroma(const DesktopRect& rect, const DesktopSize& size) {
+  return DesktopRect::MakeLTRB(
+      rect.left() & ~1, rect.top() & ~1,
+      std::min(size.width(), (rect.right() + 1) & ~1),
+      std::min(size.height(), (rect.bottom() + 1) & ~1));
+}
+
+void ConvertRect(const DesktopFrame& frame,
+                 const DesktopRect& rect,
+                 I420Buffer* buffer) {
+  // DesktopFrame is BGRA in memory, which libyuv calls ARGB.
+  libyuv::ARGBToI420(
+      frame.GetFrameDataAtPos(rect.top_left()), frame.stride(),
+      buffer->MutableDataY() + rect.top() * buffer->StrideY() + rect.left(),
+      buffer->StrideY(),
+      buffer->MutableDataU() + rect.top() / 2 * buffer->StrideU() +
+          rect.left() / 2,
+      buffer->StrideU(),
+      buffer->MutableDataV() + rect.top() / 2 * buffer->StrideV() +
+          rect.left() / 2,
+      buffer->StrideV(), rect.width(), rect.height());
+}
+
+}  // namespace
+
+constexpr int DesktopFrameI420Converter::kDefaultMaxStaticFrames;
+
+DesktopFrameI420Converter::DesktopFrameI420Converter()
+    : DesktopFrameI420Converter(kDefaultMaxStaticFrames) {}
+
+DesktopFrameI420Converter::DesktopFrameI420Converter(int max_static_frames)
+    : max_static_frames_(max_static_frames) {}
+
+DesktopFrameI420Converter::~DesktopFrameI420Converter() = default;
+
+absl::optional<VideoFrame> DesktopFrameI420Converter::Convert(
+    const DesktopFrame& frame,
+    int64_t timestamp_us) {
+  const DesktopSize& size = frame.size();
+  const DesktopRect frame_rect = DesktopRect::MakeSize(size);
+  DesktopRegion region;
+  if (!buffer_ || buffer_->width() != size.width() ||
+      buffer_->height() != size.height()) {
+    buffer_ = new rtc::RefCountedObject<I420Buffer>(size.width(),
+                                                    size.height());
+    region.SetRect(frame_rect);
+  } else {
+    region = frame.updated_region();
+    region.IntersectWith(frame_rect);
+  }
+
+  if (region.is_empty()) {
+    if (num_static_frames_ >= max_static_frames_)
+      return absl::nullopt;
+    ++num_static_frames_;
+  } else {
+    num_static_frames_ = 0;
+  }
+
+  // Bounding box of the converted area.
+  DesktopRect bounds;
+  if (!region.is_empty()) {
+    buffer_ = GetWritableBuffer();
+    for (DesktopRegion::Iterator it(region); !it.IsAtEnd(); it.Advance()) {
+      const DesktopRect rect = AlignToChroma(it.rect(), size);
+      ConvertRect(frame, rect, buffer_);
+      if (bounds.is_empty()) {
+        bounds = rect;
+      } else {
+        bounds = DesktopRect::MakeLTRB(std::min(bounds.left(), rect.left()),
+                                       std::min(bounds.top(), rect.top()),
+                                       std::max(bounds.right(), rect.right()),
+                                       std::max(bounds.bottom(),
+                                                rect.bottom()));
+      }
+    }
+  }
+
+  return VideoFrame::Builder()
+      .set_video_frame_buffer(buffer_)
+      .set_timestamp_us(timestamp_us)
+      .set_update_rect(VideoFrame::UpdateRect{bounds.left(), bounds.top(),
+                                              bounds.width(), bounds.height()})
+      .build();
+}
+
+void DesktopFrameI420Converter::Reset() {
+  buffer_ = nullptr;
+  num_static_frames_ = 0;
+}
+
+rtc::scoped_refptr<rtc::RefCountedObject<I420Buffer>>
+DesktopFrameI420Converter::GetWritableBuffer() {
+  if (buffer_->HasOneRef())
+    return buffer_;
+  // The last frame is still referenced, e.g. queued for encoding, so the
+  // unchanged area is copied into a new buffer.
+  rtc::scoped_refptr<rtc::RefCountedObject<I420Buffer>> buffer(
+      new rtc::RefCountedObject<I420Buffer>(buffer_->width(),
+                                            buffer_->height()));
+  libyuv::I420Copy(buffer_->DataY(), buffer_->StrideY(), buffer_->DataU(),
+                   buffer_->StrideU(), buffer_->DataV(), buffer_->StrideV(),
+                   buffer->MutableDataY(), buffer->StrideY(),
+                   buffer->MutableDataU(), buffer->StrideU(),
+                   buffer->MutableDataV(), buffer->StrideV(), buffer->width(),
+                   buffer->height());
+  return buffer;
+}
+
+}  // namespace webrtc
@@ -0,0 +1,69 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_DESKTOP_CAPTURE_DESKTOP_FRAME_I420_CONVERTER_H_
+#define MODULES_DESKTOP_CAPTURE_DESKTOP_FRAME_I420_CONVERTER_H_
+
+#include <stdint.h>
+
+#include "absl/types/optional.h"
+#include "api/scoped_refptr.h"
+#include "api/video/i420_buffer.h"
+#include "api/video/video_frame.h"
+#include "modules/desktop_capture/desktop_frame.h"
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/ref_counted_object.h"
+
+namespace webrtc {
+
+// Converts captured DesktopFrames into I420 VideoFrames for encoding.
+//
+// The converter keeps the last converted I420 buffer and only converts the
+// updated_region() of each frame into it, so the cost of the conversion
+// follows the amount of changed content. The bounding box of the updated
+// region becomes VideoFrame::update_rect(), which the encoders use to detect
+// static content. Frames without any change are dropped after
+// |max_static_frames| of them, which lets the encoder refine the quality of
+// the last change first.
+//
+// The frames must come with an accurate updated_region(), e.g. from
+// DesktopCapturerDifferWrapper.
+class DesktopFrameI420Converter {
+ public:
+  static constexpr int kDefaultMaxStaticFrames = 5;
+
+  DesktopFrameI420Converter();
+  explicit DesktopFrameI420Converter(int max_static_frames);
+  ~DesktopFrameI420Converter();
+
+  // Converts |frame| into a VideoFrame with |timestamp_us|. Returns
+  // absl::nullopt if the frame is static and should not be encoded.
+  absl::optional<VideoFrame> Convert(const DesktopFrame& frame,
+                                     int64_t timestamp_us);
+
+  // Makes the next frame be converted in full.
+  void Reset();
+
+ private:
+  // Returns a buffer holding the last converted frame that can be written.
+  rtc::scoped_refptr<rtc::RefCountedObject<I420Buffer>> GetWritableBuffer();
+
+  const int max_static_frames_;
+  int num_static_frames_ = 0;
+  // The last converted frame. Updated in place when not referenced
+  // elsewhere, e.g. by the encoder, otherwise copied first.
+  rtc::scoped_refptr<rtc::RefCountedObject<I420Buffer>> buffer_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(DesktopFrameI420Converter);
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_DESKTOP_CAPTURE_DESKTOP_FRAME_I420_CONVERTER_H_
@@ -0,0 +1,234 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/desktop_capture/desktop_frame_i420_converter.h"
+
+#include <stdint.h>
+#include <string.h>
+
+#include "api/video/i420_buffer.h"
+#include "rtc_base/random.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+
+namespace {
+
+// Paints |rect| of |frame| with random pixels.
+void PaintRect(const DesktopRect& rect, Random* random, DesktopFrame* frame) {
+  for (int y = rect.top(); y < rect.bottom(); ++y) {
+    uint8_t* row = frame->GetFrameDataAtPos(DesktopVector(rect.left(), y));
+    for (int x = 0; x < rect.width() * DesktopFrame::kBytesPerPixel; ++x)
+      row[x] = random->Rand<uint8_t>();
+  }
+}
+
+bool PlaneEquals(const uint8_t* left,
+                 int left_stride,
+                 const uint8_t* right,
+                 int right_stride,
+                 int width,
+                 int height) {
+  for (int y = 0; y < height; ++y) {
+    if (memcmp(left + y * left_stride, right + y * right_stride, width) != 0)
+      return false;
+  }
+  return true;
+}
+
+bool BufferEquals(const I420BufferInterface& left,
+                  const I420BufferInterface& right) {
+  return left.width() == right.width() && left.height() == right.height() &&
+         PlaneEquals(left.DataY(), left.StrideY(), right.DataY(),
+                     right.StrideY(), left.width(), left.height()) &&
+         PlaneEquals(left.DataU(), left.StrideU(), right.DataU(),
+                     right.StrideU(), left.ChromaWidth(),
+                     left.ChromaHeight()) &&
+         PlaneEquals(left.DataV(), left.StrideV(), right.DataV(),
+                     right.StrideV(), left.ChromaWidth(), left.ChromaHeight());
+}
+
+// Returns |frame| converted in full by a new converter.
+rtc::scoped_refptr<I420BufferInterface> ConvertInFull(
+    const DesktopFrame& frame) {
+  DesktopFrameI420Converter converter;
+  return converter.Convert(frame, 0)->video_frame_buffer()->ToI420();
+}
+
+void ExpectUpdateRect(const DesktopRect& expected, const VideoFrame& frame) {
+  EXPECT_EQ(expected.left(), frame.update_rect().offset_x);
+  EXPECT_EQ(expected.top(), frame.update_rect().offset_y);
+  EXPECT_EQ(expected.width(), frame.update_rect().width);
+  EXPECT_EQ(expected.height(), frame.update_rect().height);
+}
+
+}  // namespace
+
+class DesktopFrameI420ConverterTest : public ::testing::Test {
+ protected:
+  DesktopFrameI420ConverterTest()
+      : random_(1234), frame_(DesktopSize(64, 48)) {
+    PaintRect(DesktopRect::MakeSize(frame_.size()), &random_, &frame_);
+  }
+
+  // Paints |rect| of |frame_| and marks it as updated.
+  void UpdateRect(const DesktopRect& rect) {
+    PaintRect(rect, &random_, &frame_);
+    frame_.mutable_updated_region()->AddRect(rect);
+  }
+
+  Random random_;
+  BasicDesktopFrame frame_;
+};
+
+TEST_F(DesktopFrameI420ConverterTest, ConvertsFirstFrameInFull) {
+  DesktopFrameI420Converter converter;
+  absl::optional<VideoFrame> video_frame = converter.Convert(frame_, 1000);
+  ASSERT_TRUE(video_frame);
+  EXPECT_EQ(1000, video_frame->timestamp_us());
+  EXPECT_EQ(64, video_frame->width());
+  EXPECT_EQ(48, video_frame->height());
+  ExpectUpdateRect(DesktopRect::MakeSize(frame_.size()), *video_frame);
+}
+
+TEST_F(DesktopFrameI420ConverterTest, ConvertsOnlyUpdatedRegion) {
+  DesktopFrameI420Converter converter;
+  converter.Convert(frame_, 0);
+
+  frame_.mutable_updated_region()->Clear();
+  UpdateRect(DesktopRect::MakeXYWH(3, 5, 10, 7));
+  UpdateRect(DesktopRect::MakeXYWH(40, 30, 8, 8));
+  absl::optional<VideoFrame> video_frame = converter.Convert(frame_, 0);
+  ASSERT_TRUE(video_frame);
+  // The bounding box of the region, extended to whole chroma samples.
+  ExpectUpdateRect(DesktopRect::MakeLTRB(2, 4, 48, 38), *video_frame);
+  EXPECT_TRUE(BufferEquals(*ConvertInFull(frame_),
+                           *video_frame->video_frame_buffer()->ToI420()));
+}
+
+TEST_F(DesktopFrameI420ConverterTest, IgnoresUpdatesOutsideOfFrame) {
+  DesktopFrameI420Converter converter;
+  converter.Convert(frame_, 0);
+
+  frame_.mutable_updated_region()->SetRect(
+      DesktopRect::MakeXYWH(60, 40, 100, 100));
+  absl::optional<VideoFrame> video_frame = converter.Convert(frame_, 0);
+  ASSERT_TRUE(video_frame);
+  ExpectUpdateRect(DesktopRect::MakeLTRB(60, 40, 64, 48), *video_frame);
+}
+
+TEST_F(DesktopFrameI420ConverterTest, DropsStaticFramesAfterRefinement) {
+  DesktopFrameI420Converter converter(2);
+  converter.Convert(frame_, 0);
+
+  frame_.mutable_updated_region()->Clear();
+  for (int i = 0; i < 2; ++i) {
+    absl::optional<VideoFrame> video_frame = converter.Convert(frame_, 0);
+    ASSERT_TRUE(video_frame);
+    EXPECT_TRUE(video_frame->update_rect().IsEmpty());
+  }
+  EXPECT_FALSE(converter.Convert(frame_, 0));
+  EXPECT_FALSE(converter.Convert(frame_, 0));
+
+  UpdateRect(DesktopRect::MakeXYWH(0, 0, 2, 2));
+  EXPECT_TRUE(converter.Convert(frame_, 0));
+  frame_.mutable_updated_region()->Clear();
+  EXPECT_TRUE(converter.Convert(frame_, 0));
+}
+
+TEST_F(DesktopFrameI420ConverterTest, DoesNotModifyBufferInUse) {
+  DesktopFrameI420Converter converter;
+  absl::optional<VideoFrame> first_frame = converter.Convert(frame_, 0);
+  rtc::scoped_refptr<I420BufferInterface> first_buffer =
+      ConvertInFull(frame_);
+
+  frame_.mutable_updated_region()->Clear();
+  UpdateRect(DesktopRect::MakeXYWH(10, 10, 20, 20));
+  absl::optional<VideoFrame> second_frame = converter.Convert(frame_, 0);
+  ASSERT_TRUE(second_frame);
+  EXPECT_NE(first_frame->video_frame_buffer(),
+            second_frame->video_frame_buffer());
+  EXPECT_TRUE(BufferEquals(*first_buffer,
+                           *first_frame->video_frame_buffer()->ToI420()));
+  EXPECT_TRUE(BufferEquals(*ConvertInFull(frame_),
+                           *second_frame->video_frame_buffer()->ToI420()));
+}
+
+TEST_F(DesktopFrameI420ConverterTest, ReusesReleasedBuffer) {
+  DesktopFrameI420Converter converter;
+  rtc::scoped_refptr<VideoFrameBuffer> first_buffer =
+      converter.Convert(frame_, 0)->video_frame_buffer();
+  const uint8_t* data = first_buffer->GetI420()->DataY();
+  first_buffer = nullptr;
+
+  frame_.mutable_updated_region()->Clear();
+  UpdateRect(DesktopRect::MakeXYWH(10, 10, 20, 20));
+  absl::optional<VideoFrame> video_frame = converter.Convert(frame_, 0);
+  ASSERT_TRUE(video_frame);
+  EXPECT_EQ(data, video_frame->video_frame_buffer()->GetI420()->DataY());
+}
+
+TEST_F(DesktopFrameI420ConverterTest, ConvertsInFullAfterSizeChange) {
+  DesktopFrameI420Converter converter;
+  converter.Convert(frame_, 0);
+
+  BasicDesktopFrame frame(DesktopSize(32, 32));
+  PaintRect(DesktopRect::MakeSize(frame.size()), &random_, &frame);
+  absl::optional<VideoFrame> video_frame = converter.Convert(frame, 0);
+  ASSERT_TRUE(video_frame);
+  ExpectUpdateRect(DesktopRect::MakeSize(frame.size()), *video_frame);
+  EXPECT_TRUE(BufferEquals(*ConvertInFull(frame),
+                           *video_frame->video_frame_buffer()->ToI420()));
+}
+
+TEST_F(DesktopFrameI420ConverterTest, ConvertsInFullAfterReset) {
+  DesktopFrameI420Converter converter;
+  converter.Convert(frame_, 0);
+  converter.Reset();
+
+  frame_.mutable_updated_region()->Clear();
+  absl::optional<VideoFrame> video_frame = converter.Convert(frame_, 0);
+  ASSERT_TRUE(video_frame);
+  ExpectUpdateRect(DesktopRect::MakeSize(frame_.size()), *video_frame);
+}
+
+// Measures the conversion of a 1080p frame with a typing sized update, a
+// scrolled window and a full screen update.
+TEST(DesktopFrameI420ConverterPerfTest, DISABLED_ConvertPerf) {
+  constexpr int kNumFrames = 200;
+  const struct {
+    const char* name;
+    DesktopRect rect;
+  } kUpdates[] = {
+      {"typing", DesktopRect::MakeXYWH(600, 400, 32, 24)},
+      {"scrolling", DesktopRect::MakeXYWH(400, 200, 1000, 700)},
+      {"full", DesktopRect::MakeWH(1920, 1080)},
+  };
+  Random random(1234);
+  BasicDesktopFrame frame(DesktopSize(1920, 1080));
+  PaintRect(DesktopRect::MakeSize(frame.size()), &random, &frame);
+  for (const auto& update : kUpdates) {
+    DesktopFrameI420Converter converter;
+    converter.Convert(frame, 0);
+    frame.mutable_updated_region()->SetRect(update.rect);
+    const int64_t start_ns = rtc::SystemTimeNanos();
+    for (int i = 0; i < kNumFrames; ++i) {
+      absl::optional<VideoFrame> video_frame = converter.Convert(frame, 0);
+    }
+    const int64_t elapsed_ns = rtc::SystemTimeNanos() - start_ns;
+    test::PrintResult("desktop_frame_i420_converter", "_1080p", update.name,
+                      static_cast<double>(elapsed_ns) / kNumFrames / 1000,
+                      "us", false);
+  }
+}
+
+}  // namespace webrtc
@@ -13,20 +13,49 @@
 #include <assert.h>
 
 #include <algorithm>
+#include <limits>
 #include <utility>
 
 namespace webrtc {
 
-DesktopRegion::RowSpan::RowSpan(int32_t left, int32_t right)
-    : left(left), right(right) {}
+namespace {
+
+// Above this number of rects AddRects() merges the rects in two halves, so
+// that each rect is added to a small region.
+constexpr int kMaxRectsToAddOneByOne = 16;
+
+// Replaces [begin, end) of |vector| with |values|, moving the elements after
+// |end| at most once.
+template <typename T>
+void ReplaceRange(size_t begin,
+                  size_t end,
+                  const std::vector<T>& values,
+                  std::vector<T>* vector) {
+  const size_t num_common = std::min(end - begin, values.size());
+  std::copy(values.begin(), values.begin() + num_common,
+            vector->begin() + begin);
+  if (values.size() > num_common) {
+    vector->insert(vector->begin() + end, values.begin() + num_common,
+                   values.end());
+  } else {
+    vector->erase(vector->begin() + begin + num_common,
+                  vector->begin() + end);
+  }
+}
 
-DesktopRegion::Row::Row(const Row&) = default;
-DesktopRegion::Row::Row(Row&&) = default;
+}  // namespace
 
-DesktopRegion::Row::Row(int32_t top, int32_t bottom)
-    : top(top), bottom(bottom) {}
+DesktopRegion::RowSpan::RowSpan(int32_t left, int32_t right)
+    : left(left), right(right) {}
 
-DesktopRegion::Row::~Row() {}
+DesktopRegion::Row::Row(int32_t top,
+                        int32_t bottom,
+                        size_t spans_begin,
+                        size_t spans_end)
+    : top(top),
+      bottom(bottom),
+      spans_begin(spans_begin),
+      spans_end(spans_end) {}
 
 DesktopRegion::DesktopRegion() {}
 
@@ -38,47 +67,32 @@ DesktopRegion::DesktopRegion(const DesktopRect* rects, int count) {
   AddRects(rects, count);
 }
 
-DesktopRegion::DesktopRegion(const DesktopRegion& other) {
-  *this = other;
-}
+DesktopRegion::DesktopRegion(const DesktopRegion& other) = default;
 
-DesktopRegion::~DesktopRegion() {
-  Clear();
-}
+DesktopRegion::~DesktopRegion() = default;
 
-DesktopRegion& DesktopRegion::operator=(const DesktopRegion& other) {
-  Clear();
-  rows_ = other.rows_;
-  for (Rows::iterator it = rows_.begin(); it != rows_.end(); ++it) {
-    // Copy each row.
-    Row* row = it->second;
-    it->second = new Row(*row);
-  }
-  return *this;
-}
+DesktopRegion& DesktopRegion::operator=(const DesktopRegion& other) = default;
 
 bool DesktopRegion::Equals(const DesktopRegion& region) const {
-  // Iterate over rows of the tow regions and compare each row.
-  Rows::const_iterator it1 = rows_.begin();
-  Rows::const_iterator it2 = region.rows_.begin();
-  while (it1 != rows_.end()) {
-    if (it2 == region.rows_.end() || it1->first != it2->first ||
-        it1->second->top != it2->second->top ||
-        it1->second->bottom != it2->second->bottom ||
-        it1->second->spans != it2->second->spans) {
+  // Rows and spans are stored in the same canonical form for equal regions,
+  // so the rows, including their span indices, and the spans are compared.
+  if (rows_.size() != region.rows_.size() ||
+      spans_.size() != region.spans_.size()) {
+    return false;
+  }
+  for (size_t i = 0; i < rows_.size(); ++i) {
+    if (rows_[i].top != region.rows_[i].top ||
+        rows_[i].bottom != region.rows_[i].bottom ||
+        rows_[i].spans_end != region.rows_[i].spans_end) {
       return false;
     }
-    ++it1;
-    ++it2;
   }
-  return it2 == region.rows_.end();
+  return spans_ == region.spans_;
 }
 
 void DesktopRegion::Clear() {
-  for (Rows::iterator row = rows_.begin(); row != rows_.end(); ++row) {
-    delete row->second;
-  }
   rows_.clear();
+  spans_.clear();
 }
 
 void DesktopRegion::SetRect(const DesktopRect& rect) {
@@ -90,421 +104,400 @@ void DesktopRegion::AddRect(const DesktopRect& rect) {
   if (rect.is_empty())
     return;
 
-  // Top of the part of the |rect| that hasn't been inserted yet. Increased as
-  // we iterate over the rows until it reaches |rect.bottom()|.
-  int top = rect.top();
-
-  // Iterate over all rows that may intersect with |rect| and add new rows when
-  // necessary.
-  Rows::iterator row = rows_.upper_bound(top);
-  while (top < rect.bottom()) {
-    if (row == rows_.end() || top < row->second->top) {
-      // If |top| is above the top of the current |row| then add a new row above
-      // the current one.
-      int32_t bottom = rect.bottom();
-      if (row != rows_.end() && row->second->top < bottom)
-        bottom = row->second->top;
-      row = rows_.insert(row, Rows::value_type(bottom, new Row(top, bottom)));
-    } else if (top > row->second->top) {
-      // If the |top| falls in the middle of the |row| then split |row| into
-      // two, at |top|, and leave |row| referring to the lower of the two,
-      // ready to insert a new span into.
-      assert(top <= row->second->bottom);
-      Rows::iterator new_row = rows_.insert(
-          row, Rows::value_type(top, new Row(row->second->top, top)));
-      row->second->top = top;
-      new_row->second->spans = row->second->spans;
-    }
-
-    if (rect.bottom() < row->second->bottom) {
-      // If the bottom of the |rect| falls in the middle of the |row| split
-      // |row| into two, at |top|, and leave |row| referring to the upper of
-      // the two, ready to insert a new span into.
-      Rows::iterator new_row = rows_.insert(
-          row, Rows::value_type(rect.bottom(), new Row(top, rect.bottom())));
-      row->second->top = rect.bottom();
-      new_row->second->spans = row->second->spans;
-      row = new_row;
-    }
-
-    // Add a new span to the current row.
-    AddSpanToRow(row->second, rect.left(), rect.right());
-    top = row->second->bottom;
-
-    MergeWithPrecedingRow(row);
-
-    // Move to the next row.
-    ++row;
+  // Rects are usually added from top to bottom and from left to right, e.g.
+  // by the differ, so they are appended to the last row when possible.
+  if (rows_.empty() || rect.top() >= rows_.back().bottom) {
+    rows_.push_back(
+        Row(rect.top(), rect.bottom(), spans_.size(), spans_.size() + 1));
+    spans_.push_back(RowSpan(rect.left(), rect.right()));
+    MergeWithPrecedingRow(rows_.size() - 1);
+    return;
+  }
+  Row& last_row = rows_.back();
+  if (rect.top() == last_row.top && rect.bottom() == last_row.bottom &&
+      rect.left() > spans_.back().right) {
+    spans_.push_back(RowSpan(rect.left(), rect.right()));
+    ++last_row.spans_end;
+    MergeWithPrecedingRow(rows_.size() - 1);
+    return;
   }
 
-  if (row != rows_.end())
-    MergeWithPrecedingRow(row);
+  const Row row(rect.top(), rect.bottom(), 0, 1);
+  const RowSpan span(rect.left(), rect.right());
+  Combine(RowRange{&row, 1, &span}, Operation::kUnion);
 }
 
 void DesktopRegion::AddRects(const DesktopRect* rects, int count) {
-  for (int i = 0; i < count; ++i) {
-    AddRect(rects[i]);
+  if (count <= kMaxRectsToAddOneByOne) {
+    for (int i = 0; i < count; ++i) {
+      AddRect(rects[i]);
+    }
+    return;
   }
+
+  const int half = count / 2;
+  DesktopRegion second_half(rects + half, count - half);
+  AddRects(rects, half);
+  AddRegion(second_half);
 }
 
-void DesktopRegion::MergeWithPrecedingRow(Rows::iterator row) {
-  assert(row != rows_.end());
+void DesktopRegion::MergeWithPrecedingRow(size_t row) {
+  assert(row < rows_.size());
+  if (row == 0)
+    return;
 
-  if (row != rows_.begin()) {
-    Rows::iterator previous_row = row;
-    previous_row--;
+  // If |row| and the preceding row are next to each other and contain the
+  // same set of spans then they can be merged.
+  Row& previous_row = rows_[row - 1];
+  const Row& current_row = rows_[row];
+  if (previous_row.bottom != current_row.top ||
+      previous_row.num_spans() != current_row.num_spans() ||
+      !std::equal(spans_.begin() + previous_row.spans_begin,
+                  spans_.begin() + previous_row.spans_end,
+                  spans_.begin() + current_row.spans_begin)) {
+    return;
+  }
 
-    // If |row| and |previous_row| are next to each other and contain the same
-    // set of spans then they can be merged.
-    if (previous_row->second->bottom == row->second->top &&
-        previous_row->second->spans == row->second->spans) {
-      row->second->top = previous_row->second->top;
-      delete previous_row->second;
-      rows_.erase(previous_row);
-    }
+  previous_row.bottom = current_row.bottom;
+  const size_t num_spans = current_row.num_spans();
+  spans_.erase(spans_.begin() + current_row.spans_begin,
+               spans_.begin() + current_row.spans_end);
+  rows_.erase(rows_.begin() + row);
+  for (size_t i = row; i < rows_.size(); ++i) {
+    rows_[i].spans_begin -= num_spans;
+    rows_[i].spans_end -= num_spans;
   }
 }
 
 void DesktopRegion::AddRegion(const DesktopRegion& region) {
-  // TODO(sergeyu): This function is not optimized - potentially it can iterate
-  // over rows of the two regions similar to how it works in Intersect().
-  for (Iterator it(region); !it.IsAtEnd(); it.Advance()) {
-    AddRect(it.rect());
+  if (region.is_empty())
+    return;
+  if (is_empty()) {
+    *this = region;
+    return;
   }
+  Combine(region.GetRowRange(0, region.rows_.size()), Operation::kUnion);
 }
 
 void DesktopRegion::Intersect(const DesktopRegion& region1,
                               const DesktopRegion& region2) {
   Clear();
-
-  Rows::const_iterator it1 = region1.rows_.begin();
-  Rows::const_iterator end1 = region1.rows_.end();
-  Rows::const_iterator it2 = region2.rows_.begin();
-  Rows::const_iterator end2 = region2.rows_.end();
-  if (it1 == end1 || it2 == end2)
-    return;
-
-  while (it1 != end1 && it2 != end2) {
-    // Arrange for |it1| to always be the top-most of the rows.
-    if (it2->second->top < it1->second->top) {
-      std::swap(it1, it2);
-      std::swap(end1, end2);
-    }
-
-    // Skip |it1| if it doesn't intersect |it2| at all.
-    if (it1->second->bottom <= it2->second->top) {
-      ++it1;
-      continue;
-    }
-
-    // Top of the |it1| row is above the top of |it2|, so top of the
-    // intersection is always the top of |it2|.
-    int32_t top = it2->second->top;
-    int32_t bottom = std::min(it1->second->bottom, it2->second->bottom);
-
-    Rows::iterator new_row = rows_.insert(
-        rows_.end(), Rows::value_type(bottom, new Row(top, bottom)));
-    IntersectRows(it1->second->spans, it2->second->spans,
-                  &new_row->second->spans);
-    if (new_row->second->spans.empty()) {
-      delete new_row->second;
-      rows_.erase(new_row);
-    } else {
-      MergeWithPrecedingRow(new_row);
-    }
-
-    // If |it1| was completely consumed, move to the next one.
-    if (it1->second->bottom == bottom)
-      ++it1;
-    // If |it2| was completely consumed, move to the next one.
-    if (it2->second->bottom == bottom)
-      ++it2;
-  }
-}
-
-// static
-void DesktopRegion::IntersectRows(const RowSpanSet& set1,
-                                  const RowSpanSet& set2,
-                                  RowSpanSet* output) {
-  RowSpanSet::const_iterator it1 = set1.begin();
-  RowSpanSet::const_iterator end1 = set1.end();
-  RowSpanSet::const_iterator it2 = set2.begin();
-  RowSpanSet::const_iterator end2 = set2.end();
-  assert(it1 != end1 && it2 != end2);
-
-  do {
-    // Arrange for |it1| to always be the left-most of the spans.
-    if (it2->left < it1->left) {
-      std::swap(it1, it2);
-      std::swap(end1, end2);
-    }
-
-    // Skip |it1| if it doesn't intersect |it2| at all.
-    if (it1->right <= it2->left) {
-      ++it1;
-      continue;
-    }
-
-    int32_t left = it2->left;
-    int32_t right = std::min(it1->right, it2->right);
-    assert(left < right);
-
-    output->push_back(RowSpan(left, right));
-
-    // If |it1| was completely consumed, move to the next one.
-    if (it1->right == right)
-      ++it1;
-    // If |it2| was completely consumed, move to the next one.
-    if (it2->right == right)
-      ++it2;
-  } while (it1 != end1 && it2 != end2);
+  CombineRows(region1.GetRowRange(0, region1.rows_.size()),
+              region2.GetRowRange(0, region2.rows_.size()),
+              Operation::kIntersect, &rows_, &spans_);
 }
 
 void DesktopRegion::IntersectWith(const DesktopRegion& region) {
-  DesktopRegion old_region;
-  Swap(&old_region);
-  Intersect(old_region, region);
+  Combine(region.GetRowRange(0, region.rows_.size()), Operation::kIntersect);
 }
 
 void DesktopRegion::IntersectWith(const DesktopRect& rect) {
-  DesktopRegion region;
-  region.AddRect(rect);
-  IntersectWith(region);
-}
-
-void DesktopRegion::Subtract(const DesktopRegion& region) {
-  if (region.rows_.empty())
+  if (rect.is_empty()) {
+    Clear();
     return;
-
-  // |row_b| refers to the current row being subtracted.
-  Rows::const_iterator row_b = region.rows_.begin();
-
-  // Current vertical position at which subtraction is happening.
-  int top = row_b->second->top;
-
-  // |row_a| refers to the current row we are subtracting from. Skip all rows
-  // above |top|.
-  Rows::iterator row_a = rows_.upper_bound(top);
-
-  // Step through rows of the both regions subtracting content of |row_b| from
-  // |row_a|.
-  while (row_a != rows_.end() && row_b != region.rows_.end()) {
-    // Skip |row_a| if it doesn't intersect with the |row_b|.
-    if (row_a->second->bottom <= top) {
-      // Each output row is merged with previously-processed rows before further
-      // rows are processed.
-      MergeWithPrecedingRow(row_a);
-      ++row_a;
-      continue;
-    }
-
-    if (top > row_a->second->top) {
-      // If |top| falls in the middle of |row_a| then split |row_a| into two, at
-      // |top|, and leave |row_a| referring to the lower of the two, ready to
-      // subtract spans from.
-      assert(top <= row_a->second->bottom);
-      Rows::iterator new_row = rows_.insert(
-          row_a, Rows::value_type(top, new Row(row_a->second->top, top)));
-      row_a->second->top = top;
-      new_row->second->spans = row_a->second->spans;
-    } else if (top < row_a->second->top) {
-      // If the |top| is above |row_a| then skip the range between |top| and
-      // top of |row_a| because it's empty.
-      top = row_a->second->top;
-      if (top >= row_b->second->bottom) {
-        ++row_b;
-        if (row_b != region.rows_.end())
-          top = row_b->second->top;
-        continue;
-      }
-    }
-
-    if (row_b->second->bottom < row_a->second->bottom) {
-      // If the bottom of |row_b| falls in the middle of the |row_a| split
-      // |row_a| into two, at |top|, and leave |row_a| referring to the upper of
-      // the two, ready to subtract spans from.
-      int bottom = row_b->second->bottom;
-      Rows::iterator new_row =
-          rows_.insert(row_a, Rows::value_type(bottom, new Row(top, bottom)));
-      row_a->second->top = bottom;
-      new_row->second->spans = row_a->second->spans;
-      row_a = new_row;
-    }
-
-    // At this point the vertical range covered by |row_a| lays within the
-    // range covered by |row_b|. Subtract |row_b| spans from |row_a|.
-    RowSpanSet new_spans;
-    SubtractRows(row_a->second->spans, row_b->second->spans, &new_spans);
-    new_spans.swap(row_a->second->spans);
-    top = row_a->second->bottom;
-
-    if (top >= row_b->second->bottom) {
-      ++row_b;
-      if (row_b != region.rows_.end())
-        top = row_b->second->top;
-    }
-
-    // Check if the row is empty after subtraction and delete it. Otherwise move
-    // to the next one.
-    if (row_a->second->spans.empty()) {
-      Rows::iterator row_to_delete = row_a;
-      ++row_a;
-      delete row_to_delete->second;
-      rows_.erase(row_to_delete);
-    } else {
-      MergeWithPrecedingRow(row_a);
-      ++row_a;
-    }
   }
+  const Row row(rect.top(), rect.bottom(), 0, 1);
+  const RowSpan span(rect.left(), rect.right());
+  Combine(RowRange{&row, 1, &span}, Operation::kIntersect);
+}
 
-  if (row_a != rows_.end())
-    MergeWithPrecedingRow(row_a);
+void DesktopRegion::Subtract(const DesktopRegion& region) {
+  Combine(region.GetRowRange(0, region.rows_.size()), Operation::kSubtract);
 }
 
 void DesktopRegion::Subtract(const DesktopRect& rect) {
-  DesktopRegion region;
-  region.AddRect(rect);
-  Subtract(region);
+  if (rect.is_empty())
+    return;
+  const Row row(rect.top(), rect.bottom(), 0, 1);
+  const RowSpan span(rect.left(), rect.right());
+  Combine(RowRange{&row, 1, &span}, Operation::kSubtract);
 }
 
 void DesktopRegion::Translate(int32_t dx, int32_t dy) {
-  Rows new_rows;
-
-  for (Rows::iterator it = rows_.begin(); it != rows_.end(); ++it) {
-    Row* row = it->second;
-
-    row->top += dy;
-    row->bottom += dy;
-
-    if (dx != 0) {
-      // Translate each span.
-      for (RowSpanSet::iterator span = row->spans.begin();
-           span != row->spans.end(); ++span) {
-        span->left += dx;
-        span->right += dx;
-      }
+  if (dy != 0) {
+    for (Row& row : rows_) {
+      row.top += dy;
+      row.bottom += dy;
+    }
+  }
+  if (dx != 0) {
+    for (RowSpan& span : spans_) {
+      span.left += dx;
+      span.right += dx;
     }
-
-    if (dy != 0)
-      new_rows.insert(new_rows.end(), Rows::value_type(row->bottom, row));
   }
-
-  if (dy != 0)
-    new_rows.swap(rows_);
 }
 
 void DesktopRegion::Swap(DesktopRegion* region) {
   rows_.swap(region->rows_);
+  spans_.swap(region->spans_);
 }
 
-// static
-bool DesktopRegion::CompareSpanRight(const RowSpan& r, int32_t value) {
-  return r.right < value;
-}
-
-// static
-bool DesktopRegion::CompareSpanLeft(const RowSpan& r, int32_t value) {
-  return r.left < value;
-}
-
-// static
-void DesktopRegion::AddSpanToRow(Row* row, int left, int right) {
-  // First check if the new span is located to the right of all existing spans.
-  // This is an optimization to avoid binary search in the case when rectangles
-  // are inserted sequentially from left to right.
-  if (row->spans.empty() || left > row->spans.back().right) {
-    row->spans.push_back(RowSpan(left, right));
+void DesktopRegion::Combine(const RowRange& range, Operation operation) {
+  if (range.num_rows == 0) {
+    if (operation == Operation::kIntersect)
+      Clear();
     return;
   }
 
-  // Find the first span that ends at or after |left|.
-  RowSpanSet::iterator start = std::lower_bound(
-      row->spans.begin(), row->spans.end(), left, CompareSpanRight);
-  assert(start < row->spans.end());
-
-  // Find the first span that starts after |right|.
-  RowSpanSet::iterator end =
-      std::lower_bound(start, row->spans.end(), right + 1, CompareSpanLeft);
-  if (end == row->spans.begin()) {
-    // There are no overlaps. Just insert the new span at the beginning.
-    row->spans.insert(row->spans.begin(), RowSpan(left, right));
+  Rows rows;
+  RowSpans spans;
+  if (operation == Operation::kIntersect) {
+    CombineRows(GetRowRange(0, rows_.size()), range, operation, &rows, &spans);
+    rows_.swap(rows);
+    spans_.swap(spans);
     return;
   }
 
-  // Move end to the left, so that it points the last span that ends at or
-  // before |right|.
-  end--;
-
-  // At this point [start, end] is the range of spans that intersect with the
-  // new one.
-  if (end < start) {
-    // There are no overlaps. Just insert the new span at the correct position.
-    row->spans.insert(start, RowSpan(left, right));
+  // Union and subtraction don't change the rows above and below |range|, so
+  // only the rows that overlap it vertically are replaced.
+  const int32_t top = range.rows[0].top;
+  const int32_t bottom = range.rows[range.num_rows - 1].bottom;
+  const size_t begin =
+      std::upper_bound(rows_.begin(), rows_.end(), top,
+                       [](int32_t value, const Row& row) {
+                         return value < row.bottom;
+                       }) -
+      rows_.begin();
+  const size_t end = std::lower_bound(rows_.begin() + begin, rows_.end(),
+                                      bottom,
+                                      [](const Row& row, int32_t value) {
+                                        return row.top < value;
+                                      }) -
+                     rows_.begin();
+  if (operation == Operation::kSubtract && begin == end)
     return;
+
+  // Reserve enough for the common case of |range| splitting at most two rows
+  // of the region.
+  const size_t spans_begin =
+      begin < rows_.size() ? rows_[begin].spans_begin : spans_.size();
+  const size_t spans_end =
+      end < rows_.size() ? rows_[end].spans_begin : spans_.size();
+  rows.reserve(end - begin + 2 * range.num_rows + 2);
+  spans.reserve(2 * (spans_end - spans_begin) + end - begin +
+                range.rows[range.num_rows - 1].spans_end -
+                range.rows[0].spans_begin);
+  CombineRows(GetRowRange(begin, end), range, operation, &rows, &spans);
+  ReplaceRows(begin, end, rows, spans);
+}
+
+void DesktopRegion::ReplaceRows(size_t begin,
+                                size_t end,
+                                const Rows& rows,
+                                const RowSpans& spans) {
+  assert(begin <= end && end <= rows_.size());
+  const size_t spans_begin =
+      begin < rows_.size() ? rows_[begin].spans_begin : spans_.size();
+  const size_t spans_end =
+      end < rows_.size() ? rows_[end].spans_begin : spans_.size();
+
+  ReplaceRange(spans_begin, spans_end, spans, &spans_);
+  ReplaceRange(begin, end, rows, &rows_);
+  for (size_t i = begin; i < begin + rows.size(); ++i) {
+    rows_[i].spans_begin += spans_begin;
+    rows_[i].spans_end += spans_begin;
+  }
+  const size_t new_spans_end = spans_begin + spans.size();
+  if (new_spans_end != spans_end) {
+    for (size_t i = begin + rows.size(); i < rows_.size(); ++i) {
+      rows_[i].spans_begin = rows_[i].spans_begin - spans_end + new_spans_end;
+      rows_[i].spans_end = rows_[i].spans_end - spans_end + new_spans_end;
+    }
   }
 
-  left = std::min(left, start->left);
-  right = std::max(right, end->right);
+  // The new rows may need to be merged with the rows around them. The lower
+  // one is merged first, so that |begin| remains valid.
+  const size_t next_row = begin + rows.size();
+  if (next_row < rows_.size())
+    MergeWithPrecedingRow(next_row);
+  if (begin < rows_.size())
+    MergeWithPrecedingRow(begin);
+}
 
-  // Replace range [start, end] with the new span.
-  *start = RowSpan(left, right);
-  ++start;
-  ++end;
-  if (start < end)
-    row->spans.erase(start, end);
+DesktopRegion::RowRange DesktopRegion::GetRowRange(size_t begin,
+                                                   size_t end) const {
+  return RowRange{rows_.data() + begin, end - begin, spans_.data()};
 }
 
 // static
-bool DesktopRegion::IsSpanInRow(const Row& row, const RowSpan& span) {
-  // Find the first span that starts at or after |span.left| and then check if
-  // it's the same span.
-  RowSpanSet::const_iterator it = std::lower_bound(
-      row.spans.begin(), row.spans.end(), span.left, CompareSpanLeft);
-  return it != row.spans.end() && *it == span;
+void DesktopRegion::CombineRows(const RowRange& range1,
+                                const RowRange& range2,
+                                Operation operation,
+                                Rows* rows,
+                                RowSpans* spans) {
+  constexpr int32_t kNoRow = std::numeric_limits<int32_t>::max();
+
+  size_t row1 = 0;
+  size_t row2 = 0;
+  // Vertical position above which the rows have been combined.
+  int32_t position = std::numeric_limits<int32_t>::min();
+  while (row1 < range1.num_rows || row2 < range2.num_rows) {
+    const Row* it1 = row1 < range1.num_rows ? &range1.rows[row1] : nullptr;
+    const Row* it2 = row2 < range2.num_rows ? &range2.rows[row2] : nullptr;
+
+    // Top of the parts of the two rows that haven't been combined yet.
+    const int32_t top1 = it1 ? std::max(it1->top, position) : kNoRow;
+    const int32_t top2 = it2 ? std::max(it2->top, position) : kNoRow;
+    const int32_t top = std::min(top1, top2);
+    // The output row ends where either row ends, or where the lower row
+    // starts.
+    const bool in_row1 = top1 == top;
+    const bool in_row2 = top2 == top;
+    const int32_t bottom = std::min(in_row1 ? it1->bottom : top1,
+                                    in_row2 ? it2->bottom : top2);
+
+    const bool has_output = operation == Operation::kUnion ||
+                            (operation == Operation::kSubtract && in_row1) ||
+                            (in_row1 && in_row2);
+    if (has_output) {
+      const size_t spans_begin = spans->size();
+      const RowSpan* begin1 =
+          in_row1 ? range1.spans + it1->spans_begin : nullptr;
+      const RowSpan* end1 = in_row1 ? range1.spans + it1->spans_end : nullptr;
+      const RowSpan* begin2 =
+          in_row2 ? range2.spans + it2->spans_begin : nullptr;
+      const RowSpan* end2 = in_row2 ? range2.spans + it2->spans_end : nullptr;
+      CombineSpans(begin1, end1, begin2, end2, operation, spans);
+      const size_t spans_end = spans->size();
+
+      if (spans_end > spans_begin) {
+        // Merge the output row with the previous one if they contain the same
+        // spans.
+        Row* previous = rows->empty() ? nullptr : &rows->back();
+        if (previous && previous->bottom == top &&
+            previous->num_spans() == spans_end - spans_begin &&
+            std::equal(spans->begin() + previous->spans_begin,
+                       spans->begin() + previous->spans_end,
+                       spans->begin() + spans_begin)) {
+          previous->bottom = bottom;
+          spans->erase(spans->begin() + spans_begin, spans->end());
+        } else {
+          rows->push_back(Row(top, bottom, spans_begin, spans_end));
+        }
+      }
+    }
+
+    position = bottom;
+    // Move to the next rows once they have been completely consumed.
+    if (it1 && it1->bottom <= position)
+      ++row1;
+    if (it2 && it2->bottom <= position)
+      ++row2;
+  }
 }
 
 // static
-void DesktopRegion::SubtractRows(const RowSpanSet& set_a,
-                                 const RowSpanSet& set_b,
-                                 RowSpanSet* output) {
-  assert(!set_a.empty() && !set_b.empty());
-
-  RowSpanSet::const_iterator it_b = set_b.begin();
-
-  // Iterate over all spans in |set_a| adding parts of it that do not intersect
-  // with |set_b| to the |output|.
-  for (RowSpanSet::const_iterator it_a = set_a.begin(); it_a != set_a.end();
-       ++it_a) {
-    // If there is no intersection then append the current span and continue.
-    if (it_b == set_b.end() || it_a->right < it_b->left) {
-      output->push_back(*it_a);
-      continue;
+void DesktopRegion::CombineSpans(const RowSpan* begin1,
+                                 const RowSpan* end1,
+                                 const RowSpan* begin2,
+                                 const RowSpan* end2,
+                                 Operation operation,
+                                 RowSpans* output) {
+  switch (operation) {
+    case Operation::kUnion: {
+      // Rows that exist in only one of the regions are copied as is.
+      if (begin1 == end1 || begin2 == end2) {
+        output->insert(output->end(), begin1 == end1 ? begin2 : begin1,
+                       begin1 == end1 ? end2 : end1);
+        break;
+      }
+      const size_t output_begin = output->size();
+      while (begin1 != end1 || begin2 != end2) {
+        // Take the left-most of the spans, coalescing it with the previous
+        // one if they overlap or touch.
+        const RowSpan& span =
+            begin2 == end2 || (begin1 != end1 && begin1->left <= begin2->left)
+                ? *begin1++
+                : *begin2++;
+        if (output->size() > output_begin &&
+            output->back().right >= span.left) {
+          output->back().right = std::max(output->back().right, span.right);
+        } else {
+          output->push_back(span);
+        }
+      }
+      break;
     }
 
-    // Iterate over |set_b| spans that may intersect with |it_a|.
-    int pos = it_a->left;
-    while (it_b != set_b.end() && it_b->left < it_a->right) {
-      if (it_b->left > pos)
-        output->push_back(RowSpan(pos, it_b->left));
-      if (it_b->right > pos) {
-        pos = it_b->right;
-        if (pos >= it_a->right)
-          break;
+    case Operation::kIntersect:
+      while (begin1 != end1 && begin2 != end2) {
+        // Arrange for |begin1| to always be the left-most of the spans.
+        if (begin2->left < begin1->left) {
+          std::swap(begin1, begin2);
+          std::swap(end1, end2);
+        }
+
+        // Skip |begin1| if it doesn't intersect |begin2| at all.
+        if (begin1->right <= begin2->left) {
+          ++begin1;
+          continue;
+        }
+
+        int32_t left = begin2->left;
+        int32_t right = std::min(begin1->right, begin2->right);
+        assert(left < right);
+
+        output->push_back(RowSpan(left, right));
+
+        // If |begin1| was completely consumed, move to the next one.
+        if (begin1->right == right)
+          ++begin1;
+        // If |begin2| was completely consumed, move to the next one.
+        if (begin2->right == right)
+          ++begin2;
       }
-      ++it_b;
-    }
-    if (pos < it_a->right)
-      output->push_back(RowSpan(pos, it_a->right));
+      break;
+
+    case Operation::kSubtract:
+      // Iterate over all spans of the first set adding parts of it that do
+      // not intersect with the second set to the |output|.
+      for (; begin1 != end1; ++begin1) {
+        // If there is no intersection then append the current span and
+        // continue.
+        if (begin2 == end2 || begin1->right < begin2->left) {
+          output->push_back(*begin1);
+          continue;
+        }
+
+        // Iterate over spans of the second set that may intersect with
+        // |begin1|.
+        int pos = begin1->left;
+        while (begin2 != end2 && begin2->left < begin1->right) {
+          if (begin2->left > pos)
+            output->push_back(RowSpan(pos, begin2->left));
+          if (begin2->right > pos) {
+            pos = begin2->right;
+            if (pos >= begin1->right)
+              break;
+          }
+          ++begin2;
+        }
+        if (pos < begin1->right)
+          output->push_back(RowSpan(pos, begin1->right));
+      }
+      break;
   }
 }
 
+// static
+bool DesktopRegion::CompareSpanLeft(const RowSpan& r, int32_t value) {
+  return r.left < value;
+}
+
+bool DesktopRegion::IsSpanInRow(const Row& row, const RowSpan& span) const {
+  // Find the first span that starts at or after |span.left| and then check if
+  // it's the same span.
+  const RowSpans::const_iterator end = spans_.begin() + row.spans_end;
+  RowSpans::const_iterator it = std::lower_bound(
+      spans_.begin() + row.spans_begin, end, span.left, CompareSpanLeft);
+  return it != end && *it == span;
+}
+
 DesktopRegion::Iterator::Iterator(const DesktopRegion& region)
-    : region_(region),
-      row_(region.rows_.begin()),
-      previous_row_(region.rows_.end()) {
+    : region_(region), row_(0), row_span_(0) {
   if (!IsAtEnd()) {
-    assert(row_->second->spans.size() > 0);
-    row_span_ = row_->second->spans.begin();
+    assert(region_.rows_[row_].num_spans() > 0);
     UpdateCurrentRect();
   }
 }
@@ -512,32 +505,30 @@ DesktopRegion::Iterator::Iterator(const DesktopRegion& region)
 DesktopRegion::Iterator::~Iterator() {}
 
 bool DesktopRegion::Iterator::IsAtEnd() const {
-  return row_ == region_.rows_.end();
+  return row_ == region_.rows_.size();
 }
 
 void DesktopRegion::Iterator::Advance() {
   assert(!IsAtEnd());
 
   while (true) {
+    // The spans of consecutive rows are consecutive, so |row_span_| is at the
+    // first span of the next row when the current row is finished.
     ++row_span_;
-    if (row_span_ == row_->second->spans.end()) {
-      previous_row_ = row_;
+    if (row_span_ == region_.rows_[row_].spans_end) {
       ++row_;
-      if (row_ != region_.rows_.end()) {
-        assert(row_->second->spans.size() > 0);
-        row_span_ = row_->second->spans.begin();
-      }
+      if (IsAtEnd())
+        return;
+      assert(region_.rows_[row_].num_spans() > 0);
     }
 
-    if (IsAtEnd())
-      return;
-
     // If the same span exists on the previous row then skip it, as we've
     // already returned this span merged into the previous one, via
     // UpdateCurrentRect().
-    if (previous_row_ != region_.rows_.end() &&
-        previous_row_->second->bottom == row_->second->top &&
-        IsSpanInRow(*previous_row_->second, *row_span_)) {
+    const Row& row = region_.rows_[row_];
+    if (row_ > 0 && region_.rows_[row_ - 1].bottom == row.top &&
+        region_.IsSpanInRow(region_.rows_[row_ - 1],
+                            region_.spans_[row_span_])) {
       continue;
     }
 
@@ -550,18 +541,16 @@ void DesktopRegion::Iterator::Advance() {
 
 void DesktopRegion::Iterator::UpdateCurrentRect() {
   // Merge the current rectangle with the matching spans from later rows.
-  int bottom;
-  Rows::const_iterator bottom_row = row_;
-  Rows::const_iterator previous;
-  do {
-    bottom = bottom_row->second->bottom;
-    previous = bottom_row;
+  const RowSpan& span = region_.spans_[row_span_];
+  size_t bottom_row = row_;
+  while (bottom_row + 1 < region_.rows_.size() &&
+         region_.rows_[bottom_row].bottom ==
+             region_.rows_[bottom_row + 1].top &&
+         region_.IsSpanInRow(region_.rows_[bottom_row + 1], span)) {
     ++bottom_row;
-  } while (bottom_row != region_.rows_.end() &&
-           previous->second->bottom == bottom_row->second->top &&
-           IsSpanInRow(*bottom_row->second, *row_span_));
-  rect_ = DesktopRect::MakeLTRB(row_span_->left, row_->second->top,
-                                row_span_->right, bottom);
+  }
+  rect_ = DesktopRect::MakeLTRB(span.left, region_.rows_[row_].top,
+                                span.right, region_.rows_[bottom_row].bottom);
 }
 
 }  // namespace webrtc
@@ -11,9 +11,9 @@
 #ifndef MODULES_DESKTOP_CAPTURE_DESKTOP_REGION_H_
 #define MODULES_DESKTOP_CAPTURE_DESKTOP_REGION_H_
 
+#include <stddef.h>
 #include <stdint.h>
 
-#include <map>
 #include <vector>
 
 #include "modules/desktop_capture/desktop_geometry.h"
@@ -24,7 +24,9 @@ namespace webrtc {
 // DesktopRegion represents a region of the screen or window.
 //
 // Internally each region is stored as a set of rows where each row contains one
-// or more rectangles aligned vertically.
+// or more rectangles aligned vertically. The rows and their spans are kept in
+// two flat sorted arrays, so that the region operations are done as linear
+// merges of the two regions instead of many small allocations.
 class RTC_EXPORT DesktopRegion {
  private:
   // The following private types need to be declared first because they are used
@@ -34,7 +36,6 @@ class RTC_EXPORT DesktopRegion {
   struct RowSpan {
     RowSpan(int32_t left, int32_t right);
 
-    // Used by std::vector<>.
     bool operator==(const RowSpan& that) const {
       return left == that.left && right == that.right;
     }
@@ -43,26 +44,24 @@ class RTC_EXPORT DesktopRegion {
     int32_t right;
   };
 
-  typedef std::vector<RowSpan> RowSpanSet;
+  typedef std::vector<RowSpan> RowSpans;
 
   // Row represents a single row of a region. A row is set of rectangles that
-  // have the same vertical position.
+  // have the same vertical position. Its spans are [spans_begin, spans_end) of
+  // the spans of the region, the spans of consecutive rows are consecutive.
   struct Row {
-    Row(const Row&);
-    Row(Row&&);
-    Row(int32_t top, int32_t bottom);
-    ~Row();
+    Row(int32_t top, int32_t bottom, size_t spans_begin, size_t spans_end);
+
+    size_t num_spans() const { return spans_end - spans_begin; }
 
     int32_t top;
     int32_t bottom;
-
-    RowSpanSet spans;
+    size_t spans_begin;
+    size_t spans_end;
   };
 
-  // Type used to store list of rows in the region. The bottom position of row
-  // is used as the key so that rows are always ordered by their position. The
-  // map stores pointers to make Translate() more efficient.
-  typedef std::map<int, Row*> Rows;
+  // Rows of a region, ordered by their position.
+  typedef std::vector<Row> Rows;
 
  public:
   // Iterator that can be used to iterate over rectangles of a DesktopRegion.
@@ -85,9 +84,9 @@ class RTC_EXPORT DesktopRegion {
     // into |rect_|, to generate more efficient output.
     void UpdateCurrentRect();
 
-    Rows::const_iterator row_;
-    Rows::const_iterator previous_row_;
-    RowSpanSet::const_iterator row_span_;
+    // Indices of the current row and span in |region_|.
+    size_t row_;
+    size_t row_span_;
     DesktopRect rect_;
   };
 
@@ -135,33 +134,57 @@ class RTC_EXPORT DesktopRegion {
   void Swap(DesktopRegion* region);
 
  private:
-  // Comparison functions used for std::lower_bound(). Compare left or right
-  // edges withs a given |value|.
-  static bool CompareSpanLeft(const RowSpan& r, int32_t value);
-  static bool CompareSpanRight(const RowSpan& r, int32_t value);
-
-  // Adds a new span to the row, coalescing spans if necessary.
-  static void AddSpanToRow(Row* row, int32_t left, int32_t right);
-
-  // Returns true if the |span| exists in the given |row|.
-  static bool IsSpanInRow(const Row& row, const RowSpan& rect);
+  enum class Operation { kUnion, kIntersect, kSubtract };
+
+  // A range of rows and the spans they refer to, e.g. of a region or of a
+  // single rectangle.
+  struct RowRange {
+    const Row* rows;
+    size_t num_rows;
+    const RowSpan* spans;
+  };
 
-  // Calculates the intersection of two sets of spans.
-  static void IntersectRows(const RowSpanSet& set1,
-                            const RowSpanSet& set2,
-                            RowSpanSet* output);
+  // Comparison function used for std::lower_bound(). Compares left edge with
+  // a given |value|.
+  static bool CompareSpanLeft(const RowSpan& r, int32_t value);
 
-  static void SubtractRows(const RowSpanSet& set_a,
-                           const RowSpanSet& set_b,
-                           RowSpanSet* output);
+  // Returns true if the |span| exists in the given |row| of the region.
+  bool IsSpanInRow(const Row& row, const RowSpan& span) const;
+
+  // Combines the rows of |range1| and |range2| with |operation| and appends
+  // the resulting rows and spans to |rows| and |spans|.
+  static void CombineRows(const RowRange& range1,
+                          const RowRange& range2,
+                          Operation operation,
+                          Rows* rows,
+                          RowSpans* spans);
+
+  // Combines two sets of spans with |operation| and appends the resulting
+  // spans to |output|.
+  static void CombineSpans(const RowSpan* begin1,
+                           const RowSpan* end1,
+                           const RowSpan* begin2,
+                           const RowSpan* end2,
+                           Operation operation,
+                           RowSpans* output);
+
+  // Combines the region with |range| and stores the result in the region.
+  void Combine(const RowRange& range, Operation operation);
+
+  // Replaces the rows [begin, end) of the region with |rows| and |spans|.
+  void ReplaceRows(size_t begin,
+                   size_t end,
+                   const Rows& rows,
+                   const RowSpans& spans);
 
   // Merges |row| with the row above it if they contain the same spans. Doesn't
-  // do anything if called with |row| set to rows_.begin() (i.e. first row of
-  // the region). If the rows were merged |row| remains a valid iterator to the
-  // merged row.
-  void MergeWithPrecedingRow(Rows::iterator row);
+  // do anything if called with the first row of the region.
+  void MergeWithPrecedingRow(size_t row);
+
+  RowRange GetRowRange(size_t begin, size_t end) const;
 
   Rows rows_;
+  RowSpans spans_;
 };
 
 }  // namespace webrtc
@@ -14,8 +14,12 @@
 
 #include <algorithm>
 #include <cstdint>
+#include <vector>
 
+#include "rtc_base/random.h"
+#include "rtc_base/time_utils.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 
@@ -42,6 +46,172 @@ void CompareRegion(const DesktopRegion& region,
   EXPECT_TRUE(it.IsAtEnd());
 }
 
+constexpr int kBitmapSize = 64;
+
+// Reference implementation of a region, as a bitmap of its pixels.
+class RegionBitmap {
+ public:
+  RegionBitmap() {
+    std::fill_n(&pixels_[0][0], kBitmapSize * kBitmapSize, false);
+  }
+
+  void Set(const DesktopRect& rect, bool value) {
+    for (int y = rect.top(); y < rect.bottom(); ++y)
+      std::fill(pixels_[y] + rect.left(), pixels_[y] + rect.right(), value);
+  }
+
+  void Intersect(const DesktopRect& rect) {
+    for (int y = 0; y < kBitmapSize; ++y) {
+      for (int x = 0; x < kBitmapSize; ++x)
+        pixels_[y][x] = pixels_[y][x] && rect.Contains(DesktopVector(x, y));
+    }
+  }
+
+  // Verifies that |region| covers exactly the pixels set in the bitmap, with
+  // non-overlapping rects.
+  void ExpectEquals(const DesktopRegion& region) const {
+    bool covered[kBitmapSize][kBitmapSize] = {};
+    for (DesktopRegion::Iterator it(region); !it.IsAtEnd(); it.Advance()) {
+      ASSERT_TRUE(DesktopRect::MakeWH(kBitmapSize, kBitmapSize)
+                      .ContainsRect(it.rect()));
+      for (int y = it.rect().top(); y < it.rect().bottom(); ++y) {
+        for (int x = it.rect().left(); x < it.rect().right(); ++x) {
+          ASSERT_FALSE(covered[y][x]);
+          covered[y][x] = true;
+        }
+      }
+    }
+    for (int y = 0; y < kBitmapSize; ++y) {
+      for (int x = 0; x < kBitmapSize; ++x)
+        ASSERT_EQ(pixels_[y][x], covered[y][x]) << x << "," << y;
+    }
+  }
+
+ private:
+  bool pixels_[kBitmapSize][kBitmapSize];
+};
+
+DesktopRect RandomRect(Random* random, int max_size) {
+  const int left = random->Rand(0, kBitmapSize - 1);
+  const int top = random->Rand(0, kBitmapSize - 1);
+  return DesktopRect::MakeLTRB(
+      left, top, std::min(kBitmapSize, left + random->Rand(1, max_size)),
+      std::min(kBitmapSize, top + random->Rand(1, max_size)));
+}
+
+// Dirty blocks of a 1920x1080 screen, as produced by the differ for a typical
+// screen activity.
+constexpr int kScreenWidth = 1920;
+constexpr int kScreenHeight = 1080;
+constexpr int kBlockSize = 32;
+constexpr int kScreenBlocksX = kScreenWidth / kBlockSize;
+constexpr int kScreenBlocksY = (kScreenHeight + kBlockSize - 1) / kBlockSize;
+
+class DirtyBlocks {
+ public:
+  DirtyBlocks() { Clear(); }
+
+  void Clear() {
+    std::fill_n(&blocks_[0][0], kScreenBlocksX * kScreenBlocksY, false);
+  }
+
+  void Set(int x, int y) {
+    if (x >= 0 && x < kScreenBlocksX && y >= 0 && y < kScreenBlocksY)
+      blocks_[y][x] = true;
+  }
+
+  // Adds the blocks to |region| the way the differ does, row by row with
+  // horizontally adjacent blocks merged.
+  void AddTo(DesktopRegion* region) const {
+    for (int y = 0; y < kScreenBlocksY; ++y) {
+      int x = 0;
+      while (x < kScreenBlocksX) {
+        if (!blocks_[y][x]) {
+          ++x;
+          continue;
+        }
+        const int left = x;
+        while (x < kScreenBlocksX && blocks_[y][x])
+          ++x;
+        region->AddRect(DesktopRect::MakeLTRB(
+            left * kBlockSize, y * kBlockSize, x * kBlockSize,
+            std::min(kScreenHeight, (y + 1) * kBlockSize)));
+      }
+    }
+  }
+
+ private:
+  bool blocks_[kScreenBlocksY][kScreenBlocksX];
+};
+
+// Typing: a few characters and the caret change on a line of text.
+void MakeTypingBlocks(int frame, Random* random, DirtyBlocks* blocks) {
+  const int line = 10 + (frame / 100) % 10;
+  const int column = 4 + (frame % 100) / 2;
+  blocks->Set(column, line);
+  blocks->Set(column + 1, line);
+  if (random->Rand(0, 3) == 0)
+    blocks->Set(random->Rand(0, kScreenBlocksX - 1), line);
+}
+
+// Scrolling: most of a 1280x800 window changes, except the blocks that are
+// blank in both frames.
+void MakeScrollingBlocks(int frame, Random* random, DirtyBlocks* blocks) {
+  for (int y = 5; y < 5 + 800 / kBlockSize; ++y) {
+    for (int x = 10; x < 10 + 1280 / kBlockSize; ++x) {
+      if (random->Rand(0, 4) != 0)
+        blocks->Set(x, y);
+    }
+  }
+}
+
+// Video playback: a 640x360 video and its progress bar.
+void MakeVideoBlocks(int frame, Random* random, DirtyBlocks* blocks) {
+  for (int y = 8; y < 8 + 360 / kBlockSize; ++y) {
+    for (int x = 12; x < 12 + 640 / kBlockSize; ++x)
+      blocks->Set(x, y);
+  }
+  blocks->Set(12 + (frame / 30) % (640 / kBlockSize), 8 + 360 / kBlockSize);
+}
+
+// Measures the region operations done per captured frame, by the differ and
+// ScreenCapturerHelper, for the dirty blocks made by |make_blocks|.
+void RunScreenActivityPerf(
+    const char* name,
+    void (*make_blocks)(int frame, Random* random, DirtyBlocks* blocks)) {
+  constexpr int kNumFrames = 1000;
+  const DesktopRect screen_rect = DesktopRect::MakeWH(kScreenWidth,
+                                                      kScreenHeight);
+  Random random(1234);
+  std::vector<DirtyBlocks> frames(kNumFrames);
+  for (int i = 0; i < kNumFrames; ++i)
+    make_blocks(i, &random, &frames[i]);
+
+  DesktopRegion invalid_region;
+  int num_rects = 0;
+  const int64_t start_ns = rtc::SystemTimeNanos();
+  for (int i = 0; i < kNumFrames; ++i) {
+    DesktopRegion updated_region;
+    frames[i].AddTo(&updated_region);
+    invalid_region.AddRegion(updated_region);
+    // Every other frame is captured, e.g. at half of the differ's rate.
+    if (i % 2 == 0)
+      continue;
+    DesktopRegion captured_region;
+    captured_region.Swap(&invalid_region);
+    captured_region.IntersectWith(screen_rect);
+    for (DesktopRegion::Iterator it(captured_region); !it.IsAtEnd();
+         it.Advance()) {
+      ++num_rects;
+    }
+  }
+  const int64_t elapsed_ns = rtc::SystemTimeNanos() - start_ns;
+  EXPECT_GT(num_rects, 0);
+  test::PrintResult("desktop_region", "", name,
+                    static_cast<double>(elapsed_ns) / kNumFrames / 1000, "us",
+                    false);
+}
+
 }  // namespace
 
 // Verify that regions are empty when created.
@@ -831,4 +1001,74 @@ TEST(DesktopRegionTest, DISABLED_Performance) {
   }
 }
 
+TEST(DesktopRegionTest, AddRectsEqualsAddRect) {
+  Random random(1234);
+  std::vector<DesktopRect> rects;
+  for (int i = 0; i < 100; ++i)
+    rects.push_back(RandomRect(&random, 16));
+
+  DesktopRegion region1(rects.data(), rects.size());
+  DesktopRegion region2;
+  for (const DesktopRect& rect : rects)
+    region2.AddRect(rect);
+  EXPECT_TRUE(region1.Equals(region2));
+}
+
+TEST(DesktopRegionTest, RandomOperations) {
+  Random random(1234);
+  for (int c = 0; c < 100; ++c) {
+    DesktopRegion region;
+    RegionBitmap bitmap;
+    for (int i = 0; i < 50; ++i) {
+      const DesktopRect rect = RandomRect(&random, 24);
+      switch (random.Rand(0, 4)) {
+        case 0:
+          region.AddRect(rect);
+          bitmap.Set(rect, true);
+          break;
+        case 1:
+          region.AddRegion(DesktopRegion(rect));
+          bitmap.Set(rect, true);
+          break;
+        case 2:
+          region.Subtract(rect);
+          bitmap.Set(rect, false);
+          break;
+        case 3:
+          region.Subtract(DesktopRegion(rect));
+          bitmap.Set(rect, false);
+          break;
+        case 4:
+          // Keep most of the region.
+          if (rect.width() > 16 && rect.height() > 16) {
+            region.IntersectWith(rect);
+            bitmap.Intersect(rect);
+          }
+          break;
+      }
+      bitmap.ExpectEquals(region);
+      if (HasFatalFailure())
+        return;
+    }
+
+    // The region is in the same form as a region built from its own rects.
+    DesktopRegion copy;
+    for (DesktopRegion::Iterator it(region); !it.IsAtEnd(); it.Advance())
+      copy.AddRect(it.rect());
+    EXPECT_TRUE(region.Equals(copy));
+  }
+}
+
+TEST(DesktopRegionTest, DISABLED_TypingPerf) {
+  RunScreenActivityPerf("typing", &MakeTypingBlocks);
+}
+
+TEST(DesktopRegionTest, DISABLED_ScrollingPerf) {
+  RunScreenActivityPerf("scrolling", &MakeScrollingBlocks);
+}
+
+TEST(DesktopRegionTest, DISABLED_VideoPlaybackPerf) {
+  RunScreenActivityPerf("video_playback", &MakeVideoBlocks);
+}
+
 }  // namespace webrtc
@@ -12,6 +12,7 @@
 
 #include <string.h>
 
+#include "modules/desktop_capture/differ_vector_avx2.h"
 #include "modules/desktop_capture/differ_vector_sse2.h"
 #include "rtc_base/system/arch.h"
 #include "system_wrappers/include/cpu_features_wrapper.h"
@@ -20,40 +21,38 @@ namespace webrtc {
 
 namespace {
 
+using VectorDifferenceProc = bool (*)(const uint8_t*, const uint8_t*);
+using BlockDifferenceProc = bool (*)(const uint8_t*, const uint8_t*, int, int);
+
 bool VectorDifference_C(const uint8_t* image1, const uint8_t* image2) {
   return memcmp(image1, image2, kBlockSize * kBytesPerPixel) != 0;
 }
 
-}  // namespace
-
-bool VectorDifference(const uint8_t* image1, const uint8_t* image2) {
-  static bool (*diff_proc)(const uint8_t*, const uint8_t*) = nullptr;
-
-  if (!diff_proc) {
+VectorDifferenceProc GetVectorDifferenceProc() {
 #if defined(WEBRTC_ARCH_ARM_FAMILY) || defined(WEBRTC_ARCH_MIPS_FAMILY)
-    // For ARM and MIPS processors, always use C version.
-    // TODO(hclam): Implement a NEON version.
-    diff_proc = &VectorDifference_C;
+  // For ARM and MIPS processors, always use C version.
+  // TODO(hclam): Implement a NEON version.
+  return &VectorDifference_C;
 #else
-    bool have_sse2 = WebRtc_GetCPUInfo(kSSE2) != 0;
-    // For x86 processors, check if SSE2 is supported.
-    if (have_sse2 && kBlockSize == 32) {
-      diff_proc = &VectorDifference_SSE2_W32;
-    } else if (have_sse2 && kBlockSize == 16) {
-      diff_proc = &VectorDifference_SSE2_W16;
-    } else {
-      diff_proc = &VectorDifference_C;
-    }
-#endif
+  bool have_sse2 = WebRtc_GetCPUInfo(kSSE2) != 0;
+  bool have_avx2 = WebRtc_GetCPUInfo(kAVX2) != 0;
+  // For x86 processors, check if AVX2 or SSE2 is supported.
+  if (have_avx2 && kBlockSize == 32) {
+    return &VectorDifference_AVX2_W32;
+  } else if (have_sse2 && kBlockSize == 32) {
+    return &VectorDifference_SSE2_W32;
+  } else if (have_sse2 && kBlockSize == 16) {
+    return &VectorDifference_SSE2_W16;
+  } else {
+    return &VectorDifference_C;
   }
-
-  return diff_proc(image1, image2);
+#endif
 }
 
-bool BlockDifference(const uint8_t* image1,
-                     const uint8_t* image2,
-                     int height,
-                     int stride) {
+bool BlockDifference_Vector(const uint8_t* image1,
+                            const uint8_t* image2,
+                            int height,
+                            int stride) {
   for (int i = 0; i < height; i++) {
     if (VectorDifference(image1, image2)) {
       return true;
@@ -64,6 +63,33 @@ bool BlockDifference(const uint8_t* image1,
   return false;
 }
 
+BlockDifferenceProc GetBlockDifferenceProc() {
+#if !defined(WEBRTC_ARCH_ARM_FAMILY) && !defined(WEBRTC_ARCH_MIPS_FAMILY)
+  // The AVX2 version compares the rows of a block without an indirect call
+  // per row.
+  if (WebRtc_GetCPUInfo(kAVX2) != 0 && kBlockSize == 32)
+    return &BlockDifference_AVX2_W32;
+#endif
+  return &BlockDifference_Vector;
+}
+
+}  // namespace
+
+bool VectorDifference(const uint8_t* image1, const uint8_t* image2) {
+  // Frames may be compared on several threads, so the function is picked in a
+  // thread-safe static initializer.
+  static const VectorDifferenceProc diff_proc = GetVectorDifferenceProc();
+  return diff_proc(image1, image2);
+}
+
+bool BlockDifference(const uint8_t* image1,
+                     const uint8_t* image2,
+                     int height,
+                     int stride) {
+  static const BlockDifferenceProc diff_proc = GetBlockDifferenceProc();
+  return diff_proc(image1, image2, height, stride);
+}
+
 bool BlockDifference(const uint8_t* image1, const uint8_t* image2, int stride) {
   return BlockDifference(image1, image2, kBlockSize, stride);
 }
@@ -86,4 +86,26 @@ TEST(BlockDifferenceTestFirst, BlockDifference) {
   }
 }
 
+TEST(BlockDifferenceTestPartialHeight, BlockDifference) {
+  uint8_t* block1;
+  uint8_t* block2;
+  PrepareBuffers(block1, block2);
+  const int stride = kBlockSize * kBytesPerPixel;
+
+  for (int height = 1; height <= kBlockSize; ++height) {
+    EXPECT_FALSE(BlockDifference(block1, block2, height, stride));
+    // A difference in the last row is found, one in the row below is not.
+    uint8_t* last_row_pixel = block2 + (height - 1) * stride + stride - 1;
+    *last_row_pixel += 1;
+    EXPECT_TRUE(BlockDifference(block1, block2, height, stride));
+    EXPECT_FALSE(BlockDifference(block1, block2, height - 1, stride));
+    *last_row_pixel -= 1;
+    if (height < kBlockSize) {
+      block2[height * stride] += 1;
+      EXPECT_FALSE(BlockDifference(block1, block2, height, stride));
+      block2[height * stride] -= 1;
+    }
+  }
+}
+
 }  // namespace webrtc
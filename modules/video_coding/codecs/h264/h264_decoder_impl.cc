@@ -191,8 +191,8 @@ int32_t H264DecoderImpl::InitDecode(const VideoCodec* codec_settings,
   av_context_->extradata = nullptr;
   av_context_->extradata_size = 0;
 
-  // If this is ever increased, look at |av_context_->thread_safe_callbacks| and
-  // make it possible to disable the thread checker in the frame buffer pool.
+  // If this is ever increased, look at |av_context_->thread_safe_callbacks|.
+  // The frame buffer pool itself is thread safe.
   av_context_->thread_count = 1;
   av_context_->thread_type = FF_THREAD_SLICE;
 
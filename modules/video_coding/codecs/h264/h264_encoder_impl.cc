@@ -19,6 +19,7 @@
 #include <limits>
 #include <string>
 
+#include "absl/memory/memory.h"
 #include "absl/strings/match.h"
 #include "common_video/libyuv/include/webrtc_libyuv.h"
 #include "modules/video_coding/utility/simulcast_rate_allocator.h"
@@ -152,6 +153,7 @@ H264EncoderImpl::H264EncoderImpl(const cricket::VideoCodec& codec)
     : packetization_mode_(H264PacketizationMode::SingleNalUnit),
       max_payload_size_(0),
       number_of_cores_(0),
+      threading_policy_(EncoderThreadingPolicy::ParseFromFieldTrials()),
       encoded_image_callback_(nullptr),
       has_reported_init_(false),
       has_reported_error_(false) {
@@ -210,6 +212,8 @@ int32_t H264EncoderImpl::InitEncode(const VideoCodec* inst,
   tl0sync_limit_.resize(number_of_streams);
 
   number_of_cores_ = settings.number_of_cores;
+  active_encoder_ =
+      absl::make_unique<EncoderThreadingPolicy::ScopedActiveEncoder>();
   max_payload_size_ = settings.max_payload_size;
   codec_ = *inst;
 
@@ -315,6 +319,7 @@ int32_t H264EncoderImpl::Release() {
   encoded_images_.clear();
   pictures_.clear();
   tl0sync_limit_.clear();
+  active_encoder_.reset();
   return WEBRTC_VIDEO_CODEC_OK;
 }
 
@@ -555,12 +560,17 @@ SEncParamExt H264EncoderImpl::CreateEncoderParams(size_t i) const {
   // |keyFrameInterval| - number of frames
   encoder_params.uiIntraPeriod = configurations_[i].key_frame_interval;
   encoder_params.uiMaxNalSize = 0;
+  const EncoderThreadingPolicy::Settings threading =
+      threading_policy_.GetSettings(
+          kVideoCodecH264, encoder_params.iPicWidth, encoder_params.iPicHeight,
+          number_of_cores_,
+          NumberOfThreads(encoder_params.iPicWidth, encoder_params.iPicHeight,
+                          number_of_cores_));
   // Threading model: use auto.
   //  0: auto (dynamic imp. internal encoder)
   //  1: single thread (default value)
   // >1: number of threads
-  encoder_params.iMultipleThreadIdc = NumberOfThreads(
-      encoder_params.iPicWidth, encoder_params.iPicHeight, number_of_cores_);
+  encoder_params.iMultipleThreadIdc = threading.num_threads;
   // The base spatial layer 0 is the only one we use.
   encoder_params.sSpatialLayers[0].iVideoWidth = encoder_params.iPicWidth;
   encoder_params.sSpatialLayers[0].iVideoHeight = encoder_params.iPicHeight;
@@ -591,7 +601,10 @@ SEncParamExt H264EncoderImpl::CreateEncoderParams(size_t i) const {
       // design it with cpu core number.
       // TODO(sprang): Set to 0 when we understand why the rate controller borks
       //               when uiSliceNum > 1.
-      encoder_params.sSpatialLayers[0].sSliceArgument.uiSliceNum = 1;
+      // Until then, more slices are only encoded if the threading policy
+      // opts in to it.
+      encoder_params.sSpatialLayers[0].sSliceArgument.uiSliceNum =
+          threading.h264_num_slices;
       encoder_params.sSpatialLayers[0].sSliceArgument.uiSliceMode =
           SM_FIXEDSLCNUM_SLICE;
       break;
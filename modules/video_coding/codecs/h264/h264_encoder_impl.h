@@ -28,6 +28,7 @@
 #include "api/video_codecs/video_encoder.h"
 #include "common_video/h264/h264_bitstream_parser.h"
 #include "modules/video_coding/codecs/h264/include/h264.h"
+#include "modules/video_coding/utility/encoder_threading_policy.h"
 #include "modules/video_coding/utility/quality_scaler.h"
 #include "third_party/openh264/src/codec/api/svc/codec_app_def.h"
 
@@ -102,6 +103,9 @@ class H264EncoderImpl : public H264Encoder {
   H264PacketizationMode packetization_mode_;
   size_t max_payload_size_;
   int32_t number_of_cores_;
+  const EncoderThreadingPolicy threading_policy_;
+  // Set while initialized.
+  std::unique_ptr<EncoderThreadingPolicy::ScopedActiveEncoder> active_encoder_;
   EncodedImageCallback* encoded_image_callback_;
 
   bool has_reported_init_;
@@ -8,6 +8,8 @@
  *  be found in the AUTHORS file in the root of the source tree.
  */
 
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "absl/memory/memory.h"
@@ -18,10 +20,13 @@
 #include "media/engine/internal_decoder_factory.h"
 #include "media/engine/internal_encoder_factory.h"
 #include "media/engine/simulcast_encoder_adapter.h"
+#include "modules/video_coding/utility/encoder_threading_policy.h"
 #include "modules/video_coding/utility/vp8_header_parser.h"
 #include "modules/video_coding/utility/vp9_uncompressed_header_parser.h"
+#include "test/field_trial.h"
 #include "test/gtest.h"
 #include "test/testsupport/file_utils.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 namespace test {
@@ -86,6 +91,44 @@ void PrintRdPerf(std::map<size_t, std::vector<VideoStatistics>> rd_stats) {
     }
   }
 }
+
+// Encodes 720p with and without the encoder threading policy, alone and with
+// three other encoders in the process, and prints the encode speed.
+void RunEncodeSpeedPerf(const std::string& codec_name,
+                        const std::string& threading_trial) {
+  for (const std::string& field_trials : {std::string(), threading_trial}) {
+    for (int num_other_encoders : {0, 3}) {
+      test::ScopedFieldTrials scoped_field_trials(field_trials);
+      std::vector<std::unique_ptr<EncoderThreadingPolicy::ScopedActiveEncoder>>
+          other_encoders;
+      for (int i = 0; i < num_other_encoders; ++i) {
+        other_encoders.push_back(
+            absl::make_unique<EncoderThreadingPolicy::ScopedActiveEncoder>());
+      }
+
+      auto config = CreateConfig();
+      config.filename = "ConferenceMotion_1280_720_50";
+      config.filepath = ResourcePath(config.filename, "yuv");
+      config.num_frames = kNumFramesShort;
+      config.use_single_core = false;
+      config.SetCodecSettings(codec_name, 1, 1, 1, false, true, false, 1280,
+                              720);
+      auto fixture = CreateVideoCodecTestFixture(config);
+      std::vector<RateProfile> rate_profiles = {{1500, 30, 0}};
+      fixture->RunTest(rate_profiles, nullptr, nullptr, nullptr);
+
+      std::vector<VideoStatistics> layer_stats =
+          fixture->GetStats().SliceAndCalcLayerVideoStatistic(
+              0, config.num_frames - 1);
+      PrintResult("encode_speed",
+                  (field_trials.empty() ? "_default" : "_policy") +
+                      std::string("_") +
+                      std::to_string(num_other_encoders + 1) + "_encoders",
+                  codec_name + "_720p", layer_stats.back().enc_speed_fps,
+                  "fps", false);
+    }
+  }
+}
 }  // namespace
 
 #if defined(RTC_ENABLE_VP9)
@@ -430,6 +473,19 @@ TEST(VideoCodecTestLibvpx, MAYBE_SvcVP9) {
   fixture->RunTest(rate_profiles, &rc_thresholds, &quality_thresholds, nullptr);
 }
 
+TEST(VideoCodecTestLibvpx, DISABLED_EncodeSpeedVP8Perf) {
+  RunEncodeSpeedPerf(
+      cricket::kVp8CodecName,
+      "WebRTC-VideoEncoderThreading/Enabled,vp8_token_partitions:true/");
+}
+
+#if defined(RTC_ENABLE_VP9)
+TEST(VideoCodecTestLibvpx, DISABLED_EncodeSpeedVP9Perf) {
+  RunEncodeSpeedPerf(cricket::kVp9CodecName,
+                     "WebRTC-VideoEncoderThreading/Enabled,vp9_row_mt:true/");
+}
+#endif  // defined(RTC_ENABLE_VP9)
+
 TEST(VideoCodecTestLibvpx, DISABLED_MultiresVP8RdPerf) {
   auto config = CreateConfig();
   config.filename = "FourPeople_1280x720_30";
@@ -60,7 +60,6 @@ const char kVp8ForcePartitionResilience[] =
 constexpr int kLowVp8QpThreshold = 29;
 constexpr int kHighVp8QpThreshold = 95;
 
-constexpr int kTokenPartitions = VP8_ONE_TOKENPARTITION;
 constexpr uint32_t kVp832ByteAlign = 32u;
 
 constexpr int kRtpTicksPerSecond = 90000;
@@ -283,6 +282,7 @@ LibvpxVp8Encoder::LibvpxVp8Encoder(
       rate_control_settings_(RateControlSettings::ParseFromFieldTrials()),
       screenshare_max_qp_(
           ExperimentalScreenshareSettings::ParseFromFieldTrials().MaxQp()),
+      threading_policy_(EncoderThreadingPolicy::ParseFromFieldTrials()),
       encoded_complete_callback_(nullptr),
       inited_(false),
       timestamp_(0),
@@ -339,6 +339,7 @@ int LibvpxVp8Encoder::Release() {
   raw_images_.clear();
 
   frame_buffer_controller_.reset();
+  active_encoder_.reset();
   inited_ = false;
   return ret_val;
 }
@@ -635,8 +636,14 @@ int LibvpxVp8Encoder::InitEncode(const VideoCodec* inst,
 
   // Determine number of threads based on the image size and #cores.
   // TODO(fbarchard): Consider number of Simulcast layers.
-  vpx_configs_[0].g_threads = NumberOfThreads(
-      vpx_configs_[0].g_w, vpx_configs_[0].g_h, settings.number_of_cores);
+  active_encoder_ =
+      absl::make_unique<EncoderThreadingPolicy::ScopedActiveEncoder>();
+  threading_ = threading_policy_.GetSettings(
+      kVideoCodecVP8, vpx_configs_[0].g_w, vpx_configs_[0].g_h,
+      settings.number_of_cores,
+      NumberOfThreads(vpx_configs_[0].g_w, vpx_configs_[0].g_h,
+                      settings.number_of_cores));
+  vpx_configs_[0].g_threads = threading_.num_threads;
 
   // Creating a wrapper to the image - setting image data to NULL.
   // Actual pointer will be set in encode. Setting align to 1, as it
@@ -830,9 +837,9 @@ int LibvpxVp8Encoder::InitAndSetControlSettings() {
         &(encoders_[i]), VP8E_SET_STATIC_THRESHOLD,
         codec_.mode == VideoCodecMode::kScreensharing ? 100u : 1u);
     libvpx_->codec_control(&(encoders_[i]), VP8E_SET_CPUUSED, cpu_speed_[i]);
-    libvpx_->codec_control(
-        &(encoders_[i]), VP8E_SET_TOKEN_PARTITIONS,
-        static_cast<vp8e_token_partitions>(kTokenPartitions));
+    libvpx_->codec_control(&(encoders_[i]), VP8E_SET_TOKEN_PARTITIONS,
+                           static_cast<vp8e_token_partitions>(
+                               threading_.vp8_token_partitions_log2));
     libvpx_->codec_control(&(encoders_[i]), VP8E_SET_MAX_INTRA_BITRATE_PCT,
                            rc_max_intra_target_);
     // VP8E_SET_SCREEN_CONTENT_MODE 2 = screen content with more aggressive
@@ -24,6 +24,7 @@
 #include "modules/video_coding/codecs/vp8/include/vp8.h"
 #include "modules/video_coding/codecs/vp8/libvpx_interface.h"
 #include "modules/video_coding/include/video_codec_interface.h"
+#include "modules/video_coding/utility/encoder_threading_policy.h"
 #include "modules/video_coding/utility/framerate_controller.h"
 #include "rtc_base/experiments/cpu_speed_experiment.h"
 #include "rtc_base/experiments/rate_control_settings.h"
@@ -104,6 +105,10 @@ class LibvpxVp8Encoder : public VideoEncoder {
       experimental_cpu_speed_config_arm_;
   const RateControlSettings rate_control_settings_;
   const absl::optional<int> screenshare_max_qp_;
+  const EncoderThreadingPolicy threading_policy_;
+  // Set while initialized.
+  std::unique_ptr<EncoderThreadingPolicy::ScopedActiveEncoder> active_encoder_;
+  EncoderThreadingPolicy::Settings threading_;
 
   EncodedImageCallback* encoded_complete_callback_;
   VideoCodec codec_;
@@ -0,0 +1,150 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifdef RTC_ENABLE_VP9
+
+#include "modules/video_coding/codecs/vp9/vp9_frame_buffer_pool.h"
+
+#include <limits>
+#include <vector>
+
+#include "rtc_base/fake_clock.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
+
+namespace webrtc {
+namespace {
+
+constexpr size_t k720pBytes = 1280 * 720 * 3 / 2;
+constexpr size_t k360pBytes = 640 * 360 * 3 / 2;
+
+}  // namespace
+
+class Vp9FrameBufferPoolTest : public ::testing::Test {
+ protected:
+  Vp9FrameBufferPoolTest() { clock_.SetTime(Timestamp::ms(1000)); }
+
+  rtc::ScopedFakeClock clock_;
+};
+
+TEST_F(Vp9FrameBufferPoolTest, ReusesReleasedMemory) {
+  Vp9FrameBufferPool pool;
+  auto buffer = pool.GetFrameBuffer(k720pBytes);
+  ASSERT_TRUE(buffer);
+  EXPECT_EQ(k720pBytes, buffer->GetDataSize());
+  const uint8_t* data = buffer->GetData();
+  EXPECT_EQ(1, pool.GetNumBuffersInUse());
+  buffer = nullptr;
+  EXPECT_EQ(0, pool.GetNumBuffersInUse());
+
+  buffer = pool.GetFrameBuffer(k720pBytes - 100);
+  EXPECT_EQ(data, buffer->GetData());
+  EXPECT_EQ(k720pBytes - 100, buffer->GetDataSize());
+  Vp9FrameBufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(1u, stats.num_hits);
+  EXPECT_EQ(1u, stats.num_misses);
+  EXPECT_EQ(1u, stats.num_buffers);
+  EXPECT_EQ(stats.allocated_bytes, stats.in_use_bytes);
+  EXPECT_GE(stats.allocated_bytes, k720pBytes);
+}
+
+TEST_F(Vp9FrameBufferPoolTest, DoesNotReuseMuchLargerMemory) {
+  Vp9FrameBufferPool pool;
+  pool.GetFrameBuffer(k720pBytes);
+  auto buffer = pool.GetFrameBuffer(k360pBytes);
+  Vp9FrameBufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(0u, stats.num_hits);
+  EXPECT_EQ(2u, stats.num_buffers);
+  EXPECT_EQ(1u, stats.num_buffers_in_use);
+}
+
+TEST_F(Vp9FrameBufferPoolTest, ReleasesIdleMemoryAfterResolutionChange) {
+  Vp9FrameBufferPool pool;
+  std::vector<rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer>> buffers;
+  for (int i = 0; i < 10; ++i)
+    buffers.push_back(pool.GetFrameBuffer(k720pBytes));
+  buffers.clear();
+  const size_t peak_bytes = pool.GetStats().allocated_bytes;
+
+  // Keep decoding at the lower resolution.
+  for (int i = 0; i < 100; ++i) {
+    clock_.AdvanceTime(TimeDelta::ms(33));
+    pool.GetFrameBuffer(k360pBytes);
+  }
+  Vp9FrameBufferPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(1u, stats.num_buffers);
+  EXPECT_LT(stats.allocated_bytes, k720pBytes);
+  EXPECT_GE(stats.peak_allocated_bytes, peak_bytes);
+}
+
+TEST_F(Vp9FrameBufferPoolTest, EnforcesMaxNumBuffers) {
+  Vp9FrameBufferPool pool(2, std::numeric_limits<size_t>::max());
+  auto buffer1 = pool.GetFrameBuffer(k360pBytes);
+  auto buffer2 = pool.GetFrameBuffer(k360pBytes);
+  EXPECT_FALSE(pool.GetFrameBuffer(k360pBytes));
+  EXPECT_EQ(1u, pool.GetStats().num_failures);
+
+  // Unused memory is released to make room for the new size.
+  buffer1 = nullptr;
+  auto buffer3 = pool.GetFrameBuffer(k720pBytes);
+  ASSERT_TRUE(buffer3);
+  EXPECT_EQ(2u, pool.GetStats().num_buffers);
+}
+
+TEST_F(Vp9FrameBufferPoolTest, EnforcesMaxAllocatedBytes) {
+  Vp9FrameBufferPool pool(Vp9FrameBufferPool::kDefaultMaxNumBuffers,
+                          2 * k720pBytes);
+  auto buffer1 = pool.GetFrameBuffer(k720pBytes);
+  EXPECT_FALSE(pool.GetFrameBuffer(k720pBytes));
+  auto buffer2 = pool.GetFrameBuffer(k360pBytes);
+  ASSERT_TRUE(buffer2);
+  EXPECT_LE(pool.GetStats().allocated_bytes, 2 * k720pBytes);
+}
+
+TEST_F(Vp9FrameBufferPoolTest, BuffersOutliveClearedAndDestroyedPool) {
+  rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer> buffer;
+  {
+    Vp9FrameBufferPool pool;
+    buffer = pool.GetFrameBuffer(k360pBytes);
+    pool.GetFrameBuffer(k360pBytes);
+    pool.ClearPool();
+    Vp9FrameBufferPool::Stats stats = pool.GetStats();
+    EXPECT_EQ(1u, stats.num_buffers);
+    EXPECT_EQ(1u, stats.num_buffers_in_use);
+  }
+  EXPECT_TRUE(buffer->HasOneRef());
+  buffer->GetData()[k360pBytes - 1] = 0;
+}
+
+TEST_F(Vp9FrameBufferPoolTest, DISABLED_GetFrameBufferPerf) {
+  constexpr int kNumIterations = 100000;
+  // Buffers held by the decoder and the application.
+  constexpr int kNumBuffersInUse = 60;
+  Vp9FrameBufferPool pool;
+  std::vector<rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer>> buffers(
+      kNumBuffersInUse);
+  const int64_t start_ns = rtc::SystemTimeNanos();
+  for (int i = 0; i < kNumIterations; ++i)
+    buffers[i % kNumBuffersInUse] = pool.GetFrameBuffer(k720pBytes);
+  const int64_t elapsed_ns = rtc::SystemTimeNanos() - start_ns;
+  Vp9FrameBufferPool::Stats stats = pool.GetStats();
+  test::PrintResult("vp9_frame_buffer_pool", "", "get_frame_buffer_time",
+                    static_cast<double>(elapsed_ns) / kNumIterations, "ns",
+                    false);
+  test::PrintResult("vp9_frame_buffer_pool", "", "resident_bytes",
+                    stats.allocated_bytes, "bytes", false);
+  test::PrintResult("vp9_frame_buffer_pool", "", "hit_rate", stats.hit_rate(),
+                    "", false);
+}
+
+}  // namespace webrtc
+
+#endif  // RTC_ENABLE_VP9
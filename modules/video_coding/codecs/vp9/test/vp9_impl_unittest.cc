@@ -139,6 +139,8 @@ TEST_F(TestVp9Impl, EncodeDecode) {
   ASSERT_TRUE(WaitForDecodedFrame(&decoded_frame, &decoded_qp));
   ASSERT_TRUE(decoded_frame);
   EXPECT_GT(I420PSNR(input_frame, decoded_frame.get()), 36);
+  // The decoded frame is kept in a frame buffer of the pool.
+  EXPECT_GT(decoder_->FrameBufferBytes(), 0u);
 
   const ColorSpace color_space = *decoded_frame->color_space();
   EXPECT_EQ(ColorSpace::PrimaryID::kUnspecified, color_space.primaries());
@@ -13,27 +13,79 @@
 
 #include "modules/video_coding/codecs/vp9/vp9_frame_buffer_pool.h"
 
+#include <limits>
+#include <utility>
+
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
 #include "rtc_base/ref_counted_object.h"
+#include "rtc_base/time_utils.h"
 #include "vpx/vpx_codec.h"
 #include "vpx/vpx_decoder.h"
 #include "vpx/vpx_frame_buffer.h"
 
 namespace webrtc {
+namespace {
+
+constexpr int64_t kTrimIntervalMs = 500;
+
+}  // namespace
+
+constexpr size_t Vp9FrameBufferPool::kDefaultMaxNumBuffers;
+constexpr int64_t Vp9FrameBufferPool::kMaxIdleTimeMs;
+
+// Returns its memory block to the storage when the last reference is gone.
+class Vp9FrameBufferPool::PooledFrameBuffer : public Vp9FrameBuffer {
+ public:
+  PooledFrameBuffer(rtc::scoped_refptr<Storage> storage,
+                    uint32_t index,
+                    size_t size)
+      : Vp9FrameBuffer(storage->data(index), size, storage->block_bytes(index)),
+        storage_(std::move(storage)),
+        index_(index) {}
+
+ protected:
+  ~PooledFrameBuffer() override { storage_->Return(index_); }
+
+ private:
+  const rtc::scoped_refptr<Storage> storage_;
+  const uint32_t index_;
+};
+
+Vp9FrameBufferPool::Vp9FrameBuffer::Vp9FrameBuffer(uint8_t* data,
+                                                   size_t size,
+                                                   size_t capacity)
+    : data_(data), size_(size), capacity_(capacity) {}
+
+Vp9FrameBufferPool::Vp9FrameBuffer::~Vp9FrameBuffer() = default;
 
 uint8_t* Vp9FrameBufferPool::Vp9FrameBuffer::GetData() {
-  return data_.data<uint8_t>();
+  return data_;
 }
 
 size_t Vp9FrameBufferPool::Vp9FrameBuffer::GetDataSize() const {
-  return data_.size();
+  return size_;
 }
 
 void Vp9FrameBufferPool::Vp9FrameBuffer::SetSize(size_t size) {
-  data_.SetSize(size);
+  RTC_DCHECK_LE(size, capacity_);
+  size_ = size;
 }
 
+Vp9FrameBufferPool::Vp9FrameBufferPool()
+    : Vp9FrameBufferPool(kDefaultMaxNumBuffers,
+                         std::numeric_limits<size_t>::max()) {}
+
+Vp9FrameBufferPool::Vp9FrameBufferPool(size_t max_num_buffers,
+                                       size_t max_allocated_bytes)
+    : storage_(new rtc::RefCountedObject<Storage>(max_num_buffers,
+                                                  max_allocated_bytes,
+                                                  /*zero_initialize=*/false,
+                                                  kMaxIdleTimeMs,
+                                                  kTrimIntervalMs)) {}
+
+Vp9FrameBufferPool::~Vp9FrameBufferPool() = default;
+
 bool Vp9FrameBufferPool::InitializeVpxUsePool(
     vpx_codec_ctx* vpx_codec_context) {
   RTC_DCHECK(vpx_codec_context);
@@ -56,50 +108,32 @@ bool Vp9FrameBufferPool::InitializeVpxUsePool(
 rtc::scoped_refptr<Vp9FrameBufferPool::Vp9FrameBuffer>
 Vp9FrameBufferPool::GetFrameBuffer(size_t min_size) {
   RTC_DCHECK_GT(min_size, 0);
-  rtc::scoped_refptr<Vp9FrameBuffer> available_buffer = nullptr;
-  {
-    rtc::CritScope cs(&buffers_lock_);
-    // Do we have a buffer we can recycle?
-    for (const auto& buffer : allocated_buffers_) {
-      if (buffer->HasOneRef()) {
-        available_buffer = buffer;
-        break;
-      }
-    }
-    // Otherwise create one.
-    if (available_buffer == nullptr) {
-      available_buffer = new rtc::RefCountedObject<Vp9FrameBuffer>();
-      allocated_buffers_.push_back(available_buffer);
-      if (allocated_buffers_.size() > max_num_buffers_) {
-        RTC_LOG(LS_WARNING)
-            << allocated_buffers_.size() << " Vp9FrameBuffers have been "
-            << "allocated by a Vp9FrameBufferPool (exceeding what is "
-            << "considered reasonable, " << max_num_buffers_ << ").";
-
-        // TODO(phoglund): this limit is being hit in tests since Oct 5 2016.
-        // See https://bugs.chromium.org/p/webrtc/issues/detail?id=6484.
-        // RTC_NOTREACHED();
-      }
-    }
+  const int size_class = Storage::SizeClassForBytes(min_size);
+  uint32_t index;
+  if (size_class == Storage::kNumSizeClasses ||
+      storage_->Acquire(size_class, &index) != Storage::Result::kAcquired) {
+    storage_->CountFailure();
+    Stats stats = storage_->GetStats();
+    RTC_LOG(LS_WARNING) << "Vp9FrameBufferPool is full: " << stats.num_buffers
+                        << " buffers of " << stats.allocated_bytes
+                        << " bytes are allocated, "
+                        << stats.num_buffers_in_use << " in use.";
+    return nullptr;
   }
-
-  available_buffer->SetSize(min_size);
-  return available_buffer;
+  return new rtc::RefCountedObject<PooledFrameBuffer>(storage_, index,
+                                                      min_size);
 }
 
 int Vp9FrameBufferPool::GetNumBuffersInUse() const {
-  int num_buffers_in_use = 0;
-  rtc::CritScope cs(&buffers_lock_);
-  for (const auto& buffer : allocated_buffers_) {
-    if (!buffer->HasOneRef())
-      ++num_buffers_in_use;
-  }
-  return num_buffers_in_use;
+  return static_cast<int>(storage_->GetStats().num_buffers_in_use);
 }
 
 void Vp9FrameBufferPool::ClearPool() {
-  rtc::CritScope cs(&buffers_lock_);
-  allocated_buffers_.clear();
+  storage_->FreeIdleBlocks(rtc::TimeMillis(), 0);
+}
+
+Vp9FrameBufferPool::Stats Vp9FrameBufferPool::GetStats() const {
+  return storage_->GetStats();
 }
 
 // static
@@ -111,6 +145,8 @@ int32_t Vp9FrameBufferPool::VpxGetFrameBuffer(void* user_priv,
   Vp9FrameBufferPool* pool = static_cast<Vp9FrameBufferPool*>(user_priv);
 
   rtc::scoped_refptr<Vp9FrameBuffer> buffer = pool->GetFrameBuffer(min_size);
+  if (!buffer)
+    return -1;
   fb->data = buffer->GetData();
   fb->size = buffer->GetDataSize();
   // Store Vp9FrameBuffer* in |priv| for use in VpxReleaseFrameBuffer.
@@ -14,11 +14,11 @@
 
 #ifdef RTC_ENABLE_VP9
 
-#include <vector>
+#include <stddef.h>
+#include <stdint.h>
 
 #include "api/scoped_refptr.h"
-#include "rtc_base/buffer.h"
-#include "rtc_base/critical_section.h"
+#include "common_video/include/size_class_block_pool.h"
 #include "rtc_base/ref_count.h"
 
 struct vpx_codec_ctx;
@@ -36,6 +36,10 @@ namespace webrtc {
 // using scoped_refptr, the image buffer can be reused by VideoFrames and no
 // frame copy has to occur during decoding and frame delivery.
 //
+// The memory is kept in size classes, so getting a buffer doesn't depend on how
+// many buffers the pool holds. Memory that stays unused, e.g. that of the old
+// resolution after a resolution change, is released after kMaxIdleTimeMs.
+//
 // Pseudo example usage case:
 //    Vp9FrameBufferPool pool;
 //    pool.InitializeVpxUsePool(decoder_ctx);
@@ -54,33 +58,65 @@ namespace webrtc {
 //    vpx_codec_destroy(decoder_ctx);
 class Vp9FrameBufferPool {
  public:
+  using Stats = SizeClassBlockPool::Stats;
+
   class Vp9FrameBuffer : public rtc::RefCountInterface {
    public:
     uint8_t* GetData();
     size_t GetDataSize() const;
+    // |size| must not exceed the size of the memory block the buffer uses.
     void SetSize(size_t size);
 
     virtual bool HasOneRef() const = 0;
 
+   protected:
+    Vp9FrameBuffer(uint8_t* data, size_t size, size_t capacity);
+    ~Vp9FrameBuffer() override;
+
    private:
-    // Data as an easily resizable buffer.
-    rtc::Buffer data_;
+    uint8_t* const data_;
+    size_t size_;
+    const size_t capacity_;
   };
 
+  // If more buffers than this are needed, GetFrameBuffer fails. VP9 is
+  // defined to have 8 reference buffers, of which 3 can be referenced by any
+  // frame, see
+  // https://tools.ietf.org/html/draft-grange-vp9-bitstream-00#section-2.2.2.
+  // Assuming VP9 holds on to at most 8 buffers, any more buffers than that
+  // would have to be by application code. Decoded frames should not be
+  // referenced for longer than necessary. If we allow ~60 additional buffers
+  // then the application has ~1 second to e.g. render each frame of a 60 fps
+  // video.
+  static constexpr size_t kDefaultMaxNumBuffers = 68;
+  // Unused memory is released after this long, e.g. the buffers of the old
+  // resolution after a resolution change.
+  static constexpr int64_t kMaxIdleTimeMs = 2000;
+
+  Vp9FrameBufferPool();
+  // |max_allocated_bytes| caps the total size of the memory blocks, in use or
+  // not.
+  Vp9FrameBufferPool(size_t max_num_buffers, size_t max_allocated_bytes);
+  ~Vp9FrameBufferPool();
+
   // Configures libvpx to, in the specified context, use this memory pool for
   // buffers used to decompress frames. This is only supported for VP9.
   bool InitializeVpxUsePool(vpx_codec_ctx* vpx_codec_context);
 
-  // Gets a frame buffer of at least |min_size|, recycling an available one or
-  // creating a new one. When no longer referenced from the outside the buffer
-  // becomes recyclable.
+  // Gets a frame buffer of at least |min_size|, recycling the memory of a
+  // released buffer of about the same size or allocating new memory. The
+  // memory returns to the pool when the buffer is no longer referenced.
+  // Returns null if the buffer would exceed the number of buffers or bytes
+  // the pool may hold, and no unused memory can be released to make room.
   rtc::scoped_refptr<Vp9FrameBuffer> GetFrameBuffer(size_t min_size);
   // Gets the number of buffers currently in use (not ready to be recycled).
   int GetNumBuffersInUse() const;
-  // Releases allocated buffers, deleting available buffers. Buffers in use are
-  // not deleted until they are no longer referenced.
+  // Releases all unused memory. Buffers in use keep their memory until they
+  // are no longer referenced, at which point it returns to the pool.
   void ClearPool();
 
+  Stats GetStats() const;
+
   // InitializeVpxUsePool configures libvpx to call this function when it needs
   // a new frame buffer. Parameters:
   // |user_priv| Private data passed to libvpx, InitializeVpxUsePool sets it up
@@ -103,21 +139,10 @@ class Vp9FrameBufferPool {
                                        vpx_codec_frame_buffer* fb);
 
  private:
-  // Protects |allocated_buffers_|.
-  rtc::CriticalSection buffers_lock_;
-  // All buffers, in use or ready to be recycled.
-  std::vector<rtc::scoped_refptr<Vp9FrameBuffer>> allocated_buffers_
-      RTC_GUARDED_BY(buffers_lock_);
-  // If more buffers than this are allocated we print warnings and crash if in
-  // debug mode. VP9 is defined to have 8 reference buffers, of which 3 can be
-  // referenced by any frame, see
-  // https://tools.ietf.org/html/draft-grange-vp9-bitstream-00#section-2.2.2.
-  // Assuming VP9 holds on to at most 8 buffers, any more buffers than that
-  // would have to be by application code. Decoded frames should not be
-  // referenced for longer than necessary. If we allow ~60 additional buffers
-  // then the application has ~1 second to e.g. render each frame of a 60 fps
-  // video.
-  static const size_t max_num_buffers_ = 68;
+  using Storage = SizeClassBlockPool;
+  class PooledFrameBuffer;
+
+  const rtc::scoped_refptr<Storage> storage_;
 };
 
 }  // namespace webrtc
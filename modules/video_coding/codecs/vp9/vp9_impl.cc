@@ -31,6 +31,7 @@
 #include "rtc_base/time_utils.h"
 #include "rtc_base/trace_event.h"
 #include "system_wrappers/include/field_trial.h"
+#include "system_wrappers/include/metrics.h"
 #include "vpx/vp8cx.h"
 #include "vpx/vp8dx.h"
 #include "vpx/vpx_decoder.h"
@@ -215,6 +216,7 @@ VP9EncoderImpl::VP9EncoderImpl(const cricket::VideoCodec& codec)
       timestamp_(0),
       cpu_speed_(3),
       rc_max_intra_target_(0),
+      threading_policy_(EncoderThreadingPolicy::ParseFromFieldTrials()),
       encoder_(nullptr),
       config_(nullptr),
       raw_(nullptr),
@@ -277,6 +279,7 @@ int VP9EncoderImpl::Release() {
     vpx_img_free(raw_);
     raw_ = nullptr;
   }
+  active_encoder_.reset();
   inited_ = false;
   return ret_val;
 }
@@ -516,8 +519,12 @@ int VP9EncoderImpl::InitEncode(const VideoCodec* inst,
   config_->kf_min_dist = config_->kf_max_dist;
   config_->rc_resize_allowed = inst->VP9().automaticResizeOn ? 1 : 0;
   // Determine number of threads based on the image size and #cores.
-  config_->g_threads =
-      NumberOfThreads(config_->g_w, config_->g_h, settings.number_of_cores);
+  active_encoder_ =
+      absl::make_unique<EncoderThreadingPolicy::ScopedActiveEncoder>();
+  threading_ = threading_policy_.GetSettings(
+      kVideoCodecVP9, config_->g_w, config_->g_h, settings.number_of_cores,
+      NumberOfThreads(config_->g_w, config_->g_h, settings.number_of_cores));
+  config_->g_threads = threading_.num_threads;
 
   cpu_speed_ = GetCpuSpeed(config_->g_w, config_->g_h);
 
@@ -749,10 +756,11 @@ int VP9EncoderImpl::InitAndSetControlSettings(const VideoCodec* inst) {
   // log2 unit: e.g., 0 = 1 tile column, 1 = 2 tile columns, 2 = 4 tile columns.
   // The number tile columns will be capped by the encoder based on image size
   // (minimum width of tile column is 256 pixels, maximum is 4096).
-  vpx_codec_control(encoder_, VP9E_SET_TILE_COLUMNS, (config_->g_threads >> 1));
+  vpx_codec_control(encoder_, VP9E_SET_TILE_COLUMNS,
+                    threading_.vp9_tile_columns_log2);
 
   // Turn on row-based multithreading.
-  vpx_codec_control(encoder_, VP9E_SET_ROW_MT, 1);
+  vpx_codec_control(encoder_, VP9E_SET_ROW_MT, threading_.vp9_row_mt ? 1 : 0);
 
 #if !defined(WEBRTC_ARCH_ARM) && !defined(WEBRTC_ARCH_ARM64) && \
     !defined(ANDROID)
@@ -1590,6 +1598,19 @@ VP9DecoderImpl::~VP9DecoderImpl() {
     RTC_LOG(LS_INFO) << num_buffers_in_use << " Vp9FrameBuffers are still "
                      << "referenced during ~VP9DecoderImpl.";
   }
+  const Vp9FrameBufferPool::Stats stats = frame_buffer_pool_.GetStats();
+  if (stats.num_hits + stats.num_misses > 0) {
+    RTC_LOG(LS_INFO) << "Vp9FrameBufferPool held at most "
+                     << stats.peak_allocated_bytes << " bytes, hit rate "
+                     << stats.hit_rate() << ", " << stats.num_failures
+                     << " failed requests.";
+    RTC_HISTOGRAM_COUNTS("WebRTC.Video.Vp9Decoder.FrameBufferPoolPeakKb",
+                         static_cast<int>(stats.peak_allocated_bytes / 1024),
+                         1, 1000000, 50);
+    RTC_HISTOGRAM_PERCENTAGE(
+        "WebRTC.Video.Vp9Decoder.FrameBufferPoolHitRatePercent",
+        static_cast<int>(100 * stats.hit_rate()));
+  }
 }
 
 int VP9DecoderImpl::InitDecode(const VideoCodec* inst, int number_of_cores) {
@@ -1754,9 +1775,9 @@ int VP9DecoderImpl::Release() {
     delete decoder_;
     decoder_ = nullptr;
   }
-  // Releases buffers from the pool. Any buffers not in use are deleted. Buffers
-  // still referenced externally are deleted once fully released, not returning
-  // to the pool.
+  // Releases the unused memory of the pool. Buffers still referenced
+  // externally return their memory to the pool once fully released, where it
+  // is reused or released after Vp9FrameBufferPool::kMaxIdleTimeMs.
   frame_buffer_pool_.ClearPool();
   inited_ = false;
   return ret_val;
@@ -1766,6 +1787,10 @@ const char* VP9DecoderImpl::ImplementationName() const {
   return "libvpx";
 }
 
+size_t VP9DecoderImpl::FrameBufferBytes() const {
+  return frame_buffer_pool_.GetStats().allocated_bytes;
+}
+
 }  // namespace webrtc
 
 #endif  // RTC_ENABLE_VP9
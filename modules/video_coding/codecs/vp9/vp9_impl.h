@@ -24,6 +24,7 @@
 #include "media/base/vp9_profile.h"
 #include "modules/video_coding/codecs/vp9/include/vp9.h"
 #include "modules/video_coding/codecs/vp9/vp9_frame_buffer_pool.h"
+#include "modules/video_coding/utility/encoder_threading_policy.h"
 #include "modules/video_coding/utility/framerate_controller.h"
 #include "vpx/vp8cx.h"
 #include "vpx/vpx_decoder.h"
@@ -107,6 +108,10 @@ class VP9EncoderImpl : public VP9Encoder {
   int64_t timestamp_;
   int cpu_speed_;
   uint32_t rc_max_intra_target_;
+  const EncoderThreadingPolicy threading_policy_;
+  // Set while initialized.
+  std::unique_ptr<EncoderThreadingPolicy::ScopedActiveEncoder> active_encoder_;
+  EncoderThreadingPolicy::Settings threading_;
   vpx_codec_ctx_t* encoder_;
   vpx_codec_enc_cfg_t* config_;
   vpx_image_t* raw_;
@@ -195,6 +200,8 @@ class VP9DecoderImpl : public VP9Decoder {
 
   const char* ImplementationName() const override;
 
+  size_t FrameBufferBytes() const override;
+
  private:
   int ReturnFrame(const vpx_image_t* img,
                   uint32_t timestamp,
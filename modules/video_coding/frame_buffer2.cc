@@ -13,7 +13,6 @@
 #include <algorithm>
 #include <cstdlib>
 #include <iterator>
-#include <queue>
 #include <utility>
 #include <vector>
 
@@ -26,6 +25,7 @@
 #include "rtc_base/checks.h"
 #include "rtc_base/experiments/rtt_mult_experiment.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/numerics/bit_ops.h"
 #include "rtc_base/numerics/sequence_number_util.h"
 #include "rtc_base/trace_event.h"
 #include "system_wrappers/include/clock.h"
@@ -46,12 +46,36 @@ constexpr int kMaxFramesHistory = 1 << 13;
 constexpr int kMaxAllowedFrameDelayMs = 5;
 
 constexpr int64_t kLogNonDecodedIntervalMs = 5000;
+
+// Number of consecutive picture ids the frame index can hold initially.
+// Buffered frames, and the undecoded frames they reference, must all lie
+// within this window, which is doubled on demand up to |kMaxFrameWindowSize|.
+// For H264 and generic streams the picture ids are RTP sequence numbers, so
+// the max window fits |kMaxFramesBuffered| frames of about 1300 packets each.
+// Both must be powers of two.
+constexpr int64_t kInitialFrameWindowSize = 1 << 12;
+constexpr int64_t kMaxFrameWindowSize = 1 << 20;
+static_assert((kInitialFrameWindowSize & (kInitialFrameWindowSize - 1)) == 0,
+              "kInitialFrameWindowSize must be a power of two.");
+static_assert((kMaxFrameWindowSize & (kMaxFrameWindowSize - 1)) == 0,
+              "kMaxFrameWindowSize must be a power of two.");
+
+constexpr int kBitsPerMaskWord = 64;
+
 }  // namespace
 
+constexpr uint16_t FrameBuffer::kNoFrameInfo;
+
 FrameBuffer::FrameBuffer(Clock* clock,
                          VCMTiming* timing,
                          VCMReceiveStatisticsCallback* stats_callback)
-    : decoded_frames_history_(kMaxFramesHistory),
+    : frame_index_(1),
+      picture_mask_(kInitialFrameWindowSize / kBitsPerMaskWord, 0),
+      frame_window_size_(kInitialFrameWindowSize),
+      num_frames_(0),
+      first_picture_id_(0),
+      last_picture_id_(0),
+      decoded_frames_history_(kMaxFramesHistory),
       clock_(clock),
       callback_queue_(nullptr),
       jitter_estimator_(clock),
@@ -164,90 +188,104 @@ int64_t FrameBuffer::FindNextFrame(int64_t now_ms) {
   int64_t wait_ms = latest_return_time_ms_ - now_ms;
   frames_to_decode_.clear();
 
-  // |last_continuous_frame_| may be empty below, but nullopt is smaller
-  // than everything else and loop will immediately terminate as expected.
-  for (auto frame_it = frames_.begin();
-       frame_it != frames_.end() && frame_it->first <= last_continuous_frame_;
-       ++frame_it) {
-    if (!frame_it->second.continuous ||
-        frame_it->second.num_missing_decodable > 0) {
-      continue;
-    }
+  // Frames are visited in (picture id, spatial layer) order up to and
+  // including the last continuous frame. If there is no continuous frame the
+  // loop terminates immediately.
+  bool found_frame = false;
+  for (absl::optional<int64_t> picture_id = NextPictureId(first_picture_id_);
+       !found_frame && picture_id && last_continuous_frame_ &&
+       *picture_id <= last_continuous_frame_->picture_id;
+       picture_id = NextPictureId(*picture_id + 1)) {
+    for (size_t layer = 0; layer < frame_index_.size(); ++layer) {
+      VideoLayerFrameId id(*picture_id, static_cast<uint8_t>(layer));
+      if (*last_continuous_frame_ < id)
+        break;
 
-    EncodedFrame* frame = frame_it->second.frame.get();
+      uint16_t index = FindFrameInfo(id);
+      if (index == kNoFrameInfo)
+        continue;
 
-    if (keyframe_required_ && !frame->is_keyframe())
-      continue;
+      const FrameInfo& info = frame_infos_[index];
+      if (!info.continuous || info.num_missing_decodable > 0)
+        continue;
 
-    auto last_decoded_frame_timestamp =
-        decoded_frames_history_.GetLastDecodedFrameTimestamp();
+      EncodedFrame* frame = info.frame.get();
 
-    // TODO(https://bugs.webrtc.org/9974): consider removing this check
-    // as it may make a stream undecodable after a very long delay between
-    // frames.
-    if (last_decoded_frame_timestamp &&
-        AheadOf(*last_decoded_frame_timestamp, frame->Timestamp())) {
-      continue;
-    }
+      if (keyframe_required_ && !frame->is_keyframe())
+        continue;
 
-    // Only ever return all parts of a superframe. Therefore skip this
-    // frame if it's not a beginning of a superframe.
-    if (frame->inter_layer_predicted) {
-      continue;
-    }
+      auto last_decoded_frame_timestamp =
+          decoded_frames_history_.GetLastDecodedFrameTimestamp();
 
-    // Gather all remaining frames for the same superframe.
-    std::vector<FrameMap::iterator> current_superframe;
-    current_superframe.push_back(frame_it);
-    bool last_layer_completed = frame_it->second.frame->is_last_spatial_layer;
-    FrameMap::iterator next_frame_it = frame_it;
-    while (true) {
-      ++next_frame_it;
-      if (next_frame_it == frames_.end() ||
-          next_frame_it->first.picture_id != frame->id.picture_id ||
-          !next_frame_it->second.continuous) {
-        break;
+      // TODO(https://bugs.webrtc.org/9974): consider removing this check
+      // as it may make a stream undecodable after a very long delay between
+      // frames.
+      if (last_decoded_frame_timestamp &&
+          AheadOf(*last_decoded_frame_timestamp, frame->Timestamp())) {
+        continue;
       }
-      // Check if the next frame has some undecoded references other than
-      // the previous frame in the same superframe.
-      size_t num_allowed_undecoded_refs =
-          (next_frame_it->second.frame->inter_layer_predicted) ? 1 : 0;
-      if (next_frame_it->second.num_missing_decodable >
-          num_allowed_undecoded_refs) {
-        break;
+
+      // Only ever return all parts of a superframe. Therefore skip this
+      // frame if it's not a beginning of a superframe.
+      if (frame->inter_layer_predicted) {
+        continue;
       }
-      // All frames in the superframe should have the same timestamp.
-      if (frame->Timestamp() != next_frame_it->second.frame->Timestamp()) {
-        RTC_LOG(LS_WARNING) << "Frames in a single superframe have different"
-                               " timestamps. Skipping undecodable superframe.";
-        break;
+
+      // Gather all remaining frames for the same superframe.
+      SuperFrameIndices current_superframe;
+      current_superframe.push_back(index);
+      bool last_layer_completed = frame->is_last_spatial_layer;
+      for (size_t next_layer = layer + 1; next_layer < frame_index_.size();
+           ++next_layer) {
+        uint16_t next_index = FindFrameInfo(
+            VideoLayerFrameId(*picture_id, static_cast<uint8_t>(next_layer)));
+        if (next_index == kNoFrameInfo)
+          continue;
+        const FrameInfo& next_info = frame_infos_[next_index];
+        if (!next_info.continuous)
+          break;
+        // Check if the next frame has some undecoded references other than
+        // the previous frame in the same superframe.
+        size_t num_allowed_undecoded_refs =
+            (next_info.frame->inter_layer_predicted) ? 1 : 0;
+        if (next_info.num_missing_decodable > num_allowed_undecoded_refs) {
+          break;
+        }
+        // All frames in the superframe should have the same timestamp.
+        if (frame->Timestamp() != next_info.frame->Timestamp()) {
+          RTC_LOG(LS_WARNING)
+              << "Frames in a single superframe have different"
+                 " timestamps. Skipping undecodable superframe.";
+          break;
+        }
+        current_superframe.push_back(next_index);
+        last_layer_completed = next_info.frame->is_last_spatial_layer;
+      }
+      // Check if the current superframe is complete.
+      // TODO(bugs.webrtc.org/10064): consider returning all available to
+      // decode frames even if the superframe is not complete yet.
+      if (!last_layer_completed) {
+        continue;
       }
-      current_superframe.push_back(next_frame_it);
-      last_layer_completed = next_frame_it->second.frame->is_last_spatial_layer;
-    }
-    // Check if the current superframe is complete.
-    // TODO(bugs.webrtc.org/10064): consider returning all available to
-    // decode frames even if the superframe is not complete yet.
-    if (!last_layer_completed) {
-      continue;
-    }
 
-    frames_to_decode_ = std::move(current_superframe);
+      frames_to_decode_ = std::move(current_superframe);
 
-    if (frame->RenderTime() == -1) {
-      frame->SetRenderTime(timing_->RenderTimeMs(frame->Timestamp(), now_ms));
+      if (frame->RenderTime() == -1) {
+        frame->SetRenderTime(timing_->RenderTimeMs(frame->Timestamp(), now_ms));
+      }
+      wait_ms = timing_->MaxWaitingTime(frame->RenderTime(), now_ms);
+
+      // This will cause the frame buffer to prefer high framerate rather
+      // than high resolution in the case of the decoder not decoding fast
+      // enough and the stream has multiple spatial and temporal layers.
+      // For multiple temporal layers it may cause non-base layer frames to be
+      // skipped if they are late.
+      if (wait_ms < -kMaxAllowedFrameDelayMs)
+        continue;
+
+      found_frame = true;
+      break;
     }
-    wait_ms = timing_->MaxWaitingTime(frame->RenderTime(), now_ms);
-
-    // This will cause the frame buffer to prefer high framerate rather
-    // than high resolution in the case of the decoder not decoding fast
-    // enough and the stream has multiple spatial and temporal layers.
-    // For multiple temporal layers it may cause non-base layer frames to be
-    // skipped if they are late.
-    if (wait_ms < -kMaxAllowedFrameDelayMs)
-      continue;
-
-    break;
   }
   wait_ms = std::min<int64_t>(wait_ms, latest_return_time_ms_ - now_ms);
   wait_ms = std::max<int64_t>(wait_ms, 0);
@@ -262,7 +300,7 @@ EncodedFrame* FrameBuffer::GetNextFrame() {
   RTC_DCHECK(!frames_to_decode_.empty());
   bool superframe_delayed_by_retransmission = false;
   size_t superframe_size = 0;
-  EncodedFrame* first_frame = frames_to_decode_[0]->second.frame.get();
+  EncodedFrame* first_frame = frame_infos_[frames_to_decode_[0]].frame.get();
   int64_t render_time_ms = first_frame->RenderTime();
   int64_t receive_time_ms = first_frame->ReceivedTime();
   // Gracefully handle bad RTP timestamps and render time issues.
@@ -272,9 +310,10 @@ EncodedFrame* FrameBuffer::GetNextFrame() {
     render_time_ms = timing_->RenderTimeMs(first_frame->Timestamp(), now_ms);
   }
 
-  for (FrameMap::iterator& frame_it : frames_to_decode_) {
-    RTC_DCHECK(frame_it != frames_.end());
-    EncodedFrame* frame = frame_it->second.frame.release();
+  for (uint16_t index : frames_to_decode_) {
+    FrameInfo& info = frame_infos_[index];
+    const VideoLayerFrameId id = info.id;
+    EncodedFrame* frame = info.frame.release();
 
     frame->SetRenderTime(render_time_ms);
 
@@ -282,23 +321,15 @@ EncodedFrame* FrameBuffer::GetNextFrame() {
     receive_time_ms = std::max(receive_time_ms, frame->ReceivedTime());
     superframe_size += frame->size();
 
-    PropagateDecodability(frame_it->second);
-    decoded_frames_history_.InsertDecoded(frame_it->first, frame->Timestamp());
+    PropagateDecodability(info);
+    decoded_frames_history_.InsertDecoded(id, frame->Timestamp());
 
     // Remove decoded frame and all undecoded frames before it.
-    if (stats_callback_) {
-      unsigned int dropped_frames = std::count_if(
-          frames_.begin(), frame_it,
-          [](const std::pair<const VideoLayerFrameId, FrameInfo>& frame) {
-            return frame.second.frame != nullptr;
-          });
-      if (dropped_frames > 0) {
-        stats_callback_->OnDroppedFrames(dropped_frames);
-      }
+    size_t dropped_frames = EraseFramesUpTo(id);
+    if (stats_callback_ && dropped_frames > 0) {
+      stats_callback_->OnDroppedFrames(dropped_frames);
     }
 
-    frames_.erase(frames_.begin(), ++frame_it);
-
     frames_out.push_back(frame);
   }
 
@@ -415,43 +446,214 @@ void FrameBuffer::CancelCallback() {
   callback_queue_ = nullptr;
 }
 
+int64_t FrameBuffer::PictureIdSpan(const EncodedFrame& frame) {
+  if (num_frames_ == 0 && frame.num_references == 0)
+    return 1;
+
+  int64_t min_picture_id = frame.id.picture_id;
+  int64_t max_picture_id = frame.id.picture_id;
+  if (num_frames_ > 0) {
+    min_picture_id = std::min(min_picture_id, first_picture_id_);
+    max_picture_id = std::max(max_picture_id, last_picture_id_);
+  }
+
+  // References to frames that have already been handed off for decoding are
+  // never stored, so they don't need to fit.
+  auto last_decoded_frame = decoded_frames_history_.GetLastDecodedFrameId();
+  for (size_t i = 0; i < frame.num_references; ++i) {
+    VideoLayerFrameId ref_key(frame.references[i], frame.id.spatial_layer);
+    if (last_decoded_frame && ref_key <= *last_decoded_frame)
+      continue;
+    min_picture_id = std::min(min_picture_id, ref_key.picture_id);
+  }
+
+  return max_picture_id - min_picture_id + 1;
+}
+
+void FrameBuffer::GrowFrameWindow(int64_t min_size) {
+  RTC_DCHECK_LE(min_size, kMaxFrameWindowSize);
+  int64_t new_size = frame_window_size_;
+  while (new_size < min_size)
+    new_size *= 2;
+  if (new_size == frame_window_size_)
+    return;
+
+  RTC_LOG(LS_INFO) << "Growing the frame index window from "
+                   << frame_window_size_ << " to " << new_size
+                   << " picture ids.";
+  std::vector<std::vector<uint16_t>> new_frame_index(frame_index_.size());
+  for (size_t layer = 0; layer < frame_index_.size(); ++layer) {
+    if (!frame_index_[layer].empty())
+      new_frame_index[layer].resize(new_size, kNoFrameInfo);
+  }
+  std::vector<uint64_t> new_picture_mask(new_size / kBitsPerMaskWord, 0);
+
+  // The buffered picture ids span less than the old window, so they map to
+  // distinct slots in the new one as well.
+  const size_t new_slot_mask = static_cast<size_t>(new_size - 1);
+  for (absl::optional<int64_t> picture_id = NextPictureId(first_picture_id_);
+       picture_id; picture_id = NextPictureId(*picture_id + 1)) {
+    size_t old_slot = PictureIdToIndex(*picture_id);
+    size_t new_slot = static_cast<size_t>(*picture_id) & new_slot_mask;
+    for (size_t layer = 0; layer < frame_index_.size(); ++layer) {
+      if (!frame_index_[layer].empty())
+        new_frame_index[layer][new_slot] = frame_index_[layer][old_slot];
+    }
+    new_picture_mask[new_slot / kBitsPerMaskWord] |=
+        uint64_t{1} << (new_slot % kBitsPerMaskWord);
+  }
+
+  frame_index_.swap(new_frame_index);
+  picture_mask_.swap(new_picture_mask);
+  frame_window_size_ = new_size;
+}
+
+size_t FrameBuffer::PictureIdToIndex(int64_t picture_id) const {
+  // Since |frame_window_size_| is a power of two this also gives the correct
+  // index for negative picture ids.
+  return static_cast<size_t>(picture_id & (frame_window_size_ - 1));
+}
+
+uint16_t FrameBuffer::FindFrameInfo(const VideoLayerFrameId& id) const {
+  if (num_frames_ == 0 || id.picture_id < first_picture_id_ ||
+      id.picture_id > last_picture_id_ ||
+      id.spatial_layer >= frame_index_.size()) {
+    return kNoFrameInfo;
+  }
+  const std::vector<uint16_t>& layer_index = frame_index_[id.spatial_layer];
+  if (layer_index.empty())
+    return kNoFrameInfo;
+  uint16_t index = layer_index[PictureIdToIndex(id.picture_id)];
+  RTC_DCHECK(index == kNoFrameInfo || frame_infos_[index].id == id);
+  return index;
+}
+
+uint16_t FrameBuffer::EmplaceFrameInfo(const VideoLayerFrameId& id) {
+  uint16_t index = FindFrameInfo(id);
+  if (index != kNoFrameInfo)
+    return index;
+
+  RTC_DCHECK(num_frames_ == 0 ||
+             (std::max(last_picture_id_, id.picture_id) -
+                  std::min(first_picture_id_, id.picture_id) <
+              frame_window_size_));
+
+  if (!free_frame_infos_.empty()) {
+    index = free_frame_infos_.back();
+    free_frame_infos_.pop_back();
+  } else {
+    RTC_DCHECK_LT(frame_infos_.size(), kNoFrameInfo);
+    index = static_cast<uint16_t>(frame_infos_.size());
+    frame_infos_.emplace_back();
+  }
+  frame_infos_[index].id = id;
+
+  if (id.spatial_layer >= frame_index_.size())
+    frame_index_.resize(id.spatial_layer + 1);
+  std::vector<uint16_t>& layer_index = frame_index_[id.spatial_layer];
+  if (layer_index.empty())
+    layer_index.resize(frame_window_size_, kNoFrameInfo);
+
+  size_t slot = PictureIdToIndex(id.picture_id);
+  layer_index[slot] = index;
+  picture_mask_[slot / kBitsPerMaskWord] |= uint64_t{1}
+                                            << (slot % kBitsPerMaskWord);
+
+  if (num_frames_ == 0) {
+    first_picture_id_ = id.picture_id;
+    last_picture_id_ = id.picture_id;
+  } else {
+    first_picture_id_ = std::min(first_picture_id_, id.picture_id);
+    last_picture_id_ = std::max(last_picture_id_, id.picture_id);
+  }
+  ++num_frames_;
+  return index;
+}
+
+absl::optional<int64_t> FrameBuffer::NextPictureId(int64_t picture_id) const {
+  if (num_frames_ == 0)
+    return absl::nullopt;
+  picture_id = std::max(picture_id, first_picture_id_);
+  // Since all buffered picture ids lie within one window, the bits following
+  // |last_picture_id_| in the mask are always cleared and the returned picture
+  // id can never pass it.
+  while (picture_id <= last_picture_id_) {
+    size_t slot = PictureIdToIndex(picture_id);
+    size_t bit = slot % kBitsPerMaskWord;
+    uint64_t word = picture_mask_[slot / kBitsPerMaskWord] >> bit;
+    if (word != 0)
+      return picture_id + CountTrailingZeros(word);
+    picture_id += kBitsPerMaskWord - bit;
+  }
+  return absl::nullopt;
+}
+
+size_t FrameBuffer::EraseFramesUpTo(const VideoLayerFrameId& id) {
+  size_t num_dropped = 0;
+  for (absl::optional<int64_t> picture_id = NextPictureId(first_picture_id_);
+       picture_id && *picture_id <= id.picture_id;
+       picture_id = NextPictureId(*picture_id + 1)) {
+    size_t slot = PictureIdToIndex(*picture_id);
+    bool picture_erased = true;
+    for (size_t layer = 0; layer < frame_index_.size(); ++layer) {
+      if (frame_index_[layer].empty())
+        continue;
+      uint16_t& index = frame_index_[layer][slot];
+      if (index == kNoFrameInfo)
+        continue;
+      if (*picture_id == id.picture_id && layer > id.spatial_layer) {
+        picture_erased = false;
+        continue;
+      }
+      if (frame_infos_[index].frame)
+        ++num_dropped;
+      frame_infos_[index] = FrameInfo();
+      free_frame_infos_.push_back(index);
+      index = kNoFrameInfo;
+      --num_frames_;
+    }
+    if (picture_erased) {
+      picture_mask_[slot / kBitsPerMaskWord] &=
+          ~(uint64_t{1} << (slot % kBitsPerMaskWord));
+    }
+  }
+
+  if (num_frames_ > 0) {
+    absl::optional<int64_t> first_picture_id =
+        NextPictureId(first_picture_id_);
+    RTC_DCHECK(first_picture_id);
+    first_picture_id_ = *first_picture_id;
+  }
+  return num_dropped;
+}
+
 bool FrameBuffer::IsCompleteSuperFrame(const EncodedFrame& frame) {
   if (frame.inter_layer_predicted) {
     // Check that all previous spatial layers are already inserted.
     VideoLayerFrameId id = frame.id;
     RTC_DCHECK_GT(id.spatial_layer, 0);
-    --id.spatial_layer;
-    FrameMap::iterator prev_frame = frames_.find(id);
-    if (prev_frame == frames_.end() || !prev_frame->second.frame)
-      return false;
-    while (prev_frame->second.frame->inter_layer_predicted) {
-      if (prev_frame == frames_.begin())
-        return false;
-      --prev_frame;
+    while (true) {
       --id.spatial_layer;
-      if (!prev_frame->second.frame ||
-          prev_frame->first.picture_id != id.picture_id ||
-          prev_frame->first.spatial_layer != id.spatial_layer) {
+      uint16_t prev_frame = FindFrameInfo(id);
+      if (prev_frame == kNoFrameInfo || !frame_infos_[prev_frame].frame)
+        return false;
+      if (!frame_infos_[prev_frame].frame->inter_layer_predicted)
+        break;
+      if (id.spatial_layer == 0)
         return false;
-      }
     }
   }
 
   if (!frame.is_last_spatial_layer) {
     // Check that all following spatial layers are already inserted.
     VideoLayerFrameId id = frame.id;
-    ++id.spatial_layer;
-    FrameMap::iterator next_frame = frames_.find(id);
-    if (next_frame == frames_.end() || !next_frame->second.frame)
-      return false;
-    while (!next_frame->second.frame->is_last_spatial_layer) {
-      ++next_frame;
+    while (true) {
       ++id.spatial_layer;
-      if (next_frame == frames_.end() || !next_frame->second.frame ||
-          next_frame->first.picture_id != id.picture_id ||
-          next_frame->first.spatial_layer != id.spatial_layer) {
+      uint16_t next_frame = FindFrameInfo(id);
+      if (next_frame == kNoFrameInfo || !frame_infos_[next_frame].frame)
         return false;
-      }
+      if (frame_infos_[next_frame].frame->is_last_spatial_layer)
+        break;
     }
   }
 
@@ -476,7 +678,7 @@ int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
     return last_continuous_picture_id;
   }
 
-  if (frames_.size() >= kMaxFramesBuffered) {
+  if (num_frames_ >= kMaxFramesBuffered) {
     if (frame->is_keyframe()) {
       RTC_LOG(LS_WARNING) << "Inserting keyframe (picture_id:spatial_id) ("
                           << id.picture_id << ":"
@@ -521,20 +723,33 @@ int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
     }
   }
 
-  // Test if inserting this frame would cause the order of the frames to become
-  // ambiguous (covering more than half the interval of 2^16). This can happen
+  // Test if inserting this frame would make the buffered picture ids span more
+  // than the frame index window. The window is grown for streams with many
+  // packets per frame, but a span beyond |kMaxFrameWindowSize| can only happen
   // when the picture id make large jumps mid stream.
-  if (!frames_.empty() && id < frames_.begin()->first &&
-      frames_.rbegin()->first < id) {
-    RTC_LOG(LS_WARNING)
-        << "A jump in picture id was detected, clearing buffer.";
-    ClearFramesAndHistory();
-    last_continuous_picture_id = -1;
+  int64_t picture_id_span = PictureIdSpan(*frame);
+  if (picture_id_span > frame_window_size_ &&
+      picture_id_span <= kMaxFrameWindowSize) {
+    GrowFrameWindow(picture_id_span);
+  } else if (picture_id_span > frame_window_size_) {
+    if (frame->is_keyframe()) {
+      RTC_LOG(LS_WARNING)
+          << "A jump in picture id was detected, clearing buffer.";
+      ClearFramesAndHistory();
+      last_continuous_picture_id = -1;
+    } else {
+      RTC_LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) ("
+                          << id.picture_id << ":"
+                          << static_cast<int>(id.spatial_layer)
+                          << ") is too far from the buffered frames, "
+                          << "dropping frame.";
+      return last_continuous_picture_id;
+    }
   }
 
-  auto info = frames_.emplace(id, FrameInfo()).first;
+  uint16_t info_index = EmplaceFrameInfo(id);
 
-  if (info->second.frame) {
+  if (frame_infos_[info_index].frame) {
     RTC_LOG(LS_WARNING) << "Frame with (picture_id:spatial_id) ("
                         << id.picture_id << ":"
                         << static_cast<int>(id.spatial_layer)
@@ -542,7 +757,7 @@ int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
     return last_continuous_picture_id;
   }
 
-  if (!UpdateFrameInfoWithIncomingFrame(*frame, info))
+  if (!UpdateFrameInfoWithIncomingFrame(*frame, info_index))
     return last_continuous_picture_id;
 
   if (!frame->delayed_by_retransmission())
@@ -553,11 +768,12 @@ int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
                                      frame->contentType());
   }
 
-  info->second.frame = std::move(frame);
+  FrameInfo& info = frame_infos_[info_index];
+  info.frame = std::move(frame);
 
-  if (info->second.num_missing_continuous == 0) {
-    info->second.continuous = true;
-    PropagateContinuity(info);
+  if (info.num_missing_continuous == 0) {
+    info.continuous = true;
+    PropagateContinuity(info_index);
     last_continuous_picture_id = last_continuous_frame_->picture_id;
 
     // Since we now have new continuous frames there might be a better frame
@@ -579,35 +795,31 @@ int64_t FrameBuffer::InsertFrame(std::unique_ptr<EncodedFrame> frame) {
   return last_continuous_picture_id;
 }
 
-void FrameBuffer::PropagateContinuity(FrameMap::iterator start) {
+void FrameBuffer::PropagateContinuity(uint16_t start) {
   TRACE_EVENT0("webrtc", "FrameBuffer::PropagateContinuity");
-  RTC_DCHECK(start->second.continuous);
+  RTC_DCHECK(frame_infos_[start].continuous);
 
-  std::queue<FrameMap::iterator> continuous_frames;
-  continuous_frames.push(start);
+  absl::InlinedVector<uint16_t, 16> continuous_frames;
+  continuous_frames.push_back(start);
 
-  // A simple BFS to traverse continuous frames.
+  // A simple DFS to traverse continuous frames.
   while (!continuous_frames.empty()) {
-    auto frame = continuous_frames.front();
-    continuous_frames.pop();
+    const FrameInfo& info = frame_infos_[continuous_frames.back()];
+    continuous_frames.pop_back();
 
-    if (!last_continuous_frame_ || *last_continuous_frame_ < frame->first) {
-      last_continuous_frame_ = frame->first;
+    if (!last_continuous_frame_ || *last_continuous_frame_ < info.id) {
+      last_continuous_frame_ = info.id;
     }
 
     // Loop through all dependent frames, and if that frame no longer has
     // any unfulfilled dependencies then that frame is continuous as well.
-    for (size_t d = 0; d < frame->second.dependent_frames.size(); ++d) {
-      auto frame_ref = frames_.find(frame->second.dependent_frames[d]);
-      RTC_DCHECK(frame_ref != frames_.end());
-
-      // TODO(philipel): Look into why we've seen this happen.
-      if (frame_ref != frames_.end()) {
-        --frame_ref->second.num_missing_continuous;
-        if (frame_ref->second.num_missing_continuous == 0) {
-          frame_ref->second.continuous = true;
-          continuous_frames.push(frame_ref);
-        }
+    for (uint16_t dependent : info.dependent_frames) {
+      FrameInfo& dependent_info = frame_infos_[dependent];
+      RTC_DCHECK_GT(dependent_info.num_missing_continuous, 0U);
+      --dependent_info.num_missing_continuous;
+      if (dependent_info.num_missing_continuous == 0) {
+        dependent_info.continuous = true;
+        continuous_frames.push_back(dependent);
       }
     }
   }
@@ -615,24 +827,21 @@ void FrameBuffer::PropagateContinuity(FrameMap::iterator start) {
 
 void FrameBuffer::PropagateDecodability(const FrameInfo& info) {
   TRACE_EVENT0("webrtc", "FrameBuffer::PropagateDecodability");
-  for (size_t d = 0; d < info.dependent_frames.size(); ++d) {
-    auto ref_info = frames_.find(info.dependent_frames[d]);
-    RTC_DCHECK(ref_info != frames_.end());
-    // TODO(philipel): Look into why we've seen this happen.
-    if (ref_info != frames_.end()) {
-      RTC_DCHECK_GT(ref_info->second.num_missing_decodable, 0U);
-      --ref_info->second.num_missing_decodable;
-    }
+  for (uint16_t dependent : info.dependent_frames) {
+    FrameInfo& dependent_info = frame_infos_[dependent];
+    RTC_DCHECK_GT(dependent_info.num_missing_decodable, 0U);
+    --dependent_info.num_missing_decodable;
   }
 }
 
 bool FrameBuffer::UpdateFrameInfoWithIncomingFrame(const EncodedFrame& frame,
-                                                   FrameMap::iterator info) {
+                                                   uint16_t info_index) {
   TRACE_EVENT0("webrtc", "FrameBuffer::UpdateFrameInfoWithIncomingFrame");
   const VideoLayerFrameId& id = frame.id;
 
   auto last_decoded_frame = decoded_frames_history_.GetLastDecodedFrameId();
-  RTC_DCHECK(!last_decoded_frame || *last_decoded_frame < info->first);
+  RTC_DCHECK(!last_decoded_frame ||
+             *last_decoded_frame < frame_infos_[info_index].id);
 
   // In this function we determine how many missing dependencies this |frame|
   // has to become continuous/decodable. If a frame that this |frame| depend
@@ -646,7 +855,8 @@ bool FrameBuffer::UpdateFrameInfoWithIncomingFrame(const EncodedFrame& frame,
     VideoLayerFrameId id;
     bool continuous;
   };
-  std::vector<Dependency> not_yet_fulfilled_dependencies;
+  absl::InlinedVector<Dependency, EncodedFrame::kMaxFrameReferences + 1>
+      not_yet_fulfilled_dependencies;
 
   // Find all dependencies that have not yet been fulfilled.
   for (size_t i = 0; i < frame.num_references; ++i) {
@@ -668,9 +878,9 @@ bool FrameBuffer::UpdateFrameInfoWithIncomingFrame(const EncodedFrame& frame,
         return false;
       }
     } else {
-      auto ref_info = frames_.find(ref_key);
+      uint16_t ref_info = FindFrameInfo(ref_key);
       bool ref_continuous =
-          ref_info != frames_.end() && ref_info->second.continuous;
+          ref_info != kNoFrameInfo && frame_infos_[ref_info].continuous;
       not_yet_fulfilled_dependencies.push_back({ref_key, ref_continuous});
     }
   }
@@ -678,13 +888,13 @@ bool FrameBuffer::UpdateFrameInfoWithIncomingFrame(const EncodedFrame& frame,
   // Does |frame| depend on the lower spatial layer?
   if (frame.inter_layer_predicted) {
     VideoLayerFrameId ref_key(frame.id.picture_id, frame.id.spatial_layer - 1);
-    auto ref_info = frames_.find(ref_key);
+    uint16_t ref_info = FindFrameInfo(ref_key);
 
     bool lower_layer_decoded =
         last_decoded_frame && *last_decoded_frame == ref_key;
     bool lower_layer_continuous =
         lower_layer_decoded ||
-        (ref_info != frames_.end() && ref_info->second.continuous);
+        (ref_info != kNoFrameInfo && frame_infos_[ref_info].continuous);
 
     if (!lower_layer_continuous || !lower_layer_decoded) {
       not_yet_fulfilled_dependencies.push_back(
@@ -692,14 +902,19 @@ bool FrameBuffer::UpdateFrameInfoWithIncomingFrame(const EncodedFrame& frame,
     }
   }
 
-  info->second.num_missing_continuous = not_yet_fulfilled_dependencies.size();
-  info->second.num_missing_decodable = not_yet_fulfilled_dependencies.size();
+  frame_infos_[info_index].num_missing_continuous =
+      not_yet_fulfilled_dependencies.size();
+  frame_infos_[info_index].num_missing_decodable =
+      not_yet_fulfilled_dependencies.size();
 
   for (const Dependency& dep : not_yet_fulfilled_dependencies) {
     if (dep.continuous)
-      --info->second.num_missing_continuous;
+      --frame_infos_[info_index].num_missing_continuous;
 
-    frames_[dep.id].dependent_frames.push_back(id);
+    // Note that this may grow |frame_infos_|, so no references into it can be
+    // held across this call.
+    uint16_t dep_index = EmplaceFrameInfo(dep.id);
+    frame_infos_[dep_index].dependent_frames.push_back(info_index);
   }
 
   return true;
@@ -736,15 +951,19 @@ void FrameBuffer::ClearFramesAndHistory() {
   TRACE_EVENT0("webrtc", "FrameBuffer::ClearFramesAndHistory");
   if (stats_callback_) {
     unsigned int dropped_frames = std::count_if(
-        frames_.begin(), frames_.end(),
-        [](const std::pair<const VideoLayerFrameId, FrameInfo>& frame) {
-          return frame.second.frame != nullptr;
-        });
+        frame_infos_.begin(), frame_infos_.end(),
+        [](const FrameInfo& info) { return info.frame != nullptr; });
     if (dropped_frames > 0) {
       stats_callback_->OnDroppedFrames(dropped_frames);
     }
   }
-  frames_.clear();
+  // Keep the allocated capacity, it will be needed again for the new frames.
+  frame_infos_.clear();
+  free_frame_infos_.clear();
+  for (std::vector<uint16_t>& layer_index : frame_index_)
+    std::fill(layer_index.begin(), layer_index.end(), kNoFrameInfo);
+  std::fill(picture_mask_.begin(), picture_mask_.end(), 0);
+  num_frames_ = 0;
   last_continuous_frame_.reset();
   frames_to_decode_.clear();
   decoded_frames_history_.Clear();
@@ -790,6 +1009,8 @@ EncodedFrame* FrameBuffer::CombineAndDeleteFrames(
 
 FrameBuffer::FrameInfo::FrameInfo() = default;
 FrameBuffer::FrameInfo::FrameInfo(FrameInfo&&) = default;
+FrameBuffer::FrameInfo& FrameBuffer::FrameInfo::operator=(FrameInfo&&) =
+    default;
 FrameBuffer::FrameInfo::~FrameInfo() = default;
 
 }  // namespace video_coding
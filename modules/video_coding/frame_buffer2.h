@@ -12,13 +12,14 @@
 #define MODULES_VIDEO_CODING_FRAME_BUFFER2_H_
 
 #include <array>
-#include <map>
 #include <memory>
 #include <utility>
 #include <vector>
 
 #include "absl/container/inlined_vector.h"
+#include "absl/types/optional.h"
 #include "api/video/encoded_frame.h"
+#include "api/video/video_codec_constants.h"
 #include "modules/video_coding/include/video_coding_defines.h"
 #include "modules/video_coding/inter_frame_delay.h"
 #include "modules/video_coding/jitter_estimator.h"
@@ -93,14 +94,20 @@ class FrameBuffer {
   void Clear();
 
  private:
+  // Marks an unused entry in |frame_index_|.
+  static constexpr uint16_t kNoFrameInfo = 0xFFFF;
+
   struct FrameInfo {
     FrameInfo();
     FrameInfo(FrameInfo&&);
+    FrameInfo& operator=(FrameInfo&&);
     ~FrameInfo();
 
+    VideoLayerFrameId id;
+
     // Which other frames that have direct unfulfilled dependencies
-    // on this frame.
-    absl::InlinedVector<VideoLayerFrameId, 8> dependent_frames;
+    // on this frame, stored as indices into |frame_infos_|.
+    absl::InlinedVector<uint16_t, 8> dependent_frames;
 
     // A frame is continiuous if it has all its referenced/indirectly
     // referenced frames.
@@ -120,11 +127,43 @@ class FrameBuffer {
     std::unique_ptr<EncodedFrame> frame;
   };
 
-  using FrameMap = std::map<VideoLayerFrameId, FrameInfo>;
+  // Indices into |frame_infos_| of the frames of one superframe.
+  using SuperFrameIndices = absl::InlinedVector<uint16_t, kMaxSpatialLayers>;
 
   // Check that the references of |frame| are valid.
   bool ValidReferences(const EncodedFrame& frame) const;
 
+  // Returns the number of consecutive picture ids covered by the buffered
+  // frames together with |frame| and the undecoded frames it references.
+  int64_t PictureIdSpan(const EncodedFrame& frame)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Doubles the frame index window until it holds at least |min_size| picture
+  // ids, moving the buffered frames to their new slots.
+  void GrowFrameWindow(int64_t min_size) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Returns the slot of |picture_id| in the rings of |frame_index_|.
+  size_t PictureIdToIndex(int64_t picture_id) const
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Returns the index of the FrameInfo of |id| or kNoFrameInfo.
+  uint16_t FindFrameInfo(const VideoLayerFrameId& id) const
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Returns the index of the FrameInfo of |id|, creating it if needed.
+  uint16_t EmplaceFrameInfo(const VideoLayerFrameId& id)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Returns the lowest buffered picture id that is not smaller than
+  // |picture_id|, or nullopt if there is none.
+  absl::optional<int64_t> NextPictureId(int64_t picture_id) const
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Removes all frames up to and including |id|. Returns how many of the
+  // removed frames had been received but not handed off for decoding.
+  size_t EraseFramesUpTo(const VideoLayerFrameId& id)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
   int64_t FindNextFrame(int64_t now_ms) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
   EncodedFrame* GetNextFrame() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
@@ -133,18 +172,17 @@ class FrameBuffer {
 
   // Update all directly dependent and indirectly dependent frames and mark
   // them as continuous if all their references has been fulfilled.
-  void PropagateContinuity(FrameMap::iterator start)
-      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  void PropagateContinuity(uint16_t start) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // Marks the frame as decoded and updates all directly dependent frames.
   void PropagateDecodability(const FrameInfo& info)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
-  // Update the corresponding FrameInfo of |frame| and all FrameInfos that
+  // Update the FrameInfo at |info_index| of |frame| and all FrameInfos that
   // |frame| references.
   // Return false if |frame| will never be decodable, true otherwise.
   bool UpdateFrameInfoWithIncomingFrame(const EncodedFrame& frame,
-                                        FrameMap::iterator info)
+                                        uint16_t info_index)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   void UpdateJitterDelay() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
@@ -167,8 +205,21 @@ class FrameBuffer {
   EncodedFrame* CombineAndDeleteFrames(
       const std::vector<EncodedFrame*>& frames) const;
 
-  // Stores only undecoded frames.
-  FrameMap frames_ RTC_GUARDED_BY(crit_);
+  // Stores only undecoded frames. The FrameInfos live in |frame_infos_| and
+  // are located through |frame_index_|, which holds one ring per spatial layer
+  // indexed by picture id modulo the window size. |picture_mask_| has a bit
+  // set for every picture id present in the rings so that frames can be
+  // visited in order without touching every slot.
+  std::vector<FrameInfo> frame_infos_ RTC_GUARDED_BY(crit_);
+  std::vector<uint16_t> free_frame_infos_ RTC_GUARDED_BY(crit_);
+  std::vector<std::vector<uint16_t>> frame_index_ RTC_GUARDED_BY(crit_);
+  std::vector<uint64_t> picture_mask_ RTC_GUARDED_BY(crit_);
+  // Number of picture ids the rings and |picture_mask_| hold, a power of two.
+  int64_t frame_window_size_ RTC_GUARDED_BY(crit_);
+  size_t num_frames_ RTC_GUARDED_BY(crit_);
+  // Lowest and highest buffered picture ids, only valid if |num_frames_| > 0.
+  int64_t first_picture_id_ RTC_GUARDED_BY(crit_);
+  int64_t last_picture_id_ RTC_GUARDED_BY(crit_);
   DecodedFramesHistory decoded_frames_history_ RTC_GUARDED_BY(crit_);
 
   rtc::CriticalSection crit_;
@@ -187,7 +238,7 @@ class FrameBuffer {
   VCMInterFrameDelay inter_frame_delay_ RTC_GUARDED_BY(crit_);
   absl::optional<VideoLayerFrameId> last_continuous_frame_
       RTC_GUARDED_BY(crit_);
-  std::vector<FrameMap::iterator> frames_to_decode_ RTC_GUARDED_BY(crit_);
+  SuperFrameIndices frames_to_decode_ RTC_GUARDED_BY(crit_);
   bool stopped_ RTC_GUARDED_BY(crit_);
   VCMVideoProtection protection_mode_ RTC_GUARDED_BY(crit_);
   VCMReceiveStatisticsCallback* const stats_callback_;
@@ -22,10 +22,12 @@
 #include "rtc_base/numerics/sequence_number_util.h"
 #include "rtc_base/platform_thread.h"
 #include "rtc_base/random.h"
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/clock.h"
 #include "test/field_trial.h"
 #include "test/gmock.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 using ::testing::_;
 using ::testing::Return;
@@ -732,5 +734,119 @@ TEST_F(TestFrameBuffer2, HigherSpatialLayerNonDecodable) {
   CheckFrame(2, pid + 2, 1);
 }
 
+TEST_F(TestFrameBuffer2, DeltaFrameFarAheadOfBufferedFramesDropped) {
+  // Picture ids above the 16 bit range of the helpers, too far ahead of the
+  // buffered frame to be stored together with it.
+  const int64_t kFarPictureId = int64_t{1} << 21;
+
+  EXPECT_EQ(1, InsertFrame(1, 0, 1000, false, true, kFrameSize));
+  std::unique_ptr<FrameObjectFake> delta_frame =
+      CreateFrame(0, 0, 2000, false, true, kFrameSize, 0);
+  delta_frame->id.picture_id = kFarPictureId;
+  delta_frame->references[0] = kFarPictureId - 1;
+  EXPECT_EQ(1, buffer_->InsertFrame(std::move(delta_frame)));
+  // A keyframe clears the buffer instead.
+  std::unique_ptr<FrameObjectFake> key_frame =
+      CreateFrame(0, 0, 3000, false, true, kFrameSize);
+  key_frame->id.picture_id = kFarPictureId + 1;
+  EXPECT_EQ(kFarPictureId + 1, buffer_->InsertFrame(std::move(key_frame)));
+  ExtractFrame();
+  ExtractFrame();
+  CheckFrame(0, kFarPictureId + 1, 0);
+  CheckNoFrame(1);
+}
+
+TEST_F(TestFrameBuffer2, ManyPacketsPerFrameStream) {
+  // H264 style stream where the picture id of a frame is the sequence number
+  // of its last packet, so the buffered frames span more picture ids than the
+  // initial frame index window.
+  const int kNumFrames = 50;
+  const int kPacketsPerFrame = 100;
+  uint32_t ts = Rand();
+
+  int pid = kPacketsPerFrame - 1;
+  EXPECT_EQ(pid, InsertFrame(pid, 0, ts, false, true, kFrameSize));
+  for (int i = 1; i < kNumFrames; ++i) {
+    pid += kPacketsPerFrame;
+    EXPECT_EQ(pid, InsertFrame(pid, 0, ts + i * kFps10, false, true,
+                               kFrameSize, pid - kPacketsPerFrame));
+  }
+
+  for (int i = 0; i < kNumFrames; ++i) {
+    ExtractFrame();
+    clock_.AdvanceTimeMilliseconds(kFps10);
+  }
+  for (int i = 0; i < kNumFrames; ++i)
+    CheckFrame(i, (i + 1) * kPacketsPerFrame - 1, 0);
+}
+
+// Replays a three spatial layer, three temporal layer SVC stream at 60 fps
+// where every 20th superframe arrives after the following one, and extracts
+// frames as they become decodable.
+TEST_F(TestFrameBuffer2, DISABLED_SvcStreamPerf) {
+  const int kNumSuperFrames = 100000;
+  const int kNumSpatialLayers = 3;
+  const int kFrameIntervalMs = 1000 / 60;
+  const int kTemporalPattern[] = {0, 2, 1, 2};
+  const int kReorderInterval = 20;
+
+  auto insert_superframe = [this](int64_t pid, int64_t ts_ms,
+                                  int temporal_layer) {
+    // Base layer frames reference the previous base layer frame, the middle
+    // layer references the base layer and the top layer the previous frame.
+    int64_t ref = temporal_layer == 0 ? pid - 4 : temporal_layer == 1 ? pid - 2
+                                                                      : pid - 1;
+    for (int sid = 0; sid < kNumSpatialLayers; ++sid) {
+      auto frame = absl::make_unique<FrameObjectFake>();
+      frame->id.picture_id = pid;
+      frame->id.spatial_layer = sid;
+      frame->SetSpatialIndex(sid);
+      frame->SetTimestamp(ts_ms * 90);
+      frame->num_references = pid < 4 ? 0 : 1;
+      frame->references[0] = ref;
+      frame->inter_layer_predicted = sid > 0;
+      frame->is_last_spatial_layer = sid == kNumSpatialLayers - 1;
+      frame->VerifyAndAllocate(kFrameSize);
+      frame->set_size(kFrameSize);
+      buffer_->InsertFrame(std::move(frame));
+    }
+  };
+
+  int64_t insert_us = 0;
+  int64_t extract_us = 0;
+  int num_decoded = 0;
+  for (int i = 0; i < kNumSuperFrames; ++i) {
+    int64_t start_us = rtc::TimeMicros();
+    if (i % kReorderInterval == kReorderInterval - 1 &&
+        i + 1 < kNumSuperFrames) {
+      insert_superframe(i + 1, (i + 1) * kFrameIntervalMs,
+                        kTemporalPattern[(i + 1) % 4]);
+      insert_superframe(i, i * kFrameIntervalMs, kTemporalPattern[i % 4]);
+      clock_.AdvanceTimeMilliseconds(kFrameIntervalMs);
+      ++i;
+    } else {
+      insert_superframe(i, i * kFrameIntervalMs, kTemporalPattern[i % 4]);
+    }
+    insert_us += rtc::TimeMicros() - start_us;
+
+    start_us = rtc::TimeMicros();
+    std::unique_ptr<EncodedFrame> frame;
+    while (buffer_->NextFrame(0, &frame, false) ==
+           FrameBuffer::ReturnReason::kFrameFound) {
+      ++num_decoded;
+    }
+    extract_us += rtc::TimeMicros() - start_us;
+    clock_.AdvanceTimeMilliseconds(kFrameIntervalMs);
+  }
+
+  EXPECT_GT(num_decoded, 0);
+  test::PrintResult("frame_buffer2", "", "svc_l3t3_insert",
+                    static_cast<double>(insert_us) / kNumSuperFrames,
+                    "us/superframe", false);
+  test::PrintResult("frame_buffer2", "", "svc_l3t3_extract",
+                    static_cast<double>(extract_us) / kNumSuperFrames,
+                    "us/superframe", false);
+}
+
 }  // namespace video_coding
 }  // namespace webrtc
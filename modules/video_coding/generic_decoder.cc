@@ -166,6 +166,10 @@ void VCMDecodedFrameCallback::OnDecoderImplementationName(
   _receiveCallback->OnDecoderImplementationName(implementation_name);
 }
 
+void VCMDecodedFrameCallback::OnDecoderFrameBufferBytes(size_t bytes) {
+  _receiveCallback->OnDecoderFrameBufferBytes(bytes);
+}
+
 void VCMDecodedFrameCallback::Map(uint32_t timestamp,
                                   VCMFrameInformation* frameInfo) {
   rtc::CritScope cs(&lock_);
@@ -237,6 +241,7 @@ int32_t VCMGenericDecoder::Decode(const VCMEncodedFrame& frame, int64_t nowMs) {
                                  frame.RenderTimeMs());
 
   _callback->OnDecoderImplementationName(decoder_->ImplementationName());
+  _callback->OnDecoderFrameBufferBytes(decoder_->FrameBufferBytes());
   if (ret < WEBRTC_VIDEO_CODEC_OK) {
     RTC_LOG(LS_WARNING) << "Failed to decode frame with timestamp "
                         << frame.Timestamp() << ", error code: " << ret;
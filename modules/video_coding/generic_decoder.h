@@ -55,6 +55,7 @@ class VCMDecodedFrameCallback : public DecodedImageCallback {
                absl::optional<uint8_t> qp) override;
 
   void OnDecoderImplementationName(const char* implementation_name);
+  void OnDecoderFrameBufferBytes(size_t bytes);
 
   void Map(uint32_t timestamp, VCMFrameInformation* frameInfo);
   int32_t Pop(uint32_t timestamp);
@@ -72,6 +72,9 @@ class VCMReceiveCallback {
   // Called when the current receive codec changes.
   virtual void OnIncomingPayloadType(int payload_type);
   virtual void OnDecoderImplementationName(const char* implementation_name);
+  // Called after each decode with the memory held for the decoder's output
+  // frame buffers, see VideoDecoder::FrameBufferBytes().
+  virtual void OnDecoderFrameBufferBytes(size_t bytes);
 
  protected:
   virtual ~VCMReceiveCallback() {}
@@ -16,6 +16,7 @@
 #include "modules/utility/include/process_thread.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/numerics/bit_ops.h"
 #include "system_wrappers/include/field_trial.h"
 
 namespace webrtc {
@@ -30,6 +31,14 @@ const int kProcessIntervalMs = 1000 / kProcessFrequency;
 const int kMaxReorderedPackets = 128;
 const int kNumReorderingBuckets = 10;
 const int kDefaultSendNackDelayMs = 0;
+// Packets tracked by the bitmaps, enough for kMaxPacketAge packets behind the
+// newest packet plus packets recovered ahead of it. Must be a power of two.
+const int kWindowSize = 1 << 14;
+const int kBitsPerWord = 64;
+const uint16_t kNoNackInfo = 0xFFFF;
+
+static_assert(kWindowSize > kMaxPacketAge, "Window too small.");
+static_assert(kMaxNackPackets < kNoNackInfo, "Too many nack packets.");
 
 int64_t GetSendNackDelay() {
   int64_t delay_ms = strtol(
@@ -55,21 +64,91 @@ NackModule::NackInfo::NackInfo(uint16_t seq_num,
       sent_at_time(-1),
       retries(0) {}
 
+NackModule::PacketBitmap::PacketBitmap(size_t size)
+    : words_(size / kBitsPerWord) {
+  RTC_DCHECK_EQ(size & (size - 1), 0);
+  RTC_DCHECK_EQ(size % kBitsPerWord, 0);
+}
+
+NackModule::PacketBitmap::~PacketBitmap() = default;
+
+void NackModule::PacketBitmap::Set(int64_t seq_num) {
+  size_t index = Index(seq_num);
+  words_[index / kBitsPerWord] |= uint64_t{1} << (index % kBitsPerWord);
+}
+
+void NackModule::PacketBitmap::Clear(int64_t seq_num) {
+  size_t index = Index(seq_num);
+  words_[index / kBitsPerWord] &= ~(uint64_t{1} << (index % kBitsPerWord));
+}
+
+bool NackModule::PacketBitmap::Test(int64_t seq_num) const {
+  size_t index = Index(seq_num);
+  return (words_[index / kBitsPerWord] >> (index % kBitsPerWord)) & 1;
+}
+
+void NackModule::PacketBitmap::ClearRange(int64_t begin, int64_t end) {
+  end = std::min<int64_t>(end, begin + words_.size() * kBitsPerWord);
+  while (begin < end) {
+    size_t index = Index(begin);
+    int bit = index % kBitsPerWord;
+    int64_t num_bits = std::min<int64_t>(kBitsPerWord - bit, end - begin);
+    uint64_t mask = num_bits == kBitsPerWord
+                        ? ~uint64_t{0}
+                        : ((uint64_t{1} << num_bits) - 1) << bit;
+    words_[index / kBitsPerWord] &= ~mask;
+    begin += num_bits;
+  }
+}
+
+void NackModule::PacketBitmap::ClearAll() {
+  std::fill(words_.begin(), words_.end(), 0);
+}
+
+int64_t NackModule::PacketBitmap::FindNext(int64_t begin, int64_t end) const {
+  while (begin < end) {
+    size_t index = Index(begin);
+    int bit = index % kBitsPerWord;
+    uint64_t word = words_[index / kBitsPerWord] >> bit;
+    if (word != 0)
+      return std::min(end, begin + CountTrailingZeros(word));
+    begin += kBitsPerWord - bit;
+  }
+  return end;
+}
+
+size_t NackModule::PacketBitmap::Index(int64_t seq_num) const {
+  // The size is a power of two, so this also works for negative numbers.
+  return static_cast<size_t>(seq_num) & (words_.size() * kBitsPerWord - 1);
+}
+
 NackModule::NackModule(Clock* clock,
                        NackSender* nack_sender,
                        KeyFrameRequestSender* keyframe_request_sender)
     : clock_(clock),
       nack_sender_(nack_sender),
       keyframe_request_sender_(keyframe_request_sender),
+      nack_bitmap_(kWindowSize),
+      keyframe_bitmap_(kWindowSize),
+      recovered_bitmap_(kWindowSize),
+      nack_infos_(kMaxNackPackets),
+      nack_index_(kWindowSize, kNoNackInfo),
+      window_start_(0),
+      oldest_nack_hint_(0),
+      oldest_unsent_nack_hint_(0),
       reordering_histogram_(kNumReorderingBuckets, kMaxReorderedPackets),
       initialized_(false),
       rtt_ms_(kDefaultRttMs),
       newest_seq_num_(0),
+      newest_unwrapped_seq_num_(0),
       next_process_time_ms_(-1),
       send_nack_delay_ms_(GetSendNackDelay()) {
   RTC_DCHECK(clock_);
   RTC_DCHECK(nack_sender_);
   RTC_DCHECK(keyframe_request_sender_);
+  free_nack_infos_.reserve(kMaxNackPackets);
+  for (int i = kMaxNackPackets - 1; i >= 0; --i)
+    free_nack_infos_.push_back(i);
 }
 
 int NackModule::OnReceivedPacket(uint16_t seq_num, bool is_keyframe) {
@@ -88,8 +167,10 @@ int NackModule::OnReceivedPacket(uint16_t seq_num,
 
   if (!initialized_) {
     newest_seq_num_ = seq_num;
+    newest_unwrapped_seq_num_ = seq_num;
+    window_start_ = newest_unwrapped_seq_num_ - kMaxPacketAge;
     if (is_keyframe)
-      keyframe_list_.insert(seq_num);
+      keyframe_bitmap_.Set(newest_unwrapped_seq_num_);
     initialized_ = true;
     return 0;
   }
@@ -99,42 +180,45 @@ int NackModule::OnReceivedPacket(uint16_t seq_num,
   if (seq_num == newest_seq_num_)
     return 0;
 
+  int64_t unwrapped_seq_num = Unwrap(seq_num);
   if (AheadOf(newest_seq_num_, seq_num)) {
     // An out of order packet has been received.
-    auto nack_list_it = nack_list_.find(seq_num);
     int nacks_sent_for_packet = 0;
-    if (nack_list_it != nack_list_.end()) {
-      nacks_sent_for_packet = nack_list_it->second.retries;
-      nack_list_.erase(nack_list_it);
+    if (InWindow(unwrapped_seq_num) && nack_bitmap_.Test(unwrapped_seq_num)) {
+      nacks_sent_for_packet =
+          nack_infos_[nack_index_[unwrapped_seq_num & (kWindowSize - 1)]]
+              .retries;
+      EraseNack(unwrapped_seq_num);
     }
     if (!is_retransmitted)
       UpdateReorderingStatistics(seq_num);
     return nacks_sent_for_packet;
   }
 
-  // Keep track of new keyframes.
-  if (is_keyframe)
-    keyframe_list_.insert(seq_num);
-
-  // And remove old ones so we don't accumulate keyframes.
-  auto it = keyframe_list_.lower_bound(seq_num - kMaxPacketAge);
-  if (it != keyframe_list_.begin())
-    keyframe_list_.erase(keyframe_list_.begin(), it);
-
   if (is_recovered) {
-    recovered_list_.insert(seq_num);
-
-    // Remove old ones so we don't accumulate recovered packets.
-    auto it = recovered_list_.lower_bound(seq_num - kMaxPacketAge);
-    if (it != recovered_list_.begin())
-      recovered_list_.erase(recovered_list_.begin(), it);
+    // Recovered packets do not move the window, packets too far ahead of the
+    // newest packet are not tracked.
+    if (InWindow(unwrapped_seq_num)) {
+      if (is_keyframe)
+        keyframe_bitmap_.Set(unwrapped_seq_num);
+      recovered_bitmap_.Set(unwrapped_seq_num);
+    }
 
     // Do not send nack for packets recovered by FEC or RTX.
     return 0;
   }
 
-  AddPacketsToNack(newest_seq_num_ + 1, seq_num);
+  // Forget old packets so we don't accumulate keyframes, recovered packets or
+  // nacks.
+  AdvanceWindow(unwrapped_seq_num - kMaxPacketAge);
+
+  // Keep track of new keyframes.
+  if (is_keyframe)
+    keyframe_bitmap_.Set(unwrapped_seq_num);
+
+  AddPacketsToNack(newest_unwrapped_seq_num_ + 1, unwrapped_seq_num);
   newest_seq_num_ = seq_num;
+  newest_unwrapped_seq_num_ = unwrapped_seq_num;
 
   // Are there any nacks that are waiting for this seq_num.
   std::vector<uint16_t> nack_batch = GetNackBatch(kSeqNumOnly);
@@ -149,11 +233,12 @@ int NackModule::OnReceivedPacket(uint16_t seq_num,
 
 void NackModule::ClearUpTo(uint16_t seq_num) {
   rtc::CritScope lock(&crit_);
-  nack_list_.erase(nack_list_.begin(), nack_list_.lower_bound(seq_num));
-  keyframe_list_.erase(keyframe_list_.begin(),
-                       keyframe_list_.lower_bound(seq_num));
-  recovered_list_.erase(recovered_list_.begin(),
-                        recovered_list_.lower_bound(seq_num));
+  if (!initialized_)
+    return;
+  int64_t end = std::min(Unwrap(seq_num), WindowEnd());
+  EraseNacks(window_start_, end);
+  keyframe_bitmap_.ClearRange(window_start_, end);
+  recovered_bitmap_.ClearRange(window_start_, end);
 }
 
 void NackModule::UpdateRtt(int64_t rtt_ms) {
@@ -163,9 +248,9 @@ void NackModule::UpdateRtt(int64_t rtt_ms) {
 
 void NackModule::Clear() {
   rtc::CritScope lock(&crit_);
-  nack_list_.clear();
-  keyframe_list_.clear();
-  recovered_list_.clear();
+  EraseNacks(window_start_, WindowEnd());
+  keyframe_bitmap_.ClearAll();
+  recovered_bitmap_.ClearAll();
 }
 
 int64_t NackModule::TimeUntilNextProcess() {
@@ -202,41 +287,84 @@ void NackModule::Process() {
   }
 }
 
-bool NackModule::RemovePacketsUntilKeyFrame() {
-  while (!keyframe_list_.empty()) {
-    auto it = nack_list_.lower_bound(*keyframe_list_.begin());
+void NackModule::EraseNack(int64_t seq_num) {
+  uint16_t& info_index = nack_index_[seq_num & (kWindowSize - 1)];
+  RTC_DCHECK_NE(info_index, kNoNackInfo);
+  free_nack_infos_.push_back(info_index);
+  info_index = kNoNackInfo;
+  nack_bitmap_.Clear(seq_num);
+}
+
+void NackModule::EraseNacks(int64_t begin, int64_t end) {
+  if (free_nack_infos_.size() == nack_infos_.size())
+    return;
+  for (int64_t seq_num = nack_bitmap_.FindNext(begin, end); seq_num < end;
+       seq_num = nack_bitmap_.FindNext(seq_num + 1, end)) {
+    uint16_t& info_index = nack_index_[seq_num & (kWindowSize - 1)];
+    free_nack_infos_.push_back(info_index);
+    info_index = kNoNackInfo;
+  }
+  nack_bitmap_.ClearRange(begin, end);
+}
+
+void NackModule::AdvanceWindow(int64_t window_start) {
+  if (window_start <= window_start_)
+    return;
+  int64_t end = std::min(window_start, WindowEnd());
+  EraseNacks(window_start_, end);
+  keyframe_bitmap_.ClearRange(window_start_, end);
+  recovered_bitmap_.ClearRange(window_start_, end);
+  window_start_ = window_start;
+}
 
-    if (it != nack_list_.begin()) {
+int64_t NackModule::WindowEnd() const {
+  return window_start_ + kWindowSize;
+}
+
+bool NackModule::InWindow(int64_t seq_num) const {
+  return seq_num >= window_start_ && seq_num < WindowEnd();
+}
+
+int64_t NackModule::Unwrap(uint16_t seq_num) const {
+  if (AheadOf(newest_seq_num_, seq_num))
+    return newest_unwrapped_seq_num_ - ReverseDiff(newest_seq_num_, seq_num);
+  return newest_unwrapped_seq_num_ + ForwardDiff(newest_seq_num_, seq_num);
+}
+
+bool NackModule::RemovePacketsUntilKeyFrame() {
+  const int64_t window_end = WindowEnd();
+  int64_t keyframe = keyframe_bitmap_.FindNext(window_start_, window_end);
+  while (keyframe != window_end) {
+    if (nack_bitmap_.FindNext(window_start_, keyframe) != keyframe) {
       // We have found a keyframe that actually is newer than at least one
       // packet in the nack list.
-      nack_list_.erase(nack_list_.begin(), it);
+      EraseNacks(window_start_, keyframe);
       return true;
     }
 
     // If this keyframe is so old it does not remove any packets from the list,
     // remove it from the list of keyframes and try the next keyframe.
-    keyframe_list_.erase(keyframe_list_.begin());
+    keyframe_bitmap_.Clear(keyframe);
+    keyframe = keyframe_bitmap_.FindNext(keyframe + 1, window_end);
   }
   return false;
 }
 
-void NackModule::AddPacketsToNack(uint16_t seq_num_start,
-                                  uint16_t seq_num_end) {
-  // Remove old packets.
-  auto it = nack_list_.lower_bound(seq_num_end - kMaxPacketAge);
-  nack_list_.erase(nack_list_.begin(), it);
-
+void NackModule::AddPacketsToNack(int64_t seq_num_start, int64_t seq_num_end) {
   // If the nack list is too large, remove packets from the nack list until
   // the latest first packet of a keyframe. If the list is still too large,
   // clear it and request a keyframe.
-  uint16_t num_new_nacks = ForwardDiff(seq_num_start, seq_num_end);
-  if (nack_list_.size() + num_new_nacks > kMaxNackPackets) {
+  size_t num_new_nacks = seq_num_end - seq_num_start;
+  auto nack_list_size = [this] {
+    return nack_infos_.size() - free_nack_infos_.size();
+  };
+  if (nack_list_size() + num_new_nacks > kMaxNackPackets) {
     while (RemovePacketsUntilKeyFrame() &&
-           nack_list_.size() + num_new_nacks > kMaxNackPackets) {
+           nack_list_size() + num_new_nacks > kMaxNackPackets) {
     }
 
-    if (nack_list_.size() + num_new_nacks > kMaxNackPackets) {
-      nack_list_.clear();
+    if (nack_list_size() + num_new_nacks > kMaxNackPackets) {
+      EraseNacks(window_start_, WindowEnd());
       RTC_LOG(LS_WARNING) << "NACK list full, clearing NACK"
                              " list and requesting keyframe.";
       keyframe_request_sender_->RequestKeyFrame();
@@ -244,45 +372,65 @@ void NackModule::AddPacketsToNack(uint16_t seq_num_start,
     }
   }
 
-  for (uint16_t seq_num = seq_num_start; seq_num != seq_num_end; ++seq_num) {
+  if (free_nack_infos_.size() == nack_infos_.size())
+    oldest_nack_hint_ = seq_num_start;
+  const int64_t now_ms = clock_->TimeInMilliseconds();
+  const int wait_number_of_packets = WaitNumberOfPackets(0.5);
+  for (int64_t seq_num = seq_num_start; seq_num != seq_num_end; ++seq_num) {
     // Do not send nack for packets that are already recovered by FEC or RTX
-    if (recovered_list_.find(seq_num) != recovered_list_.end())
+    if (recovered_bitmap_.Test(seq_num))
       continue;
-    NackInfo nack_info(seq_num, seq_num + WaitNumberOfPackets(0.5),
-                       clock_->TimeInMilliseconds());
-    RTC_DCHECK(nack_list_.find(seq_num) == nack_list_.end());
-    nack_list_[seq_num] = nack_info;
+    RTC_DCHECK(!nack_bitmap_.Test(seq_num));
+    uint16_t info_index = free_nack_infos_.back();
+    free_nack_infos_.pop_back();
+    nack_infos_[info_index] =
+        NackInfo(static_cast<uint16_t>(seq_num),
+                 static_cast<uint16_t>(seq_num + wait_number_of_packets),
+                 now_ms);
+    nack_index_[seq_num & (kWindowSize - 1)] = info_index;
+    nack_bitmap_.Set(seq_num);
   }
 }
 
 std::vector<uint16_t> NackModule::GetNackBatch(NackFilterOptions options) {
+  std::vector<uint16_t> nack_batch;
+  if (free_nack_infos_.size() == nack_infos_.size())
+    return nack_batch;
+
   bool consider_seq_num = options != kTimeOnly;
   bool consider_timestamp = options != kSeqNumOnly;
   int64_t now_ms = clock_->TimeInMilliseconds();
-  std::vector<uint16_t> nack_batch;
-  auto it = nack_list_.begin();
-  while (it != nack_list_.end()) {
-    bool delay_timed_out =
-        now_ms - it->second.created_at_time >= send_nack_delay_ms_;
-    bool nack_on_rtt_passed = now_ms - it->second.sent_at_time >= rtt_ms_;
+  // Nacked packets are never newer than the newest received packet.
+  const int64_t end = newest_unwrapped_seq_num_ + 1;
+  // Packets are only nacked based on sequence number the first time.
+  int64_t begin = nack_bitmap_.FindNext(
+      std::max(window_start_, consider_timestamp ? oldest_nack_hint_
+                                                 : oldest_unsent_nack_hint_),
+      end);
+  if (consider_timestamp)
+    oldest_nack_hint_ = begin;
+  oldest_unsent_nack_hint_ = end;
+  for (int64_t seq_num = begin; seq_num < end;
+       seq_num = nack_bitmap_.FindNext(seq_num + 1, end)) {
+    NackInfo& info = nack_infos_[nack_index_[seq_num & (kWindowSize - 1)]];
+    bool delay_timed_out = now_ms - info.created_at_time >= send_nack_delay_ms_;
+    bool nack_on_rtt_passed = now_ms - info.sent_at_time >= rtt_ms_;
     bool nack_on_seq_num_passed =
-        it->second.sent_at_time == -1 &&
-        AheadOrAt(newest_seq_num_, it->second.send_at_seq_num);
+        info.sent_at_time == -1 &&
+        AheadOrAt(newest_seq_num_, info.send_at_seq_num);
     if (delay_timed_out && ((consider_seq_num && nack_on_seq_num_passed) ||
                             (consider_timestamp && nack_on_rtt_passed))) {
-      nack_batch.emplace_back(it->second.seq_num);
-      ++it->second.retries;
-      it->second.sent_at_time = now_ms;
-      if (it->second.retries >= kMaxNackRetries) {
-        RTC_LOG(LS_WARNING) << "Sequence number " << it->second.seq_num
+      nack_batch.emplace_back(info.seq_num);
+      ++info.retries;
+      info.sent_at_time = now_ms;
+      if (info.retries >= kMaxNackRetries) {
+        RTC_LOG(LS_WARNING) << "Sequence number " << info.seq_num
                             << " removed from NACK list due to max retries.";
-        it = nack_list_.erase(it);
-      } else {
-        ++it;
+        EraseNack(seq_num);
       }
-      continue;
     }
-    ++it;
+    if (info.sent_at_time == -1)
+      oldest_unsent_nack_hint_ = std::min(oldest_unsent_nack_hint_, seq_num);
   }
   return nack_batch;
 }
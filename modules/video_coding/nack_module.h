@@ -13,8 +13,6 @@
 
 #include <stdint.h>
 
-#include <map>
-#include <set>
 #include <vector>
 
 #include "modules/include/module.h"
@@ -64,8 +62,44 @@ class NackModule : public Module {
     int64_t sent_at_time;
     int retries;
   };
-  void AddPacketsToNack(uint16_t seq_num_start, uint16_t seq_num_end)
+
+  // One bit per packet of a window of unwrapped sequence numbers, indexed by
+  // the sequence number modulo the window size. The caller makes sure that
+  // only packets inside the current window are accessed.
+  class PacketBitmap {
+   public:
+    explicit PacketBitmap(size_t size);
+    ~PacketBitmap();
+
+    void Set(int64_t seq_num);
+    void Clear(int64_t seq_num);
+    bool Test(int64_t seq_num) const;
+    // Clears the bits of [|begin|, |end|).
+    void ClearRange(int64_t begin, int64_t end);
+    void ClearAll();
+    // Returns the first set packet of [|begin|, |end|), or |end| if none.
+    int64_t FindNext(int64_t begin, int64_t end) const;
+
+   private:
+    size_t Index(int64_t seq_num) const;
+
+    std::vector<uint64_t> words_;
+  };
+
+  // Sequence numbers handled below are unwrapped.
+  void AddPacketsToNack(int64_t seq_num_start, int64_t seq_num_end)
       RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  void EraseNack(int64_t seq_num) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  // Erases the nacks of [|begin|, |end|).
+  void EraseNacks(int64_t begin, int64_t end)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  // Moves the start of the tracked window forward to |window_start|,
+  // forgetting about all packets before it.
+  void AdvanceWindow(int64_t window_start) RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  int64_t WindowEnd() const RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  bool InWindow(int64_t seq_num) const RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  int64_t Unwrap(uint16_t seq_num) const RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
 
   // Removes packets from the nack list until the next keyframe. Returns true
   // if packets were removed.
@@ -90,16 +124,30 @@ class NackModule : public Module {
   // TODO(philipel): Some of the variables below are consistently used on a
   // known thread (e.g. see |initialized_|). Those probably do not need
   // synchronized access.
-  std::map<uint16_t, NackInfo, DescendingSeqNumComp<uint16_t>> nack_list_
-      RTC_GUARDED_BY(crit_);
-  std::set<uint16_t, DescendingSeqNumComp<uint16_t>> keyframe_list_
-      RTC_GUARDED_BY(crit_);
-  std::set<uint16_t, DescendingSeqNumComp<uint16_t>> recovered_list_
-      RTC_GUARDED_BY(crit_);
+  //
+  // Packets are tracked in a window of unwrapped sequence numbers starting at
+  // |window_start_|. The window reaches kMaxPacketAge packets back from the
+  // newest packet, older packets are forgotten as it moves forward.
+  PacketBitmap nack_bitmap_ RTC_GUARDED_BY(crit_);
+  PacketBitmap keyframe_bitmap_ RTC_GUARDED_BY(crit_);
+  PacketBitmap recovered_bitmap_ RTC_GUARDED_BY(crit_);
+  // NackInfos of the packets in |nack_bitmap_|, located through
+  // |nack_index_| which is indexed like the bitmaps.
+  std::vector<NackInfo> nack_infos_ RTC_GUARDED_BY(crit_);
+  std::vector<uint16_t> free_nack_infos_ RTC_GUARDED_BY(crit_);
+  std::vector<uint16_t> nack_index_ RTC_GUARDED_BY(crit_);
+  int64_t window_start_ RTC_GUARDED_BY(crit_);
+  // No packet before |oldest_nack_hint_| is in |nack_bitmap_|, and all
+  // packets before |oldest_unsent_nack_hint_| have been nacked at least once.
+  // They save scanning the parts of the window that can not hold packets to
+  // nack.
+  int64_t oldest_nack_hint_ RTC_GUARDED_BY(crit_);
+  int64_t oldest_unsent_nack_hint_ RTC_GUARDED_BY(crit_);
   video_coding::Histogram reordering_histogram_ RTC_GUARDED_BY(crit_);
   bool initialized_ RTC_GUARDED_BY(crit_);
   int64_t rtt_ms_ RTC_GUARDED_BY(crit_);
   uint16_t newest_seq_num_ RTC_GUARDED_BY(crit_);
+  int64_t newest_unwrapped_seq_num_ RTC_GUARDED_BY(crit_);
 
   // Only touched on the process thread.
   int64_t next_process_time_ms_;
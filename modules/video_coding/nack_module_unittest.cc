@@ -14,9 +14,12 @@
 #include <cstring>
 #include <memory>
 
+#include "rtc_base/random.h"
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/clock.h"
 #include "test/field_trial.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 class TestNackModule : public ::testing::Test,
@@ -294,6 +297,76 @@ TEST_F(TestNackModule, SendNackWithoutDelay) {
   EXPECT_EQ(99u, sent_nacks_.size());
 }
 
+TEST_F(TestNackModule, NacksOnlyTrackedForMaxPacketAge) {
+  nack_module_.OnReceivedPacket(0, false, false);
+  nack_module_.OnReceivedPacket(2, false, false);
+  EXPECT_EQ(1u, sent_nacks_.size());
+
+  // Packet 1 is dropped from the nack list once it is older than the max
+  // packet age.
+  for (uint16_t seq_num = 3; seq_num <= 10001; ++seq_num)
+    nack_module_.OnReceivedPacket(seq_num, false, false);
+  EXPECT_EQ(1u, sent_nacks_.size());
+  nack_module_.OnReceivedPacket(10002, false, false);
+  EXPECT_EQ(0, nack_module_.OnReceivedPacket(1, false, false));
+}
+
+TEST_F(TestNackModule, RecoveredPacketsAheadOfNewestNotNacked) {
+  nack_module_.OnReceivedPacket(0xfffe, false, false);
+  nack_module_.OnReceivedPacket(2, false, true);
+  nack_module_.OnReceivedPacket(3, false, false);
+  ASSERT_EQ(3u, sent_nacks_.size());
+  EXPECT_EQ(0xffff, sent_nacks_[0]);
+  EXPECT_EQ(0, sent_nacks_[1]);
+  EXPECT_EQ(1, sent_nacks_[2]);
+}
+
+// Inserts packets at 5000 packets per second with 10% random loss, the lost
+// packets being retransmitted one RTT after they were first nacked.
+TEST_F(TestNackModule, DISABLED_InsertWithLossPerf) {
+  const int kPacketsPerSecond = 5000;
+  const int kDurationSeconds = 60;
+  const int kRttMs = 50;
+  const double kLossRate = 0.1;
+  Random random(0x1234);
+  nack_module_.UpdateRtt(kRttMs);
+
+  // Lost packets indexed by the packet count at which they are retransmitted.
+  std::vector<std::pair<int, uint16_t>> retransmissions;
+  size_t next_retransmission = 0;
+  const int kPacketsPerProcess = kPacketsPerSecond / 50;
+  const int kRttPackets = kPacketsPerSecond * kRttMs / 1000;
+  int num_inserted = 0;
+  uint16_t seq_num = 0;
+  int64_t start_us = rtc::TimeMicros();
+  for (int i = 0; i < kPacketsPerSecond * kDurationSeconds; ++i, ++seq_num) {
+    if (random.Rand<double>() >= kLossRate) {
+      nack_module_.OnReceivedPacket(seq_num, i % 1000 == 0, false);
+      ++num_inserted;
+    } else {
+      retransmissions.emplace_back(i + kRttPackets, seq_num);
+    }
+    while (next_retransmission < retransmissions.size() &&
+           retransmissions[next_retransmission].first <= i) {
+      nack_module_.OnReceivedPacket(retransmissions[next_retransmission].second,
+                                    false, false);
+      ++next_retransmission;
+      ++num_inserted;
+    }
+    if (i % kPacketsPerProcess == 0) {
+      clock_->AdvanceTimeMilliseconds(20);
+      nack_module_.Process();
+    }
+    if (sent_nacks_.size() > 10000)
+      sent_nacks_.clear();
+  }
+  int64_t insert_time_us = rtc::TimeMicros() - start_us;
+  EXPECT_EQ(0, keyframes_requested_);
+  test::PrintResult("nack_module", "", "insert_10pct_loss_5kpps",
+                    static_cast<double>(insert_time_us) / num_inserted,
+                    "us/packet", false);
+}
+
 class TestNackModuleWithFieldTrial : public ::testing::Test,
                                      public NackSender,
                                      public KeyFrameRequestSender {
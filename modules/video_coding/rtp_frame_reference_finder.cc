@@ -18,17 +18,163 @@
 #include "modules/video_coding/packet_buffer.h"
 #include "rtc_base/checks.h"
 #include "rtc_base/logging.h"
+#include "rtc_base/numerics/bit_ops.h"
 #include "rtc_base/system/fallthrough.h"
 
 namespace webrtc {
 namespace video_coding {
 
+template <typename T>
+RtpFrameReferenceFinder::Tl0Ring<T>::Tl0Ring() = default;
+
+template <typename T>
+RtpFrameReferenceFinder::Tl0Ring<T>::~Tl0Ring() = default;
+
+template <typename T>
+T* RtpFrameReferenceFinder::Tl0Ring<T>::Find(int64_t tl0) {
+  Slot& slot = slots_[static_cast<size_t>(tl0) % kTl0RingSize];
+  if (!slot.value || slot.tl0 != tl0)
+    return nullptr;
+  return &*slot.value;
+}
+
+template <typename T>
+T* RtpFrameReferenceFinder::Tl0Ring<T>::Insert(int64_t tl0, const T& value) {
+  Slot& slot = slots_[static_cast<size_t>(tl0) % kTl0RingSize];
+  if (slot.value) {
+    if (slot.tl0 == tl0)
+      return &*slot.value;
+    ++evicted_;
+    --size_;
+  }
+  if (size_ == 0 || tl0 < oldest_tl0_)
+    oldest_tl0_ = tl0;
+  slot.tl0 = tl0;
+  slot.value.emplace(value);
+  ++size_;
+  return &*slot.value;
+}
+
+template <typename T>
+void RtpFrameReferenceFinder::Tl0Ring<T>::EraseBefore(int64_t tl0) {
+  if (size_ == 0 || tl0 <= oldest_tl0_)
+    return;
+  // Every slot is visited at most once, even if |tl0| is far ahead.
+  int64_t end = std::min<int64_t>(tl0, oldest_tl0_ + kTl0RingSize);
+  for (int64_t i = oldest_tl0_; i < end && size_ > 0; ++i) {
+    Slot& slot = slots_[static_cast<size_t>(i) % kTl0RingSize];
+    if (slot.value && slot.tl0 < tl0) {
+      slot.value.reset();
+      --size_;
+    }
+  }
+  oldest_tl0_ = tl0;
+}
+
+RtpFrameReferenceFinder::PictureIdWindow::PictureIdWindow() {
+  words_.fill(0);
+}
+
+RtpFrameReferenceFinder::PictureIdWindow::~PictureIdWindow() = default;
+
+void RtpFrameReferenceFinder::PictureIdWindow::Insert(uint16_t picture_id) {
+  if (!initialized_) {
+    begin_ = Subtract<kPicIdLength>(picture_id, kPictureIdWindowSize - 1);
+    initialized_ = true;
+  }
+  if (AheadOf<uint16_t, kPicIdLength>(begin_, picture_id))
+    return;
+  if (ForwardDiff<uint16_t, kPicIdLength>(begin_, picture_id) >=
+      kPictureIdWindowSize) {
+    EraseBefore(Subtract<kPicIdLength>(picture_id, kPictureIdWindowSize - 1));
+  }
+  size_t index = picture_id % kPictureIdWindowSize;
+  words_[index / kBitsPerWord] |= uint64_t{1} << (index % kBitsPerWord);
+}
+
+void RtpFrameReferenceFinder::PictureIdWindow::Erase(uint16_t picture_id) {
+  if (!initialized_ || AheadOf<uint16_t, kPicIdLength>(begin_, picture_id) ||
+      ForwardDiff<uint16_t, kPicIdLength>(begin_, picture_id) >=
+          kPictureIdWindowSize) {
+    return;
+  }
+  size_t index = picture_id % kPictureIdWindowSize;
+  words_[index / kBitsPerWord] &= ~(uint64_t{1} << (index % kBitsPerWord));
+}
+
+void RtpFrameReferenceFinder::PictureIdWindow::EraseBefore(
+    uint16_t picture_id) {
+  if (!initialized_) {
+    begin_ = picture_id;
+    initialized_ = true;
+    return;
+  }
+  if (!AheadOf<uint16_t, kPicIdLength>(picture_id, begin_))
+    return;
+  size_t count = ForwardDiff<uint16_t, kPicIdLength>(begin_, picture_id);
+  if (count >= kPictureIdWindowSize) {
+    words_.fill(0);
+  } else {
+    ClearBits(begin_, count);
+  }
+  begin_ = picture_id;
+}
+
+bool RtpFrameReferenceFinder::PictureIdWindow::ContainsAny(
+    uint16_t begin,
+    uint16_t end) const {
+  if (!initialized_)
+    return false;
+  if (AheadOf<uint16_t, kPicIdLength>(begin_, begin))
+    begin = begin_;
+  if (!AheadOf<uint16_t, kPicIdLength>(end, begin))
+    return false;
+  size_t offset = ForwardDiff<uint16_t, kPicIdLength>(begin_, begin);
+  if (offset >= kPictureIdWindowSize)
+    return false;
+  size_t count =
+      std::min<size_t>(ForwardDiff<uint16_t, kPicIdLength>(begin, end),
+                       kPictureIdWindowSize - offset);
+  size_t index = begin % kPictureIdWindowSize;
+  while (count > 0) {
+    size_t bit = index % kBitsPerWord;
+    uint64_t word = words_[index / kBitsPerWord] >> bit;
+    if (word != 0 && static_cast<size_t>(CountTrailingZeros(word)) < count)
+      return true;
+    size_t step = std::min(kBitsPerWord - bit, count);
+    count -= step;
+    index = (index + step) % kPictureIdWindowSize;
+  }
+  return false;
+}
+
+void RtpFrameReferenceFinder::PictureIdWindow::ClearBits(uint16_t picture_id,
+                                                         size_t count) {
+  size_t index = picture_id % kPictureIdWindowSize;
+  while (count > 0) {
+    size_t bit = index % kBitsPerWord;
+    size_t step = std::min(kBitsPerWord - bit, count);
+    uint64_t mask = step == kBitsPerWord ? ~uint64_t{0}
+                                         : ((uint64_t{1} << step) - 1) << bit;
+    words_[index / kBitsPerWord] &= ~mask;
+    count -= step;
+    index = (index + step) % kPictureIdWindowSize;
+  }
+}
+
 RtpFrameReferenceFinder::RtpFrameReferenceFinder(
     OnCompleteFrameCallback* frame_callback)
     : last_picture_id_(-1),
+      stashed_frames_evicted_(0),
       current_ss_idx_(0),
       cleared_to_seq_num_(-1),
-      frame_callback_(frame_callback) {}
+      frame_callback_(frame_callback) {
+  static_assert(kTl0RingSize > kMaxLayerInfo && kTl0RingSize > kMaxGofSaved,
+                "TL0PICIDX rings must hold all entries not yet aged out.");
+  static_assert(kPictureIdWindowSize > kMaxNotYetReceivedFrames,
+                "Picture id window must hold all not yet received frames.");
+  stashed_frames_.reserve(kMaxStashedFrames + 1);
+}
 
 RtpFrameReferenceFinder::~RtpFrameReferenceFinder() = default;
 
@@ -46,9 +192,11 @@ void RtpFrameReferenceFinder::ManageFrame(
 
   switch (decision) {
     case kStash:
-      if (stashed_frames_.size() > kMaxStashedFrames)
-        stashed_frames_.pop_back();
-      stashed_frames_.push_front(std::move(frame));
+      if (stashed_frames_.size() > kMaxStashedFrames) {
+        stashed_frames_.erase(stashed_frames_.begin());
+        ++stashed_frames_evicted_;
+      }
+      stashed_frames_.push_back(std::move(frame));
       break;
     case kHandOff:
       frame_callback_->OnCompleteFrame(std::move(frame));
@@ -63,22 +211,26 @@ void RtpFrameReferenceFinder::RetryStashedFrames() {
   bool complete_frame = false;
   do {
     complete_frame = false;
-    for (auto frame_it = stashed_frames_.begin();
-         frame_it != stashed_frames_.end();) {
+    // Newest frames are retried first. Frames that are handed off or dropped
+    // are removed in one go after the pass.
+    for (auto frame_it = stashed_frames_.rbegin();
+         frame_it != stashed_frames_.rend(); ++frame_it) {
       FrameDecision decision = ManageFrameInternal(frame_it->get());
 
       switch (decision) {
         case kStash:
-          ++frame_it;
           break;
         case kHandOff:
           complete_frame = true;
           frame_callback_->OnCompleteFrame(std::move(*frame_it));
           RTC_FALLTHROUGH();
         case kDrop:
-          frame_it = stashed_frames_.erase(frame_it);
+          frame_it->reset();
       }
     }
+    stashed_frames_.erase(
+        std::remove(stashed_frames_.begin(), stashed_frames_.end(), nullptr),
+        stashed_frames_.end());
   } while (complete_frame);
 }
 
@@ -123,14 +275,22 @@ void RtpFrameReferenceFinder::ClearTo(uint16_t seq_num) {
   rtc::CritScope lock(&crit_);
   cleared_to_seq_num_ = seq_num;
 
-  auto it = stashed_frames_.begin();
-  while (it != stashed_frames_.end()) {
-    if (AheadOf<uint16_t>(cleared_to_seq_num_, (*it)->first_seq_num())) {
-      it = stashed_frames_.erase(it);
-    } else {
-      ++it;
-    }
-  }
+  stashed_frames_.erase(
+      std::remove_if(stashed_frames_.begin(), stashed_frames_.end(),
+                     [seq_num](const std::unique_ptr<RtpFrameObject>& frame) {
+                       return AheadOf<uint16_t>(seq_num,
+                                                frame->first_seq_num());
+                     }),
+      stashed_frames_.end());
+}
+
+RtpFrameReferenceFinder::Stats RtpFrameReferenceFinder::GetStats() const {
+  rtc::CritScope lock(&crit_);
+  Stats stats;
+  stats.stashed_frames_evicted = stashed_frames_evicted_;
+  stats.layer_infos_evicted = layer_info_.evicted();
+  stats.gof_infos_evicted = gof_info_.evicted();
+  return stats;
 }
 
 void RtpFrameReferenceFinder::UpdateLastPictureIdWithPadding(uint16_t seq_num) {
@@ -283,50 +443,50 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameVp8(
     last_picture_id_ = frame->id.picture_id;
 
   // Find if there has been a gap in fully received frames and save the picture
-  // id of those frames in |not_yet_received_frames_|.
+  // id of those frames in |not_yet_received_frames_|. Frames older than
+  // |kMaxNotYetReceivedFrames| are cleaned up below, so skip them.
   if (AheadOf<uint16_t, kPicIdLength>(frame->id.picture_id, last_picture_id_)) {
+    uint16_t oldest_picture_id = Subtract<kPicIdLength>(
+        frame->id.picture_id, kMaxNotYetReceivedFrames + 1);
+    if (AheadOf<uint16_t, kPicIdLength>(oldest_picture_id, last_picture_id_))
+      last_picture_id_ = oldest_picture_id;
     do {
       last_picture_id_ = Add<kPicIdLength>(last_picture_id_, 1);
-      not_yet_received_frames_.insert(last_picture_id_);
+      not_yet_received_frames_.Insert(last_picture_id_);
     } while (last_picture_id_ != frame->id.picture_id);
   }
 
   int64_t unwrapped_tl0 = tl0_unwrapper_.Unwrap(codec_header.tl0PicIdx);
 
   // Clean up info for base layers that are too old.
-  int64_t old_tl0_pic_idx = unwrapped_tl0 - kMaxLayerInfo;
-  auto clean_layer_info_to = layer_info_.lower_bound(old_tl0_pic_idx);
-  layer_info_.erase(layer_info_.begin(), clean_layer_info_to);
+  layer_info_.EraseBefore(unwrapped_tl0 - kMaxLayerInfo);
 
   // Clean up info about not yet received frames that are too old.
   uint16_t old_picture_id =
       Subtract<kPicIdLength>(frame->id.picture_id, kMaxNotYetReceivedFrames);
-  auto clean_frames_to = not_yet_received_frames_.lower_bound(old_picture_id);
-  not_yet_received_frames_.erase(not_yet_received_frames_.begin(),
-                                 clean_frames_to);
+  not_yet_received_frames_.EraseBefore(old_picture_id);
 
   if (frame->frame_type() == VideoFrameType::kVideoFrameKey) {
     frame->num_references = 0;
-    layer_info_[unwrapped_tl0].fill(-1);
+    layer_info_.Insert(unwrapped_tl0, {})->fill(-1);
     UpdateLayerInfoVp8(frame, unwrapped_tl0, codec_header.temporalIdx);
     return kHandOff;
   }
 
-  auto layer_info_it = layer_info_.find(
+  std::array<int64_t, kMaxTemporalLayers>* layer_info = layer_info_.Find(
       codec_header.temporalIdx == 0 ? unwrapped_tl0 - 1 : unwrapped_tl0);
 
   // If we don't have the base layer frame yet, stash this frame.
-  if (layer_info_it == layer_info_.end())
+  if (!layer_info)
     return kStash;
 
   // A non keyframe base layer frame has been received, copy the layer info
   // from the previous base layer frame and set a reference to the previous
   // base layer frame.
   if (codec_header.temporalIdx == 0) {
-    layer_info_it =
-        layer_info_.emplace(unwrapped_tl0, layer_info_it->second).first;
+    layer_info = layer_info_.Insert(unwrapped_tl0, *layer_info);
     frame->num_references = 1;
-    frame->references[0] = layer_info_it->second[0];
+    frame->references[0] = (*layer_info)[0];
     UpdateLayerInfoVp8(frame, unwrapped_tl0, codec_header.temporalIdx);
     return kHandOff;
   }
@@ -334,7 +494,7 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameVp8(
   // Layer sync frame, this frame only references its base layer frame.
   if (codec_header.layerSync) {
     frame->num_references = 1;
-    frame->references[0] = layer_info_it->second[0];
+    frame->references[0] = (*layer_info)[0];
 
     UpdateLayerInfoVp8(frame, unwrapped_tl0, codec_header.temporalIdx);
     return kHandOff;
@@ -345,29 +505,26 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameVp8(
   for (uint8_t layer = 0; layer <= codec_header.temporalIdx; ++layer) {
     // If we have not yet received a previous frame on this temporal layer,
     // stash this frame.
-    if (layer_info_it->second[layer] == -1)
+    if ((*layer_info)[layer] == -1)
       return kStash;
 
     // If the last frame on this layer is ahead of this frame it means that
     // a layer sync frame has been received after this frame for the same
     // base layer frame, drop this frame.
-    if (AheadOf<uint16_t, kPicIdLength>(layer_info_it->second[layer],
+    if (AheadOf<uint16_t, kPicIdLength>((*layer_info)[layer],
                                         frame->id.picture_id)) {
       return kDrop;
     }
 
     // If we have not yet received a frame between this frame and the referenced
     // frame then we have to wait for that frame to be completed first.
-    auto not_received_frame_it =
-        not_yet_received_frames_.upper_bound(layer_info_it->second[layer]);
-    if (not_received_frame_it != not_yet_received_frames_.end() &&
-        AheadOf<uint16_t, kPicIdLength>(frame->id.picture_id,
-                                        *not_received_frame_it)) {
+    if (not_yet_received_frames_.ContainsAny(
+            Add<kPicIdLength>((*layer_info)[layer], 1), frame->id.picture_id)) {
       return kStash;
     }
 
     if (!(AheadOf<uint16_t, kPicIdLength>(frame->id.picture_id,
-                                          layer_info_it->second[layer]))) {
+                                          (*layer_info)[layer]))) {
       RTC_LOG(LS_WARNING) << "Frame with picture id " << frame->id.picture_id
                           << " and packet range [" << frame->first_seq_num()
                           << ", " << frame->last_seq_num()
@@ -377,7 +534,7 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameVp8(
     }
 
     ++frame->num_references;
-    frame->references[layer] = layer_info_it->second[layer];
+    frame->references[layer] = (*layer_info)[layer];
   }
 
   UpdateLayerInfoVp8(frame, unwrapped_tl0, codec_header.temporalIdx);
@@ -387,23 +544,24 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameVp8(
 void RtpFrameReferenceFinder::UpdateLayerInfoVp8(RtpFrameObject* frame,
                                                  int64_t unwrapped_tl0,
                                                  uint8_t temporal_idx) {
-  auto layer_info_it = layer_info_.find(unwrapped_tl0);
+  std::array<int64_t, kMaxTemporalLayers>* layer_info =
+      layer_info_.Find(unwrapped_tl0);
 
   // Update this layer info and newer.
-  while (layer_info_it != layer_info_.end()) {
-    if (layer_info_it->second[temporal_idx] != -1 &&
-        AheadOf<uint16_t, kPicIdLength>(layer_info_it->second[temporal_idx],
+  while (layer_info) {
+    if ((*layer_info)[temporal_idx] != -1 &&
+        AheadOf<uint16_t, kPicIdLength>((*layer_info)[temporal_idx],
                                         frame->id.picture_id)) {
       // The frame was not newer, then no subsequent layer info have to be
       // update.
       break;
     }
 
-    layer_info_it->second[temporal_idx] = frame->id.picture_id;
+    (*layer_info)[temporal_idx] = frame->id.picture_id;
     ++unwrapped_tl0;
-    layer_info_it = layer_info_.find(unwrapped_tl0);
+    layer_info = layer_info_.Find(unwrapped_tl0);
   }
-  not_yet_received_frames_.erase(frame->id.picture_id);
+  not_yet_received_frames_.Erase(frame->id.picture_id);
 
   UnwrapPictureIds(frame);
 }
@@ -466,17 +624,15 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameVp9(
       current_ss_idx_ = Add<kMaxGofSaved>(current_ss_idx_, 1);
       scalability_structures_[current_ss_idx_] = gof;
       scalability_structures_[current_ss_idx_].pid_start = frame->id.picture_id;
-      gof_info_.emplace(unwrapped_tl0,
-                        GofInfo(&scalability_structures_[current_ss_idx_],
-                                frame->id.picture_id));
+      gof_info_.Insert(unwrapped_tl0,
+                       GofInfo(&scalability_structures_[current_ss_idx_],
+                               frame->id.picture_id));
     }
 
-    const auto gof_info_it = gof_info_.find(unwrapped_tl0);
-    if (gof_info_it == gof_info_.end())
+    info = gof_info_.Find(unwrapped_tl0);
+    if (!info)
       return kStash;
 
-    info = &gof_info_it->second;
-
     if (frame->frame_type() == VideoFrameType::kVideoFrameKey) {
       frame->num_references = 0;
       FrameReceivedVp9(frame->id.picture_id, info);
@@ -488,12 +644,10 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameVp9(
       RTC_LOG(LS_WARNING) << "Received keyframe without scalability structure";
       return kDrop;
     }
-    const auto gof_info_it = gof_info_.find(unwrapped_tl0);
-    if (gof_info_it == gof_info_.end())
+    info = gof_info_.Find(unwrapped_tl0);
+    if (!info)
       return kStash;
 
-    info = &gof_info_it->second;
-
     if (frame->frame_type() == VideoFrameType::kVideoFrameKey) {
       frame->num_references = 0;
       FrameReceivedVp9(frame->id.picture_id, info);
@@ -501,27 +655,21 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameVp9(
       return kHandOff;
     }
   } else {
-    auto gof_info_it = gof_info_.find(
-        (codec_header.temporal_idx == 0) ? unwrapped_tl0 - 1 : unwrapped_tl0);
+    info = gof_info_.Find((codec_header.temporal_idx == 0) ? unwrapped_tl0 - 1
+                                                           : unwrapped_tl0);
 
     // Gof info for this frame is not available yet, stash this frame.
-    if (gof_info_it == gof_info_.end())
+    if (!info)
       return kStash;
 
     if (codec_header.temporal_idx == 0) {
-      gof_info_it = gof_info_
-                        .emplace(unwrapped_tl0, GofInfo(gof_info_it->second.gof,
-                                                        frame->id.picture_id))
-                        .first;
+      info = gof_info_.Insert(unwrapped_tl0,
+                              GofInfo(info->gof, frame->id.picture_id));
     }
-
-    info = &gof_info_it->second;
   }
 
   // Clean up info for base layers that are too old.
-  int64_t old_tl0_pic_idx = unwrapped_tl0 - kMaxGofSaved;
-  auto clean_gof_info_to = gof_info_.lower_bound(old_tl0_pic_idx);
-  gof_info_.erase(gof_info_.begin(), clean_gof_info_to);
+  gof_info_.EraseBefore(unwrapped_tl0 - kMaxGofSaved);
 
   FrameReceivedVp9(frame->id.picture_id, info);
 
@@ -586,11 +734,8 @@ bool RtpFrameReferenceFinder::MissingRequiredFrameVp9(uint16_t picture_id,
     uint16_t ref_pid =
         Subtract<kPicIdLength>(picture_id, info.gof->pid_diff[gof_idx][i]);
     for (size_t l = 0; l < temporal_idx; ++l) {
-      auto missing_frame_it = missing_frames_for_layer_[l].lower_bound(ref_pid);
-      if (missing_frame_it != missing_frames_for_layer_[l].end() &&
-          AheadOf<uint16_t, kPicIdLength>(picture_id, *missing_frame_it)) {
+      if (missing_frames_for_layer_[l].ContainsAny(ref_pid, picture_id))
         return true;
-      }
     }
   }
   return false;
@@ -621,7 +766,7 @@ void RtpFrameReferenceFinder::FrameReceivedVp9(uint16_t picture_id,
         return;
       }
 
-      missing_frames_for_layer_[temporal_idx].insert(last_picture_id);
+      missing_frames_for_layer_[temporal_idx].Insert(last_picture_id);
       last_picture_id = Add<kPicIdLength>(last_picture_id, 1);
     }
 
@@ -639,7 +784,7 @@ void RtpFrameReferenceFinder::FrameReceivedVp9(uint16_t picture_id,
       return;
     }
 
-    missing_frames_for_layer_[temporal_idx].erase(picture_id);
+    missing_frames_for_layer_[temporal_idx].Erase(picture_id);
   }
 }
 
@@ -702,9 +847,7 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameH264(
   int64_t unwrapped_tl0 = tl0_unwrapper_.Unwrap(rtp_frame_marking.tl0_pic_idx);
 
   // Clean up info for base layers that are too old.
-  int64_t old_tl0_pic_idx = unwrapped_tl0 - kMaxLayerInfo;
-  auto clean_layer_info_to = layer_info_.lower_bound(old_tl0_pic_idx);
-  layer_info_.erase(layer_info_.begin(), clean_layer_info_to);
+  layer_info_.EraseBefore(unwrapped_tl0 - kMaxLayerInfo);
 
   // Clean up info about not yet received frames that are too old.
   uint16_t old_picture_id = frame->id.picture_id - kMaxNotYetReceivedFrames * 2;
@@ -714,25 +857,23 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameH264(
 
   if (frame->frame_type() == VideoFrameType::kVideoFrameKey) {
     frame->num_references = 0;
-    layer_info_[unwrapped_tl0].fill(-1);
+    layer_info_.Insert(unwrapped_tl0, {})->fill(-1);
     UpdateDataH264(frame, unwrapped_tl0, tid);
     return kHandOff;
   }
 
-  auto layer_info_it =
-      layer_info_.find(tid == 0 ? unwrapped_tl0 - 1 : unwrapped_tl0);
+  std::array<int64_t, kMaxTemporalLayers>* layer_info =
+      layer_info_.Find(tid == 0 ? unwrapped_tl0 - 1 : unwrapped_tl0);
 
   // Stash if we have no base layer frame yet.
-  if (layer_info_it == layer_info_.end())
+  if (!layer_info)
     return kStash;
 
   // Base layer frame. Copy layer info from previous base layer frame.
   if (tid == 0) {
-    layer_info_it =
-        layer_info_.insert(std::make_pair(unwrapped_tl0, layer_info_it->second))
-            .first;
+    layer_info = layer_info_.Insert(unwrapped_tl0, *layer_info);
     frame->num_references = 1;
-    frame->references[0] = layer_info_it->second[0];
+    frame->references[0] = (*layer_info)[0];
     UpdateDataH264(frame, unwrapped_tl0, tid);
     return kHandOff;
   }
@@ -740,7 +881,7 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameH264(
   // This frame only references its base layer frame.
   if (blSync) {
     frame->num_references = 1;
-    frame->references[0] = layer_info_it->second[0];
+    frame->references[0] = (*layer_info)[0];
     UpdateDataH264(frame, unwrapped_tl0, tid);
     return kHandOff;
   }
@@ -749,12 +890,12 @@ RtpFrameReferenceFinder::FrameDecision RtpFrameReferenceFinder::ManageFrameH264(
   frame->num_references = 0;
   for (uint8_t layer = 0; layer <= tid; ++layer) {
     // Stash if we have not yet received frames on this temporal layer.
-    if (layer_info_it->second[layer] == -1)
+    if ((*layer_info)[layer] == -1)
       return kStash;
 
     // Drop if the last frame on this layer is ahead of this frame. A layer sync
     // frame was received after this frame for the same base layer frame.
-    uint16_t last_frame_in_layer = layer_info_it->second[layer];
+    uint16_t last_frame_in_layer = (*layer_info)[layer];
     if (AheadOf<uint16_t>(last_frame_in_layer, frame->id.picture_id))
       return kDrop;
 
@@ -803,20 +944,20 @@ void RtpFrameReferenceFinder::UpdateLastPictureIdWithPaddingH264() {
 void RtpFrameReferenceFinder::UpdateLayerInfoH264(RtpFrameObject* frame,
                                                   int64_t unwrapped_tl0,
                                                   uint8_t temporal_idx) {
-  auto layer_info_it = layer_info_.find(unwrapped_tl0);
+  std::array<int64_t, kMaxTemporalLayers>* layer_info =
+      layer_info_.Find(unwrapped_tl0);
 
   // Update this layer info and newer.
-  while (layer_info_it != layer_info_.end()) {
-    if (layer_info_it->second[temporal_idx] != -1 &&
-        AheadOf<uint16_t>(layer_info_it->second[temporal_idx],
-                          frame->id.picture_id)) {
+  while (layer_info) {
+    if ((*layer_info)[temporal_idx] != -1 &&
+        AheadOf<uint16_t>((*layer_info)[temporal_idx], frame->id.picture_id)) {
       // Not a newer frame. No subsequent layer info needs update.
       break;
     }
 
-    layer_info_it->second[temporal_idx] = frame->id.picture_id;
+    (*layer_info)[temporal_idx] = frame->id.picture_id;
     ++unwrapped_tl0;
-    layer_info_it = layer_info_.find(unwrapped_tl0);
+    layer_info = layer_info_.Find(unwrapped_tl0);
   }
 
   for (size_t i = 0; i < frame->num_references; ++i)
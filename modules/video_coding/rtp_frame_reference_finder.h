@@ -11,13 +11,17 @@
 #ifndef MODULES_VIDEO_CODING_RTP_FRAME_REFERENCE_FINDER_H_
 #define MODULES_VIDEO_CODING_RTP_FRAME_REFERENCE_FINDER_H_
 
+#include <stddef.h>
+#include <stdint.h>
+
 #include <array>
-#include <deque>
 #include <map>
 #include <memory>
 #include <set>
 #include <utility>
+#include <vector>
 
+#include "absl/types/optional.h"
 #include "modules/include/module_common_types.h"
 #include "modules/rtp_rtcp/source/rtp_generic_frame_descriptor.h"
 #include "rtc_base/critical_section.h"
@@ -40,6 +44,16 @@ class OnCompleteFrameCallback {
 
 class RtpFrameReferenceFinder {
  public:
+  struct Stats {
+    // Stashed frames dropped because more than |kMaxStashedFrames| frames were
+    // waiting for their references.
+    size_t stashed_frames_evicted = 0;
+    // VP8/H264 layer infos and VP9 GOF infos dropped to make room for a newer
+    // TL0PICIDX before they had aged out.
+    size_t layer_infos_evicted = 0;
+    size_t gof_infos_evicted = 0;
+  };
+
   explicit RtpFrameReferenceFinder(OnCompleteFrameCallback* frame_callback);
   ~RtpFrameReferenceFinder();
 
@@ -58,6 +72,8 @@ class RtpFrameReferenceFinder {
   // Clear all stashed frames that include packets older than |seq_num|.
   void ClearTo(uint16_t seq_num);
 
+  Stats GetStats() const;
+
  private:
   static const uint16_t kPicIdLength = 1 << 15;
   static const uint8_t kMaxTemporalLayers = 5;
@@ -66,6 +82,11 @@ class RtpFrameReferenceFinder {
   static const int kMaxNotYetReceivedFrames = 100;
   static const int kMaxGofSaved = 50;
   static const int kMaxPaddingAge = 100;
+  // Number of slots of the TL0PICIDX indexed rings, a power of two larger
+  // than both |kMaxLayerInfo| and |kMaxGofSaved|.
+  static const size_t kTl0RingSize = 64;
+  // Number of picture ids tracked by a |PictureIdWindow|, a power of two.
+  static const uint16_t kPictureIdWindowSize = 1024;
 
   enum FrameDecision { kStash, kHandOff, kDrop };
 
@@ -76,6 +97,67 @@ class RtpFrameReferenceFinder {
     uint16_t last_picture_id;
   };
 
+  // Map from unwrapped TL0PICIDX to |T|, holding at most |kTl0RingSize|
+  // entries. Every entry is stored in the slot given by its TL0PICIDX, so
+  // inserting an entry evicts the one occupying that slot, if any.
+  template <typename T>
+  class Tl0Ring {
+   public:
+    Tl0Ring();
+    ~Tl0Ring();
+
+    // Returns nullptr if there is no entry for |tl0|.
+    T* Find(int64_t tl0);
+    // Like std::map::emplace, an already existing entry for |tl0| is returned
+    // unmodified.
+    T* Insert(int64_t tl0, const T& value);
+    // Erases all entries older than |tl0|.
+    void EraseBefore(int64_t tl0);
+
+    size_t evicted() const { return evicted_; }
+
+   private:
+    struct Slot {
+      int64_t tl0 = 0;
+      absl::optional<T> value;
+    };
+
+    std::array<Slot, kTl0RingSize> slots_;
+    size_t size_ = 0;
+    // No entry is older than |oldest_tl0_|.
+    int64_t oldest_tl0_ = 0;
+    size_t evicted_ = 0;
+  };
+
+  // Set of the picture ids of the last |kPictureIdWindowSize| picture ids,
+  // stored as a bitmap. The window only moves forward, and picture ids that
+  // fall out of it are forgotten.
+  class PictureIdWindow {
+   public:
+    PictureIdWindow();
+    ~PictureIdWindow();
+
+    // Inserts |picture_id|, moving the window forward if needed. Picture ids
+    // older than the window are ignored.
+    void Insert(uint16_t picture_id);
+    void Erase(uint16_t picture_id);
+    // Moves the start of the window forward to |picture_id|, erasing all
+    // older picture ids.
+    void EraseBefore(uint16_t picture_id);
+    // Returns true if any picture id of [|begin|, |end|) is in the set.
+    bool ContainsAny(uint16_t begin, uint16_t end) const;
+
+   private:
+    static const size_t kBitsPerWord = 64;
+
+    // Clears |count| bits starting at the bit of |picture_id|.
+    void ClearBits(uint16_t picture_id, size_t count);
+
+    bool initialized_ = false;
+    uint16_t begin_ = 0;
+    std::array<uint64_t, kPictureIdWindowSize / kBitsPerWord> words_;
+  };
+
   rtc::CriticalSection crit_;
 
   // Find the relevant group of pictures and update its "last-picture-id-with
@@ -174,8 +256,7 @@ class RtpFrameReferenceFinder {
 
   // Frames earlier than the last received frame that have not yet been
   // fully received.
-  std::set<uint16_t, DescendingSeqNumComp<uint16_t, kPicIdLength>>
-      not_yet_received_frames_ RTC_GUARDED_BY(crit_);
+  PictureIdWindow not_yet_received_frames_ RTC_GUARDED_BY(crit_);
 
   // Sequence numbers of frames earlier than the last received frame that
   // have not yet been fully received.
@@ -183,13 +264,14 @@ class RtpFrameReferenceFinder {
       RTC_GUARDED_BY(crit_);
 
   // Frames that have been fully received but didn't have all the information
-  // needed to determine their references.
-  std::deque<std::unique_ptr<RtpFrameObject>> stashed_frames_
+  // needed to determine their references, oldest first.
+  std::vector<std::unique_ptr<RtpFrameObject>> stashed_frames_
       RTC_GUARDED_BY(crit_);
+  size_t stashed_frames_evicted_ RTC_GUARDED_BY(crit_);
 
   // Holds the information about the last completed frame for a given temporal
   // layer given an unwrapped Tl0 picture index.
-  std::map<int64_t, std::array<int64_t, kMaxTemporalLayers>> layer_info_
+  Tl0Ring<std::array<int64_t, kMaxTemporalLayers>> layer_info_
       RTC_GUARDED_BY(crit_);
 
   // Where the current scalability structure is in the
@@ -201,7 +283,7 @@ class RtpFrameReferenceFinder {
       RTC_GUARDED_BY(crit_);
 
   // Holds the the Gof information for a given unwrapped TL0 picture index.
-  std::map<int64_t, GofInfo> gof_info_ RTC_GUARDED_BY(crit_);
+  Tl0Ring<GofInfo> gof_info_ RTC_GUARDED_BY(crit_);
 
   // Keep track of which picture id and which temporal layer that had the
   // up switch flag set.
@@ -209,9 +291,8 @@ class RtpFrameReferenceFinder {
       up_switch_ RTC_GUARDED_BY(crit_);
 
   // For every temporal layer, keep a set of which frames that are missing.
-  std::array<std::set<uint16_t, DescendingSeqNumComp<uint16_t, kPicIdLength>>,
-             kMaxTemporalLayers>
-      missing_frames_for_layer_ RTC_GUARDED_BY(crit_);
+  std::array<PictureIdWindow, kMaxTemporalLayers> missing_frames_for_layer_
+      RTC_GUARDED_BY(crit_);
 
   // How far frames have been cleared by sequence number. A frame will be
   // cleared if it contains a packet with a sequence number older than
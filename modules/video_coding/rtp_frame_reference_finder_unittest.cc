@@ -13,13 +13,17 @@
 #include <map>
 #include <set>
 #include <utility>
+#include <vector>
 
+#include "absl/memory/memory.h"
 #include "modules/video_coding/frame_object.h"
 #include "modules/video_coding/packet_buffer.h"
 #include "rtc_base/random.h"
 #include "rtc_base/ref_count.h"
+#include "rtc_base/time_utils.h"
 #include "system_wrappers/include/clock.h"
 #include "test/gtest.h"
+#include "test/testsupport/perf_test.h"
 
 namespace webrtc {
 namespace video_coding {
@@ -99,6 +103,17 @@ class TestRtpFrameReferenceFinder : public ::testing::Test,
                  uint8_t tid = kNoTemporalIdx,
                  int32_t tl0 = kNoTl0PicIdx,
                  bool sync = false) {
+    reference_finder_->ManageFrame(CreateVp8Frame(
+        seq_num_start, seq_num_end, keyframe, pid, tid, tl0, sync));
+  }
+
+  std::unique_ptr<RtpFrameObject> CreateVp8Frame(uint16_t seq_num_start,
+                                                 uint16_t seq_num_end,
+                                                 bool keyframe,
+                                                 int32_t pid,
+                                                 uint8_t tid,
+                                                 int32_t tl0,
+                                                 bool sync) {
     VCMPacket packet;
     packet.video_header.codec = kVideoCodecVP8;
     packet.seqNum = seq_num_start;
@@ -121,9 +136,9 @@ class TestRtpFrameReferenceFinder : public ::testing::Test,
       ref_packet_buffer_->InsertPacket(&packet);
     }
 
-    std::unique_ptr<RtpFrameObject> frame(new RtpFrameObject(
-        ref_packet_buffer_, seq_num_start, seq_num_end, 0, 0, 0, 0, {}));
-    reference_finder_->ManageFrame(std::move(frame));
+    return absl::make_unique<RtpFrameObject>(
+        ref_packet_buffer_, seq_num_start, seq_num_end, 0, 0, 0, 0,
+        RtpPacketInfos());
   }
 
   void InsertVp9Gof(uint16_t seq_num_start,
@@ -180,6 +195,19 @@ class TestRtpFrameReferenceFinder : public ::testing::Test,
                      uint8_t tid = kNoTemporalIdx,
                      bool inter = false,
                      std::vector<uint8_t> refs = std::vector<uint8_t>()) {
+    reference_finder_->ManageFrame(CreateVp9FlexFrame(
+        seq_num_start, seq_num_end, keyframe, pid, sid, tid, inter, refs));
+  }
+
+  std::unique_ptr<RtpFrameObject> CreateVp9FlexFrame(
+      uint16_t seq_num_start,
+      uint16_t seq_num_end,
+      bool keyframe,
+      int32_t pid,
+      uint8_t sid,
+      uint8_t tid,
+      bool inter,
+      const std::vector<uint8_t>& refs) {
     VCMPacket packet;
     auto& vp9_header =
         packet.video_header.video_type_header.emplace<RTPVideoHeaderVP9>();
@@ -208,9 +236,9 @@ class TestRtpFrameReferenceFinder : public ::testing::Test,
       ref_packet_buffer_->InsertPacket(&packet);
     }
 
-    std::unique_ptr<RtpFrameObject> frame(new RtpFrameObject(
-        ref_packet_buffer_, seq_num_start, seq_num_end, 0, 0, 0, 0, {}));
-    reference_finder_->ManageFrame(std::move(frame));
+    return absl::make_unique<RtpFrameObject>(
+        ref_packet_buffer_, seq_num_start, seq_num_end, 0, 0, 0, 0,
+        RtpPacketInfos());
   }
 
   void InsertH264(uint16_t seq_num_start,
@@ -1793,5 +1821,107 @@ TEST_F(TestRtpFrameReferenceFinder, H264Tl0PicIdxWrap) {
   }
 }
 
+TEST_F(TestRtpFrameReferenceFinder, StatsCountEvictedStashedFrames) {
+  uint16_t sn = Rand();
+
+  // Without a keyframe every frame is stashed.
+  for (int i = 0; i < 105; ++i)
+    InsertGeneric(sn + 2 * i, sn + 2 * i + 1, false);
+
+  EXPECT_EQ(4u, reference_finder_->GetStats().stashed_frames_evicted);
+  EXPECT_EQ(0UL, frames_from_callback_.size());
+}
+
+TEST_F(TestRtpFrameReferenceFinder, StatsCountEvictedLayerInfo) {
+  uint16_t sn = Rand();
+
+  InsertVp8(sn, sn, true, 10, 0, 65);
+  // A late keyframe whose TL0PICIDX maps to the same slot as 65.
+  InsertVp8(sn - 1, sn - 1, true, 5, 0, 1);
+
+  ASSERT_EQ(2UL, frames_from_callback_.size());
+  EXPECT_EQ(1u, reference_finder_->GetStats().layer_infos_evicted);
+  EXPECT_EQ(0u, reference_finder_->GetStats().gof_infos_evicted);
+}
+
+namespace {
+
+class CountingFrameCallback : public OnCompleteFrameCallback {
+ public:
+  void OnCompleteFrame(std::unique_ptr<EncodedFrame> frame) override {
+    ++num_frames;
+  }
+  int num_frames = 0;
+};
+
+// Swaps each frame with the next one with a probability of 5%.
+void ReorderFrames(Random* rand,
+                   std::vector<std::unique_ptr<RtpFrameObject>>* frames) {
+  for (size_t i = 1; i + 1 < frames->size(); ++i) {
+    if (rand->Rand(0, 99) < 5) {
+      std::swap((*frames)[i], (*frames)[i + 1]);
+      ++i;
+    }
+  }
+}
+
+void RunReferenceFinderPerf(
+    const std::string& story,
+    std::vector<std::unique_ptr<RtpFrameObject>> frames) {
+  CountingFrameCallback callback;
+  RtpFrameReferenceFinder reference_finder(&callback);
+  const size_t num_frames = frames.size();
+  int64_t start_us = rtc::TimeMicros();
+  for (auto& frame : frames)
+    reference_finder.ManageFrame(std::move(frame));
+  int64_t elapsed_us = rtc::TimeMicros() - start_us;
+  EXPECT_GT(callback.num_frames, 0);
+
+  webrtc::test::PrintResult(
+      "rtp_frame_reference_finder_manage_frame", "", story,
+      static_cast<double>(elapsed_us) / num_frames, "us", false);
+  webrtc::test::PrintResult(
+      "rtp_frame_reference_finder_stashed_frames_evicted", "", story,
+      reference_finder.GetStats().stashed_frames_evicted, "frames", false);
+}
+
+}  // namespace
+
+TEST_F(TestRtpFrameReferenceFinder, DISABLED_Vp8TemporalLayersPerf) {
+  const int kNumFrames = 100000;
+  const uint8_t kTemporalPattern[] = {0, 2, 1, 2};
+  std::vector<std::unique_ptr<RtpFrameObject>> frames;
+  uint16_t sn = Rand();
+  uint8_t tl0 = 0;
+  for (int i = 0; i < kNumFrames; ++i, sn += 2) {
+    uint8_t tid = kTemporalPattern[i % 4];
+    if (i > 0 && tid == 0)
+      ++tl0;
+    // The first frames of the upper layers only reference the base layer.
+    bool sync = i == 1 || i == 2;
+    frames.push_back(CreateVp8Frame(sn, sn + 1, i == 0, i, tid, tl0, sync));
+  }
+  ReorderFrames(&rand_, &frames);
+  RunReferenceFinderPerf("vp8_3tl_5pct_reordered", std::move(frames));
+}
+
+TEST_F(TestRtpFrameReferenceFinder, DISABLED_Vp9FlexibleModePerf) {
+  const int kNumFrames = 100000;
+  const uint8_t kTemporalPattern[] = {0, 2, 1, 2};
+  const uint8_t kPidDiff[] = {4, 2, 1};
+  std::vector<std::unique_ptr<RtpFrameObject>> frames;
+  uint16_t sn = Rand();
+  for (int i = 0; i < kNumFrames; ++i, sn += 2) {
+    uint8_t tid = kTemporalPattern[i % 4];
+    std::vector<uint8_t> refs;
+    if (i > 0)
+      refs.push_back(kPidDiff[tid]);
+    frames.push_back(CreateVp9FlexFrame(sn, sn + 1, i == 0, i, 0, tid,
+                                        /*inter=*/false, refs));
+  }
+  ReorderFrames(&rand_, &frames);
+  RunReferenceFinderPerf("vp9_flexible_3tl_5pct_reordered", std::move(frames));
+}
+
 }  // namespace video_coding
 }  // namespace webrtc
@@ -0,0 +1,181 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/video_coding/utility/encoder_threading_policy.h"
+
+#include <stdint.h>
+
+#include <algorithm>
+#include <atomic>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/experiments/field_trial_parser.h"
+#include "system_wrappers/include/field_trial.h"
+
+namespace webrtc {
+namespace {
+
+constexpr char kFieldTrial[] = "WebRTC-VideoEncoderThreading";
+
+constexpr int kDefaultPixelsPerThread = 640 * 360;
+constexpr int kDefaultMaxThreads = 8;
+// libvpx supports at most 8 token partitions.
+constexpr int kMaxVp8TokenPartitionsLog2 = 3;
+// Minimum width of a VP9 tile column.
+constexpr int kMinVp9TileColumnWidth = 256;
+
+std::atomic<int> g_num_active_encoders(0);
+
+int FloorLog2(int value) {
+  RTC_DCHECK_GT(value, 0);
+  int log2 = 0;
+  while (value >>= 1)
+    ++log2;
+  return log2;
+}
+
+}  // namespace
+
+EncoderThreadingPolicy::ScopedActiveEncoder::ScopedActiveEncoder() {
+  g_num_active_encoders.fetch_add(1);
+}
+
+EncoderThreadingPolicy::ScopedActiveEncoder::~ScopedActiveEncoder() {
+  g_num_active_encoders.fetch_sub(1);
+}
+
+EncoderThreadingPolicy::EncoderThreadingPolicy()
+    : enabled_(false),
+      share_cores_(true),
+      vp8_token_partitions_(false),
+      vp9_row_mt_(true),
+      h264_slice_threads_(false),
+      vp8_{kDefaultPixelsPerThread, kDefaultMaxThreads},
+      vp9_{kDefaultPixelsPerThread, kDefaultMaxThreads},
+      h264_{kDefaultPixelsPerThread, kDefaultMaxThreads} {}
+
+// static
+EncoderThreadingPolicy EncoderThreadingPolicy::ParseFromFieldTrials() {
+  EncoderThreadingPolicy policy;
+  policy.enabled_ = field_trial::IsEnabled(kFieldTrial);
+  if (!policy.enabled_)
+    return policy;
+
+  FieldTrialParameter<bool> share_cores("share_cores", policy.share_cores_);
+  FieldTrialParameter<bool> vp8_token_partitions(
+      "vp8_token_partitions", policy.vp8_token_partitions_);
+  FieldTrialParameter<bool> vp9_row_mt("vp9_row_mt", policy.vp9_row_mt_);
+  FieldTrialParameter<bool> h264_slice_threads("h264_slice_threads",
+                                               policy.h264_slice_threads_);
+  FieldTrialParameter<int> vp8_pixels_per_thread("vp8_pixels_per_thread",
+                                                 kDefaultPixelsPerThread);
+  FieldTrialParameter<int> vp9_pixels_per_thread("vp9_pixels_per_thread",
+                                                 kDefaultPixelsPerThread);
+  FieldTrialParameter<int> h264_pixels_per_thread("h264_pixels_per_thread",
+                                                  kDefaultPixelsPerThread);
+  FieldTrialParameter<int> vp8_max_threads("vp8_max_threads",
+                                           kDefaultMaxThreads);
+  FieldTrialParameter<int> vp9_max_threads("vp9_max_threads",
+                                           kDefaultMaxThreads);
+  FieldTrialParameter<int> h264_max_threads("h264_max_threads",
+                                            kDefaultMaxThreads);
+  ParseFieldTrial(
+      {&share_cores, &vp8_token_partitions, &vp9_row_mt, &h264_slice_threads,
+       &vp8_pixels_per_thread, &vp9_pixels_per_thread, &h264_pixels_per_thread,
+       &vp8_max_threads, &vp9_max_threads, &h264_max_threads},
+      field_trial::FindFullName(kFieldTrial));
+
+  policy.share_cores_ = share_cores.Get();
+  policy.vp8_token_partitions_ = vp8_token_partitions.Get();
+  policy.vp9_row_mt_ = vp9_row_mt.Get();
+  policy.h264_slice_threads_ = h264_slice_threads.Get();
+  policy.vp8_ = {std::max(1, vp8_pixels_per_thread.Get()),
+                 std::max(1, vp8_max_threads.Get())};
+  policy.vp9_ = {std::max(1, vp9_pixels_per_thread.Get()),
+                 std::max(1, vp9_max_threads.Get())};
+  policy.h264_ = {std::max(1, h264_pixels_per_thread.Get()),
+                  std::max(1, h264_max_threads.Get())};
+  return policy;
+}
+
+// static
+int EncoderThreadingPolicy::NumActiveEncoders() {
+  return g_num_active_encoders.load();
+}
+
+EncoderThreadingPolicy::Settings EncoderThreadingPolicy::GetSettings(
+    VideoCodecType codec_type,
+    int width,
+    int height,
+    int number_of_cores,
+    int default_num_threads) const {
+  Settings settings;
+  if (!enabled_) {
+    settings.num_threads = std::max(1, default_num_threads);
+    settings.vp9_tile_columns_log2 = FloorLog2(settings.num_threads);
+    return settings;
+  }
+
+  int available_cores = std::max(1, number_of_cores);
+  if (share_cores_)
+    available_cores /= std::max(1, NumActiveEncoders());
+  const CodecConfig& config = GetCodecConfig(codec_type);
+  const int64_t num_pixels = static_cast<int64_t>(width) * height;
+  int num_threads = static_cast<int>(
+      (num_pixels + config.pixels_per_thread - 1) / config.pixels_per_thread);
+  num_threads = std::min({num_threads, available_cores, config.max_threads});
+  num_threads = std::max(1, num_threads);
+
+  switch (codec_type) {
+    case kVideoCodecVP8:
+      settings.num_threads = num_threads;
+      if (vp8_token_partitions_) {
+        settings.vp8_token_partitions_log2 =
+            std::min(FloorLog2(num_threads), kMaxVp8TokenPartitionsLog2);
+      }
+      break;
+    case kVideoCodecVP9: {
+      const int max_tile_columns =
+          std::max(1, width / kMinVp9TileColumnWidth);
+      settings.vp9_row_mt = vp9_row_mt_;
+      settings.vp9_tile_columns_log2 =
+          FloorLog2(std::min(num_threads, max_tile_columns));
+      // Without row based multithreading, threads beyond one per tile column
+      // are idle.
+      settings.num_threads =
+          vp9_row_mt_ ? num_threads : 1 << settings.vp9_tile_columns_log2;
+      break;
+    }
+    case kVideoCodecH264:
+      settings.num_threads = num_threads;
+      // OpenH264 only encodes slices in parallel.
+      if (h264_slice_threads_)
+        settings.h264_num_slices = num_threads;
+      break;
+    default:
+      settings.num_threads = num_threads;
+      break;
+  }
+  return settings;
+}
+
+const EncoderThreadingPolicy::CodecConfig&
+EncoderThreadingPolicy::GetCodecConfig(VideoCodecType codec_type) const {
+  switch (codec_type) {
+    case kVideoCodecVP9:
+      return vp9_;
+    case kVideoCodecH264:
+      return h264_;
+    default:
+      return vp8_;
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,97 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef MODULES_VIDEO_CODING_UTILITY_ENCODER_THREADING_POLICY_H_
+#define MODULES_VIDEO_CODING_UTILITY_ENCODER_THREADING_POLICY_H_
+
+#include "api/video/video_codec_type.h"
+#include "rtc_base/constructor_magic.h"
+
+namespace webrtc {
+
+// Decides how many threads the libvpx and OpenH264 encoders use, and which of
+// their multithreading tools they turn on.
+//
+// Unless the "WebRTC-VideoEncoderThreading" field trial is enabled, each
+// encoder keeps its own resolution based heuristic. When enabled, the cores
+// are shared between the encoders that are initialized in the process, e.g.
+// the layers of a SimulcastEncoderAdapter or the encoders of many send
+// streams, and each encoder gets one thread per |pixels_per_thread| pixels, up
+// to its share of the cores. The trial can also turn on VP8 token partitions,
+// VP9 row based multithreading and OpenH264 slice threads, e.g.
+// "WebRTC-VideoEncoderThreading/Enabled,vp8_token_partitions:true/".
+//
+// The number of encoders is only taken into account when an encoder is
+// initialized, encoders don't change their threading when others come and go.
+class EncoderThreadingPolicy {
+ public:
+  struct Settings {
+    int num_threads = 1;
+    // In log2, e.g. 2 for four token partitions.
+    int vp8_token_partitions_log2 = 0;
+    bool vp9_row_mt = true;
+    // In log2, capped by libvpx by the minimum tile width of 256 pixels.
+    int vp9_tile_columns_log2 = 0;
+    // Number of slices encoded in parallel, for non-interleaved packetization.
+    // More than one only with "h264_slice_threads:true", which is off by
+    // default since the OpenH264 rate controller misbehaves with more slices.
+    int h264_num_slices = 1;
+  };
+
+  // Counts an encoder as sharing the cores for as long as it's alive.
+  class ScopedActiveEncoder {
+   public:
+    ScopedActiveEncoder();
+    ~ScopedActiveEncoder();
+
+   private:
+    RTC_DISALLOW_COPY_AND_ASSIGN(ScopedActiveEncoder);
+  };
+
+  static EncoderThreadingPolicy ParseFromFieldTrials();
+
+  // Returns the number of ScopedActiveEncoders alive.
+  static int NumActiveEncoders();
+
+  bool enabled() const { return enabled_; }
+
+  // Returns the threading of an encoder of |codec_type| for |width|x|height|
+  // frames, on a machine with |number_of_cores|. |default_num_threads| is the
+  // encoder's own choice, which is used unless the policy is enabled.
+  Settings GetSettings(VideoCodecType codec_type,
+                       int width,
+                       int height,
+                       int number_of_cores,
+                       int default_num_threads) const;
+
+ private:
+  struct CodecConfig {
+    int pixels_per_thread;
+    int max_threads;
+  };
+
+  EncoderThreadingPolicy();
+
+  const CodecConfig& GetCodecConfig(VideoCodecType codec_type) const;
+
+  bool enabled_;
+  // If set, the cores are divided between the active encoders.
+  bool share_cores_;
+  bool vp8_token_partitions_;
+  bool vp9_row_mt_;
+  bool h264_slice_threads_;
+  CodecConfig vp8_;
+  CodecConfig vp9_;
+  CodecConfig h264_;
+};
+
+}  // namespace webrtc
+
+#endif  // MODULES_VIDEO_CODING_UTILITY_ENCODER_THREADING_POLICY_H_
@@ -0,0 +1,145 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "modules/video_coding/utility/encoder_threading_policy.h"
+
+#include "test/field_trial.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+
+TEST(EncoderThreadingPolicyTest, UsesDefaultThreadsWhenDisabled) {
+  EncoderThreadingPolicy policy =
+      EncoderThreadingPolicy::ParseFromFieldTrials();
+  EXPECT_FALSE(policy.enabled());
+  EncoderThreadingPolicy::Settings settings =
+      policy.GetSettings(kVideoCodecVP9, 1280, 720, 16, 4);
+  EXPECT_EQ(4, settings.num_threads);
+  EXPECT_EQ(2, settings.vp9_tile_columns_log2);
+  EXPECT_TRUE(settings.vp9_row_mt);
+  EXPECT_EQ(0, settings.vp8_token_partitions_log2);
+  EXPECT_EQ(1, settings.h264_num_slices);
+}
+
+TEST(EncoderThreadingPolicyTest, UsesOneThreadPerPixelsPerThread) {
+  test::ScopedFieldTrials field_trials(
+      "WebRTC-VideoEncoderThreading/Enabled,share_cores:false/");
+  EncoderThreadingPolicy policy =
+      EncoderThreadingPolicy::ParseFromFieldTrials();
+  EXPECT_TRUE(policy.enabled());
+  EXPECT_EQ(1, policy.GetSettings(kVideoCodecVP8, 320, 180, 16, 1).num_threads);
+  EXPECT_EQ(2, policy.GetSettings(kVideoCodecVP8, 640, 480, 16, 1).num_threads);
+  EXPECT_EQ(4,
+            policy.GetSettings(kVideoCodecVP8, 1280, 720, 16, 1).num_threads);
+  EXPECT_EQ(8,
+            policy.GetSettings(kVideoCodecVP8, 3840, 2160, 16, 1).num_threads);
+  // Never more threads than cores.
+  EXPECT_EQ(2, policy.GetSettings(kVideoCodecVP8, 1280, 720, 2, 1).num_threads);
+}
+
+TEST(EncoderThreadingPolicyTest, AppliesPerCodecConfig) {
+  test::ScopedFieldTrials field_trials(
+      "WebRTC-VideoEncoderThreading/Enabled,share_cores:false,"
+      "vp8_pixels_per_thread:100000,vp8_max_threads:3/");
+  EncoderThreadingPolicy policy =
+      EncoderThreadingPolicy::ParseFromFieldTrials();
+  EXPECT_EQ(3, policy.GetSettings(kVideoCodecVP8, 640, 480, 16, 1).num_threads);
+  EXPECT_EQ(2, policy.GetSettings(kVideoCodecVP9, 640, 480, 16, 1).num_threads);
+}
+
+TEST(EncoderThreadingPolicyTest, SharesCoresBetweenActiveEncoders) {
+  test::ScopedFieldTrials field_trials("WebRTC-VideoEncoderThreading/Enabled/");
+  EncoderThreadingPolicy policy =
+      EncoderThreadingPolicy::ParseFromFieldTrials();
+  EncoderThreadingPolicy::ScopedActiveEncoder encoder1;
+  EXPECT_EQ(4, policy.GetSettings(kVideoCodecVP8, 1280, 720, 8, 1).num_threads);
+  {
+    EncoderThreadingPolicy::ScopedActiveEncoder encoder2;
+    EncoderThreadingPolicy::ScopedActiveEncoder encoder3;
+    EncoderThreadingPolicy::ScopedActiveEncoder encoder4;
+    EXPECT_EQ(4, EncoderThreadingPolicy::NumActiveEncoders());
+    EXPECT_EQ(2,
+              policy.GetSettings(kVideoCodecVP8, 1280, 720, 8, 1).num_threads);
+    EXPECT_EQ(1,
+              policy.GetSettings(kVideoCodecVP8, 1280, 720, 2, 1).num_threads);
+  }
+  EXPECT_EQ(1, EncoderThreadingPolicy::NumActiveEncoders());
+}
+
+TEST(EncoderThreadingPolicyTest, EnablesVp8TokenPartitions) {
+  test::ScopedFieldTrials field_trials("WebRTC-VideoEncoderThreading/"
+      "Enabled,share_cores:false,vp8_token_partitions:true/");
+  EncoderThreadingPolicy policy =
+      EncoderThreadingPolicy::ParseFromFieldTrials();
+  EXPECT_EQ(0, policy.GetSettings(kVideoCodecVP8, 320, 180, 16, 1)
+                   .vp8_token_partitions_log2);
+  EXPECT_EQ(2, policy.GetSettings(kVideoCodecVP8, 1280, 720, 16, 1)
+                   .vp8_token_partitions_log2);
+  EXPECT_EQ(3, policy.GetSettings(kVideoCodecVP8, 3840, 2160, 16, 1)
+                   .vp8_token_partitions_log2);
+}
+
+TEST(EncoderThreadingPolicyTest, LimitsVp9TileColumnsByWidth) {
+  test::ScopedFieldTrials field_trials(
+      "WebRTC-VideoEncoderThreading/Enabled,share_cores:false/");
+  EncoderThreadingPolicy policy =
+      EncoderThreadingPolicy::ParseFromFieldTrials();
+  // 1920 pixels fit 7 tile columns of 256, rounded down to 4.
+  EncoderThreadingPolicy::Settings settings =
+      policy.GetSettings(kVideoCodecVP9, 1920, 1080, 16, 1);
+  EXPECT_TRUE(settings.vp9_row_mt);
+  EXPECT_EQ(2, settings.vp9_tile_columns_log2);
+  // Row based multithreading keeps all threads busy.
+  EXPECT_EQ(8, settings.num_threads);
+}
+
+TEST(EncoderThreadingPolicyTest, UsesThreadPerVp9TileWithoutRowMt) {
+  test::ScopedFieldTrials field_trials("WebRTC-VideoEncoderThreading/"
+      "Enabled,share_cores:false,vp9_row_mt:false/");
+  EncoderThreadingPolicy policy =
+      EncoderThreadingPolicy::ParseFromFieldTrials();
+  EncoderThreadingPolicy::Settings settings =
+      policy.GetSettings(kVideoCodecVP9, 1920, 1080, 16, 1);
+  EXPECT_FALSE(settings.vp9_row_mt);
+  EXPECT_EQ(2, settings.vp9_tile_columns_log2);
+  EXPECT_EQ(4, settings.num_threads);
+}
+
+TEST(EncoderThreadingPolicyTest, UsesH264PixelsPerThread) {
+  test::ScopedFieldTrials field_trials("WebRTC-VideoEncoderThreading/"
+      "Enabled,share_cores:false,h264_pixels_per_thread:921600/");
+  EncoderThreadingPolicy policy =
+      EncoderThreadingPolicy::ParseFromFieldTrials();
+  EXPECT_EQ(1,
+            policy.GetSettings(kVideoCodecH264, 1280, 720, 16, 4).num_threads);
+  EXPECT_EQ(3,
+            policy.GetSettings(kVideoCodecH264, 1920, 1080, 16, 4).num_threads);
+}
+
+TEST(EncoderThreadingPolicyTest, UsesH264SliceThreadsOnlyIfEnabled) {
+  {
+    test::ScopedFieldTrials field_trials(
+        "WebRTC-VideoEncoderThreading/Enabled,share_cores:false/");
+    EncoderThreadingPolicy::Settings settings =
+        EncoderThreadingPolicy::ParseFromFieldTrials().GetSettings(
+            kVideoCodecH264, 1280, 720, 16, 1);
+    EXPECT_EQ(4, settings.num_threads);
+    EXPECT_EQ(1, settings.h264_num_slices);
+  }
+  test::ScopedFieldTrials field_trials("WebRTC-VideoEncoderThreading/"
+      "Enabled,share_cores:false,h264_slice_threads:true/");
+  EncoderThreadingPolicy::Settings settings =
+      EncoderThreadingPolicy::ParseFromFieldTrials().GetSettings(
+          kVideoCodecH264, 1280, 720, 16, 1);
+  EXPECT_EQ(4, settings.num_threads);
+  EXPECT_EQ(4, settings.h264_num_slices);
+}
+
+}  // namespace webrtc
@@ -16,5 +16,6 @@ void VCMReceiveCallback::OnDroppedFrames(uint32_t frames_dropped) {}
 void VCMReceiveCallback::OnIncomingPayloadType(int payload_type) {}
 void VCMReceiveCallback::OnDecoderImplementationName(
     const char* implementation_name) {}
+void VCMReceiveCallback::OnDecoderFrameBufferBytes(size_t bytes) {}
 
 }  // namespace webrtc
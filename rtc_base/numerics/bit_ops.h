@@ -0,0 +1,37 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef RTC_BASE_NUMERICS_BIT_OPS_H_
+#define RTC_BASE_NUMERICS_BIT_OPS_H_
+
+#include <stdint.h>
+
+#include "rtc_base/checks.h"
+
+namespace webrtc {
+
+// Returns the number of trailing zero bits of |word|, which must not be zero.
+inline int CountTrailingZeros(uint64_t word) {
+  RTC_DCHECK_NE(word, 0);
+#if defined(__GNUC__)
+  return __builtin_ctzll(word);
+#else
+  int zeros = 0;
+  while ((word & 1) == 0) {
+    word >>= 1;
+    ++zeros;
+  }
+  return zeros;
+#endif
+}
+
+}  // namespace webrtc
+
+#endif  // RTC_BASE_NUMERICS_BIT_OPS_H_
@@ -0,0 +1,30 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "rtc_base/numerics/bit_ops.h"
+
+#include <stdint.h>
+
+#include "test/gtest.h"
+
+namespace webrtc {
+
+TEST(BitOpsTest, CountTrailingZeros) {
+  EXPECT_EQ(0, CountTrailingZeros(1));
+  EXPECT_EQ(0, CountTrailingZeros(~uint64_t{0}));
+  EXPECT_EQ(3, CountTrailingZeros(0x28));
+  EXPECT_EQ(32, CountTrailingZeros(uint64_t{1} << 32));
+  EXPECT_EQ(63, CountTrailingZeros(uint64_t{1} << 63));
+  for (int bit = 0; bit < 64; ++bit) {
+    EXPECT_EQ(bit, CountTrailingZeros(~uint64_t{0} << bit));
+  }
+}
+
+}  // namespace webrtc
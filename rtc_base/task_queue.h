@@ -87,7 +87,7 @@ class RTC_LOCKABLE RTC_EXPORT TaskQueue {
   bool IsCurrent() const;
 
   // Returns non-owning pointer to the task queue implementation.
-  webrtc::TaskQueueBase* Get() { return impl_; }
+  webrtc::TaskQueueBase* Get() const { return impl_; }
 
   // TODO(tommi): For better debuggability, implement RTC_FROM_HERE.
 
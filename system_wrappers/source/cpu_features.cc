@@ -10,6 +10,8 @@
 
 // Parts of this file derived from Chromium's base/cpu.cc.
 
+#include <stdint.h>
+
 #include "rtc_base/system/arch.h"
 #include "system_wrappers/include/cpu_features_wrapper.h"
 
@@ -44,7 +46,38 @@ static inline void __cpuid(int cpu_info[4], int info_type) {
                    : "a"(info_type));
 }
 #endif
+
+// Intrinsic for "cpuid" with a sub-leaf in ecx.
+#if defined(__pic__) && defined(__i386__)
+static inline void __cpuidex(int cpu_info[4], int info_type, int sub_type) {
+  __asm__ volatile(
+      "mov %%ebx, %%edi\n"
+      "cpuid\n"
+      "xchg %%edi, %%ebx\n"
+      : "=a"(cpu_info[0]), "=D"(cpu_info[1]), "=c"(cpu_info[2]),
+        "=d"(cpu_info[3])
+      : "a"(info_type), "c"(sub_type));
+}
+#else
+static inline void __cpuidex(int cpu_info[4], int info_type, int sub_type) {
+  __asm__ volatile("cpuid\n"
+                   : "=a"(cpu_info[0]), "=b"(cpu_info[1]), "=c"(cpu_info[2]),
+                     "=d"(cpu_info[3])
+                   : "a"(info_type), "c"(sub_type));
+}
+#endif
 #endif  // _MSC_VER
+
+// Returns the XCR0 register, only valid on CPUs reporting OSXSAVE.
+static inline uint64_t GetXcr0() {
+#if defined(_MSC_VER)
+  return _xgetbv(0);
+#else
+  uint32_t eax, edx;
+  __asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+  return (static_cast<uint64_t>(edx) << 32) | eax;
+#endif
+}
 #endif  // WEBRTC_ARCH_X86_FAMILY
 
 #if defined(WEBRTC_ARCH_X86_FAMILY)
@@ -58,6 +91,24 @@ static int GetCPUInfo(CPUFeature feature) {
   if (feature == kSSE3) {
     return 0 != (cpu_info[2] & 0x00000001);
   }
+  // AVX2 and FMA3 also need the OS to save the YMM registers, which it
+  // reports through OSXSAVE and XCR0.
+  const int kOsxsaveAndAvx = 0x18000000;
+  const bool os_saves_ymm = (cpu_info[2] & kOsxsaveAndAvx) == kOsxsaveAndAvx &&
+                            (GetXcr0() & 0x6) == 0x6;
+  if (feature == kFMA3) {
+    return os_saves_ymm && 0 != (cpu_info[2] & 0x00001000);
+  }
+  if (feature == kAVX2) {
+    if (!os_saves_ymm) {
+      return 0;
+    }
+    __cpuid(cpu_info, 0);
+    if (cpu_info[0] < 7)
+      return 0;
+    __cpuidex(cpu_info, 7, 0);
+    return 0 != (cpu_info[1] & 0x00000020);
+  }
   return 0;
 }
 #else
@@ -0,0 +1,221 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "video/encoder_cpu_budget_scheduler.h"
+
+#include <math.h>
+
+#include <algorithm>
+
+#include "rtc_base/checks.h"
+#include "rtc_base/experiments/field_trial_parser.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
+#include "system_wrappers/include/cpu_info.h"
+#include "system_wrappers/include/field_trial.h"
+
+namespace webrtc {
+namespace {
+
+constexpr char kFieldTrial[] = "WebRTC-EncoderCpuBudget";
+
+// Encoders are given this much more than their load before the rest of the
+// budget is shared, so that they don't adapt down as soon as the load grows.
+constexpr double kHeadroom = 1.2;
+// Assumed increase of the load per step of encoder complexity.
+constexpr double kComplexityCostFactor = 1.25;
+constexpr int kMaxComplexityLevel =
+    static_cast<int>(VideoCodecComplexity::kComplexityHigher);
+// Usage thresholds are rounded down to steps of this size, so that small load
+// changes don't update the allocation.
+constexpr int kEncodeUsageStepPercent = 5;
+constexpr int kMinEncodeUsagePercent = 10;
+
+EncoderCpuBudgetScheduler* CreateProcessScheduler() {
+  if (!field_trial::IsEnabled(kFieldTrial))
+    return nullptr;
+  FieldTrialParameter<double> cores("cores", CpuInfo::DetectNumberOfCores());
+  ParseFieldTrial({&cores}, field_trial::FindFullName(kFieldTrial));
+  RTC_LOG(LS_INFO) << "Sharing a budget of " << cores.Get()
+                   << " cores between video encoders.";
+  return new EncoderCpuBudgetScheduler(cores.Get());
+}
+
+}  // namespace
+
+constexpr double EncoderCpuBudgetScheduler::kInitialLoad;
+constexpr int64_t EncoderCpuBudgetScheduler::kRebalanceIntervalMs;
+
+// static
+EncoderCpuBudgetScheduler* EncoderCpuBudgetScheduler::GetProcessScheduler() {
+  static EncoderCpuBudgetScheduler* const scheduler = CreateProcessScheduler();
+  return scheduler;
+}
+
+EncoderCpuBudgetScheduler::EncoderCpuBudgetScheduler(double budget)
+    : budget_(budget) {
+  RTC_DCHECK_GT(budget, 0.0);
+}
+
+EncoderCpuBudgetScheduler::~EncoderCpuBudgetScheduler() = default;
+
+void EncoderCpuBudgetScheduler::AddClient(Client* client, double priority) {
+  RTC_DCHECK(client);
+  RTC_DCHECK_GT(priority, 0.0);
+  rtc::CritScope lock(&crit_);
+  auto it = FindClient(client);
+  if (it != clients_.end()) {
+    if (it->priority == priority)
+      return;
+    it->priority = priority;
+  } else {
+    clients_.push_back(
+        ClientState{client, priority, kInitialLoad, 0.0, Allocation()});
+  }
+  Rebalance();
+}
+
+void EncoderCpuBudgetScheduler::RemoveClient(Client* client) {
+  rtc::CritScope lock(&crit_);
+  auto it = FindClient(client);
+  if (it == clients_.end())
+    return;
+  clients_.erase(it);
+  Rebalance();
+}
+
+void EncoderCpuBudgetScheduler::OnLoadMeasured(Client* client, double load) {
+  RTC_DCHECK_GE(load, 0.0);
+  rtc::CritScope lock(&crit_);
+  auto it = FindClient(client);
+  if (it == clients_.end())
+    return;
+  it->load = load;
+  if (rtc::TimeMillis() - last_rebalance_time_ms_ >= kRebalanceIntervalMs)
+    Rebalance();
+}
+
+EncoderCpuBudgetScheduler::Stats EncoderCpuBudgetScheduler::GetStats() const {
+  rtc::CritScope lock(&crit_);
+  Stats stats;
+  stats.budget = budget_;
+  stats.num_rebalances = num_rebalances_;
+  for (const ClientState& state : clients_) {
+    ClientStats client_stats;
+    client_stats.priority = state.priority;
+    client_stats.load = state.load;
+    client_stats.budget = state.budget;
+    client_stats.allocation = state.allocation;
+    stats.total_load += state.load;
+    stats.clients.push_back(client_stats);
+  }
+  return stats;
+}
+
+std::vector<EncoderCpuBudgetScheduler::ClientState>::iterator
+EncoderCpuBudgetScheduler::FindClient(Client* client) {
+  return std::find_if(
+      clients_.begin(), clients_.end(),
+      [client](const ClientState& state) { return state.client == client; });
+}
+
+void EncoderCpuBudgetScheduler::Rebalance() {
+  last_rebalance_time_ms_ = rtc::TimeMillis();
+  ++num_rebalances_;
+  if (clients_.empty())
+    return;
+
+  // The loads at normal complexity, which the demands are based on.
+  std::vector<double> base_loads;
+  std::vector<double> demands;
+  for (const ClientState& state : clients_) {
+    base_loads.push_back(
+        state.load / pow(kComplexityCostFactor,
+                         static_cast<int>(state.allocation.complexity)));
+    demands.push_back(kHeadroom * base_loads.back());
+  }
+
+  // Weighted max-min fair sharing: satisfy all demands below the fair share,
+  // then share what is left between the rest.
+  std::vector<double> budgets(clients_.size(), 0.0);
+  std::vector<size_t> unsatisfied;
+  for (size_t i = 0; i < clients_.size(); ++i)
+    unsatisfied.push_back(i);
+  double remaining = budget_;
+  while (!unsatisfied.empty()) {
+    double total_priority = 0.0;
+    for (size_t i : unsatisfied)
+      total_priority += clients_[i].priority;
+    std::vector<size_t> still_unsatisfied;
+    for (size_t i : unsatisfied) {
+      if (demands[i] > remaining * clients_[i].priority / total_priority)
+        still_unsatisfied.push_back(i);
+    }
+    if (still_unsatisfied.size() == unsatisfied.size()) {
+      for (size_t i : unsatisfied)
+        budgets[i] = remaining * clients_[i].priority / total_priority;
+      remaining = 0.0;
+      break;
+    }
+    for (size_t i : unsatisfied) {
+      if (demands[i] <= remaining * clients_[i].priority / total_priority) {
+        budgets[i] = demands[i];
+        remaining -= demands[i];
+      }
+    }
+    unsatisfied.swap(still_unsatisfied);
+  }
+
+  // Spend what is left on complexity, highest priority first, and then give
+  // the rest to everyone as more headroom.
+  std::vector<size_t> by_priority;
+  for (size_t i = 0; i < clients_.size(); ++i)
+    by_priority.push_back(i);
+  std::stable_sort(by_priority.begin(), by_priority.end(),
+                   [this](size_t a, size_t b) {
+                     return clients_[a].priority > clients_[b].priority;
+                   });
+  std::vector<int> complexity_levels(clients_.size(), 0);
+  for (size_t i : by_priority) {
+    while (complexity_levels[i] < kMaxComplexityLevel) {
+      const double cost =
+          demands[i] * (pow(kComplexityCostFactor, complexity_levels[i] + 1) -
+                        pow(kComplexityCostFactor, complexity_levels[i]));
+      if (cost > remaining)
+        break;
+      ++complexity_levels[i];
+      budgets[i] += cost;
+      remaining -= cost;
+    }
+  }
+  double total_priority = 0.0;
+  for (const ClientState& state : clients_)
+    total_priority += state.priority;
+  for (size_t i = 0; i < clients_.size(); ++i)
+    budgets[i] += remaining * clients_[i].priority / total_priority;
+
+  for (size_t i = 0; i < clients_.size(); ++i) {
+    ClientState& state = clients_[i];
+    state.budget = budgets[i];
+    Allocation allocation;
+    allocation.max_encode_usage_percent =
+        std::max(kMinEncodeUsagePercent,
+                 static_cast<int>(100 * budgets[i]) / kEncodeUsageStepPercent *
+                     kEncodeUsageStepPercent);
+    allocation.complexity =
+        static_cast<VideoCodecComplexity>(complexity_levels[i]);
+    if (allocation != state.allocation) {
+      state.allocation = allocation;
+      state.client->OnCpuBudgetAllocationUpdated(allocation);
+    }
+  }
+}
+
+}  // namespace webrtc
@@ -0,0 +1,129 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VIDEO_ENCODER_CPU_BUDGET_SCHEDULER_H_
+#define VIDEO_ENCODER_CPU_BUDGET_SCHEDULER_H_
+
+#include <stdint.h>
+
+#include <vector>
+
+#include "api/video_codecs/video_codec.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+// Shares a CPU budget between the video encoders of a process, so that a
+// process hosting many send streams degrades its low priority streams first
+// instead of all streams adapting independently of each other.
+//
+// Each encoder reports its load, the fraction of a core its encoding uses as
+// measured by its OveruseFrameDetector. The budget is divided with weighted
+// max-min fairness: encoders get what they use plus some headroom, as far as
+// the budget allows, and encoders that want more than their fair share split
+// the rest in proportion to their priorities. An encoder's share becomes the
+// overuse threshold of its OveruseFrameDetector, so encoders above their share
+// adapt resolution and framerate down through the usual cpu adaptation. Budget
+// left over after all encoders are satisfied is spent on higher encoder
+// complexity, in priority order.
+//
+// All methods are thread safe.
+class EncoderCpuBudgetScheduler {
+ public:
+  struct Allocation {
+    bool operator==(const Allocation& o) const {
+      return max_encode_usage_percent == o.max_encode_usage_percent &&
+             complexity == o.complexity;
+    }
+    bool operator!=(const Allocation& o) const { return !(*this == o); }
+
+    // The encoder should adapt down when its encode usage is above this.
+    int max_encode_usage_percent = 0;
+    VideoCodecComplexity complexity = VideoCodecComplexity::kComplexityNormal;
+  };
+
+  class Client {
+   public:
+    // Called on a scheduler thread, with the scheduler locked. Must not call
+    // back into the scheduler.
+    virtual void OnCpuBudgetAllocationUpdated(
+        const Allocation& allocation) = 0;
+
+   protected:
+    virtual ~Client() = default;
+  };
+
+  struct ClientStats {
+    double priority = 0.0;
+    // Measured load, in cores.
+    double load = 0.0;
+    // Share of the budget, in cores.
+    double budget = 0.0;
+    Allocation allocation;
+  };
+
+  struct Stats {
+    // In cores.
+    double budget = 0.0;
+    double total_load = 0.0;
+    int num_rebalances = 0;
+    // In the order the clients were added.
+    std::vector<ClientStats> clients;
+  };
+
+  // Load assumed for encoders that haven't reported any.
+  static constexpr double kInitialLoad = 0.5;
+  // Loads are reported more often than this only rebalance the budget after
+  // this interval.
+  static constexpr int64_t kRebalanceIntervalMs = 5000;
+
+  // Returns the scheduler shared by all encoders of the process, or null if
+  // not enabled by the "WebRTC-EncoderCpuBudget" field trial. The budget is
+  // the number of cores unless given by the "cores" parameter.
+  static EncoderCpuBudgetScheduler* GetProcessScheduler();
+
+  // |budget| is in cores.
+  explicit EncoderCpuBudgetScheduler(double budget);
+  ~EncoderCpuBudgetScheduler();
+
+  // Adds |client| with a positive |priority|, or updates its priority if
+  // already added, and rebalances the budget.
+  void AddClient(Client* client, double priority);
+  void RemoveClient(Client* client);
+
+  // Reports that |client| uses |load| cores for encoding.
+  void OnLoadMeasured(Client* client, double load);
+
+  Stats GetStats() const;
+
+ private:
+  struct ClientState {
+    Client* client;
+    double priority;
+    double load;
+    double budget;
+    Allocation allocation;
+  };
+
+  std::vector<ClientState>::iterator FindClient(Client* client)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+  void Rebalance() RTC_EXCLUSIVE_LOCKS_REQUIRED(crit_);
+
+  const double budget_;
+  rtc::CriticalSection crit_;
+  std::vector<ClientState> clients_ RTC_GUARDED_BY(crit_);
+  int64_t last_rebalance_time_ms_ RTC_GUARDED_BY(crit_) = 0;
+  int num_rebalances_ RTC_GUARDED_BY(crit_) = 0;
+};
+
+}  // namespace webrtc
+
+#endif  // VIDEO_ENCODER_CPU_BUDGET_SCHEDULER_H_
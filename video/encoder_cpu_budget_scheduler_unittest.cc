@@ -0,0 +1,172 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "video/encoder_cpu_budget_scheduler.h"
+
+#include "rtc_base/fake_clock.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+using Allocation = EncoderCpuBudgetScheduler::Allocation;
+
+class FakeClient : public EncoderCpuBudgetScheduler::Client {
+ public:
+  void OnCpuBudgetAllocationUpdated(const Allocation& allocation) override {
+    allocation_ = allocation;
+    ++num_updates_;
+  }
+
+  const Allocation& allocation() const { return allocation_; }
+  int num_updates() const { return num_updates_; }
+
+ private:
+  Allocation allocation_;
+  int num_updates_ = 0;
+};
+
+}  // namespace
+
+class EncoderCpuBudgetSchedulerTest : public ::testing::Test {
+ protected:
+  EncoderCpuBudgetSchedulerTest() { clock_.SetTime(Timestamp::ms(1000)); }
+
+  rtc::ScopedFakeClock clock_;
+  FakeClient client_a_;
+  FakeClient client_b_;
+};
+
+TEST_F(EncoderCpuBudgetSchedulerTest, SingleClientGetsWholeBudget) {
+  EncoderCpuBudgetScheduler scheduler(1.0);
+  scheduler.AddClient(&client_a_, 1.0);
+  EXPECT_EQ(1, client_a_.num_updates());
+  EXPECT_EQ(100, client_a_.allocation().max_encode_usage_percent);
+  // The budget left after the initial load is spent on complexity.
+  EXPECT_EQ(VideoCodecComplexity::kComplexityHigher,
+            client_a_.allocation().complexity);
+}
+
+TEST_F(EncoderCpuBudgetSchedulerTest, OversubscribedBudgetIsSharedByPriority) {
+  EncoderCpuBudgetScheduler scheduler(1.0);
+  scheduler.AddClient(&client_a_, 1.0);
+  scheduler.AddClient(&client_b_, 3.0);
+  scheduler.OnLoadMeasured(&client_a_, 1.0);
+  clock_.AdvanceTime(
+      TimeDelta::ms(EncoderCpuBudgetScheduler::kRebalanceIntervalMs));
+  scheduler.OnLoadMeasured(&client_b_, 1.0);
+
+  EXPECT_EQ(25, client_a_.allocation().max_encode_usage_percent);
+  EXPECT_EQ(75, client_b_.allocation().max_encode_usage_percent);
+  EXPECT_EQ(VideoCodecComplexity::kComplexityNormal,
+            client_a_.allocation().complexity);
+  EXPECT_EQ(VideoCodecComplexity::kComplexityNormal,
+            client_b_.allocation().complexity);
+
+  EncoderCpuBudgetScheduler::Stats stats = scheduler.GetStats();
+  EXPECT_DOUBLE_EQ(1.0, stats.budget);
+  EXPECT_DOUBLE_EQ(2.0, stats.total_load);
+  ASSERT_EQ(2u, stats.clients.size());
+  EXPECT_DOUBLE_EQ(0.25, stats.clients[0].budget);
+  EXPECT_DOUBLE_EQ(0.75, stats.clients[1].budget);
+}
+
+TEST_F(EncoderCpuBudgetSchedulerTest, ClientsBelowFairShareKeepTheirDemand) {
+  EncoderCpuBudgetScheduler scheduler(1.0);
+  scheduler.AddClient(&client_a_, 1.0);
+  scheduler.AddClient(&client_b_, 1.0);
+  scheduler.OnLoadMeasured(&client_a_, 0.2);
+  clock_.AdvanceTime(
+      TimeDelta::ms(EncoderCpuBudgetScheduler::kRebalanceIntervalMs));
+  scheduler.OnLoadMeasured(&client_b_, 2.0);
+
+  // |client_a_| gets its load plus headroom, the rest goes to |client_b_|.
+  EncoderCpuBudgetScheduler::Stats stats = scheduler.GetStats();
+  ASSERT_EQ(2u, stats.clients.size());
+  EXPECT_LT(stats.clients[0].budget, 0.5);
+  EXPECT_GT(stats.clients[0].budget, 0.2);
+  EXPECT_DOUBLE_EQ(1.0, stats.clients[0].budget + stats.clients[1].budget);
+  EXPECT_GT(client_b_.allocation().max_encode_usage_percent, 50);
+}
+
+TEST_F(EncoderCpuBudgetSchedulerTest, HigherPriorityGetsComplexityFirst) {
+  EncoderCpuBudgetScheduler scheduler(1.5);
+  scheduler.AddClient(&client_a_, 1.0);
+  scheduler.AddClient(&client_b_, 2.0);
+  EXPECT_EQ(VideoCodecComplexity::kComplexityHigher,
+            client_b_.allocation().complexity);
+  EXPECT_EQ(VideoCodecComplexity::kComplexityHigh,
+            client_a_.allocation().complexity);
+}
+
+TEST_F(EncoderCpuBudgetSchedulerTest, RemovingClientRebalances) {
+  EncoderCpuBudgetScheduler scheduler(1.0);
+  scheduler.AddClient(&client_a_, 1.0);
+  scheduler.AddClient(&client_b_, 1.0);
+  EXPECT_LT(client_a_.allocation().max_encode_usage_percent, 100);
+  scheduler.RemoveClient(&client_b_);
+  EXPECT_EQ(100, client_a_.allocation().max_encode_usage_percent);
+  EXPECT_EQ(1u, scheduler.GetStats().clients.size());
+}
+
+TEST_F(EncoderCpuBudgetSchedulerTest, UpdatingPriorityRebalances) {
+  EncoderCpuBudgetScheduler scheduler(1.0);
+  scheduler.AddClient(&client_a_, 1.0);
+  scheduler.AddClient(&client_b_, 1.0);
+  scheduler.OnLoadMeasured(&client_a_, 1.0);
+  clock_.AdvanceTime(
+      TimeDelta::ms(EncoderCpuBudgetScheduler::kRebalanceIntervalMs));
+  scheduler.OnLoadMeasured(&client_b_, 1.0);
+  EXPECT_EQ(50, client_a_.allocation().max_encode_usage_percent);
+
+  scheduler.AddClient(&client_a_, 3.0);
+  EXPECT_EQ(75, client_a_.allocation().max_encode_usage_percent);
+  EXPECT_EQ(25, client_b_.allocation().max_encode_usage_percent);
+}
+
+TEST_F(EncoderCpuBudgetSchedulerTest, RebalancesOnLoadAtMostOncePerInterval) {
+  EncoderCpuBudgetScheduler scheduler(1.0);
+  scheduler.AddClient(&client_a_, 1.0);
+  const int num_rebalances = scheduler.GetStats().num_rebalances;
+
+  clock_.AdvanceTime(
+      TimeDelta::ms(EncoderCpuBudgetScheduler::kRebalanceIntervalMs - 1));
+  scheduler.OnLoadMeasured(&client_a_, 0.1);
+  EXPECT_EQ(num_rebalances, scheduler.GetStats().num_rebalances);
+  // The load is still recorded.
+  EXPECT_DOUBLE_EQ(0.1, scheduler.GetStats().total_load);
+
+  clock_.AdvanceTime(TimeDelta::ms(1));
+  scheduler.OnLoadMeasured(&client_a_, 0.1);
+  EXPECT_EQ(num_rebalances + 1, scheduler.GetStats().num_rebalances);
+}
+
+TEST_F(EncoderCpuBudgetSchedulerTest, NotifiesOnlyWhenAllocationChanges) {
+  EncoderCpuBudgetScheduler scheduler(1.0);
+  scheduler.AddClient(&client_a_, 1.0);
+  EXPECT_EQ(1, client_a_.num_updates());
+  for (int i = 0; i < 3; ++i) {
+    clock_.AdvanceTime(
+        TimeDelta::ms(EncoderCpuBudgetScheduler::kRebalanceIntervalMs));
+    scheduler.OnLoadMeasured(&client_a_, 0.5);
+  }
+  EXPECT_EQ(1, client_a_.num_updates());
+}
+
+TEST_F(EncoderCpuBudgetSchedulerTest, IgnoresLoadOfUnknownClient) {
+  EncoderCpuBudgetScheduler scheduler(1.0);
+  clock_.AdvanceTime(
+      TimeDelta::ms(EncoderCpuBudgetScheduler::kRebalanceIntervalMs));
+  scheduler.OnLoadMeasured(&client_a_, 0.5);
+  EXPECT_EQ(0, client_a_.num_updates());
+  EXPECT_EQ(0, scheduler.GetStats().num_rebalances);
+}
+
+}  // namespace webrtc
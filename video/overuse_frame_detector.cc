@@ -64,8 +64,33 @@ const float kMaxSampleDiffMarginFactor = 1.35f;
 const int kMinFramerate = 7;
 const int kMaxFramerate = 30;
 
+// Time constant of the CPU time based estimator, unless set in the options.
+const int kDefaultCpuTimeFilterTimeMs = 5000;
+
 const auto kScaleReasonCpu = AdaptationObserverInterface::AdaptReason::kCpu;
 
+// Returns |load_estimate| updated with a sample of |encode_time| spent during
+// |diff_time|, both in seconds, using the filter update
+//
+// load <-- x/d (1-exp (-d/T)) + exp (-d/T) load
+//
+// where we must take care for small d, using the proper limit
+// (1 - exp(-d/tau)) / d = 1/tau - d/2tau^2 + O(d^2)
+double FilterLoadEstimate(double load_estimate,
+                          double encode_time,
+                          double diff_time,
+                          double tau) {
+  RTC_CHECK_GE(diff_time, 0.0);
+  double e = diff_time / tau;
+  double c;
+  if (e < 0.0001) {
+    c = (1 - e / 2) / tau;
+  } else {
+    c = -expm1(-e) / diff_time;
+  }
+  return c * encode_time + exp(-e) * load_estimate;
+}
+
 // Class for calculating the processing usage on the send-side (the average
 // processing time of a frame divided by the average time difference between
 // captured frames).
@@ -270,23 +295,8 @@ class SendProcessingUsage2 : public OveruseFrameDetector::ProcessingUsage {
 
  private:
   void AddSample(double encode_time, double diff_time) {
-    RTC_CHECK_GE(diff_time, 0.0);
-
-    // Use the filter update
-    //
-    // load <-- x/d (1-exp (-d/T)) + exp (-d/T) load
-    //
-    // where we must take care for small d, using the proper limit
-    // (1 - exp(-d/tau)) / d = 1/tau - d/2tau^2 + O(d^2)
-    double tau = (1e-3 * options_.filter_time_ms);
-    double e = diff_time / tau;
-    double c;
-    if (e < 0.0001) {
-      c = (1 - e / 2) / tau;
-    } else {
-      c = -expm1(-e) / diff_time;
-    }
-    load_estimate_ = c * encode_time + exp(-e) * load_estimate_;
+    load_estimate_ = FilterLoadEstimate(load_estimate_, encode_time, diff_time,
+                                        1e-3 * options_.filter_time_ms);
   }
 
   int64_t DurationPerInputFrame(int64_t capture_time_us,
@@ -330,6 +340,67 @@ class SendProcessingUsage2 : public OveruseFrameDetector::ProcessingUsage {
   double load_estimate_;
 };
 
+// Estimates the load as the CPU time spent by the encoder thread per frame,
+// divided by the time between frames. Unlike the wall clock encode time, the
+// CPU time doesn't grow when the encoder thread is preempted, e.g. by other
+// processes on a shared machine, which would otherwise be mistaken for overuse.
+class EncodeCpuTimeUsage : public OveruseFrameDetector::ProcessingUsage {
+ public:
+  explicit EncodeCpuTimeUsage(const CpuOveruseOptions& options)
+      : options_(options),
+        filter_time_ms_(options.filter_time_ms > 0
+                            ? options.filter_time_ms
+                            : kDefaultCpuTimeFilterTimeMs) {
+    Reset();
+  }
+  ~EncodeCpuTimeUsage() override = default;
+
+  void Reset() override {
+    prev_capture_time_us_ = -1;
+    // Start in between the underuse and overuse threshold.
+    load_estimate_ = (options_.low_encode_usage_threshold_percent +
+                      options_.high_encode_usage_threshold_percent) /
+                     200.0;
+  }
+
+  void SetMaxSampleDiffMs(float /* diff_ms */) override {}
+
+  void FrameCaptured(const VideoFrame& frame,
+                     int64_t time_when_first_seen_us,
+                     int64_t last_capture_time_us) override {}
+
+  absl::optional<int> FrameSent(
+      uint32_t /* timestamp */,
+      int64_t /* time_sent_in_us */,
+      int64_t /* capture_time_us */,
+      absl::optional<int> encode_duration_us) override {
+    return encode_duration_us;
+  }
+
+  void FrameEncodeCpuTimeMeasured(int64_t capture_time_us,
+                                  int64_t cpu_time_us) override {
+    if (prev_capture_time_us_ != -1) {
+      // Like in SendProcessingUsage2, frames out of order are treated as
+      // captured at the same time as the previous frame.
+      load_estimate_ = FilterLoadEstimate(
+          load_estimate_, 1e-6 * cpu_time_us,
+          1e-6 * std::max<int64_t>(capture_time_us - prev_capture_time_us_, 0),
+          1e-3 * filter_time_ms_);
+    }
+    prev_capture_time_us_ = std::max(capture_time_us, prev_capture_time_us_);
+  }
+
+  int Value() override {
+    return static_cast<int>(100.0 * load_estimate_ + 0.5);
+  }
+
+ private:
+  const CpuOveruseOptions options_;
+  const int filter_time_ms_;
+  int64_t prev_capture_time_us_ = -1;
+  double load_estimate_;
+};
+
 // Class used for manual testing of overuse, enabled via field trial flag.
 class OverdoseInjector : public OveruseFrameDetector::ProcessingUsage {
  public:
@@ -375,6 +446,11 @@ class OverdoseInjector : public OveruseFrameDetector::ProcessingUsage {
                              encode_duration_us);
   }
 
+  void FrameEncodeCpuTimeMeasured(int64_t capture_time_us,
+                                  int64_t cpu_time_us) override {
+    usage_->FrameEncodeCpuTimeMeasured(capture_time_us, cpu_time_us);
+  }
+
   int Value() override {
     int64_t now_ms = rtc::TimeMillis();
     if (last_toggling_ms_ == -1) {
@@ -438,7 +514,8 @@ CpuOveruseOptions::CpuOveruseOptions()
       min_process_count(3),
       high_threshold_consecutive_count(2),
       // Disabled by default.
-      filter_time_ms(0) {
+      filter_time_ms(0),
+      use_encode_cpu_time(false) {
 #if defined(WEBRTC_MAC) && !defined(WEBRTC_IOS)
   // This is proof-of-concept code for letting the physical core count affect
   // the interval into which we attempt to scale. For now, the code is Mac OS
@@ -486,7 +563,9 @@ CpuOveruseOptions::CpuOveruseOptions()
 std::unique_ptr<OveruseFrameDetector::ProcessingUsage>
 OveruseFrameDetector::CreateProcessingUsage(const CpuOveruseOptions& options) {
   std::unique_ptr<ProcessingUsage> instance;
-  if (options.filter_time_ms > 0) {
+  if (options.use_encode_cpu_time) {
+    instance = absl::make_unique<EncodeCpuTimeUsage>(options);
+  } else if (options.filter_time_ms > 0) {
     instance = absl::make_unique<SendProcessingUsage2>(options);
   } else {
     instance = absl::make_unique<SendProcessingUsage1>(options);
@@ -631,6 +710,33 @@ void OveruseFrameDetector::FrameSent(uint32_t timestamp,
   }
 }
 
+void OveruseFrameDetector::SetUsageThresholds(
+    int low_encode_usage_threshold_percent,
+    int high_encode_usage_threshold_percent) {
+  RTC_DCHECK_RUN_ON(&task_checker_);
+  RTC_DCHECK_LT(low_encode_usage_threshold_percent,
+                high_encode_usage_threshold_percent);
+  options_.low_encode_usage_threshold_percent =
+      low_encode_usage_threshold_percent;
+  options_.high_encode_usage_threshold_percent =
+      high_encode_usage_threshold_percent;
+}
+
+absl::optional<int> OveruseFrameDetector::GetEncodeUsagePercent() const {
+  RTC_DCHECK_RUN_ON(&task_checker_);
+  return encode_usage_percent_;
+}
+
+void OveruseFrameDetector::FrameEncodeCpuTimeMeasured(int64_t capture_time_us,
+                                                      int64_t cpu_time_us) {
+  RTC_DCHECK_RUN_ON(&task_checker_);
+  usage_->FrameEncodeCpuTimeMeasured(capture_time_us, cpu_time_us);
+  if (options_.use_encode_cpu_time) {
+    // Don't depend on the encoder reporting encode timing in FrameSent().
+    encode_usage_percent_ = usage_->Value();
+  }
+}
+
 void OveruseFrameDetector::CheckForOveruse(
     AdaptationObserverInterface* observer) {
   RTC_DCHECK_RUN_ON(&task_checker_);
@@ -45,6 +45,13 @@ struct CpuOveruseOptions {
                                          // triggering an overuse.
   // New estimator enabled if this is set non-zero.
   int filter_time_ms;  // Time constant for averaging
+  // If true, the load is estimated from the CPU time the encoder thread spends
+  // on each frame, reported with FrameEncodeCpuTimeMeasured(), rather than
+  // from wall clock encode times. This is not affected by the encoder thread
+  // being preempted by other processes, but CPU time spent on other threads,
+  // e.g. by encoders with internal threads, is not included. Uses
+  // |filter_time_ms| as time constant if set.
+  bool use_encode_cpu_time;
 };
 
 // Use to detect system overuse based on the send-side processing time of
@@ -82,6 +89,19 @@ class OveruseFrameDetector {
                  int64_t capture_time_us,
                  absl::optional<int> encode_duration_us);
 
+  // Replaces the usage thresholds of the options given to
+  // StartCheckForOveruse(), without resetting the load estimate.
+  void SetUsageThresholds(int low_encode_usage_threshold_percent,
+                          int high_encode_usage_threshold_percent);
+
+  // Returns the current load estimate, if there is one.
+  absl::optional<int> GetEncodeUsagePercent() const;
+
+  // Called for each frame given to the encoder, with the CPU time the
+  // encoding thread spent in the encoder for it.
+  virtual void FrameEncodeCpuTimeMeasured(int64_t capture_time_us,
+                                          int64_t cpu_time_us);
+
   // Interface for cpu load estimation. Intended for internal use only.
   class ProcessingUsage {
    public:
@@ -98,6 +118,9 @@ class OveruseFrameDetector {
         // And these two by the new estimator.
         int64_t capture_time_us,
         absl::optional<int> encode_duration_us) = 0;
+    // Only used by estimators based on CPU time.
+    virtual void FrameEncodeCpuTimeMeasured(int64_t capture_time_us,
+                                            int64_t cpu_time_us) {}
 
     virtual int Value() = 0;
     virtual ~ProcessingUsage() = default;
@@ -791,6 +791,20 @@ TEST_F(OveruseFrameDetectorTest2, ProcessingUsage) {
   EXPECT_EQ(kProcessTimeUs * 100 / kFrameIntervalUs, UsagePercent());
 }
 
+TEST_F(OveruseFrameDetectorTest2, SetUsageThresholdsKeepsLoadEstimate) {
+  overuse_detector_->SetOptions(options_);
+  InsertAndSendFramesWithInterval(1000, kFrameIntervalUs, kWidth, kHeight,
+                                  kProcessTimeUs);
+  ASSERT_TRUE(overuse_detector_->GetEncodeUsagePercent());
+  EXPECT_EQ(kProcessTimeUs * 100 / kFrameIntervalUs,
+            *overuse_detector_->GetEncodeUsagePercent());
+  // The same usage is overuse with lower thresholds.
+  overuse_detector_->SetUsageThresholds(4, 10);
+  EXPECT_CALL(mock_observer_, AdaptDown(reason_)).Times(1);
+  for (int i = 0; i < options_.high_threshold_consecutive_count; ++i)
+    overuse_detector_->CheckForOveruse(observer_);
+}
+
 TEST_F(OveruseFrameDetectorTest2, ResetAfterResolutionChange) {
   overuse_detector_->SetOptions(options_);
   ForceUpdate(kWidth, kHeight);
@@ -1017,4 +1031,118 @@ TEST_F(OveruseFrameDetectorTest2, NoOveruseForSimulcast) {
   EXPECT_LE(UsagePercent(), 45);
 }
 
+// Tests using the cpu time based load estimator.
+class OveruseFrameDetectorCpuTimeTest : public OveruseFrameDetectorTest {
+ protected:
+  void SetUp() override {
+    options_.use_encode_cpu_time = true;
+    OveruseFrameDetectorTest::SetUp();
+  }
+
+  // Reports |delay_us| as both the cpu time and the wall clock encode time.
+  void InsertAndSendFramesWithInterval(int num_frames,
+                                       int interval_us,
+                                       int width,
+                                       int height,
+                                       int delay_us) override {
+    InsertAndSendFramesWithCpuTime(num_frames, interval_us, width, height,
+                                   delay_us, delay_us);
+  }
+
+  void InsertAndSendFramesWithCpuTime(int num_frames,
+                                      int interval_us,
+                                      int width,
+                                      int height,
+                                      int cpu_time_us,
+                                      int delay_us) {
+    VideoFrame frame =
+        VideoFrame::Builder()
+            .set_video_frame_buffer(I420Buffer::Create(width, height))
+            .set_rotation(webrtc::kVideoRotation_0)
+            .set_timestamp_us(0)
+            .build();
+    while (num_frames-- > 0) {
+      int64_t capture_time_us = rtc::TimeMicros();
+      overuse_detector_->FrameCaptured(frame, capture_time_us);
+      overuse_detector_->FrameEncodeCpuTimeMeasured(capture_time_us,
+                                                    cpu_time_us);
+      overuse_detector_->FrameSent(0 /* ignored timestamp */,
+                                   0 /* ignored send_time_us */,
+                                   capture_time_us, delay_us);
+      clock_.AdvanceTime(TimeDelta::us(interval_us));
+    }
+  }
+};
+
+TEST_F(OveruseFrameDetectorCpuTimeTest, TriggerOveruse) {
+  overuse_detector_->SetOptions(options_);
+  EXPECT_CALL(mock_observer_, AdaptDown(reason_)).Times(1);
+  TriggerOveruse(options_.high_threshold_consecutive_count);
+}
+
+TEST_F(OveruseFrameDetectorCpuTimeTest, OveruseAndRecover) {
+  overuse_detector_->SetOptions(options_);
+  EXPECT_CALL(mock_observer_, AdaptDown(reason_)).Times(1);
+  TriggerOveruse(options_.high_threshold_consecutive_count);
+  EXPECT_CALL(mock_observer_, AdaptUp(reason_)).Times(::testing::AtLeast(1));
+  TriggerUnderuse();
+}
+
+TEST_F(OveruseFrameDetectorCpuTimeTest, ProcessingUsage) {
+  overuse_detector_->SetOptions(options_);
+  InsertAndSendFramesWithInterval(1000, kFrameIntervalUs, kWidth, kHeight,
+                                  kProcessTimeUs);
+  EXPECT_EQ(kProcessTimeUs * 100 / kFrameIntervalUs, UsagePercent());
+}
+
+TEST_F(OveruseFrameDetectorCpuTimeTest, ResetAfterResolutionChange) {
+  overuse_detector_->SetOptions(options_);
+  InsertAndSendFramesWithInterval(1000, kFrameIntervalUs, kWidth, kHeight,
+                                  kProcessTimeUs);
+  EXPECT_NE(InitialUsage(), UsagePercent());
+  // Verify reset (with new width/height).
+  InsertAndSendFramesWithInterval(1, kFrameIntervalUs, kWidth, kHeight + 1,
+                                  kProcessTimeUs);
+  EXPECT_EQ(InitialUsage(), UsagePercent());
+}
+
+// The encoder thread being preempted makes the wall clock encode time long,
+// but doesn't increase the cpu time.
+TEST_F(OveruseFrameDetectorCpuTimeTest, NoOveruseForPreemptedEncoderThread) {
+  overuse_detector_->SetOptions(options_);
+  EXPECT_CALL(mock_observer_, AdaptDown(_)).Times(0);
+  const int kPreemptedDelayUs = 32 * rtc::kNumMicrosecsPerMillisec;
+  for (int i = 0; i < options_.high_threshold_consecutive_count; ++i) {
+    InsertAndSendFramesWithCpuTime(1000, kFrameIntervalUs, kWidth, kHeight,
+                                   kProcessTimeUs, kPreemptedDelayUs);
+    overuse_detector_->CheckForOveruse(observer_);
+  }
+  EXPECT_EQ(kProcessTimeUs * 100 / kFrameIntervalUs, UsagePercent());
+}
+
+// The usage is updated from the cpu time alone, for encoders not reporting
+// encode timing.
+TEST_F(OveruseFrameDetectorCpuTimeTest, TriggerOveruseWithoutEncodeTiming) {
+  overuse_detector_->SetOptions(options_);
+  EXPECT_CALL(mock_observer_, AdaptDown(reason_)).Times(1);
+  const int kCpuTimeUs = 32 * rtc::kNumMicrosecsPerMillisec;
+  VideoFrame frame =
+      VideoFrame::Builder()
+          .set_video_frame_buffer(I420Buffer::Create(kWidth, kHeight))
+          .set_rotation(webrtc::kVideoRotation_0)
+          .set_timestamp_us(0)
+          .build();
+  for (int i = 0; i < options_.high_threshold_consecutive_count; ++i) {
+    for (int j = 0; j < 1000; ++j) {
+      int64_t capture_time_us = rtc::TimeMicros();
+      overuse_detector_->FrameCaptured(frame, capture_time_us);
+      overuse_detector_->FrameEncodeCpuTimeMeasured(capture_time_us,
+                                                    kCpuTimeUs);
+      overuse_detector_->FrameSent(0, 0, capture_time_us, absl::nullopt);
+      clock_.AdvanceTime(TimeDelta::us(kFrameIntervalUs));
+    }
+    overuse_detector_->CheckForOveruse(observer_);
+  }
+}
+
 }  // namespace webrtc
@@ -593,6 +593,11 @@ void ReceiveStatisticsProxy::OnDecoderImplementationName(
   stats_.decoder_implementation_name = implementation_name;
 }
 
+void ReceiveStatisticsProxy::OnDecoderFrameBufferBytes(size_t bytes) {
+  rtc::CritScope lock(&crit_);
+  stats_.decoder_frame_buffer_bytes = bytes;
+}
+
 void ReceiveStatisticsProxy::OnFrameBufferTimingsUpdated(
     int max_decode_ms,
     int current_delay_ms,
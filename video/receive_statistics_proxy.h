@@ -55,6 +55,7 @@ class ReceiveStatisticsProxy : public VCMReceiveStatisticsCallback,
   void OnRenderedFrame(const VideoFrame& frame);
   void OnIncomingPayloadType(int payload_type);
   void OnDecoderImplementationName(const char* implementation_name);
+  void OnDecoderFrameBufferBytes(size_t bytes);
 
   void OnPreDecode(VideoCodecType codec_type, int qp);
 
@@ -389,6 +389,13 @@ TEST_F(ReceiveStatisticsProxyTest, GetStatsReportsDecoderImplementationName) {
       kName, statistics_proxy_->GetStats().decoder_implementation_name.c_str());
 }
 
+TEST_F(ReceiveStatisticsProxyTest, GetStatsReportsDecoderFrameBufferBytes) {
+  EXPECT_EQ(0u, statistics_proxy_->GetStats().decoder_frame_buffer_bytes);
+  const size_t kBytes = 1382400;
+  statistics_proxy_->OnDecoderFrameBufferBytes(kBytes);
+  EXPECT_EQ(kBytes, statistics_proxy_->GetStats().decoder_frame_buffer_bytes);
+}
+
 TEST_F(ReceiveStatisticsProxyTest, GetStatsReportsOnCompleteFrame) {
   const int kFrameSizeBytes = 1000;
   statistics_proxy_->OnCompleteFrame(true, kFrameSizeBytes,
@@ -691,6 +691,14 @@ void SendStatisticsProxy::OnEncodedFrameTimeMeasured(int encode_time_ms,
   stats_.encode_usage_percent = encode_usage_percent;
 }
 
+void SendStatisticsProxy::OnCpuBudgetAllocationUpdated(
+    int max_encode_usage_percent,
+    VideoCodecComplexity complexity) {
+  rtc::CritScope lock(&crit_);
+  stats_.cpu_budget_max_encode_usage_percent = max_encode_usage_percent;
+  stats_.cpu_budget_complexity = complexity;
+}
+
 void SendStatisticsProxy::OnSuspendChange(bool is_suspended) {
   int64_t now_ms = clock_->TimeInMilliseconds();
   rtc::CritScope lock(&crit_);
@@ -81,6 +81,8 @@ class SendStatisticsProxy : public VideoStreamEncoderObserver,
   void OnInitialQualityResolutionAdaptDown() override;
 
   void OnSuspendChange(bool is_suspended) override;
+  void OnCpuBudgetAllocationUpdated(int max_encode_usage_percent,
+                                    VideoCodecComplexity complexity) override;
   void OnInactiveSsrc(uint32_t ssrc);
 
   // Used to indicate change in content type, which may require a change in
@@ -202,6 +202,27 @@ TEST_F(SendStatisticsProxyTest, Suspended) {
   EXPECT_FALSE(statistics_proxy_->GetStats().suspended);
 }
 
+TEST_F(SendStatisticsProxyTest, CpuBudgetAllocation) {
+  // Verify that the allocation is unset by default.
+  VideoSendStream::Stats stats = statistics_proxy_->GetStats();
+  EXPECT_FALSE(stats.cpu_budget_max_encode_usage_percent);
+  EXPECT_FALSE(stats.cpu_budget_complexity);
+
+  statistics_proxy_->OnCpuBudgetAllocationUpdated(
+      42, VideoCodecComplexity::kComplexityHigh);
+  stats = statistics_proxy_->GetStats();
+  EXPECT_EQ(42, stats.cpu_budget_max_encode_usage_percent);
+  EXPECT_EQ(VideoCodecComplexity::kComplexityHigh, stats.cpu_budget_complexity);
+
+  // Verify that a later allocation replaces the previous one.
+  statistics_proxy_->OnCpuBudgetAllocationUpdated(
+      25, VideoCodecComplexity::kComplexityNormal);
+  stats = statistics_proxy_->GetStats();
+  EXPECT_EQ(25, stats.cpu_budget_max_encode_usage_percent);
+  EXPECT_EQ(VideoCodecComplexity::kComplexityNormal,
+            stats.cpu_budget_complexity);
+}
+
 TEST_F(SendStatisticsProxyTest, FrameCounts) {
   FrameCountObserver* observer = statistics_proxy_.get();
   for (const auto& ssrc : config_.rtp.ssrcs) {
@@ -0,0 +1,315 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "video/video_decode_thread_pool.h"
+
+#include <algorithm>
+#include <deque>
+#include <string>
+
+#include "absl/memory/memory.h"
+#include "rtc_base/checks.h"
+#include "rtc_base/experiments/field_trial_parser.h"
+#include "rtc_base/logging.h"
+#include "rtc_base/time_utils.h"
+#include "system_wrappers/include/cpu_info.h"
+#include "system_wrappers/include/field_trial.h"
+
+namespace webrtc {
+namespace {
+
+constexpr char kFieldTrialName[] = "WebRTC-VideoDecodeThreadPool";
+
+VideoDecodeThreadPool* CreateSharedInstance() {
+  FieldTrialFlag enabled("Enabled");
+  FieldTrialParameter<int> max_threads("max_threads", 0);
+  ParseFieldTrial({&enabled, &max_threads},
+                  field_trial::FindFullName(kFieldTrialName));
+  if (!enabled)
+    return nullptr;
+
+  int num_threads = static_cast<int>(CpuInfo::DetectNumberOfCores());
+  if (max_threads.Get() > 0)
+    num_threads = std::min(num_threads, max_threads.Get());
+  RTC_LOG(LS_INFO) << "Decoding video on a shared pool of " << num_threads
+                   << " threads.";
+  return new VideoDecodeThreadPool(num_threads);
+}
+
+}  // namespace
+
+class VideoDecodeThreadPool::PoolTaskQueue final : public TaskQueueBase {
+ public:
+  struct PendingTask {
+    std::unique_ptr<QueuedTask> task;
+    int64_t deadline_ms;
+    uint64_t order;
+    bool has_deadline;
+  };
+
+  explicit PoolTaskQueue(VideoDecodeThreadPool* pool) : pool_(pool) {}
+  ~PoolTaskQueue() override = default;
+
+  void Delete() override { pool_->DeleteTaskQueue(this); }
+  void PostTask(std::unique_ptr<QueuedTask> task) override {
+    pool_->PostTaskInternal(this, std::move(task), rtc::TimeMillis(),
+                            /*has_deadline=*/false);
+  }
+  void PostDelayedTask(std::unique_ptr<QueuedTask> task,
+                       uint32_t milliseconds) override {
+    pool_->PostDelayedTaskInternal(this, std::move(task), milliseconds);
+  }
+
+  // Runs |task| with this task queue set as the current one.
+  void RunTask(std::unique_ptr<QueuedTask> task) {
+    CurrentTaskQueueSetter set_current(this);
+    QueuedTask* task_ptr = task.release();
+    if (task_ptr->Run())
+      delete task_ptr;
+  }
+
+  // The members below are guarded by the |lock_| of |pool_|.
+  std::deque<PendingTask> pending;
+  // Key in |ready_queues_| of the pool, if |scheduled|.
+  ReadyKey ready_key;
+  bool scheduled = false;
+  bool running = false;
+  bool deleted = false;
+  uint64_t deadline_misses = 0;
+
+  // Signaled when the task that was running at the time of deletion is done.
+  rtc::Event idle;
+
+ private:
+  VideoDecodeThreadPool* const pool_;
+};
+
+std::unique_ptr<TaskQueueBase, TaskQueueDeleter>
+VideoDecodeThreadPool::Factory::CreateTaskQueue(absl::string_view name,
+                                                Priority priority) const {
+  return std::unique_ptr<TaskQueueBase, TaskQueueDeleter>(
+      pool_->CreatePoolTaskQueue());
+}
+
+VideoDecodeThreadPool* VideoDecodeThreadPool::GetSharedInstanceIfEnabled() {
+  // The field trial is only read once, the pool is shared by all streams for
+  // the lifetime of the process.
+  static VideoDecodeThreadPool* const instance = CreateSharedInstance();
+  return instance;
+}
+
+VideoDecodeThreadPool::VideoDecodeThreadPool(int num_threads)
+    : task_queue_factory_(this) {
+  RTC_DCHECK_GT(num_threads, 0);
+  for (int i = 0; i < num_threads; ++i) {
+    threads_.push_back(absl::make_unique<rtc::PlatformThread>(
+        &VideoDecodeThreadPool::ThreadMain, this,
+        "DecodeThreadPool" + std::to_string(i), rtc::kHighPriority));
+    threads_.back()->Start();
+  }
+}
+
+VideoDecodeThreadPool::~VideoDecodeThreadPool() {
+  {
+    rtc::CritScope lock(&lock_);
+    RTC_DCHECK(task_queues_.empty());
+    quit_ = true;
+  }
+  wake_up_.Set();
+  for (auto& thread : threads_)
+    thread->Stop();
+}
+
+void VideoDecodeThreadPool::PostTaskWithDeadline(
+    TaskQueueBase* task_queue,
+    std::unique_ptr<QueuedTask> task,
+    int64_t deadline_ms) {
+  PostTaskInternal(static_cast<PoolTaskQueue*>(task_queue), std::move(task),
+                   deadline_ms, /*has_deadline=*/true);
+}
+
+VideoDecodeThreadPool::Stats VideoDecodeThreadPool::GetStats() const {
+  rtc::CritScope lock(&lock_);
+  Stats stats;
+  stats.num_task_queues = static_cast<int>(task_queues_.size());
+  stats.queue_depth = queue_depth_;
+  stats.deadline_misses = deadline_misses_;
+  return stats;
+}
+
+VideoDecodeThreadPool::TaskQueueStats VideoDecodeThreadPool::GetTaskQueueStats(
+    TaskQueueBase* task_queue) const {
+  PoolTaskQueue* pool_task_queue = static_cast<PoolTaskQueue*>(task_queue);
+  rtc::CritScope lock(&lock_);
+  RTC_DCHECK(task_queues_.count(pool_task_queue));
+  TaskQueueStats stats;
+  stats.queue_depth = static_cast<int>(pool_task_queue->pending.size());
+  stats.deadline_misses = pool_task_queue->deadline_misses;
+  return stats;
+}
+
+void VideoDecodeThreadPool::ThreadMain(void* context) {
+  static_cast<VideoDecodeThreadPool*>(context)->ProcessTasks();
+}
+
+void VideoDecodeThreadPool::ProcessTasks() {
+  while (true) {
+    PoolTaskQueue* task_queue = nullptr;
+    PoolTaskQueue::PendingTask pending_task;
+    int wait_ms = rtc::Event::kForever;
+    {
+      rtc::CritScope lock(&lock_);
+      if (quit_) {
+        // Pass the wake up on to the next thread.
+        wake_up_.Set();
+        return;
+      }
+      int64_t now_ms = rtc::TimeMillis();
+      ReleaseDelayedTasks(now_ms);
+      if (!ready_queues_.empty()) {
+        auto it = ready_queues_.begin();
+        task_queue = it->second;
+        ready_queues_.erase(it);
+        task_queue->scheduled = false;
+        task_queue->running = true;
+        pending_task = std::move(task_queue->pending.front());
+        task_queue->pending.pop_front();
+        --queue_depth_;
+        // Let another thread pick up the remaining work.
+        if (!ready_queues_.empty())
+          wake_up_.Set();
+      } else if (!delayed_tasks_.empty()) {
+        wait_ms =
+            static_cast<int>(delayed_tasks_.begin()->first.first - now_ms);
+      }
+    }
+
+    if (!task_queue) {
+      wake_up_.Wait(wait_ms);
+      continue;
+    }
+
+    task_queue->RunTask(std::move(pending_task.task));
+
+    rtc::CritScope lock(&lock_);
+    if (pending_task.has_deadline &&
+        rtc::TimeMillis() > pending_task.deadline_ms) {
+      ++task_queue->deadline_misses;
+      ++deadline_misses_;
+    }
+    task_queue->running = false;
+    if (task_queue->deleted) {
+      task_queue->idle.Set();
+    } else {
+      MaybeScheduleTaskQueue(task_queue);
+    }
+  }
+}
+
+VideoDecodeThreadPool::PoolTaskQueue*
+VideoDecodeThreadPool::CreatePoolTaskQueue() {
+  PoolTaskQueue* task_queue = new PoolTaskQueue(this);
+  rtc::CritScope lock(&lock_);
+  task_queues_.insert(task_queue);
+  return task_queue;
+}
+
+void VideoDecodeThreadPool::DeleteTaskQueue(PoolTaskQueue* task_queue) {
+  RTC_DCHECK(!task_queue->IsCurrent());
+  // Tasks are destroyed without holding |lock_| since their destructors may
+  // post to other task queues of the pool.
+  std::vector<std::unique_ptr<QueuedTask>> dropped_tasks;
+  bool wait_for_running_task;
+  {
+    rtc::CritScope lock(&lock_);
+    RTC_DCHECK(task_queues_.count(task_queue));
+    task_queue->deleted = true;
+    if (task_queue->scheduled)
+      ready_queues_.erase(task_queue->ready_key);
+    queue_depth_ -= static_cast<int>(task_queue->pending.size());
+    for (auto& pending_task : task_queue->pending)
+      dropped_tasks.push_back(std::move(pending_task.task));
+    task_queue->pending.clear();
+    for (auto it = delayed_tasks_.begin(); it != delayed_tasks_.end();) {
+      if (it->second.first == task_queue) {
+        dropped_tasks.push_back(std::move(it->second.second));
+        it = delayed_tasks_.erase(it);
+      } else {
+        ++it;
+      }
+    }
+    task_queues_.erase(task_queue);
+    wait_for_running_task = task_queue->running;
+  }
+  dropped_tasks.clear();
+  if (wait_for_running_task)
+    task_queue->idle.Wait(rtc::Event::kForever);
+  delete task_queue;
+}
+
+void VideoDecodeThreadPool::PostTaskInternal(PoolTaskQueue* task_queue,
+                                             std::unique_ptr<QueuedTask> task,
+                                             int64_t deadline_ms,
+                                             bool has_deadline) {
+  rtc::CritScope lock(&lock_);
+  RTC_DCHECK(task_queues_.count(task_queue) || task_queue->deleted);
+  if (task_queue->deleted) {
+    // Posted by the task still running on a deleted task queue.
+    return;
+  }
+  task_queue->pending.push_back(
+      {std::move(task), deadline_ms, next_order_++, has_deadline});
+  ++queue_depth_;
+  MaybeScheduleTaskQueue(task_queue);
+}
+
+void VideoDecodeThreadPool::PostDelayedTaskInternal(
+    PoolTaskQueue* task_queue,
+    std::unique_ptr<QueuedTask> task,
+    uint32_t milliseconds) {
+  rtc::CritScope lock(&lock_);
+  if (task_queue->deleted)
+    return;
+  ReadyKey key(rtc::TimeMillis() + milliseconds, next_order_++);
+  bool new_first =
+      delayed_tasks_.empty() || key < delayed_tasks_.begin()->first;
+  delayed_tasks_.emplace(key, std::make_pair(task_queue, std::move(task)));
+  // Threads waiting for a later delayed task need to recompute their timeout.
+  if (new_first)
+    wake_up_.Set();
+}
+
+void VideoDecodeThreadPool::ReleaseDelayedTasks(int64_t now_ms) {
+  while (!delayed_tasks_.empty() &&
+         delayed_tasks_.begin()->first.first <= now_ms) {
+    auto it = delayed_tasks_.begin();
+    PoolTaskQueue* task_queue = it->second.first;
+    task_queue->pending.push_back({std::move(it->second.second),
+                                   it->first.first, it->first.second,
+                                   /*has_deadline=*/false});
+    ++queue_depth_;
+    delayed_tasks_.erase(it);
+    MaybeScheduleTaskQueue(task_queue);
+  }
+}
+
+void VideoDecodeThreadPool::MaybeScheduleTaskQueue(PoolTaskQueue* task_queue) {
+  if (task_queue->running || task_queue->scheduled ||
+      task_queue->pending.empty()) {
+    return;
+  }
+  const PoolTaskQueue::PendingTask& next_task = task_queue->pending.front();
+  task_queue->ready_key = ReadyKey(next_task.deadline_ms, next_task.order);
+  task_queue->scheduled = true;
+  ready_queues_.emplace(task_queue->ready_key, task_queue);
+  wake_up_.Set();
+}
+
+}  // namespace webrtc
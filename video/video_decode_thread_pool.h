@@ -0,0 +1,143 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#ifndef VIDEO_VIDEO_DECODE_THREAD_POOL_H_
+#define VIDEO_VIDEO_DECODE_THREAD_POOL_H_
+
+#include <stdint.h>
+
+#include <map>
+#include <memory>
+#include <set>
+#include <utility>
+#include <vector>
+
+#include "absl/strings/string_view.h"
+#include "api/task_queue/queued_task.h"
+#include "api/task_queue/task_queue_base.h"
+#include "api/task_queue/task_queue_factory.h"
+#include "rtc_base/constructor_magic.h"
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
+#include "rtc_base/platform_thread.h"
+#include "rtc_base/thread_annotations.h"
+
+namespace webrtc {
+
+// Runs the tasks of many task queues on a fixed number of threads. Every task
+// queue created by the pool keeps the FIFO ordering of its own tasks, but at
+// most one of its tasks runs at a time. Among the task queues that have tasks
+// ready to run, the one whose first task has the earliest deadline is served
+// first. This lets many video receive streams share a few decode threads
+// instead of each owning a mostly idle thread.
+class VideoDecodeThreadPool {
+ public:
+  struct Stats {
+    // Number of task queues currently created by the pool.
+    int num_task_queues = 0;
+    // Tasks that are ready to run but have not started yet.
+    int queue_depth = 0;
+    // Tasks posted with a deadline that finished running after it.
+    uint64_t deadline_misses = 0;
+  };
+
+  struct TaskQueueStats {
+    int queue_depth = 0;
+    uint64_t deadline_misses = 0;
+  };
+
+  // Returns the process-wide pool if enabled by the
+  // "WebRTC-VideoDecodeThreadPool" field trial, nullptr otherwise. The pool is
+  // created on first use and lives until the process exits.
+  static VideoDecodeThreadPool* GetSharedInstanceIfEnabled();
+
+  explicit VideoDecodeThreadPool(int num_threads);
+  ~VideoDecodeThreadPool();
+
+  // Factory for task queues running on this pool. Task queue priorities are
+  // ignored, all threads of the pool run at high priority.
+  TaskQueueFactory* task_queue_factory() { return &task_queue_factory_; }
+
+  // Posts |task| to |task_queue|, which must have been created by this pool.
+  // |deadline_ms|, in rtc::TimeMillis() time, is used to order the task
+  // against tasks of other task queues. Tasks posted through
+  // TaskQueueBase::PostTask get the current time as deadline, and delayed
+  // tasks the time they become ready to run.
+  void PostTaskWithDeadline(TaskQueueBase* task_queue,
+                            std::unique_ptr<QueuedTask> task,
+                            int64_t deadline_ms);
+
+  Stats GetStats() const;
+  TaskQueueStats GetTaskQueueStats(TaskQueueBase* task_queue) const;
+
+  int num_threads() const { return static_cast<int>(threads_.size()); }
+
+ private:
+  class PoolTaskQueue;
+
+  class Factory : public TaskQueueFactory {
+   public:
+    explicit Factory(VideoDecodeThreadPool* pool) : pool_(pool) {}
+    std::unique_ptr<TaskQueueBase, TaskQueueDeleter> CreateTaskQueue(
+        absl::string_view name,
+        Priority priority) const override;
+
+   private:
+    VideoDecodeThreadPool* const pool_;
+  };
+
+  // Ordering key of a task queue in |ready_queues_|.
+  using ReadyKey = std::pair<int64_t, uint64_t>;
+
+  static void ThreadMain(void* context);
+  void ProcessTasks();
+
+  PoolTaskQueue* CreatePoolTaskQueue();
+  void DeleteTaskQueue(PoolTaskQueue* task_queue);
+  void PostTaskInternal(PoolTaskQueue* task_queue,
+                        std::unique_ptr<QueuedTask> task,
+                        int64_t deadline_ms,
+                        bool has_deadline);
+  void PostDelayedTaskInternal(PoolTaskQueue* task_queue,
+                               std::unique_ptr<QueuedTask> task,
+                               uint32_t milliseconds);
+
+  // Moves delayed tasks whose time has come to their task queues.
+  void ReleaseDelayedTasks(int64_t now_ms) RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+  // Adds |task_queue| to |ready_queues_| if it has a task ready to run and is
+  // not already running or scheduled.
+  void MaybeScheduleTaskQueue(PoolTaskQueue* task_queue)
+      RTC_EXCLUSIVE_LOCKS_REQUIRED(lock_);
+
+  Factory task_queue_factory_;
+
+  rtc::CriticalSection lock_;
+  // Signaled whenever a task becomes ready to run, a delayed task is posted
+  // or the pool shuts down.
+  rtc::Event wake_up_;
+  bool quit_ RTC_GUARDED_BY(lock_) = false;
+  uint64_t next_order_ RTC_GUARDED_BY(lock_) = 0;
+  std::set<PoolTaskQueue*> task_queues_ RTC_GUARDED_BY(lock_);
+  std::map<ReadyKey, PoolTaskQueue*> ready_queues_ RTC_GUARDED_BY(lock_);
+  // Delayed tasks keyed by the time they become ready to run, and posting
+  // order.
+  std::map<ReadyKey, std::pair<PoolTaskQueue*, std::unique_ptr<QueuedTask>>>
+      delayed_tasks_ RTC_GUARDED_BY(lock_);
+  int queue_depth_ RTC_GUARDED_BY(lock_) = 0;
+  uint64_t deadline_misses_ RTC_GUARDED_BY(lock_) = 0;
+
+  std::vector<std::unique_ptr<rtc::PlatformThread>> threads_;
+
+  RTC_DISALLOW_COPY_AND_ASSIGN(VideoDecodeThreadPool);
+};
+
+}  // namespace webrtc
+
+#endif  // VIDEO_VIDEO_DECODE_THREAD_POOL_H_
@@ -0,0 +1,177 @@
+/*
+ *  Copyright (c) 2019 The WebRTC project authors. All Rights Reserved.
+ *
+ *  Use of this source code is governed by a BSD-style license
+ *  that can be found in the LICENSE file in the root of the source
+ *  tree. An additional intellectual property rights grant can be found
+ *  in the file PATENTS.  All contributing project authors may
+ *  be found in the AUTHORS file in the root of the source tree.
+ */
+
+#include "video/video_decode_thread_pool.h"
+
+#include <memory>
+#include <vector>
+
+#include "rtc_base/critical_section.h"
+#include "rtc_base/event.h"
+#include "rtc_base/task_utils/to_queued_task.h"
+#include "rtc_base/time_utils.h"
+#include "test/gtest.h"
+
+namespace webrtc {
+namespace {
+
+using TaskQueuePtr = std::unique_ptr<TaskQueueBase, TaskQueueDeleter>;
+
+constexpr int kWaitMs = 5000;
+
+TaskQueuePtr CreateTaskQueue(VideoDecodeThreadPool* pool) {
+  return pool->task_queue_factory()->CreateTaskQueue(
+      "test", TaskQueueFactory::Priority::HIGH);
+}
+
+// Blocks the task queue it is posted to until Unblock() is called.
+class Blocker {
+ public:
+  void Block(TaskQueueBase* task_queue) {
+    task_queue->PostTask(ToQueuedTask([this] {
+      started_.Set();
+      unblock_.Wait(rtc::Event::kForever);
+    }));
+    ASSERT_TRUE(started_.Wait(kWaitMs));
+  }
+  void Unblock() { unblock_.Set(); }
+
+ private:
+  rtc::Event started_;
+  rtc::Event unblock_;
+};
+
+TEST(VideoDecodeThreadPoolTest, RunsTasksOfTaskQueueInOrder) {
+  VideoDecodeThreadPool pool(4);
+  TaskQueuePtr task_queue = CreateTaskQueue(&pool);
+  rtc::CriticalSection crit;
+  std::vector<int> order;
+  rtc::Event done;
+  for (int i = 0; i < 100; ++i) {
+    // Earlier deadlines must not reorder tasks within a task queue.
+    pool.PostTaskWithDeadline(task_queue.get(), ToQueuedTask([&, i] {
+                                EXPECT_TRUE(task_queue->IsCurrent());
+                                rtc::CritScope lock(&crit);
+                                order.push_back(i);
+                              }),
+                              rtc::TimeMillis() + 1000 - i);
+  }
+  task_queue->PostTask(ToQueuedTask([&done] { done.Set(); }));
+  ASSERT_TRUE(done.Wait(kWaitMs));
+  rtc::CritScope lock(&crit);
+  ASSERT_EQ(order.size(), 100u);
+  for (int i = 0; i < 100; ++i)
+    EXPECT_EQ(order[i], i);
+}
+
+TEST(VideoDecodeThreadPoolTest, ServesEarliestDeadlineFirst) {
+  VideoDecodeThreadPool pool(1);
+  TaskQueuePtr late_queue = CreateTaskQueue(&pool);
+  TaskQueuePtr early_queue = CreateTaskQueue(&pool);
+  TaskQueuePtr blocked_queue = CreateTaskQueue(&pool);
+
+  // Occupy the only thread while the tasks are posted.
+  Blocker blocker;
+  blocker.Block(blocked_queue.get());
+
+  rtc::CriticalSection crit;
+  std::vector<TaskQueueBase*> order;
+  rtc::Event done;
+  const int64_t now_ms = rtc::TimeMillis();
+  pool.PostTaskWithDeadline(late_queue.get(), ToQueuedTask([&] {
+                              rtc::CritScope lock(&crit);
+                              order.push_back(late_queue.get());
+                              done.Set();
+                            }),
+                            now_ms + 2000);
+  pool.PostTaskWithDeadline(early_queue.get(), ToQueuedTask([&] {
+                              rtc::CritScope lock(&crit);
+                              order.push_back(early_queue.get());
+                            }),
+                            now_ms + 1000);
+  EXPECT_EQ(pool.GetStats().queue_depth, 2);
+  blocker.Unblock();
+
+  ASSERT_TRUE(done.Wait(kWaitMs));
+  rtc::CritScope lock(&crit);
+  ASSERT_EQ(order.size(), 2u);
+  EXPECT_EQ(order[0], early_queue.get());
+  EXPECT_EQ(order[1], late_queue.get());
+}
+
+TEST(VideoDecodeThreadPoolTest, CountsDeadlineMisses) {
+  VideoDecodeThreadPool pool(2);
+  TaskQueuePtr task_queue = CreateTaskQueue(&pool);
+  rtc::Event done;
+  pool.PostTaskWithDeadline(task_queue.get(), ToQueuedTask([] {}),
+                            rtc::TimeMillis() + 60000);
+  pool.PostTaskWithDeadline(task_queue.get(), ToQueuedTask([] {}),
+                            rtc::TimeMillis() - 1);
+  task_queue->PostTask(ToQueuedTask([&done] { done.Set(); }));
+  ASSERT_TRUE(done.Wait(kWaitMs));
+
+  // Tasks posted without a deadline are never counted as misses.
+  VideoDecodeThreadPool::TaskQueueStats stats =
+      pool.GetTaskQueueStats(task_queue.get());
+  EXPECT_EQ(stats.deadline_misses, 1u);
+  EXPECT_EQ(pool.GetStats().deadline_misses, 1u);
+}
+
+TEST(VideoDecodeThreadPoolTest, RunsDelayedTasks) {
+  VideoDecodeThreadPool pool(2);
+  TaskQueuePtr task_queue = CreateTaskQueue(&pool);
+  rtc::Event done;
+  const int64_t start_ms = rtc::TimeMillis();
+  int64_t run_ms = 0;
+  task_queue->PostDelayedTask(ToQueuedTask([&] {
+                                run_ms = rtc::TimeMillis();
+                                done.Set();
+                              }),
+                              50);
+  ASSERT_TRUE(done.Wait(kWaitMs));
+  EXPECT_GE(run_ms - start_ms, 50);
+}
+
+TEST(VideoDecodeThreadPoolTest, RunsTaskQueuesInParallel) {
+  VideoDecodeThreadPool pool(2);
+  TaskQueuePtr first_queue = CreateTaskQueue(&pool);
+  TaskQueuePtr second_queue = CreateTaskQueue(&pool);
+  Blocker blocker;
+  blocker.Block(first_queue.get());
+  rtc::Event done;
+  second_queue->PostTask(ToQueuedTask([&done] { done.Set(); }));
+  EXPECT_TRUE(done.Wait(kWaitMs));
+  blocker.Unblock();
+}
+
+TEST(VideoDecodeThreadPoolTest, DeleteWaitsForRunningTaskAndDropsOthers) {
+  VideoDecodeThreadPool pool(2);
+  TaskQueuePtr task_queue = CreateTaskQueue(&pool);
+  TaskQueuePtr other_queue = CreateTaskQueue(&pool);
+  Blocker blocker;
+  blocker.Block(task_queue.get());
+  bool ran = false;
+  task_queue->PostTask(ToQueuedTask([&ran] { ran = true; }));
+  task_queue->PostDelayedTask(ToQueuedTask([&ran] { ran = true; }), 10);
+  EXPECT_EQ(pool.GetStats().num_task_queues, 2);
+  EXPECT_EQ(pool.GetStats().queue_depth, 1);
+
+  other_queue->PostDelayedTask(
+      ToQueuedTask([&blocker] { blocker.Unblock(); }), 50);
+  task_queue = nullptr;
+
+  EXPECT_FALSE(ran);
+  VideoDecodeThreadPool::Stats stats = pool.GetStats();
+  EXPECT_EQ(stats.num_task_queues, 1);
+  EXPECT_EQ(stats.queue_depth, 0);
+}
+
+}  // namespace
+}  // namespace webrtc
@@ -44,6 +44,7 @@
 #include "rtc_base/logging.h"
 #include "rtc_base/strings/string_builder.h"
 #include "rtc_base/system/thread_registry.h"
+#include "rtc_base/task_utils/to_queued_task.h"
 #include "rtc_base/time_utils.h"
 #include "rtc_base/trace_event.h"
 #include "system_wrappers/include/clock.h"
@@ -179,6 +180,7 @@ VideoReceiveStream::VideoReceiveStream(
     Clock* clock,
     VCMTiming* timing)
     : task_queue_factory_(task_queue_factory),
+      decode_thread_pool_(VideoDecodeThreadPool::GetSharedInstanceIfEnabled()),
       transport_adapter_(config.rtcp_send_transport),
       config_(std::move(config)),
       num_cpu_cores_(num_cpu_cores),
@@ -209,9 +211,11 @@ VideoReceiveStream::VideoReceiveStream(
       max_wait_for_frame_ms_(KeyframeIntervalSettings::ParseFromFieldTrials()
                                  .MaxWaitForFrameMs()
                                  .value_or(kMaxWaitForFrameMs)),
-      decode_queue_(task_queue_factory_->CreateTaskQueue(
-          "DecodingQueue",
-          TaskQueueFactory::Priority::HIGH)) {
+      decode_queue_((decode_thread_pool_
+                         ? decode_thread_pool_->task_queue_factory()
+                         : task_queue_factory_)
+                        ->CreateTaskQueue("DecodingQueue",
+                                          TaskQueueFactory::Priority::HIGH)) {
   RTC_LOG(LS_INFO) << "VideoReceiveStream: " << config_.ToString();
 
   RTC_DCHECK(config_.renderer);
@@ -447,6 +451,12 @@ VideoReceiveStream::Stats VideoReceiveStream::GetStats() const {
     if (rtx_statistician)
       stats.total_bitrate_bps += rtx_statistician->BitrateReceived();
   }
+  if (decode_thread_pool_) {
+    VideoDecodeThreadPool::TaskQueueStats decode_stats =
+        decode_thread_pool_->GetTaskQueueStats(decode_queue_.Get());
+    stats.decode_queue_depth = decode_stats.queue_depth;
+    stats.decode_deadline_misses = decode_stats.deadline_misses;
+  }
   return stats;
 }
 
@@ -644,7 +654,18 @@ void VideoReceiveStream::StartNextDecode() {
       [this](std::unique_ptr<EncodedFrame> frame, ReturnReason res) {
         RTC_DCHECK_EQ(frame == nullptr, res == ReturnReason::kTimeout);
         RTC_DCHECK_EQ(frame != nullptr, res == ReturnReason::kFrameFound);
-        decode_queue_.PostTask(DecodeTask{this, std::move(frame)});
+        if (!decode_thread_pool_) {
+          decode_queue_.PostTask(DecodeTask{this, std::move(frame)});
+          return;
+        }
+        // Let the pool serve the stream whose frame is due first. The render
+        // time is in |clock_| time, the pool works in rtc::TimeMillis().
+        int64_t deadline_ms = rtc::TimeMillis();
+        if (frame)
+          deadline_ms += frame->RenderTime() - clock_->TimeInMilliseconds();
+        decode_thread_pool_->PostTaskWithDeadline(
+            decode_queue_.Get(),
+            ToQueuedTask(DecodeTask{this, std::move(frame)}), deadline_ms);
       });
 }
 
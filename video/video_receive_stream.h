@@ -30,6 +30,7 @@
 #include "video/rtp_streams_synchronizer.h"
 #include "video/rtp_video_stream_receiver.h"
 #include "video/transport_adapter.h"
+#include "video/video_decode_thread_pool.h"
 #include "video/video_stream_decoder.h"
 
 namespace webrtc {
@@ -148,6 +149,9 @@ class VideoReceiveStream : public webrtc::VideoReceiveStream,
   SequenceChecker network_sequence_checker_;
 
   TaskQueueFactory* const task_queue_factory_;
+  // Shared pool running |decode_queue_|, or nullptr if the stream has a
+  // decode thread of its own.
+  VideoDecodeThreadPool* const decode_thread_pool_;
 
   TransportAdapter transport_adapter_;
   const VideoReceiveStream::Config config_;
@@ -64,4 +64,8 @@ void VideoStreamDecoder::OnDecoderImplementationName(
   receive_stats_callback_->OnDecoderImplementationName(implementation_name);
 }
 
+void VideoStreamDecoder::OnDecoderFrameBufferBytes(size_t bytes) {
+  receive_stats_callback_->OnDecoderFrameBufferBytes(bytes);
+}
+
 }  // namespace webrtc
@@ -44,6 +44,7 @@ class VideoStreamDecoder : public VCMReceiveCallback {
   void OnDroppedFrames(uint32_t frames_dropped) override;
   void OnIncomingPayloadType(int payload_type) override;
   void OnDecoderImplementationName(const char* implementation_name) override;
+  void OnDecoderFrameBufferBytes(size_t bytes) override;
 
   void RegisterReceiveStatisticsProxy(
       ReceiveStatisticsProxy* receive_statistics_proxy);
@@ -28,6 +28,7 @@
 #include "modules/video_coding/utility/default_video_bitrate_allocator.h"
 #include "rtc_base/arraysize.h"
 #include "rtc_base/checks.h"
+#include "rtc_base/cpu_time.h"
 #include "rtc_base/experiments/alr_experiment.h"
 #include "rtc_base/experiments/quality_scaling_experiment.h"
 #include "rtc_base/experiments/rate_control_settings.h"
@@ -66,6 +67,9 @@ const int64_t kFrameRateAvergingWindowSizeMs = (1000 / 30) * 90;
 
 const size_t kDefaultPayloadSize = 1440;
 
+// Scheduling priority given to streams with a non-positive bitrate priority.
+constexpr double kMinCpuBudgetPriority = 0.01;
+
 const int64_t kParameterUpdateIntervalMs = 1000;
 
 uint32_t abs_diff(uint32_t a, uint32_t b) {
@@ -98,6 +102,7 @@ CpuOveruseOptions GetCpuOveruseOptions(
   if (settings.experiment_cpu_load_estimator) {
     options.filter_time_ms = 5 * rtc::kNumMillisecsPerSec;
   }
+  options.use_encode_cpu_time = settings.experiment_cpu_time_load_estimator;
 
   return options;
 }
@@ -207,6 +212,37 @@ VideoBitrateAllocation UpdateAllocationFromEncoderInfo(
   }
   return new_allocation;
 }
+
+bool IsBufferTypeSupported(VideoFrameBuffer::Type type,
+                           bool supports_native_handle) {
+  return type == VideoFrameBuffer::Type::kI420 ||
+         (type == VideoFrameBuffer::Type::kNative && supports_native_handle);
+}
+
+// Crops |crop_width| x |crop_height| pixels off |buffer|, converting it to
+// I420. Returns null if the conversion fails.
+rtc::scoped_refptr<VideoFrameBuffer> CropFrameBuffer(
+    const rtc::scoped_refptr<VideoFrameBuffer>& buffer,
+    int crop_width,
+    int crop_height) {
+  rtc::scoped_refptr<I420BufferInterface> i420_buffer = buffer->ToI420();
+  if (!i420_buffer)
+    return nullptr;
+  int cropped_width = buffer->width() - crop_width;
+  int cropped_height = buffer->height() - crop_height;
+  rtc::scoped_refptr<I420Buffer> cropped_buffer =
+      I420Buffer::Create(cropped_width, cropped_height);
+  // TODO(ilnik): Remove scaling if cropping is too big, as it should never
+  // happen after SinkWants signaled correctly from ReconfigureEncoder.
+  if (crop_width < 4 && crop_height < 4) {
+    cropped_buffer->CropAndScaleFrom(*i420_buffer, crop_width / 2,
+                                     crop_height / 2, cropped_width,
+                                     cropped_height);
+  } else {
+    cropped_buffer->ScaleFrom(*i420_buffer);
+  }
+  return cropped_buffer;
+}
 }  //  namespace
 
 // VideoSourceProxy is responsible ensuring thread safety between calls to
@@ -489,6 +525,8 @@ VideoStreamEncoder::VideoStreamEncoder(
       rate_control_settings_(RateControlSettings::ParseFromFieldTrials()),
       quality_scaler_settings_(QualityScalerSettings::ParseFromFieldTrials()),
       overuse_detector_(std::move(overuse_detector)),
+      cpu_budget_scheduler_(EncoderCpuBudgetScheduler::GetProcessScheduler()),
+      cpu_budget_client_added_(false),
       encoder_stats_observer_(encoder_stats_observer),
       encoder_initialized_(false),
       max_framerate_(-1),
@@ -507,6 +545,7 @@ VideoStreamEncoder::VideoStreamEncoder(
       clock_(clock),
       degradation_preference_(DegradationPreference::DISABLED),
       posted_frames_waiting_for_encode_(0),
+      posted_frames_waiting_for_preprocess_(0),
       last_captured_timestamp_(0),
       delta_ntp_internal_ms_(clock_->CurrentNtpInMilliseconds() -
                              clock_->TimeInMilliseconds()),
@@ -526,7 +565,14 @@ VideoStreamEncoder::VideoStreamEncoder(
       next_frame_id_(0),
       encoder_queue_(task_queue_factory->CreateTaskQueue(
           "EncoderQueue",
-          TaskQueueFactory::Priority::NORMAL)) {
+          TaskQueueFactory::Priority::NORMAL)),
+      preprocess_queue_(
+          settings.enable_pipelined_encoding
+              ? absl::make_unique<rtc::TaskQueue>(
+                    task_queue_factory->CreateTaskQueue(
+                        "EncoderPreprocessQueue",
+                        TaskQueueFactory::Priority::NORMAL))
+              : nullptr) {
   RTC_DCHECK(encoder_stats_observer);
   RTC_DCHECK(overuse_detector_);
   RTC_DCHECK_GE(number_of_cores, 1);
@@ -544,15 +590,27 @@ VideoStreamEncoder::~VideoStreamEncoder() {
 void VideoStreamEncoder::Stop() {
   RTC_DCHECK_RUN_ON(&thread_checker_);
   source_proxy_->SetSource(nullptr, DegradationPreference());
-  encoder_queue_.PostTask([this] {
+  auto shutdown = [this] {
     RTC_DCHECK_RUN_ON(&encoder_queue_);
     overuse_detector_->StopCheckForOveruse();
+    if (cpu_budget_client_added_) {
+      cpu_budget_scheduler_->RemoveClient(this);
+      cpu_budget_client_added_ = false;
+    }
     rate_allocator_ = nullptr;
     bitrate_observer_ = nullptr;
     ReleaseEncoder();
     quality_scaler_ = nullptr;
     shutdown_event_.Set();
-  });
+  };
+  if (preprocess_queue_) {
+    // Frames still being preprocessed are posted to |encoder_queue_|
+    // afterwards, so shut down behind them.
+    preprocess_queue_->PostTask(
+        [this, shutdown] { encoder_queue_.PostTask(shutdown); });
+  } else {
+    encoder_queue_.PostTask(shutdown);
+  }
 
   shutdown_event_.Wait(rtc::Event::kForever);
 }
@@ -659,6 +717,12 @@ void VideoStreamEncoder::ConfigureEncoderOnTaskQueue(
   encoder_config_ = std::move(config);
   max_data_payload_length_ = max_data_payload_length;
   pending_encoder_reconfiguration_ = true;
+  if (cpu_budget_scheduler_) {
+    cpu_budget_scheduler_->AddClient(
+        this,
+        std::max(encoder_config_.bitrate_priority, kMinCpuBudgetPriority));
+    cpu_budget_client_added_ = true;
+  }
 
   // Reconfigure the encoder now if the encoder has an internal source or
   // if the frame resolution is known. Otherwise, the reconfiguration is
@@ -741,6 +805,7 @@ void VideoStreamEncoder::ReconfigureEncoder() {
   RTC_CHECK_GE(last_frame_info_->height, highest_stream_height);
   crop_width_ = last_frame_info_->width - highest_stream_width;
   crop_height_ = last_frame_info_->height - highest_stream_height;
+  UpdatePreprocessSettings();
 
   bool encoder_reset_required = false;
   if (pending_encoder_creation_) {
@@ -785,6 +850,8 @@ void VideoStreamEncoder::ReconfigureEncoder() {
   if (!VideoCodecInitializer::SetupCodec(encoder_config_, streams, &codec)) {
     RTC_LOG(LS_ERROR) << "Failed to create encoder configuration.";
   }
+  if (cpu_budget_allocation_ && codec.codecType == kVideoCodecVP8)
+    codec.VP8()->complexity = cpu_budget_allocation_->complexity;
 
   // Set min_bitrate_bps, max_bitrate_bps, and max padding bit rate for VP9.
   if (encoder_config_.codec_type == kVideoCodecVP9) {
@@ -890,10 +957,7 @@ void VideoStreamEncoder::ReconfigureEncoder() {
   if (pending_encoder_creation_) {
     overuse_detector_->StopCheckForOveruse();
     overuse_detector_->StartCheckForOveruse(
-        &encoder_queue_,
-        GetCpuOveruseOptions(
-            settings_, encoder_->GetEncoderInfo().is_hardware_accelerated),
-        this);
+        &encoder_queue_, GetCpuOveruseOptionsWithinBudget(), this);
     pending_encoder_creation_ = false;
   }
 
@@ -1058,38 +1122,98 @@ void VideoStreamEncoder::OnFrame(const VideoFrame& video_frame) {
   int64_t post_time_us = rtc::TimeMicros();
   ++posted_frames_waiting_for_encode_;
 
+  if (preprocess_queue_) {
+    ++posted_frames_waiting_for_preprocess_;
+    preprocess_queue_->PostTask(
+        [this, incoming_frame, post_time_us, log_stats]() {
+          PreprocessFrame(incoming_frame, post_time_us, log_stats);
+        });
+    return;
+  }
+
+  encoder_queue_.PostTask([this, incoming_frame, post_time_us, log_stats]() {
+    RTC_DCHECK_RUN_ON(&encoder_queue_);
+    OnFramePosted(incoming_frame, post_time_us, log_stats,
+                  /*preprocessed_frame=*/nullptr);
+  });
+}
+
+void VideoStreamEncoder::PreprocessFrame(const VideoFrame& frame,
+                                         int64_t time_when_posted_us,
+                                         bool log_stats) {
+  RTC_DCHECK(preprocess_queue_->IsCurrent());
+  absl::optional<PreprocessedFrame> preprocessed_frame;
+  // Only the newest frame will be encoded, don't spend time on older ones.
+  if (posted_frames_waiting_for_preprocess_.fetch_sub(1) == 1) {
+    PreprocessSettings settings;
+    {
+      rtc::CritScope lock(&preprocess_settings_lock_);
+      settings = preprocess_settings_;
+    }
+    int64_t start_time_us = rtc::TimeMicros();
+    rtc::scoped_refptr<VideoFrameBuffer> buffer = frame.video_frame_buffer();
+    if (settings.crop_width > 0 || settings.crop_height > 0) {
+      buffer =
+          CropFrameBuffer(buffer, settings.crop_width, settings.crop_height);
+    } else if (!IsBufferTypeSupported(buffer->type(),
+                                      settings.supports_native_handle)) {
+      buffer = buffer->ToI420();
+    }
+    int64_t end_time_us = rtc::TimeMicros();
+    preprocessed_frame = PreprocessedFrame{
+        buffer, settings.crop_width, settings.crop_height,
+        static_cast<int>(end_time_us - start_time_us), end_time_us};
+  }
+
   encoder_queue_.PostTask(
-      [this, incoming_frame, post_time_us, log_stats]() {
+      [this, frame, time_when_posted_us, log_stats, preprocessed_frame]() {
         RTC_DCHECK_RUN_ON(&encoder_queue_);
-        encoder_stats_observer_->OnIncomingFrame(incoming_frame.width(),
-                                                 incoming_frame.height());
-        ++captured_frame_count_;
-        const int posted_frames_waiting_for_encode =
-            posted_frames_waiting_for_encode_.fetch_sub(1);
-        RTC_DCHECK_GT(posted_frames_waiting_for_encode, 0);
-        if (posted_frames_waiting_for_encode == 1) {
-          MaybeEncodeVideoFrame(incoming_frame, post_time_us);
-        } else {
-          // There is a newer frame in flight. Do not encode this frame.
-          RTC_LOG(LS_VERBOSE)
-              << "Incoming frame dropped due to that the encoder is blocked.";
-          ++dropped_frame_count_;
-          encoder_stats_observer_->OnFrameDropped(
-              VideoStreamEncoderObserver::DropReason::kEncoderQueue);
-          accumulated_update_rect_.Union(incoming_frame.update_rect());
-        }
-        if (log_stats) {
-          RTC_LOG(LS_INFO) << "Number of frames: captured "
-                           << captured_frame_count_
-                           << ", dropped (due to encoder blocked) "
-                           << dropped_frame_count_ << ", interval_ms "
-                           << kFrameLogIntervalMs;
-          captured_frame_count_ = 0;
-          dropped_frame_count_ = 0;
-        }
+        OnFramePosted(frame, time_when_posted_us, log_stats,
+                      preprocessed_frame ? &*preprocessed_frame : nullptr);
       });
 }
 
+void VideoStreamEncoder::OnFramePosted(
+    const VideoFrame& frame,
+    int64_t time_when_posted_us,
+    bool log_stats,
+    const PreprocessedFrame* preprocessed_frame) {
+  encoder_stats_observer_->OnIncomingFrame(frame.width(), frame.height());
+  ++captured_frame_count_;
+  const int posted_frames_waiting_for_encode =
+      posted_frames_waiting_for_encode_.fetch_sub(1);
+  RTC_DCHECK_GT(posted_frames_waiting_for_encode, 0);
+  if (posted_frames_waiting_for_encode == 1) {
+    MaybeEncodeVideoFrame(frame, time_when_posted_us, preprocessed_frame);
+  } else {
+    // There is a newer frame in flight. Do not encode this frame.
+    RTC_LOG(LS_VERBOSE)
+        << "Incoming frame dropped due to that the encoder is blocked.";
+    ++dropped_frame_count_;
+    encoder_stats_observer_->OnFrameDropped(
+        VideoStreamEncoderObserver::DropReason::kEncoderQueue);
+    accumulated_update_rect_.Union(frame.update_rect());
+  }
+  if (log_stats) {
+    RTC_LOG(LS_INFO) << "Number of frames: captured " << captured_frame_count_
+                     << ", dropped (due to encoder blocked) "
+                     << dropped_frame_count_ << ", interval_ms "
+                     << kFrameLogIntervalMs;
+    captured_frame_count_ = 0;
+    dropped_frame_count_ = 0;
+  }
+}
+
+void VideoStreamEncoder::UpdatePreprocessSettings() {
+  if (!preprocess_queue_)
+    return;
+  rtc::CritScope lock(&preprocess_settings_lock_);
+  preprocess_settings_.crop_width = crop_width_;
+  preprocess_settings_.crop_height = crop_height_;
+  preprocess_settings_.supports_native_handle =
+      encoder_info_.supports_native_handle;
+}
+
 void VideoStreamEncoder::OnDiscardedFrame() {
   encoder_stats_observer_->OnFrameDropped(
       VideoStreamEncoderObserver::DropReason::kSource);
@@ -1221,8 +1345,10 @@ void VideoStreamEncoder::SetEncoderRates(
   }
 }
 
-void VideoStreamEncoder::MaybeEncodeVideoFrame(const VideoFrame& video_frame,
-                                               int64_t time_when_posted_us) {
+void VideoStreamEncoder::MaybeEncodeVideoFrame(
+    const VideoFrame& video_frame,
+    int64_t time_when_posted_us,
+    const PreprocessedFrame* preprocessed_frame) {
   RTC_DCHECK_RUN_ON(&encoder_queue_);
 
   if (!last_frame_info_ || video_frame.width() != last_frame_info_->width ||
@@ -1343,11 +1469,13 @@ void VideoStreamEncoder::MaybeEncodeVideoFrame(const VideoFrame& video_frame,
     return;
   }
 
-  EncodeVideoFrame(video_frame, time_when_posted_us);
+  EncodeVideoFrame(video_frame, time_when_posted_us, preprocessed_frame);
 }
 
-void VideoStreamEncoder::EncodeVideoFrame(const VideoFrame& video_frame,
-                                          int64_t time_when_posted_us) {
+void VideoStreamEncoder::EncodeVideoFrame(
+    const VideoFrame& video_frame,
+    int64_t time_when_posted_us,
+    const PreprocessedFrame* preprocessed_frame) {
   RTC_DCHECK_RUN_ON(&encoder_queue_);
 
   // If the encoder fail we can't continue to encode frames. When this happens
@@ -1358,33 +1486,34 @@ void VideoStreamEncoder::EncodeVideoFrame(const VideoFrame& video_frame,
 
   TraceFrameDropEnd();
 
+  // The encoder may have been reconfigured after the frame was preprocessed.
+  const bool use_preprocessed_frame =
+      preprocessed_frame && preprocessed_frame->crop_width == crop_width_ &&
+      preprocessed_frame->crop_height == crop_height_;
+
   VideoFrame out_frame(video_frame);
   // Crop frame if needed.
   if (crop_width_ > 0 || crop_height_ > 0) {
+    rtc::scoped_refptr<VideoFrameBuffer> cropped_buffer =
+        use_preprocessed_frame
+            ? preprocessed_frame->buffer
+            : CropFrameBuffer(video_frame.video_frame_buffer(), crop_width_,
+                              crop_height_);
     // If the frame can't be converted to I420, drop it.
-    auto i420_buffer = video_frame.video_frame_buffer()->ToI420();
-    if (!i420_buffer) {
+    if (!cropped_buffer) {
       RTC_LOG(LS_ERROR) << "Frame conversion for crop failed, dropping frame.";
       return;
     }
-    int cropped_width = video_frame.width() - crop_width_;
-    int cropped_height = video_frame.height() - crop_height_;
-    rtc::scoped_refptr<I420Buffer> cropped_buffer =
-        I420Buffer::Create(cropped_width, cropped_height);
-    // TODO(ilnik): Remove scaling if cropping is too big, as it should never
-    // happen after SinkWants signaled correctly from ReconfigureEncoder.
+    int cropped_width = cropped_buffer->width();
+    int cropped_height = cropped_buffer->height();
     VideoFrame::UpdateRect update_rect = video_frame.update_rect();
     if (crop_width_ < 4 && crop_height_ < 4) {
-      cropped_buffer->CropAndScaleFrom(*i420_buffer, crop_width_ / 2,
-                                       crop_height_ / 2, cropped_width,
-                                       cropped_height);
       update_rect.offset_x -= crop_width_ / 2;
       update_rect.offset_y -= crop_height_ / 2;
       update_rect.Intersect(
           VideoFrame::UpdateRect{0, 0, cropped_width, cropped_height});
 
     } else {
-      cropped_buffer->ScaleFrom(*i420_buffer);
       if (!update_rect.IsEmpty()) {
         // Since we can't reason about pixels after scaling, we invalidate whole
         // picture, if anything changed.
@@ -1438,20 +1567,22 @@ void VideoStreamEncoder::EncodeVideoFrame(const VideoFrame& video_frame,
   }
 
   encoder_info_ = info;
+  UpdatePreprocessSettings();
   last_encode_info_ms_ = clock_->TimeInMilliseconds();
   RTC_DCHECK_EQ(send_codec_.width, out_frame.width());
   RTC_DCHECK_EQ(send_codec_.height, out_frame.height());
-  const VideoFrameBuffer::Type buffer_type =
-      out_frame.video_frame_buffer()->type();
-  const bool is_buffer_type_supported =
-      buffer_type == VideoFrameBuffer::Type::kI420 ||
-      (buffer_type == VideoFrameBuffer::Type::kNative &&
-       info.supports_native_handle);
-
-  if (!is_buffer_type_supported) {
+
+  if (!IsBufferTypeSupported(out_frame.video_frame_buffer()->type(),
+                             info.supports_native_handle)) {
     // This module only supports software encoding.
+    rtc::scoped_refptr<VideoFrameBuffer> buffer_to_convert =
+        out_frame.video_frame_buffer();
+    if (use_preprocessed_frame && preprocessed_frame->buffer &&
+        preprocessed_frame->buffer->type() == VideoFrameBuffer::Type::kI420) {
+      buffer_to_convert = preprocessed_frame->buffer;
+    }
     rtc::scoped_refptr<I420BufferInterface> converted_buffer(
-        out_frame.video_frame_buffer()->ToI420());
+        buffer_to_convert->ToI420());
 
     if (!converted_buffer) {
       RTC_LOG(LS_ERROR) << "Frame conversion failed, dropping frame.";
@@ -1477,9 +1608,29 @@ void VideoStreamEncoder::EncodeVideoFrame(const VideoFrame& video_frame,
 
   frame_encode_metadata_writer_.OnEncodeStarted(out_frame);
 
+  const int64_t encode_start_time_us = rtc::TimeMicros();
+  const int64_t encode_start_cpu_time_ns =
+      settings_.experiment_cpu_time_load_estimator
+          ? rtc::GetThreadCpuTimeNanos()
+          : 0;
   const int32_t encode_status = encoder_->Encode(out_frame, &next_frame_types_);
   was_encode_called_since_last_initialization_ = true;
 
+  if (settings_.experiment_cpu_time_load_estimator) {
+    overuse_detector_->FrameEncodeCpuTimeMeasured(
+        out_frame.timestamp_us(),
+        (rtc::GetThreadCpuTimeNanos() - encode_start_cpu_time_ns) /
+            rtc::kNumNanosecsPerMicrosec);
+  }
+
+  if (preprocessed_frame) {
+    encoder_stats_observer_->OnFramePipelineTimeMeasured(
+        preprocessed_frame->preprocess_time_us,
+        static_cast<int>(encode_start_time_us -
+                         preprocessed_frame->preprocessed_time_us),
+        static_cast<int>(rtc::TimeMicros() - encode_start_time_us));
+  }
+
   if (encode_status < 0) {
     if (encode_status == WEBRTC_VIDEO_CODEC_ENCODER_FAILURE) {
       RTC_LOG(LS_ERROR) << "Encoder failed, failing encoder format: "
@@ -1786,7 +1937,8 @@ void VideoStreamEncoder::OnBitrateUpdated(DataRate target_bitrate,
       !DropDueToSize(pending_frame_->size())) {
     int64_t pending_time_us = rtc::TimeMicros() - pending_frame_post_time_us_;
     if (pending_time_us < kPendingFrameTimeoutMs * 1000)
-      EncodeVideoFrame(*pending_frame_, pending_frame_post_time_us_);
+      EncodeVideoFrame(*pending_frame_, pending_frame_post_time_us_,
+                       /*preprocessed_frame=*/nullptr);
     pending_frame_.reset();
   }
 }
@@ -2100,6 +2252,12 @@ void VideoStreamEncoder::RunPostEncode(EncodedImage encoded_image,
       encoded_image.Timestamp(), time_sent_us,
       encoded_image.capture_time_ms_ * rtc::kNumMicrosecsPerMillisec,
       encode_duration_us);
+  if (cpu_budget_client_added_) {
+    absl::optional<int> usage_percent =
+        overuse_detector_->GetEncodeUsagePercent();
+    if (usage_percent)
+      cpu_budget_scheduler_->OnLoadMeasured(this, *usage_percent / 100.0);
+  }
   if (quality_scaler_ && encoded_image.qp_ >= 0)
     quality_scaler_->ReportQp(encoded_image.qp_, time_sent_us);
   if (bitrate_adjuster_) {
@@ -2107,6 +2265,43 @@ void VideoStreamEncoder::RunPostEncode(EncodedImage encoded_image,
   }
 }
 
+void VideoStreamEncoder::OnCpuBudgetAllocationUpdated(
+    const EncoderCpuBudgetScheduler::Allocation& allocation) {
+  encoder_queue_.PostTask([this, allocation] {
+    RTC_DCHECK_RUN_ON(&encoder_queue_);
+    const bool complexity_changed =
+        !cpu_budget_allocation_ ||
+        cpu_budget_allocation_->complexity != allocation.complexity;
+    cpu_budget_allocation_ = allocation;
+    encoder_stats_observer_->OnCpuBudgetAllocationUpdated(
+        allocation.max_encode_usage_percent, allocation.complexity);
+    // Without an encoder, the budget is applied when one is created.
+    if (!encoder_)
+      return;
+    CpuOveruseOptions options = GetCpuOveruseOptionsWithinBudget();
+    overuse_detector_->SetUsageThresholds(
+        options.low_encode_usage_threshold_percent,
+        options.high_encode_usage_threshold_percent);
+    if (complexity_changed && encoder_config_.codec_type == kVideoCodecVP8)
+      pending_encoder_reconfiguration_ = true;
+  });
+}
+
+CpuOveruseOptions VideoStreamEncoder::GetCpuOveruseOptionsWithinBudget()
+    const {
+  CpuOveruseOptions options = GetCpuOveruseOptions(
+      settings_, encoder_->GetEncoderInfo().is_hardware_accelerated);
+  if (cpu_budget_allocation_) {
+    options.high_encode_usage_threshold_percent =
+        std::min(options.high_encode_usage_threshold_percent,
+                 cpu_budget_allocation_->max_encode_usage_percent);
+    options.low_encode_usage_threshold_percent =
+        std::min(options.low_encode_usage_threshold_percent,
+                 options.high_encode_usage_threshold_percent / 2);
+  }
+  return options;
+}
+
 bool VideoStreamEncoder::HasInternalSource() const {
   // TODO(sprang): Checking both info from encoder and from encoder factory
   // until we have deprecated and removed the encoder factory info.
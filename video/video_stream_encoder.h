@@ -38,6 +38,7 @@
 #include "rtc_base/task_queue.h"
 #include "system_wrappers/include/clock.h"
 #include "video/encoder_bitrate_adjuster.h"
+#include "video/encoder_cpu_budget_scheduler.h"
 #include "video/frame_encode_metadata_writer.h"
 #include "video/overuse_frame_detector.h"
 
@@ -54,6 +55,7 @@ namespace webrtc {
 class VideoStreamEncoder : public VideoStreamEncoderInterface,
                            private EncodedImageCallback,
                            // Protected only to provide access to tests.
+                           protected EncoderCpuBudgetScheduler::Client,
                            protected AdaptationObserverInterface {
  public:
   VideoStreamEncoder(Clock* clock,
@@ -106,6 +108,10 @@ class VideoStreamEncoder : public VideoStreamEncoderInterface,
   void AdaptUp(AdaptReason reason) override;
   bool AdaptDown(AdaptReason reason) override;
 
+  // Implements EncoderCpuBudgetScheduler::Client. Protected for testing.
+  void OnCpuBudgetAllocationUpdated(
+      const EncoderCpuBudgetScheduler::Allocation& allocation) override;
+
  private:
   class VideoSourceProxy;
 
@@ -145,15 +151,48 @@ class VideoStreamEncoder : public VideoStreamEncoderInterface,
 
   void ConfigureQualityScaler(const VideoEncoder::EncoderInfo& encoder_info);
 
+  // Returns the overuse options for the current encoder, with the thresholds
+  // limited by |cpu_budget_allocation_|.
+  CpuOveruseOptions GetCpuOveruseOptionsWithinBudget() const
+      RTC_RUN_ON(&encoder_queue_);
+
   // Implements VideoSinkInterface.
   void OnFrame(const VideoFrame& video_frame) override;
   void OnDiscardedFrame() override;
 
+  // Result of preprocessing a frame on |preprocess_queue_|.
+  struct PreprocessedFrame {
+    // Cropped, or converted to a buffer type the encoder supports. Null if
+    // the conversion failed.
+    rtc::scoped_refptr<VideoFrameBuffer> buffer;
+    // Cropping applied to |buffer|, it can only be used if the encoder still
+    // crops the same when the frame is encoded.
+    int crop_width;
+    int crop_height;
+    int preprocess_time_us;
+    int64_t preprocessed_time_us;
+  };
+
+  // Crops and converts |frame| on |preprocess_queue_| and posts it on to
+  // |encoder_queue_|.
+  void PreprocessFrame(const VideoFrame& frame,
+                       int64_t time_when_posted_us,
+                       bool log_stats);
+  void OnFramePosted(const VideoFrame& frame,
+                     int64_t time_when_posted_us,
+                     bool log_stats,
+                     const PreprocessedFrame* preprocessed_frame)
+      RTC_RUN_ON(&encoder_queue_);
+  // Updates the copy of the encoder state used by PreprocessFrame().
+  void UpdatePreprocessSettings() RTC_RUN_ON(&encoder_queue_);
+
   void MaybeEncodeVideoFrame(const VideoFrame& frame,
-                             int64_t time_when_posted_in_ms);
+                             int64_t time_when_posted_in_ms,
+                             const PreprocessedFrame* preprocessed_frame);
 
   void EncodeVideoFrame(const VideoFrame& frame,
-                        int64_t time_when_posted_in_ms);
+                        int64_t time_when_posted_in_ms,
+                        const PreprocessedFrame* preprocessed_frame);
   // Indicates wether frame should be dropped because the pixel count is too
   // large for the current bitrate configuration.
   bool DropDueToSize(uint32_t pixel_count) const RTC_RUN_ON(&encoder_queue_);
@@ -246,6 +285,11 @@ class VideoStreamEncoder : public VideoStreamEncoderInterface,
 
   const std::unique_ptr<OveruseFrameDetector> overuse_detector_
       RTC_PT_GUARDED_BY(&encoder_queue_);
+  // Null unless the encoders of the process share a CPU budget.
+  EncoderCpuBudgetScheduler* const cpu_budget_scheduler_;
+  bool cpu_budget_client_added_ RTC_GUARDED_BY(&encoder_queue_);
+  absl::optional<EncoderCpuBudgetScheduler::Allocation> cpu_budget_allocation_
+      RTC_GUARDED_BY(&encoder_queue_);
   std::unique_ptr<QualityScaler> quality_scaler_ RTC_GUARDED_BY(&encoder_queue_)
       RTC_PT_GUARDED_BY(&encoder_queue_);
 
@@ -319,6 +363,17 @@ class VideoStreamEncoder : public VideoStreamEncoderInterface,
   rtc::RaceChecker incoming_frame_race_checker_
       RTC_GUARDED_BY(incoming_frame_race_checker_);
   std::atomic<int> posted_frames_waiting_for_encode_;
+  std::atomic<int> posted_frames_waiting_for_preprocess_;
+
+  // The encoder state needed to preprocess frames on |preprocess_queue_|.
+  struct PreprocessSettings {
+    int crop_width = 0;
+    int crop_height = 0;
+    bool supports_native_handle = false;
+  };
+  rtc::CriticalSection preprocess_settings_lock_;
+  PreprocessSettings preprocess_settings_
+      RTC_GUARDED_BY(preprocess_settings_lock_);
   // Used to make sure incoming time stamp is increasing for every frame.
   int64_t last_captured_timestamp_ RTC_GUARDED_BY(incoming_frame_race_checker_);
   // Delta used for translating between NTP and internal timestamps.
@@ -390,6 +445,10 @@ class VideoStreamEncoder : public VideoStreamEncoderInterface,
   // destroyed first to make sure no tasks are run that use other members.
   rtc::TaskQueue encoder_queue_;
 
+  // Set if pipelined encoding is enabled. Frames are preprocessed here before
+  // being posted to |encoder_queue_|, so it is destroyed before it.
+  std::unique_ptr<rtc::TaskQueue> preprocess_queue_;
+
   RTC_DISALLOW_COPY_AND_ASSIGN(VideoStreamEncoder);
 };
 
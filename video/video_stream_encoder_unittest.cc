@@ -120,16 +120,32 @@ class CpuOveruseDetectorProxy : public OveruseFrameDetector {
     OveruseFrameDetector::OnTargetFramerateUpdated(framerate_fps);
   }
 
+  void FrameEncodeCpuTimeMeasured(int64_t capture_time_us,
+                                  int64_t cpu_time_us) override {
+    {
+      rtc::CritScope cs(&lock_);
+      ++num_cpu_time_measurements_;
+    }
+    OveruseFrameDetector::FrameEncodeCpuTimeMeasured(capture_time_us,
+                                                     cpu_time_us);
+  }
+
   int GetLastTargetFramerate() {
     rtc::CritScope cs(&lock_);
     return last_target_framerate_fps_;
   }
 
+  int num_cpu_time_measurements() {
+    rtc::CritScope cs(&lock_);
+    return num_cpu_time_measurements_;
+  }
+
   CpuOveruseOptions GetOptions() { return options_; }
 
  private:
   rtc::CriticalSection lock_;
   int last_target_framerate_fps_ RTC_GUARDED_BY(lock_);
+  int num_cpu_time_measurements_ RTC_GUARDED_BY(lock_) = 0;
 };
 
 class VideoStreamEncoderUnderTest : public VideoStreamEncoder {
@@ -174,6 +190,15 @@ class VideoStreamEncoderUnderTest : public VideoStreamEncoder {
 
   void TriggerQualityHigh() { PostTaskAndWait(false, AdaptReason::kQuality); }
 
+  void SetCpuBudgetAllocationAndWait(int max_encode_usage_percent,
+                                     VideoCodecComplexity complexity) {
+    EncoderCpuBudgetScheduler::Allocation allocation;
+    allocation.max_encode_usage_percent = max_encode_usage_percent;
+    allocation.complexity = complexity;
+    OnCpuBudgetAllocationUpdated(allocation);
+    WaitUntilTaskQueueIsIdle();
+  }
+
   CpuOveruseDetectorProxy* overuse_detector_proxy_;
 };
 
@@ -336,9 +361,22 @@ class MockableSendStatisticsProxy : public SendStatisticsProxy {
     mock_stats_.reset();
   }
 
+  void OnFramePipelineTimeMeasured(int preprocess_time_us,
+                                   int queue_time_us,
+                                   int encode_time_us) override {
+    rtc::CritScope cs(&lock_);
+    ++num_pipeline_time_measurements_;
+  }
+
+  int num_pipeline_time_measurements() const {
+    rtc::CritScope cs(&lock_);
+    return num_pipeline_time_measurements_;
+  }
+
  private:
   rtc::CriticalSection lock_;
   absl::optional<VideoSendStream::Stats> mock_stats_ RTC_GUARDED_BY(lock_);
+  int num_pipeline_time_measurements_ RTC_GUARDED_BY(lock_) = 0;
 };
 
 class MockBitrateObserver : public VideoBitrateAllocationObserver {
@@ -511,7 +549,7 @@ class VideoStreamEncoderTest : public ::testing::Test {
         DataRate::bps(kTargetBitrateBps), 0, 0);
 
     video_source_.IncomingCapturedFrame(
-        CreateFrame(1, codec_width_, codec_height_));
+        CreateFrame(1, nullptr));
     WaitForEncodedFrame(1);
   }
 
@@ -1194,6 +1232,65 @@ TEST_F(VideoStreamEncoderTest, DropsPendingFramesOnSlowEncode) {
   video_stream_encoder_->Stop();
 }
 
+TEST_F(VideoStreamEncoderTest, PipelinedEncodingEncodesFrames) {
+  video_send_config_.encoder_settings.enable_pipelined_encoding = true;
+  ConfigureEncoder(video_encoder_config_.Copy());
+  video_stream_encoder_->OnBitrateUpdated(
+      DataRate::bps(kTargetBitrateBps), DataRate::bps(kTargetBitrateBps),
+      DataRate::bps(kTargetBitrateBps), 0, 0);
+
+  video_source_.IncomingCapturedFrame(CreateFrame(1, nullptr));
+  WaitForEncodedFrame(1);
+  video_source_.IncomingCapturedFrame(CreateFrame(2, nullptr));
+  WaitForEncodedFrame(2);
+  EXPECT_EQ(2, stats_proxy_->num_pipeline_time_measurements());
+
+  video_stream_encoder_->Stop();
+}
+
+TEST_F(VideoStreamEncoderTest,
+       PipelinedEncodingDropsPendingFramesOnSlowEncode) {
+  video_send_config_.encoder_settings.enable_pipelined_encoding = true;
+  ConfigureEncoder(video_encoder_config_.Copy());
+  video_stream_encoder_->OnBitrateUpdated(
+      DataRate::bps(kTargetBitrateBps), DataRate::bps(kTargetBitrateBps),
+      DataRate::bps(kTargetBitrateBps), 0, 0);
+
+  fake_encoder_.BlockNextEncode();
+  video_source_.IncomingCapturedFrame(CreateFrame(1, nullptr));
+  WaitForEncodedFrame(1);
+  // The encoder thread is blocked, frame 2 is dropped since frame 3 is posted
+  // behind it, and reported as dropped by the encoder queue.
+  video_source_.IncomingCapturedFrame(CreateFrame(2, nullptr));
+  video_source_.IncomingCapturedFrame(CreateFrame(3, nullptr));
+  fake_encoder_.ContinueEncode();
+  WaitForEncodedFrame(3);
+  EXPECT_EQ(1u, stats_proxy_->GetStats().frames_dropped_by_encoder_queue);
+
+  video_stream_encoder_->Stop();
+}
+
+TEST_F(VideoStreamEncoderTest, PipelinedEncodingCropsFrames) {
+  video_send_config_.encoder_settings.enable_pipelined_encoding = true;
+  video_encoder_config_.video_stream_factory =
+      new rtc::RefCountedObject<CroppingVideoStreamFactory>(1, 30);
+  ConfigureEncoder(video_encoder_config_.Copy());
+  video_stream_encoder_->OnBitrateUpdated(
+      DataRate::bps(kTargetBitrateBps), DataRate::bps(kTargetBitrateBps),
+      DataRate::bps(kTargetBitrateBps), 0, 0);
+
+  // The first frame is cropped on the encoder queue since the crop is only
+  // known after the encoder has been configured for it.
+  video_source_.IncomingCapturedFrame(
+      CreateFrame(1, codec_width_ + 1, codec_height_ + 1));
+  WaitForEncodedFrame(codec_width_, codec_height_);
+  video_source_.IncomingCapturedFrame(
+      CreateFrame(2, codec_width_ + 1, codec_height_ + 1));
+  WaitForEncodedFrame(codec_width_, codec_height_);
+
+  video_stream_encoder_->Stop();
+}
+
 TEST_F(VideoStreamEncoderTest, DropFrameWithFailedI420Conversion) {
   video_stream_encoder_->OnBitrateUpdated(
       DataRate::bps(kTargetBitrateBps), DataRate::bps(kTargetBitrateBps),
@@ -4359,6 +4456,90 @@ TEST_F(VideoStreamEncoderTest,
   video_stream_encoder_->Stop();
 }
 
+TEST_F(VideoStreamEncoderTest,
+       CpuBudgetAllocationLimitsThresholdsAndSetsComplexity) {
+  video_stream_encoder_->OnBitrateUpdated(
+      DataRate::bps(kTargetBitrateBps), DataRate::bps(kTargetBitrateBps),
+      DataRate::bps(kTargetBitrateBps), 0, 0);
+  video_source_.IncomingCapturedFrame(CreateFrame(1, nullptr));
+  WaitForEncodedFrame(1);
+  EXPECT_EQ(1, fake_encoder_.GetNumEncoderInitializations());
+  EXPECT_EQ(VideoCodecComplexity::kComplexityNormal,
+            fake_encoder_.codec_config().VP8()->complexity);
+
+  // A budget below the default high threshold lowers both thresholds. The
+  // complexity is unchanged, so the encoder is not reconfigured.
+  video_stream_encoder_->SetCpuBudgetAllocationAndWait(
+      70, VideoCodecComplexity::kComplexityNormal);
+  CpuOveruseOptions options =
+      video_stream_encoder_->overuse_detector_proxy_->GetOptions();
+  EXPECT_EQ(70, options.high_encode_usage_threshold_percent);
+  EXPECT_EQ(35, options.low_encode_usage_threshold_percent);
+  EXPECT_EQ(70, stats_proxy_->GetStats().cpu_budget_max_encode_usage_percent);
+  video_source_.IncomingCapturedFrame(CreateFrame(2, nullptr));
+  WaitForEncodedFrame(2);
+  EXPECT_EQ(1, fake_encoder_.GetNumEncoderInitializations());
+
+  // A higher complexity, which the VP8 encoder maps to a lower cpu-used, is
+  // applied by reconfiguring the encoder on the next frame.
+  video_stream_encoder_->SetCpuBudgetAllocationAndWait(
+      200, VideoCodecComplexity::kComplexityHigher);
+  options = video_stream_encoder_->overuse_detector_proxy_->GetOptions();
+  const CpuOveruseOptions default_options;
+  EXPECT_EQ(default_options.high_encode_usage_threshold_percent,
+            options.high_encode_usage_threshold_percent);
+  EXPECT_EQ(default_options.low_encode_usage_threshold_percent,
+            options.low_encode_usage_threshold_percent);
+  EXPECT_EQ(VideoCodecComplexity::kComplexityHigher,
+            stats_proxy_->GetStats().cpu_budget_complexity);
+  video_source_.IncomingCapturedFrame(CreateFrame(3, nullptr));
+  WaitForEncodedFrame(3);
+  EXPECT_EQ(2, fake_encoder_.GetNumEncoderInitializations());
+  EXPECT_EQ(VideoCodecComplexity::kComplexityHigher,
+            fake_encoder_.codec_config().VP8()->complexity);
+  video_stream_encoder_->Stop();
+}
+
+TEST_F(VideoStreamEncoderTest, CpuBudgetAllocationIsAppliedToLaterEncoder) {
+  // No encoder exists before the first frame.
+  video_stream_encoder_->SetCpuBudgetAllocationAndWait(
+      60, VideoCodecComplexity::kComplexityHigh);
+  EXPECT_EQ(60, stats_proxy_->GetStats().cpu_budget_max_encode_usage_percent);
+
+  video_stream_encoder_->OnBitrateUpdated(
+      DataRate::bps(kTargetBitrateBps), DataRate::bps(kTargetBitrateBps),
+      DataRate::bps(kTargetBitrateBps), 0, 0);
+  video_source_.IncomingCapturedFrame(CreateFrame(1, nullptr));
+  WaitForEncodedFrame(1);
+  const CpuOveruseOptions options =
+      video_stream_encoder_->overuse_detector_proxy_->GetOptions();
+  EXPECT_EQ(60, options.high_encode_usage_threshold_percent);
+  EXPECT_EQ(30, options.low_encode_usage_threshold_percent);
+  EXPECT_EQ(1, fake_encoder_.GetNumEncoderInitializations());
+  EXPECT_EQ(VideoCodecComplexity::kComplexityHigh,
+            fake_encoder_.codec_config().VP8()->complexity);
+  video_stream_encoder_->Stop();
+}
+
+TEST_F(VideoStreamEncoderTest, CpuTimeLoadEstimatorMeasuresEncodeCpuTime) {
+  video_send_config_.encoder_settings.experiment_cpu_time_load_estimator =
+      true;
+  ConfigureEncoder(video_encoder_config_.Copy());
+  video_stream_encoder_->OnBitrateUpdated(
+      DataRate::bps(kTargetBitrateBps), DataRate::bps(kTargetBitrateBps),
+      DataRate::bps(kTargetBitrateBps), 0, 0);
+
+  video_source_.IncomingCapturedFrame(CreateFrame(1, nullptr));
+  WaitForEncodedFrame(1);
+  video_source_.IncomingCapturedFrame(CreateFrame(2, nullptr));
+  WaitForEncodedFrame(2);
+  CpuOveruseDetectorProxy* overuse_detector =
+      video_stream_encoder_->overuse_detector_proxy_;
+  EXPECT_TRUE(overuse_detector->GetOptions().use_encode_cpu_time);
+  EXPECT_EQ(2, overuse_detector->num_cpu_time_measurements());
+  video_stream_encoder_->Stop();
+}
+
 TEST_F(VideoStreamEncoderTest, DropsFramesWhenEncoderOvershoots) {
   const int kFrameWidth = 320;
   const int kFrameHeight = 240;